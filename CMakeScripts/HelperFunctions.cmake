@@ -33,6 +33,31 @@ endfunction()
 
 
 
+# Create the symlink "${CMAKE_BINARY_DIR}/inkscape_datadir/inkscape" pointing to the source tree's share directory,
+# so that ${CMAKE_BINARY_DIR}/inkscape_datadir can be used as INKSCAPE_DATADIR without installing the project.
+# ${OUTPUT} is set to that directory if the link exists afterwards, otherwise to an empty string.
+function(create_inkscape_datadir OUTPUT)
+    set(datadir ${CMAKE_BINARY_DIR}/inkscape_datadir)
+    if(NOT EXISTS ${datadir}/inkscape)
+        set(link_source ${datadir}/inkscape)
+        set(link_target ${CMAKE_SOURCE_DIR}/share)
+        message(STATUS "Creating link '${link_source}' --> '${link_target}'")
+        file(MAKE_DIRECTORY ${datadir})
+        execute_process(COMMAND ${CMAKE_COMMAND} -E create_symlink ${link_target} ${link_source}
+                        RESULT_VARIABLE result)
+        if(result)
+            message(WARNING "Creation of link failed: ${result}")
+        endif()
+    endif()
+    if(EXISTS ${datadir}/inkscape)
+        set(${OUTPUT} ${datadir} PARENT_SCOPE)
+    else()
+        set(${OUTPUT} "" PARENT_SCOPE)
+    endif()
+endfunction()
+
+
+
 # Checks if the last call to execute_process() was successful and throws an error otherwise.
 # ${result} and ${stderr} should hold the value of RESULT_VARIABLE and ERROR_VARIABLE respectively
 # ${command} can be empty or the command that was executed during the last call of execute_process()
@@ -0,0 +1,318 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Synthetic benchmark corpus - implementation.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "corpus.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <locale>
+#include <sstream>
+
+#include <cairo.h>
+#include <glib.h>
+
+namespace Inkscape::Benchmarks {
+
+namespace {
+
+/// Small deterministic generator; the corpus must not depend on the standard library's engines.
+class Random
+{
+public:
+    explicit Random(std::uint32_t seed) : _state(seed) {}
+
+    std::uint32_t next()
+    {
+        _state = _state * 1664525u + 1013904223u;
+        return _state;
+    }
+
+    /// Uniform value in [lo, hi).
+    double uniform(double lo, double hi) { return lo + (hi - lo) * (next() >> 8) / double(1u << 24); }
+
+    unsigned below(unsigned n) { return next() % n; }
+
+    std::string color()
+    {
+        char buf[8];
+        g_snprintf(buf, sizeof(buf), "#%06x", next() & 0xffffff);
+        return buf;
+    }
+
+private:
+    std::uint32_t _state;
+};
+
+std::ostringstream make_stream()
+{
+    std::ostringstream os;
+    os.imbue(std::locale::classic());
+    return os;
+}
+
+void header(std::ostringstream &os, double width, double height)
+{
+    os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+       << "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+       << " width=\"" << width << "\" height=\"" << height << "\""
+       << " viewBox=\"0 0 " << width << " " << height << "\">\n";
+}
+
+int scaled(int count, double scale)
+{
+    return std::max(1, static_cast<int>(std::lround(count * scale)));
+}
+
+/** Many small irregular polygons, as in a vector map of administrative areas. */
+CorpusEntry large_map(double scale)
+{
+    Random rnd(1);
+    double const size = 4000;
+    auto os = make_stream();
+    header(os, size, size);
+
+    int const shapes = scaled(20000, scale);
+    int const layers = 8;
+    for (int layer = 0; layer < layers; ++layer) {
+        os << "<g id=\"layer" << layer << "\" style=\"stroke:#202020;stroke-width:0.5\">\n";
+        for (int i = layer; i < shapes; i += layers) {
+            double cx = rnd.uniform(0, size), cy = rnd.uniform(0, size);
+            double r = rnd.uniform(5, 40);
+            int vertices = 8 + rnd.below(12);
+            os << "<path style=\"fill:" << rnd.color() << "\" d=\"M";
+            for (int v = 0; v < vertices; ++v) {
+                double a = 2 * M_PI * v / vertices;
+                double rr = r * rnd.uniform(0.6, 1.0);
+                os << ' ' << cx + rr * std::cos(a) << ',' << cy + rr * std::sin(a);
+            }
+            os << " Z\"/>\n";
+        }
+        os << "</g>\n";
+    }
+    os << "</svg>\n";
+    return {"large-map", "Many small filled and stroked polygons", os.str()};
+}
+
+/** Shapes using expensive filter chains. */
+CorpusEntry filter_art(double scale)
+{
+    Random rnd(2);
+    double const size = 2000;
+    auto os = make_stream();
+    header(os, size, size);
+
+    os << "<defs>\n"
+       << "<filter id=\"blur\" x=\"-0.5\" y=\"-0.5\" width=\"2\" height=\"2\">"
+          "<feGaussianBlur stdDeviation=\"8\"/></filter>\n"
+       << "<filter id=\"shadow\" x=\"-0.5\" y=\"-0.5\" width=\"2\" height=\"2\">"
+          "<feGaussianBlur in=\"SourceAlpha\" stdDeviation=\"6\" result=\"b\"/>"
+          "<feOffset in=\"b\" dx=\"8\" dy=\"8\" result=\"o\"/>"
+          "<feMerge><feMergeNode in=\"o\"/><feMergeNode in=\"SourceGraphic\"/></feMerge></filter>\n"
+       << "<filter id=\"turbulence\" x=\"0\" y=\"0\" width=\"1\" height=\"1\">"
+          "<feTurbulence baseFrequency=\"0.03\" numOctaves=\"4\" result=\"t\"/>"
+          "<feDisplacementMap in=\"SourceGraphic\" in2=\"t\" scale=\"20\"/></filter>\n"
+       << "<filter id=\"matrix\">"
+          "<feColorMatrix type=\"hueRotate\" values=\"90\" result=\"c\"/>"
+          "<feComposite in=\"c\" in2=\"SourceGraphic\" operator=\"arithmetic\" k1=\"0.5\" k2=\"0.5\" k3=\"0.5\"/>"
+          "</filter>\n"
+       << "</defs>\n";
+
+    char const *filters[] = {"blur", "shadow", "turbulence", "matrix"};
+    int const shapes = scaled(150, scale);
+    for (int i = 0; i < shapes; ++i) {
+        double x = rnd.uniform(0, size - 200), y = rnd.uniform(0, size - 200);
+        double w = rnd.uniform(40, 200), h = rnd.uniform(40, 200);
+        os << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << w << "\" height=\"" << h << "\""
+           << " rx=\"" << w / 8 << "\" style=\"fill:" << rnd.color() << ";filter:url(#"
+           << filters[i % 4] << ")\"/>\n";
+    }
+    os << "</svg>\n";
+    return {"filter-art", "Blur, shadow, turbulence and colour matrix filters", os.str()};
+}
+
+/** A page layout made mostly of text. */
+CorpusEntry text_document(double scale)
+{
+    Random rnd(3);
+    double const width = 2100, height = 29700;
+    auto os = make_stream();
+    header(os, width, height);
+
+    static char const *const words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur",
+                                        "adipiscing", "elit", "sed", "do", "eiusmod", "tempor",
+                                        "incididunt", "ut", "labore", "et", "dolore", "magna"};
+    static char const *const families[] = {"sans-serif", "serif", "monospace"};
+    int const lines = scaled(1500, scale);
+    double y = 40;
+    for (int i = 0; i < lines; ++i) {
+        double font_size = rnd.uniform(10, 18);
+        os << "<text x=\"40\" y=\"" << y << "\" style=\"font-size:" << font_size
+           << "px;font-family:" << families[i % 3] << "\">";
+        int count = 8 + rnd.below(8);
+        for (int w = 0; w < count; ++w) {
+            char const *word = words[rnd.below(G_N_ELEMENTS(words))];
+            if (rnd.below(6) == 0) {
+                os << "<tspan style=\"font-weight:bold;fill:" << rnd.color() << "\">" << word << "</tspan> ";
+            } else {
+                os << word << ' ';
+            }
+        }
+        os << "</text>\n";
+        y += font_size * 1.25;
+        if (y > height - 40) {
+            y = 40;
+        }
+    }
+    os << "</svg>\n";
+    return {"text-document", "Long runs of styled text", os.str()};
+}
+
+cairo_status_t append_to_string(void *closure, unsigned char const *data, unsigned length)
+{
+    static_cast<std::string *>(closure)->append(reinterpret_cast<char const *>(data), length);
+    return CAIRO_STATUS_SUCCESS;
+}
+
+/** One very large embedded bitmap, drawn twice under different transforms. */
+CorpusEntry embedded_image(double scale)
+{
+    Random rnd(4);
+    int const side = std::clamp(static_cast<int>(4096 * std::sqrt(scale)), 64, 16384);
+
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, side, side);
+    auto cr = cairo_create(surface);
+    auto gradient = cairo_pattern_create_linear(0, 0, side, side);
+    cairo_pattern_add_color_stop_rgb(gradient, 0, 0.1, 0.3, 0.8);
+    cairo_pattern_add_color_stop_rgb(gradient, 1, 0.9, 0.6, 0.1);
+    cairo_set_source(cr, gradient);
+    cairo_paint(cr);
+    cairo_pattern_destroy(gradient);
+    // Noise defeats the PNG compressor, as in a photograph.
+    for (int i = 0; i < side * 4; ++i) {
+        cairo_set_source_rgb(cr, rnd.uniform(0, 1), rnd.uniform(0, 1), rnd.uniform(0, 1));
+        cairo_rectangle(cr, rnd.below(side), rnd.below(side), 1 + rnd.below(16), 1 + rnd.below(16));
+        cairo_fill(cr);
+    }
+    cairo_destroy(cr);
+
+    std::string png;
+    cairo_surface_write_to_png_stream(surface, append_to_string, &png);
+    cairo_surface_destroy(surface);
+    gchar *base64 = g_base64_encode(reinterpret_cast<guchar const *>(png.data()), png.size());
+
+    auto os = make_stream();
+    header(os, side, side);
+    os << "<image id=\"photo\" width=\"" << side << "\" height=\"" << side
+       << "\" preserveAspectRatio=\"none\" xlink:href=\"data:image/png;base64," << base64 << "\"/>\n"
+       << "<use xlink:href=\"#photo\" transform=\"translate(" << side / 2 << "," << side / 2
+       << ") rotate(30) scale(0.4)\" style=\"opacity:0.7\"/>\n"
+       << "</svg>\n";
+    g_free(base64);
+    return {"embedded-image", "A huge embedded PNG, scaled and rotated", os.str()};
+}
+
+/** Clones of clones, both deep and wide. */
+CorpusEntry clone_tree(double scale)
+{
+    Random rnd(5);
+    double const size = 2000;
+    auto os = make_stream();
+    header(os, size, size);
+
+    os << "<defs>\n<g id=\"level0\">\n";
+    for (int i = 0; i < 16; ++i) {
+        os << "<circle cx=\"" << rnd.uniform(0, 100) << "\" cy=\"" << rnd.uniform(0, 100)
+           << "\" r=\"" << rnd.uniform(2, 12) << "\" style=\"fill:" << rnd.color() << "\"/>\n";
+    }
+    os << "</g>\n";
+
+    // Every level clones the previous one twice, so the number of drawn leaves doubles.
+    int const depth = std::clamp(static_cast<int>(std::lround(10 + std::log2(scale))), 1, 16);
+    for (int level = 1; level <= depth; ++level) {
+        double offset = 100 * std::pow(1.25, level);
+        os << "<g id=\"level" << level << "\">"
+           << "<use xlink:href=\"#level" << level - 1 << "\"/>"
+           << "<use xlink:href=\"#level" << level - 1 << "\" transform=\"translate("
+           << (level % 2 ? offset : 0) << "," << (level % 2 ? 0 : offset) << ") rotate(5)\"/>"
+           << "</g>\n";
+    }
+    os << "</defs>\n"
+       << "<use xlink:href=\"#level" << depth << "\" transform=\"scale(0.5)\"/>\n";
+
+    // A long chain of clones, each referring to the previous one.
+    int const chain = scaled(300, scale);
+    os << "<rect id=\"chain0\" width=\"20\" height=\"20\" style=\"fill:#3070c0\"/>\n";
+    for (int i = 1; i < chain; ++i) {
+        os << "<use id=\"chain" << i << "\" xlink:href=\"#chain" << i - 1
+           << "\" transform=\"translate(" << size / chain << ",3)\"/>\n";
+    }
+    os << "</svg>\n";
+    return {"clone-tree", "Nested and chained clones", os.str()};
+}
+
+/** Polylines with a marker on every vertex, as in a map of routes. */
+CorpusEntry marker_map(double scale)
+{
+    Random rnd(6);
+    double const size = 4000;
+    auto os = make_stream();
+    header(os, size, size);
+
+    // The dot does not depend on the path, nor is it turned along it; the arrowhead takes its
+    // colour from the stroke.
+    os << "<defs>\n"
+       << "<marker id=\"dot\" style=\"overflow:visible\" refX=\"0\" refY=\"0\">"
+          "<circle r=\"2\" style=\"fill:#ffffff;stroke:#000000;stroke-width:0.5\"/></marker>\n"
+       << "<marker id=\"arrow\" style=\"overflow:visible\" refX=\"0\" refY=\"0\" orient=\"auto\">"
+          "<path d=\"M 0,-3 L 6,0 L 0,3 Z\" style=\"fill:context-stroke;stroke:none\"/></marker>\n"
+       << "</defs>\n";
+
+    int const paths = scaled(10000, scale);
+    int const vertices = 11; // nine mid markers and an end marker per path
+    for (int i = 0; i < paths; ++i) {
+        double x = rnd.uniform(0, size), y = rnd.uniform(0, size);
+        os << "<path style=\"fill:none;stroke:" << rnd.color()
+           << ";stroke-width:1;marker-mid:url(#dot);marker-end:url(#arrow)\" d=\"M";
+        for (int v = 0; v < vertices; ++v) {
+            os << ' ' << x << ',' << y;
+            x += rnd.uniform(-30, 30);
+            y += rnd.uniform(-30, 30);
+        }
+        os << "\"/>\n";
+    }
+    os << "</svg>\n";
+    return {"marker-map", "Markers on 100000 path vertices", os.str()};
+}
+
+} // namespace
+
+std::vector<CorpusEntry> generate_corpus(double scale)
+{
+    std::vector<CorpusEntry> corpus;
+    corpus.push_back(large_map(scale));
+    corpus.push_back(filter_art(scale));
+    corpus.push_back(text_document(scale));
+    corpus.push_back(embedded_image(scale));
+    corpus.push_back(clone_tree(scale));
+    corpus.push_back(marker_map(scale));
+    return corpus;
+}
+
+} // namespace Inkscape::Benchmarks
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Synthetic benchmark corpus.
+ *
+ * Each entry is generated deterministically from a fixed seed, so results stay comparable
+ * between releases without keeping large SVG files in the repository.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_BENCHMARKS_CORPUS_H
+#define INKSCAPE_BENCHMARKS_CORPUS_H
+
+#include <string>
+#include <vector>
+
+namespace Inkscape::Benchmarks {
+
+struct CorpusEntry
+{
+    std::string name;        ///< Short identifier used in the results.
+    std::string description; ///< What the document stresses.
+    std::string svg;         ///< Document source.
+};
+
+/**
+ * Generate the built-in corpus.
+ * @param scale Multiplies the number of generated elements; 1 is the reference size.
+ */
+std::vector<CorpusEntry> generate_corpus(double scale = 1.0);
+
+} // namespace Inkscape::Benchmarks
+
+#endif // INKSCAPE_BENCHMARKS_CORPUS_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
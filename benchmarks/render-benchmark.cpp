@@ -0,0 +1,458 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Offline rendering benchmark.
+ *
+ * Loads every document of the built-in corpus (and any SVG files given on the command line),
+ * then times loading, the first drawing update, rendering at several zoom levels, PNG and PDF
+ * export, saving as SVG and boolean operations. The results are written as JSON so that they can be compared
+ * between builds.
+ *
+ * Usage: render-benchmark [--output FILE] [--repeat N] [--scale S] [--no-corpus] [FILE.svg...]
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <locale>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <cairo.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <giomm/init.h>
+#include <2geom/int-rect.h>
+#include <2geom/transforms.h>
+
+#include "corpus.h"
+#include "document.h"
+#include "inkscape.h"
+#include "inkscape-version.h"
+#include "display/drawing.h"
+#include "display/drawing-context.h"
+#include "display/rendermode.h"
+#include "extension/db.h"
+#include "extension/init.h"
+#include "extension/output.h"
+#include "extension/system.h"
+#include "helper/png-write.h"
+#include "inkgc/gc-core.h"
+#include "object/sp-item.h"
+#include "object/sp-root.h"
+#include "object/sp-shape.h"
+#include "path/path-boolop.h"
+#include "util/statics.h"
+#include "xml/repr.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/// Samples of one measurement, in milliseconds.
+using Samples = std::vector<double>;
+
+struct Result
+{
+    std::string name;
+    std::string source;
+    std::string description;
+    std::map<std::string, Samples> metrics;
+    std::string error;
+};
+
+struct Options
+{
+    std::string output = "benchmark-results.json";
+    int repeat = 3;
+    double scale = 1.0;
+    bool corpus = true;
+    std::vector<std::string> files;
+};
+
+constexpr double ZOOM_LEVELS[] = {0.25, 1.0, 4.0};
+constexpr int VIEWPORT_SIZE = 1024;
+constexpr std::size_t BOOLOP_MAX_SHAPES = 200;
+constexpr std::size_t CANVAS_CACHE_BUDGET = std::size_t{64} << 20; ///< /options/renderingcache/size
+
+/**
+ * Draws the document offscreen the way the canvas does, into a fixed-size viewport
+ * centered on the document.
+ */
+class OffscreenView
+{
+public:
+    explicit OffscreenView(SPDocument &doc)
+        : _doc(doc)
+        , _dkey(SPItem::display_key_new(1))
+    {
+        _drawing.setRoot(_doc.getRoot()->invoke_show(_drawing, _dkey, SP_ITEM_SHOW_DISPLAY));
+    }
+
+    ~OffscreenView() { _doc.getRoot()->invoke_hide(_dkey); }
+
+    void setRenderMode(Inkscape::RenderMode mode) { _drawing.setRenderMode(mode); }
+    void setCacheBudget(std::size_t bytes) { _drawing.setCacheBudget(bytes); }
+
+    void update(double zoom)
+    {
+        auto const center = _doc.getDimensions() * zoom / 2;
+        _area = Geom::IntRect::from_xywh(std::floor(center.x()) - VIEWPORT_SIZE / 2,
+                                         std::floor(center.y()) - VIEWPORT_SIZE / 2,
+                                         VIEWPORT_SIZE, VIEWPORT_SIZE);
+        _drawing.root()->setTransform(Geom::Scale(zoom));
+        _drawing.update(_area);
+    }
+
+    void render(unsigned flags = Inkscape::DrawingItem::RENDER_BYPASS_CACHE)
+    {
+        auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, _area.width(), _area.height());
+        {
+            Inkscape::DrawingContext dc(surface, _area.min());
+            _drawing.render(dc, _area, flags);
+        }
+        cairo_surface_flush(surface);
+        cairo_surface_destroy(surface);
+    }
+
+private:
+    SPDocument &_doc;
+    Inkscape::Drawing _drawing;
+    unsigned _dkey;
+    Geom::IntRect _area;
+};
+
+std::vector<Geom::PathVector> collect_paths(SPDocument &doc)
+{
+    std::vector<Geom::PathVector> paths;
+    std::vector<SPObject *> stack{doc.getRoot()};
+    while (!stack.empty() && paths.size() < BOOLOP_MAX_SHAPES) {
+        auto current = stack.back();
+        stack.pop_back();
+        if (auto shape = cast<SPShape>(current); shape && shape->curve()) {
+            paths.push_back(shape->curve()->get_pathvector() * shape->i2doc_affine());
+        }
+        for (auto &child : current->children) {
+            stack.push_back(&child);
+        }
+    }
+    return paths;
+}
+
+class Benchmark
+{
+public:
+    Benchmark(Options const &options, std::string const &tmpdir)
+        : _options(options)
+        , _tmpdir(tmpdir)
+    {}
+
+    Result run(std::string name, std::string source, std::string description,
+               std::function<std::unique_ptr<SPDocument>()> const &load)
+    {
+        Result result{std::move(name), std::move(source), std::move(description), {}, {}};
+        std::cerr << "Benchmarking " << result.name << "..." << std::endl;
+
+        for (int i = 0; i < _options.repeat; ++i) {
+            if (!_runOnce(result, load)) {
+                break;
+            }
+        }
+        return result;
+    }
+
+private:
+    bool _runOnce(Result &result, std::function<std::unique_ptr<SPDocument>()> const &load)
+    {
+        auto &m = result.metrics;
+
+        auto start = Clock::now();
+        auto doc = load();
+        if (!doc || !doc->getRoot()) {
+            result.error = "failed to load document";
+            return false;
+        }
+        doc->ensureUpToDate();
+        m["load"].push_back(elapsed_ms(start));
+
+        {
+            start = Clock::now();
+            OffscreenView view(*doc);
+            view.update(1.0);
+            m["first_update"].push_back(elapsed_ms(start));
+
+            for (double zoom : ZOOM_LEVELS) {
+                auto const key = "render_zoom_" + format_number(zoom);
+                start = Clock::now();
+                view.update(zoom);
+                view.render();
+                m[key].push_back(elapsed_ms(start));
+            }
+
+            // With the default cache budget of the canvas, drawing the viewport a second time.
+            view.setCacheBudget(CANVAS_CACHE_BUDGET);
+            view.update(1.0);
+            view.render(0);
+            start = Clock::now();
+            view.render(0);
+            m["render_cached"].push_back(elapsed_ms(start));
+            view.setCacheBudget(0);
+
+            view.setRenderMode(Inkscape::RenderMode::OUTLINE);
+            start = Clock::now();
+            view.update(1.0);
+            view.render();
+            m["render_outline"].push_back(elapsed_ms(start));
+        }
+
+        auto const png = g_build_filename(_tmpdir.c_str(), "export.png", nullptr);
+        auto const dims = doc->getDimensions();
+        start = Clock::now();
+        auto png_status = sp_export_png_file(doc.get(), png, Geom::Rect(Geom::Point(0, 0), dims),
+                                             std::ceil(dims.x()), std::ceil(dims.y()), 96, 96,
+                                             0xffffffff, nullptr, nullptr, true);
+        if (png_status == EXPORT_OK) {
+            m["export_png"].push_back(elapsed_ms(start));
+        }
+        g_unlink(png);
+        g_free(png);
+
+        if (auto pdf_out = Inkscape::Extension::db.get("org.inkscape.output.pdf.cairorenderer")) {
+            auto const pdf = g_build_filename(_tmpdir.c_str(), "export.pdf", nullptr);
+            start = Clock::now();
+            try {
+                Inkscape::Extension::save(pdf_out, doc.get(), pdf, false, false,
+                                          Inkscape::Extension::FILE_SAVE_METHOD_TEMPORARY);
+                m["export_pdf"].push_back(elapsed_ms(start));
+            } catch (...) {
+                std::cerr << "  PDF export failed" << std::endl;
+            }
+            g_unlink(pdf);
+            g_free(pdf);
+        }
+
+        // Serializing the XML tree, which is most of what saving and autosaving take on large files.
+        auto const svg = g_build_filename(_tmpdir.c_str(), "save.svg", nullptr);
+        start = Clock::now();
+        if (sp_repr_save_file(doc->getReprDoc(), svg, SP_SVG_NS_URI)) {
+            m["save_svg"].push_back(elapsed_ms(start));
+        } else {
+            std::cerr << "  SVG save failed" << std::endl;
+        }
+        g_unlink(svg);
+        g_free(svg);
+
+        auto const paths = collect_paths(*doc);
+        if (paths.size() > 1) {
+            start = Clock::now();
+            Geom::PathVector accumulated = paths.front();
+            for (std::size_t i = 1; i < paths.size(); ++i) {
+                accumulated = sp_pathvector_boolop(accumulated, paths[i], bool_op_union, fill_nonZero, fill_nonZero);
+            }
+            m["boolop_union"].push_back(elapsed_ms(start));
+        }
+
+        return true;
+    }
+
+    static std::string format_number(double value)
+    {
+        std::ostringstream os;
+        os.imbue(std::locale::classic());
+        os << value;
+        return os.str();
+    }
+
+    Options const &_options;
+    std::string _tmpdir;
+};
+
+std::string json_escape(std::string const &str)
+{
+    std::string out;
+    out.reserve(str.size() + 2);
+    for (unsigned char c : str) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    g_snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+void write_json(std::ostream &os, Options const &options, std::vector<Result> const &results)
+{
+    os.imbue(std::locale::classic());
+    os.precision(6);
+
+    char timestamp[32];
+    auto now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    os << "{\n"
+       << "  \"inkscape_version\": \"" << json_escape(Inkscape::version_string) << "\",\n"
+       << "  \"timestamp\": \"" << timestamp << "\",\n"
+       << "  \"repeat\": " << options.repeat << ",\n"
+       << "  \"scale\": " << options.scale << ",\n"
+       << "  \"unit\": \"ms\",\n"
+       << "  \"documents\": [";
+
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        auto const &r = results[i];
+        os << (i ? ",\n" : "\n")
+           << "    {\n"
+           << "      \"name\": \"" << json_escape(r.name) << "\",\n"
+           << "      \"source\": \"" << json_escape(r.source) << "\",\n"
+           << "      \"description\": \"" << json_escape(r.description) << "\",\n";
+        if (!r.error.empty()) {
+            os << "      \"error\": \"" << json_escape(r.error) << "\",\n";
+        }
+        os << "      \"metrics\": {";
+        bool first = true;
+        for (auto const &[key, samples] : r.metrics) {
+            if (samples.empty()) {
+                continue;
+            }
+            auto sorted = samples;
+            std::sort(sorted.begin(), sorted.end());
+            double const mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+            double const median = sorted.size() % 2 ? sorted[sorted.size() / 2]
+                                                    : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+            os << (first ? "\n" : ",\n")
+               << "        \"" << json_escape(key) << "\": {"
+               << "\"min\": " << sorted.front() << ", \"median\": " << median
+               << ", \"mean\": " << mean << ", \"max\": " << sorted.back() << ", \"samples\": [";
+            for (std::size_t s = 0; s < samples.size(); ++s) {
+                os << (s ? ", " : "") << samples[s];
+            }
+            os << "]}";
+            first = false;
+        }
+        os << "\n      }\n    }";
+    }
+    os << "\n  ]\n}\n";
+}
+
+bool parse_options(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&] () -> char const * { return i + 1 < argc ? argv[++i] : nullptr; };
+        if (arg == "--output" || arg == "-o") {
+            auto v = value();
+            if (!v) return false;
+            options.output = v;
+        } else if (arg == "--repeat" || arg == "-r") {
+            auto v = value();
+            if (!v) return false;
+            options.repeat = std::max(1, std::atoi(v));
+        } else if (arg == "--scale" || arg == "-s") {
+            auto v = value();
+            if (!v) return false;
+            options.scale = std::max(0.01, g_ascii_strtod(v, nullptr));
+        } else if (arg == "--no-corpus") {
+            options.corpus = false;
+        } else if (arg == "--help" || arg == "-h" || arg.starts_with("-")) {
+            return false;
+        } else {
+            options.files.push_back(arg);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--output FILE] [--repeat N] [--scale S] [--no-corpus] [FILE.svg...]" << std::endl;
+        return 2;
+    }
+
+    Gio::init();
+    Inkscape::GC::init();
+    Inkscape::Application::create(false);
+    Inkscape::Extension::init();
+
+    GError *error = nullptr;
+    gchar *tmpdir = g_dir_make_tmp("inkscape-benchmark-XXXXXX", &error);
+    if (!tmpdir) {
+        std::cerr << "Cannot create temporary directory: " << error->message << std::endl;
+        g_error_free(error);
+        return 1;
+    }
+
+    std::vector<Result> results;
+    {
+        Benchmark benchmark(options, tmpdir);
+
+        if (options.corpus) {
+            for (auto const &entry : Inkscape::Benchmarks::generate_corpus(options.scale)) {
+                results.push_back(benchmark.run(entry.name, "generated", entry.description, [&] {
+                    return SPDocument::createNewDocFromMem(entry.svg, false);
+                }));
+            }
+        }
+        for (auto const &file : options.files) {
+            gchar *basename = g_path_get_basename(file.c_str());
+            results.push_back(benchmark.run(basename, file, "", [&] {
+                return SPDocument::createNewDoc(file.c_str(), false);
+            }));
+            g_free(basename);
+        }
+    }
+    g_rmdir(tmpdir);
+    g_free(tmpdir);
+
+    std::ofstream out(options.output);
+    if (!out) {
+        std::cerr << "Cannot write " << options.output << std::endl;
+        return 1;
+    }
+    write_json(out, options, results);
+    std::cerr << "Results written to " << options.output << std::endl;
+
+    Inkscape::Util::StaticsBin::get().destroy();
+
+    bool const failed = std::any_of(results.begin(), results.end(), [] (Result const &r) { return !r.error.empty(); });
+    return failed ? 1 : 0;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -120,6 +120,7 @@ ConnRef::~ConnRef()
     m_router->removeObjectFromQueuedActions(this);
 
     freeRoutes();
+    m_router->connectorDeleted(this);
 
     if (m_src_vert)
     {
@@ -584,6 +585,7 @@ void ConnRef::freeRoutes(void)
 {
     m_route.clear();
     m_display_route.clear();
+    m_router->connectorRouteChanged(this);
 }
     
 
@@ -629,6 +631,7 @@ void ConnRef::setFixedRoute(const PolyLine& route)
     m_has_fixed_route = true;
     m_route = route;
     m_display_route = m_route.simplify();
+    m_router->connectorRouteChanged(this);
     m_router->registerSettingsChange();
 }
 
@@ -942,6 +945,7 @@ bool ConnRef::generatePath(void)
 
     m_false_path = false;
     m_needs_reroute_flag = false;
+    m_router->connectorRouteChanged(this);
 
     m_start_vert = m_src_vert;
 
@@ -993,8 +997,11 @@ bool ConnRef::generatePath(void)
                 edge->addConn(m_reroute_flag_ptr);
             }
         }
-        else
+        else if ((m_type != ConnType_Orthogonal) || !m_checkpoints.empty())
         {
+            // Orthogonal routes without checkpoints are instead marked by
+            // Router::markOrthogonalConnectorsNeedingRerouting() when 
+            // nearby obstacles change.
             m_false_path = true;
         }
 
@@ -27,7 +27,10 @@
 #include <cfloat>
 #include <cmath>
 #include <set>
+#include <map>
 #include <list>
+#include <queue>
+#include <string>
 #include <algorithm>
 
 #include "libavoid/router.h"
@@ -1273,6 +1276,10 @@ class SegmentListWrapper
 // Given a router instance and a set of possible horizontal segments, and a
 // possible vertical visibility segment, compute and add edges to the
 // orthogonal visibility graph for all the visibility edges.
+// The segments list must be sorted, so that it can serve as an index of 
+// the horizontal segments ordered by where they begin.  Segments are only
+// ever shortened up to the current sweep position, so the segments that
+// have not yet been reached stay in order.
 static void intersectSegments(Router *router, SegmentList& segments,
         LineSegment& vertLine)
 {
@@ -1291,9 +1298,10 @@ static void intersectSegments(Router *router, SegmentList& segments,
 
         if (vertLine.pos < horiLine.begin)
         {
-            // We've yet to reach this segment in the sweep, so ignore.
-            ++it;
-            continue;
+            // We've yet to reach this segment in the sweep.  The segments 
+            // are sorted by their start position, so neither have we 
+            // reached any of those that follow.
+            break;
         }
         else if (vertLine.pos == horiLine.begin)
         {
@@ -2506,6 +2514,392 @@ class PotentialSegmentConstraint
 };
 
 
+// Finds, for each segment, the other segments that overlap it.  Segments
+// can only overlap if their extents in the other dimension touch, so with
+// the segments sorted by where these begin, each only needs comparing with
+// the segments that begin within its extent.
+static void findOverlappingSegments(const std::vector<ShiftSegment *>& segments,
+        const size_t dim, std::vector<std::vector<size_t> >& overlapping)
+{
+    const size_t altDim = (dim + 1) % 2;
+    std::vector<std::pair<double, double> > extents(segments.size());
+    std::vector<std::pair<double, size_t> > order(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        double low = segments[i]->lowPoint()[altDim];
+        double high = segments[i]->highPoint()[altDim];
+        extents[i] = std::make_pair(std::min(low, high), std::max(low, high));
+        order[i] = std::make_pair(extents[i].first, i);
+    }
+    std::sort(order.begin(), order.end());
+
+    overlapping.assign(segments.size(), std::vector<size_t>());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        size_t index1 = order[i].second;
+        for (size_t j = i + 1; (j < order.size()) &&
+                (order[j].first <= extents[index1].second); ++j)
+        {
+            size_t index2 = order[j].second;
+            if (segments[index1]->overlapsWith(segments[index2], dim))
+            {
+                overlapping[index1].push_back(index2);
+                overlapping[index2].push_back(index1);
+            }
+        }
+    }
+}
+
+
+static void appendBytes(std::string& key, const void *data, size_t size)
+{
+    key.append(static_cast<const char *> (data), size);
+}
+
+
+// Returns a key that identifies a nudging problem exactly.  The solver's
+// result depends only on the variables and constraints, in order.
+static std::string nudgingProblemKey(const Variables& vs,
+        const Constraints& cs, const bool justUnifying,
+        const double baseSepDist)
+{
+    std::string key;
+    key.reserve(1 + sizeof(double) + (vs.size() * 24) + (cs.size() * 24));
+    key.push_back(justUnifying ? 'u' : 'n');
+    appendBytes(key, &baseSepDist, sizeof(double));
+
+    std::map<const Variable *, unsigned int> indexes;
+    for (size_t i = 0; i < vs.size(); ++i)
+    {
+        indexes[vs[i]] = (unsigned int) i;
+        appendBytes(key, &vs[i]->id, sizeof(int));
+        appendBytes(key, &vs[i]->desiredPosition, sizeof(double));
+        appendBytes(key, &vs[i]->weight, sizeof(double));
+    }
+    for (size_t i = 0; i < cs.size(); ++i)
+    {
+        unsigned int left = indexes[cs[i]->left];
+        unsigned int right = indexes[cs[i]->right];
+        appendBytes(key, &left, sizeof(unsigned int));
+        appendBytes(key, &right, sizeof(unsigned int));
+        appendBytes(key, &cs[i]->gap, sizeof(double));
+        key.push_back(cs[i]->equality ? 'e' : 's');
+    }
+    return key;
+}
+
+
+bool NudgingCache::lookup(const std::string& key, bool& satisfied,
+        std::vector<double>& positions)
+{
+    SolutionMap::iterator found = m_current.find(key);
+    if (found == m_current.end())
+    {
+        found = m_previous.find(key);
+        if (found == m_previous.end())
+        {
+            return false;
+        }
+        // Keep this for the next transaction.
+        found = m_current.insert(*found).first;
+    }
+    satisfied = found->second.first;
+    positions = found->second.second;
+    return true;
+}
+
+
+void NudgingCache::store(const std::string& key, const bool satisfied,
+        const std::vector<double>& positions)
+{
+    m_current[key] = std::make_pair(satisfied, positions);
+}
+
+
+void NudgingCache::endTransaction(void)
+{
+    // Forget solutions not used in this transaction.
+    m_previous.clear();
+    m_previous.swap(m_current);
+}
+
+
+// Solves the nudging problem for a region, returning whether it could be
+// satisfied.  See ImproveOrthogonalRoutes::nudgeOrthogonalRoutes().
+static bool solveNudgingProblem(Variables& vs, Constraints& cs,
+        const std::list<size_t>& freeIndexes, const bool justUnifying,
+        const double baseSepDist)
+{
+    // If we can fit things with the desired separation distance, then
+    // we try 10 times, reducing each time by a 10th of the original amount.
+    double reductionSteps = 10.0;
+    double sepDist = baseSepDist;
+
+    std::list<PotentialSegmentConstraint> potentialConstraints;
+    if (justUnifying)
+    {
+        for (std::list<size_t>::const_iterator curr = freeIndexes.begin();
+                curr != freeIndexes.end(); ++curr)
+        {
+            for (std::list<size_t>::const_iterator curr2 = curr;
+                    curr2 != freeIndexes.end(); ++curr2)
+            {
+                if (curr == curr2)
+                {
+                    continue;
+                }
+                potentialConstraints.push_back(
+                        PotentialSegmentConstraint(*curr, *curr2, vs));
+            }
+        }
+    }
+#ifdef NUDGE_DEBUG
+    for (unsigned i = 0;i < vs.size(); ++i)
+    {
+        fprintf(stderr, "-vs[%d]=%f\n", i, vs[i]->desiredPosition);
+    }
+#endif
+    // Repeatedly try solving this.  There are two cases:
+    //  -  When Unifying, we greedily place as many free segments as
+    //     possible at the same positions, that way they have more
+    //     accurate nudging orders determined for them in the Nudging
+    //     stage.
+    //  -  When Nudging, if we can't fit all the segments with the
+    //     default nudging distance we try smaller separation
+    //     distances till we find a solution that is satisfied.
+    bool justAddedConstraint = false;
+    bool satisfied;
+
+    typedef std::pair<size_t, size_t> UnsatisfiedRange;
+    std::list<UnsatisfiedRange> unsatisfiedRanges;
+    do
+    {
+        IncSolver f(vs, cs);
+        f.solve();
+
+        // Determine if the problem was satisfied.
+        satisfied = true;
+        for (size_t i = 0; i < vs.size(); ++i)
+        {
+            // For each variable...
+            if (vs[i]->id != freeSegmentID)
+            {
+                // If it is a fixed segment (should stay still)...
+                if (fabs(vs[i]->finalPosition -
+                        vs[i]->desiredPosition) > 0.0001)
+                {
+                    // and it is not at it's desired position, then
+                    // we consider the problem to be unsatisfied.
+                    satisfied = false;
+
+                    // We record ranges of unsatisfied variables based on
+                    // the channel edges.
+                    if (vs[i]->id == channelLeftID)
+                    {
+                        // This is the left-hand-side of a channel.
+                        if (unsatisfiedRanges.empty() ||
+                                (unsatisfiedRanges.back().first !=
+                                unsatisfiedRanges.back().second))
+                        {
+                            // There are no existing unsatisfied ranges,
+                            // or there are but they are a valid range
+                            // (we've encountered the right-hand channel
+                            // edges already).
+                            // So, start a new unsatisfied range.
+                            unsatisfiedRanges.push_back(
+                                    std::make_pair(i, i + 1));
+                        }
+                    }
+                    else if (vs[i]->id == channelRightID)
+                    {
+                        // This is the right-hand-side of a channel.
+                        if (unsatisfiedRanges.empty())
+                        {
+                            // There are no existing unsatisfied ranges,
+                            // so start a new unsatisfied range.
+                            // We are looking at a unsatisfied right side
+                            // where the left side was satisfied, so the
+                            // range begins at the previous variable
+                            // which should be a left channel side.
+                            COLA_ASSERT(i > 0);
+                            COLA_ASSERT(vs[i - 1]->id == channelLeftID);
+                            unsatisfiedRanges.push_back(
+                                    std::make_pair(i - 1, i));
+                        }
+                        else
+                        {
+                            // Expand the existing range to include index.
+                            unsatisfiedRanges.back().second = i;
+                        }
+                    }
+                    else if (vs[i]->id == fixedSegmentID)
+                    {
+                        // Fixed connector segments can also start and
+                        // extend unsatisfied variable ranges.
+                        if (unsatisfiedRanges.empty())
+                        {
+                            // There are no existing unsatisfied ranges,
+                            // so start a new unsatisfied range.
+                            unsatisfiedRanges.push_back(
+                                    std::make_pair(i, i));
+                        }
+                        else
+                        {
+                            // Expand the existing range to include index.
+                            unsatisfiedRanges.back().second = i;
+                        }
+                    }
+                }
+            }
+        }
+
+#ifdef NUDGE_DEBUG
+        if (!satisfied)
+        {
+            fprintf(stderr,"unsatisfied\n");
+        }
+#endif
+
+        if (justUnifying)
+        {
+            // When we're centring, we'd like to greedily place as many
+            // segments as possible at the same positions, that way they
+            // have more accurate nudging orders determined for them.
+            //
+            // We do this by taking pairs of adjoining free segments and
+            // attempting to constrain them to have the same position,
+            // starting from the closest up to the furthest.
+
+            if (justAddedConstraint)
+            {
+                COLA_ASSERT(potentialConstraints.size() > 0);
+                if (!satisfied)
+                {
+                    // We couldn't satisfy the problem with the added
+                    // potential constraint, so we can't position these
+                    // segments together.  Roll back.
+                    potentialConstraints.pop_front();
+                    delete cs.back();
+                    cs.pop_back();
+                }
+                else
+                {
+                    // We could position these two segments together.
+                    PotentialSegmentConstraint& pc =
+                            potentialConstraints.front();
+
+                    // Rewrite the indexes of these two variables to
+                    // one, so we need not worry about redundant
+                    // equality constraints.
+                    for (std::list<PotentialSegmentConstraint>::iterator
+                            it = potentialConstraints.begin();
+                            it != potentialConstraints.end(); ++it)
+                    {
+                        it->rewriteIndex(pc.index1, pc.index2);
+                    }
+                    potentialConstraints.pop_front();
+                }
+            }
+            potentialConstraints.sort();
+            justAddedConstraint = false;
+
+            // Remove now invalid potential segment constraints.
+            // This could have been caused by the variable rewriting.
+            while (!potentialConstraints.empty() &&
+                   !potentialConstraints.front().stillValid())
+            {
+                potentialConstraints.pop_front();
+            }
+
+            if (!potentialConstraints.empty())
+            {
+                // We still have more possibilities to consider.
+                // Create a constraint for this, add it, and mark as
+                // unsatisfied, so the problem gets re-solved.
+                PotentialSegmentConstraint& pc =
+                        potentialConstraints.front();
+                COLA_ASSERT(pc.index1 != pc.index2);
+                cs.push_back(new Constraint(vs[pc.index1], vs[pc.index2],
+                        0, true));
+                satisfied = false;
+                justAddedConstraint = true;
+            }
+        }
+        else
+        {
+            if (!satisfied)
+            {
+                COLA_ASSERT(unsatisfiedRanges.size() > 0);
+                // Reduce the separation distance.
+                sepDist -= (baseSepDist / reductionSteps);
+#ifndef NDEBUG
+                for (std::list<UnsatisfiedRange>::iterator it =
+                        unsatisfiedRanges.begin();
+                        it != unsatisfiedRanges.end(); ++it)
+                {
+                    COLA_ASSERT(vs[it->first]->id != freeSegmentID);
+                    COLA_ASSERT(vs[it->second]->id != freeSegmentID);
+                }
+#endif
+#ifdef NUDGE_DEBUG
+                for (std::list<UnsatisfiedRange>::iterator it =
+                        unsatisfiedRanges.begin();
+                        it != unsatisfiedRanges.end(); ++it)
+                {
+                    fprintf(stderr, "unsatisfiedVarRange(%ld, %ld)\n",
+                            it->first, it->second);
+                }
+                fprintf(stderr, "unsatisfied, trying %g\n", sepDist);
+#endif
+                // And rewrite all the gap constraints to have the new
+                // reduced separation distance.
+                bool withinUnsatisfiedGroup = false;
+                for (Constraints::iterator cIt = cs.begin();
+                        cIt != cs.end(); ++cIt)
+                {
+                    UnsatisfiedRange& range = unsatisfiedRanges.front();
+                    Constraint *constraint = *cIt;
+
+                    if (constraint->left == vs[range.first])
+                    {
+                        // Entered an unsatisfied range of variables.
+                        withinUnsatisfiedGroup = true;
+                    }
+
+                    if (withinUnsatisfiedGroup && (constraint->gap > 0))
+                    {
+                        // Rewrite constraints in unsatisfied ranges
+                        // that have a non-zero gap.
+                        constraint->gap = sepDist;
+                    }
+
+                    if (constraint->right == vs[range.second])
+                    {
+                        // Left an unsatisfied range of variables.
+                        withinUnsatisfiedGroup = false;
+                        unsatisfiedRanges.pop_front();
+                        if (unsatisfiedRanges.empty())
+                        {
+                            // And there are no more unsatisfied variables.
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    while (!satisfied && (sepDist > 0.0001));
+
+#ifdef NUDGE_DEBUG
+    if (satisfied)
+    {
+        fprintf(stderr,"satisfied at nudgeDist = %g\n", sepDist);
+    }
+#endif
+    return satisfied;
+}
+
+
 class ImproveOrthogonalRoutes
 {
 public:
@@ -2591,6 +2985,8 @@ void ImproveOrthogonalRoutes::execute(void)
     // Clear the segment-checkpoint cache for connectors.
     clearConnectorRouteCheckpointCache(m_router);
 
+    m_router->m_nudging_cache->endTransaction();
+
     TIMER_STOP(m_router);
 }
 
@@ -2603,55 +2999,65 @@ void ImproveOrthogonalRoutes::nudgeOrthogonalRoutes(size_t dimension,
             nudgeSharedPathsWithCommonEndPoint);
     double baseSepDist = m_router->routingParameter(idealNudgingDistance);
     COLA_ASSERT(baseSepDist >= 0);
-    // If we can fit things with the desired separation distance, then
-    // we try 10 times, reducing each time by a 10th of the original amount.
-    double reductionSteps = 10.0;
 
     size_t totalSegmentsToShift = m_segment_list.size();
     size_t numOfSegmentsShifted = 0;
+
+    // Find which segments overlap each other up front, rather than
+    // rescanning the whole remaining segment list for each new member of
+    // a region.
+    std::vector<ShiftSegment *> segments(m_segment_list.begin(),
+            m_segment_list.end());
+    m_segment_list.clear();
+    std::vector<std::vector<size_t> > overlapping;
+    findOverlappingSegments(segments, dimension, overlapping);
+    std::vector<bool> grouped(segments.size(), false);
+    size_t nextSegment = 0;
+
+    NudgingCache *cache = m_router->m_nudging_cache;
+
     // Do the actual nudging.
     ShiftSegmentList currentRegion;
-    while (!m_segment_list.empty())
+    while (numOfSegmentsShifted < totalSegmentsToShift)
     {
         // Progress reporting and continuation check.
-        numOfSegmentsShifted = totalSegmentsToShift - m_segment_list.size();
         m_router->performContinuationCheck(
                 (dimension == XDIM) ? TransactionPhaseOrthogonalNudgingX :
                 TransactionPhaseOrthogonalNudgingY, numOfSegmentsShifted,
                 totalSegmentsToShift);
 
         // Take a reference segment
-        ShiftSegment *currentSegment = m_segment_list.front();
-        // Then, find the segments that overlap this one.
+        while (grouped[nextSegment])
+        {
+            ++nextSegment;
+        }
+        // Then, find the segments that overlap this one.  They are added
+        // in list order of the first remaining segment that overlaps any
+        // segment already in the region, since the order matters for the
+        // unifying step.
         currentRegion.clear();
-        currentRegion.push_back(currentSegment);
-        m_segment_list.erase(m_segment_list.begin());
-        for (ShiftSegmentList::iterator curr = m_segment_list.begin();
-                curr != m_segment_list.end(); )
+        std::priority_queue<size_t, std::vector<size_t>,
+                std::greater<size_t> > pending;
+        pending.push(nextSegment);
+        while (!pending.empty())
         {
-            bool overlaps = false;
-            for (ShiftSegmentList::iterator curr2 = currentRegion.begin();
-                    curr2 != currentRegion.end(); ++curr2)
+            size_t index = pending.top();
+            pending.pop();
+            if (grouped[index])
             {
-                if ((*curr)->overlapsWith(*curr2, dimension))
-                {
-                    overlaps = true;
-                    break;
-                }
-            }
-            if (overlaps)
-            {
-                currentRegion.push_back(*curr);
-                m_segment_list.erase(curr);
-                // Consider segments from the beginning, since we may have
-                // since passed segments that overlap with the new set.
-                curr = m_segment_list.begin();
+                continue;
             }
-            else
+            grouped[index] = true;
+            currentRegion.push_back(segments[index]);
+            for (size_t i = 0; i < overlapping[index].size(); ++i)
             {
-                ++curr;
+                if (!grouped[overlapping[index][i]])
+                {
+                    pending.push(overlapping[index][i]);
+                }
             }
         }
+        numOfSegmentsShifted += currentRegion.size();
 
         if (! justUnifying)
         {
@@ -2835,266 +3241,40 @@ void ImproveOrthogonalRoutes::nudgeOrthogonalRoutes(size_t dimension,
             prevVars.push_back(&(*currSegment));
         }
 
-        std::list<PotentialSegmentConstraint> potentialConstraints;
-        if (justUnifying)
+        // A region's problem is often unchanged from the last transaction,
+        // e.g., when it is far from any moved shape, and then its solution
+        // is too.  So, reuse that rather than solve it again.
+        std::string problemKey = nudgingProblemKey(vs, cs, justUnifying,
+                baseSepDist);
+        std::vector<double> positions;
+        bool satisfied;
+        if (cache->lookup(problemKey, satisfied, positions))
         {
-            for (std::list<size_t>::iterator curr = freeIndexes.begin();
-                    curr != freeIndexes.end(); ++curr)
+            size_t index = 0;
+            for (ShiftSegmentList::iterator currSegment = currentRegion.begin();
+                    currSegment != currentRegion.end(); ++currSegment)
             {
-                for (std::list<size_t>::iterator curr2 = curr;
-                        curr2 != freeIndexes.end(); ++curr2)
-                {
-                    if (curr == curr2)
-                    {
-                        continue;
-                    }
-                    potentialConstraints.push_back(
-                            PotentialSegmentConstraint(*curr, *curr2, vs));
-                }
+                NudgingShiftSegment *segment =
+                        static_cast<NudgingShiftSegment *> (*currSegment);
+                segment->variable->finalPosition = positions[index++];
             }
         }
-#ifdef NUDGE_DEBUG
-        for (unsigned i = 0;i < vs.size(); ++i)
-        {
-            fprintf(stderr, "-vs[%d]=%f\n", i, vs[i]->desiredPosition);
-        }
-#endif
-        // Repeatedly try solving this.  There are two cases:
-        //  -  When Unifying, we greedily place as many free segments as
-        //     possible at the same positions, that way they have more
-        //     accurate nudging orders determined for them in the Nudging
-        //     stage.
-        //  -  When Nudging, if we can't fit all the segments with the
-        //     default nudging distance we try smaller separation
-        //     distances till we find a solution that is satisfied.
-        bool justAddedConstraint = false;
-        bool satisfied;
-
-        typedef std::pair<size_t, size_t> UnsatisfiedRange;
-        std::list<UnsatisfiedRange> unsatisfiedRanges;
-        do
+        else
         {
-            IncSolver f(vs, cs);
-            f.solve();
-
-            // Determine if the problem was satisfied.
-            satisfied = true;
-            for (size_t i = 0; i < vs.size(); ++i)
-            {
-                // For each variable...
-                if (vs[i]->id != freeSegmentID)
-                {
-                    // If it is a fixed segment (should stay still)...
-                    if (fabs(vs[i]->finalPosition -
-                            vs[i]->desiredPosition) > 0.0001)
-                    {
-                        // and it is not at it's desired position, then
-                        // we consider the problem to be unsatisfied.
-                        satisfied = false;
-
-                        // We record ranges of unsatisfied variables based on
-                        // the channel edges.
-                        if (vs[i]->id == channelLeftID)
-                        {
-                            // This is the left-hand-side of a channel.
-                            if (unsatisfiedRanges.empty() ||
-                                    (unsatisfiedRanges.back().first !=
-                                    unsatisfiedRanges.back().second))
-                            {
-                                // There are no existing unsatisfied ranges,
-                                // or there are but they are a valid range
-                                // (we've encountered the right-hand channel
-                                // edges already).
-                                // So, start a new unsatisfied range.
-                                unsatisfiedRanges.push_back(
-                                        std::make_pair(i, i + 1));
-                            }
-                        }
-                        else if (vs[i]->id == channelRightID)
-                        {
-                            // This is the right-hand-side of a channel.
-                            if (unsatisfiedRanges.empty())
-                            {
-                                // There are no existing unsatisfied ranges,
-                                // so start a new unsatisfied range.
-                                // We are looking at a unsatisfied right side
-                                // where the left side was satisfied, so the
-                                // range begins at the previous variable
-                                // which should be a left channel side.
-                                COLA_ASSERT(i > 0);
-                                COLA_ASSERT(vs[i - 1]->id == channelLeftID);
-                                unsatisfiedRanges.push_back(
-                                        std::make_pair(i - 1, i));
-                            }
-                            else
-                            {
-                                // Expand the existing range to include index.
-                                unsatisfiedRanges.back().second = i;
-                            }
-                        }
-                        else if (vs[i]->id == fixedSegmentID)
-                        {
-                            // Fixed connector segments can also start and
-                            // extend unsatisfied variable ranges.
-                            if (unsatisfiedRanges.empty())
-                            {
-                                // There are no existing unsatisfied ranges,
-                                // so start a new unsatisfied range.
-                                unsatisfiedRanges.push_back(
-                                        std::make_pair(i, i));
-                            }
-                            else
-                            {
-                                // Expand the existing range to include index.
-                                unsatisfiedRanges.back().second = i;
-                            }
-                        }
-                    }
-                }
-            }
-
-#ifdef NUDGE_DEBUG
-            if (!satisfied)
-            {
-                fprintf(stderr,"unsatisfied\n");
-            }
-#endif
-
-            if (justUnifying)
-            {
-                // When we're centring, we'd like to greedily place as many
-                // segments as possible at the same positions, that way they
-                // have more accurate nudging orders determined for them.
-                //
-                // We do this by taking pairs of adjoining free segments and
-                // attempting to constrain them to have the same position,
-                // starting from the closest up to the furthest.
-
-                if (justAddedConstraint)
-                {
-                    COLA_ASSERT(potentialConstraints.size() > 0);
-                    if (!satisfied)
-                    {
-                        // We couldn't satisfy the problem with the added
-                        // potential constraint, so we can't position these
-                        // segments together.  Roll back.
-                        potentialConstraints.pop_front();
-                        delete cs.back();
-                        cs.pop_back();
-                    }
-                    else
-                    {
-                        // We could position these two segments together.
-                        PotentialSegmentConstraint& pc =
-                                potentialConstraints.front();
-
-                        // Rewrite the indexes of these two variables to
-                        // one, so we need not worry about redundant
-                        // equality constraints.
-                        for (std::list<PotentialSegmentConstraint>::iterator
-                                it = potentialConstraints.begin();
-                                it != potentialConstraints.end(); ++it)
-                        {
-                            it->rewriteIndex(pc.index1, pc.index2);
-                        }
-                        potentialConstraints.pop_front();
-                    }
-                }
-                potentialConstraints.sort();
-                justAddedConstraint = false;
-
-                // Remove now invalid potential segment constraints.
-                // This could have been caused by the variable rewriting.
-                while (!potentialConstraints.empty() &&
-                       !potentialConstraints.front().stillValid())
-                {
-                    potentialConstraints.pop_front();
-                }
-
-                if (!potentialConstraints.empty())
-                {
-                    // We still have more possibilities to consider.
-                    // Create a constraint for this, add it, and mark as
-                    // unsatisfied, so the problem gets re-solved.
-                    PotentialSegmentConstraint& pc =
-                            potentialConstraints.front();
-                    COLA_ASSERT(pc.index1 != pc.index2);
-                    cs.push_back(new Constraint(vs[pc.index1], vs[pc.index2],
-                            0, true));
-                    satisfied = false;
-                    justAddedConstraint = true;
-                }
-            }
-            else
+            satisfied = solveNudgingProblem(vs, cs, freeIndexes, justUnifying,
+                    baseSepDist);
+            for (ShiftSegmentList::iterator currSegment = currentRegion.begin();
+                    currSegment != currentRegion.end(); ++currSegment)
             {
-                if (!satisfied)
-                {
-                    COLA_ASSERT(unsatisfiedRanges.size() > 0);
-                    // Reduce the separation distance.
-                    sepDist -= (baseSepDist / reductionSteps);
-#ifndef NDEBUG
-                    for (std::list<UnsatisfiedRange>::iterator it =
-                            unsatisfiedRanges.begin();
-                            it != unsatisfiedRanges.end(); ++it)
-                    {
-                        COLA_ASSERT(vs[it->first]->id != freeSegmentID);
-                        COLA_ASSERT(vs[it->second]->id != freeSegmentID);
-                    }
-#endif
-#ifdef NUDGE_DEBUG
-                    for (std::list<UnsatisfiedRange>::iterator it =
-                            unsatisfiedRanges.begin();
-                            it != unsatisfiedRanges.end(); ++it)
-                    {
-                        fprintf(stderr, "unsatisfiedVarRange(%ld, %ld)\n",
-                                it->first, it->second);
-                    }
-                    fprintf(stderr, "unsatisfied, trying %g\n", sepDist);
-#endif
-                    // And rewrite all the gap constraints to have the new
-                    // reduced separation distance.
-                    bool withinUnsatisfiedGroup = false;
-                    for (Constraints::iterator cIt = cs.begin();
-                            cIt != cs.end(); ++cIt)
-                    {
-                        UnsatisfiedRange& range = unsatisfiedRanges.front();
-                        Constraint *constraint = *cIt;
-
-                        if (constraint->left == vs[range.first])
-                        {
-                            // Entered an unsatisfied range of variables.
-                            withinUnsatisfiedGroup = true;
-                        }
-
-                        if (withinUnsatisfiedGroup && (constraint->gap > 0))
-                        {
-                            // Rewrite constraints in unsatisfied ranges
-                            // that have a non-zero gap.
-                            constraint->gap = sepDist;
-                        }
-
-                        if (constraint->right == vs[range.second])
-                        {
-                            // Left an unsatisfied range of variables.
-                            withinUnsatisfiedGroup = false;
-                            unsatisfiedRanges.pop_front();
-                            if (unsatisfiedRanges.empty())
-                            {
-                                // And there are no more unsatisfied variables.
-                                break;
-                            }
-                        }
-                    }
-                }
+                NudgingShiftSegment *segment =
+                        static_cast<NudgingShiftSegment *> (*currSegment);
+                positions.push_back(segment->variable->finalPosition);
             }
+            cache->store(problemKey, satisfied, positions);
         }
-        while (!satisfied && (sepDist > 0.0001));
 
         if (satisfied)
         {
-#ifdef NUDGE_DEBUG
-            fprintf(stderr,"satisfied at nudgeDist = %g\n", sepDist);
-#endif
             for (ShiftSegmentList::iterator currSegment = currentRegion.begin();
                     currSegment != currentRegion.end(); ++currSegment)
             {
@@ -3144,6 +3324,13 @@ void ImproveOrthogonalRoutes::simplifyOrthogonalRoutes(void)
 }
 
 
+static bool boxesTouch(const Box& a, const Box& b)
+{
+    return (a.min.x <= b.max.x) && (b.min.x <= a.max.x) &&
+            (a.min.y <= b.max.y) && (b.min.y <= a.max.y);
+}
+
+
 // Populates m_point_orders and m_shared_path_connectors_with_common_endpoints.
 void ImproveOrthogonalRoutes::buildOrthogonalNudgingOrderInfo(void)
 {
@@ -3173,6 +3360,25 @@ void ImproveOrthogonalRoutes::buildOrthogonalNudgingOrderInfo(void)
         connRoutes[ind] = connRefs[ind]->displayRoute();
     }
 
+    // Routes can only branch from, cross or share paths with each other 
+    // if their bounding boxes touch, so use these to skip distant pairs.
+    // Splitting segments adds points along existing segments, so it
+    // leaves these boxes unchanged.
+    std::vector<Box> routeBoxes(connRefs.size());
+    for (size_t ind = 0; ind < connRefs.size(); ++ind)
+    {
+        if (connRoutes[ind].empty())
+        {
+            // An empty box, which touches nothing.
+            routeBoxes[ind].min = Point(DBL_MAX, DBL_MAX);
+            routeBoxes[ind].max = Point(-DBL_MAX, -DBL_MAX);
+        }
+        else
+        {
+            routeBoxes[ind] = connRoutes[ind].offsetBoundingBox(0.0);
+        }
+    }
+
     // Do segment splitting.
     for (size_t ind1 = 0; ind1 < connRefs.size(); ++ind1)
     {
@@ -3190,7 +3396,8 @@ void ImproveOrthogonalRoutes::buildOrthogonalNudgingOrderInfo(void)
             }
 
             ConnRef *conn2 = connRefs[ind2];
-            if (conn2->routingType() != ConnType_Orthogonal)
+            if ((conn2->routingType() != ConnType_Orthogonal) ||
+                    !boxesTouch(routeBoxes[ind1], routeBoxes[ind2]))
             {
                 continue;
             }
@@ -3212,7 +3419,8 @@ void ImproveOrthogonalRoutes::buildOrthogonalNudgingOrderInfo(void)
         for (size_t ind2 = ind1 + 1; ind2 < connRefs.size(); ++ind2)
         {
             ConnRef *conn2 = connRefs[ind2];
-            if (conn2->routingType() != ConnType_Orthogonal)
+            if ((conn2->routingType() != ConnType_Orthogonal) ||
+                    !boxesTouch(routeBoxes[ind1], routeBoxes[ind2]))
             {
                 continue;
             }
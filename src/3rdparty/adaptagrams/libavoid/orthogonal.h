@@ -26,6 +26,11 @@
 #ifndef AVOID_ORTHOGONAL_H
 #define AVOID_ORTHOGONAL_H
 
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace Avoid {
 
 class Router;
@@ -34,6 +39,25 @@ extern void generateStaticOrthogonalVisGraph(Router *router);
 extern void improveOrthogonalRoutes(Router *router);
 
 
+// Solutions to the nudging problems of the last transaction, so that
+// regions with unchanged problems need not be solved again.
+class NudgingCache
+{
+    public:
+        bool lookup(const std::string& key, bool& satisfied,
+                std::vector<double>& positions);
+        void store(const std::string& key, const bool satisfied,
+                const std::vector<double>& positions);
+        void endTransaction(void);
+
+    private:
+        typedef std::map<std::string,
+                std::pair<bool, std::vector<double> > > SolutionMap;
+        SolutionMap m_current;
+        SolutionMap m_previous;
+};
+
+
 }
 
 #endif
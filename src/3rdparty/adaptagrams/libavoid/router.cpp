@@ -26,6 +26,8 @@
 #include <algorithm>
 #include <cmath>
 #include <cfloat>
+#include <map>
+#include <set>
 
 #include "libavoid/shape.h"
 #include "libavoid/router.h"
@@ -43,6 +45,220 @@
 namespace Avoid {
 
 
+// A spatial index of the routes of orthogonal connectors, kept from one
+// transaction to the next.  Each connector is entered with the boxes of its
+// route segments and with the box its route could be improved within (see
+// Router::markOrthogonalConnectorsNeedingRerouting()), on a uniform grid of
+// square cells.  Connectors whose route has changed are only marked, and
+// reentered before the next query, so that the cost of keeping the index
+// up to date is proportional to the number of connectors rerouted.
+class ConnectorRouteIndex
+{
+    public:
+        ConnectorRouteIndex()
+            : m_cell_size(0)
+        {
+        }
+
+        // The route of conn may have changed.
+        void invalidate(ConnRef *conn)
+        {
+            m_dirty.insert(conn);
+        }
+
+        // conn is being deleted.
+        void remove(ConnRef *conn)
+        {
+            m_dirty.erase(conn);
+            removeEntry(conn);
+        }
+
+        const std::set<ConnRef *>& dirty(void) const
+        {
+            return m_dirty;
+        }
+
+        // Enters conn with the given boxes, replacing any previous entry.
+        // A connector without boxes is left out of the index.
+        void update(ConnRef *conn, const std::vector<Box>& segments,
+                const Box *reach)
+        {
+            removeEntry(conn);
+            if (segments.empty() && !reach)
+            {
+                return;
+            }
+
+            if (m_cell_size == 0)
+            {
+                // Size the cells on the first connectors entered, so that
+                // a typical route covers a few of them.
+                m_cell_size = (reach) ? 
+                        std::max(reach->width(), reach->height()) : 0;
+                m_cell_size = std::max(m_cell_size / 4, 1.0);
+            }
+
+            Entry& entry = m_entries[conn];
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                insert(conn, segments[i], m_segment_cells, 
+                        entry.segment_cells, entry.large);
+            }
+            if (reach)
+            {
+                insert(conn, *reach, m_reach_cells, entry.reach_cells, 
+                        entry.large);
+            }
+            if (entry.large)
+            {
+                m_large.insert(conn);
+            }
+        }
+
+        void clearDirty(void)
+        {
+            m_dirty.clear();
+        }
+
+        // Adds the connectors with a route segment that may overlap area.
+        void querySegments(const Box& area, std::set<ConnRef *>& result) const
+        {
+            query(area, m_segment_cells, result);
+        }
+
+        // Adds the connectors whose route may be improved within area.
+        void queryReach(const Box& area, std::set<ConnRef *>& result) const
+        {
+            query(area, m_reach_cells, result);
+        }
+
+    private:
+        typedef std::pair<long, long> Cell;
+        typedef std::map<Cell, std::set<ConnRef *> > Grid;
+
+        struct Entry
+        {
+            Entry() : large(false) { }
+
+            std::vector<Cell> segment_cells;
+            std::vector<Cell> reach_cells;
+            // Entered in m_large rather than in the grid.
+            bool large;
+        };
+
+        // Boxes covering more cells than this along either side are not
+        // entered into the grid, but returned by every query.
+        static const long maxCellSpan = 64;
+
+        bool cellRange(const Box& box, long& x1, long& y1, long& x2, 
+                long& y2) const
+        {
+            const double limit = maxCellSpan * m_cell_size;
+            if (!(box.width() <= limit) || !(box.height() <= limit))
+            {
+                return false;
+            }
+            x1 = (long) std::floor(box.min.x / m_cell_size);
+            y1 = (long) std::floor(box.min.y / m_cell_size);
+            x2 = (long) std::floor(box.max.x / m_cell_size);
+            y2 = (long) std::floor(box.max.y / m_cell_size);
+            return true;
+        }
+
+        void insert(ConnRef *conn, const Box& box, Grid& grid,
+                std::vector<Cell>& cells, bool& large)
+        {
+            long x1, y1, x2, y2;
+            if (!cellRange(box, x1, y1, x2, y2))
+            {
+                large = true;
+                return;
+            }
+            for (long y = y1; y <= y2; ++y)
+            {
+                for (long x = x1; x <= x2; ++x)
+                {
+                    Cell cell(x, y);
+                    if (grid[cell].insert(conn).second)
+                    {
+                        cells.push_back(cell);
+                    }
+                }
+            }
+        }
+
+        void removeEntry(ConnRef *conn)
+        {
+            std::map<ConnRef *, Entry>::iterator found = m_entries.find(conn);
+            if (found == m_entries.end())
+            {
+                return;
+            }
+            removeCells(conn, found->second.segment_cells, m_segment_cells);
+            removeCells(conn, found->second.reach_cells, m_reach_cells);
+            m_large.erase(conn);
+            m_entries.erase(found);
+        }
+
+        static void removeCells(ConnRef *conn, const std::vector<Cell>& cells,
+                Grid& grid)
+        {
+            for (size_t i = 0; i < cells.size(); ++i)
+            {
+                Grid::iterator cell = grid.find(cells[i]);
+                cell->second.erase(conn);
+                if (cell->second.empty())
+                {
+                    grid.erase(cell);
+                }
+            }
+        }
+
+        void query(const Box& area, const Grid& grid, 
+                std::set<ConnRef *>& result) const
+        {
+            result.insert(m_large.begin(), m_large.end());
+            if (grid.empty())
+            {
+                return;
+            }
+            long x1, y1, x2, y2;
+            if (!cellRange(area, x1, y1, x2, y2) || 
+                    ((double) (x2 - x1 + 1) * (y2 - y1 + 1) > grid.size()))
+            {
+                // The area covers more cells than there are in use, so
+                // visit those instead.
+                for (Grid::const_iterator cell = grid.begin(); 
+                        cell != grid.end(); ++cell)
+                {
+                    result.insert(cell->second.begin(), cell->second.end());
+                }
+                return;
+            }
+            for (long y = y1; y <= y2; ++y)
+            {
+                for (long x = x1; x <= x2; ++x)
+                {
+                    Grid::const_iterator cell = grid.find(Cell(x, y));
+                    if (cell != grid.end())
+                    {
+                        result.insert(cell->second.begin(), 
+                                cell->second.end());
+                    }
+                }
+            }
+        }
+
+        double m_cell_size;
+        Grid m_segment_cells;
+        Grid m_reach_cells;
+        std::map<ConnRef *, Entry> m_entries;
+        std::set<ConnRef *> m_large;
+        std::set<ConnRef *> m_dirty;
+};
+
+
+
 Router::Router(const unsigned int flags)
     : visOrthogGraph(),
       PartialTime(false),
@@ -68,6 +284,8 @@ Router::Router(const unsigned int flags)
       m_static_orthogonal_graph_invalidated(true),
       m_in_crossing_rerouting_stage(false),
       m_settings_changes(false),
+      m_nudging_cache(new NudgingCache()),
+      m_route_index(new ConnectorRouteIndex()),
       m_debug_handler(nullptr)
 {
     // At least one of the Routing modes must be set.
@@ -143,6 +361,8 @@ Router::~Router()
     COLA_ASSERT(visGraph.size() == 0);
 
     delete m_topology_addon;
+    delete m_nudging_cache;
+    delete m_route_index;
 }
 
 void Router::setDebugHandler(DebugHandler *handler)
@@ -219,6 +439,24 @@ void Router::modifyConnector(ConnRef *conn)
 
 void Router::modifyConnectionPin(ShapeConnectionPin *pin)
 {
+    // Connectors attached to the pin's shape or junction may now be better
+    // routed to a different pin, so they need to be rerouted.
+    Obstacle *obstacle = (pin->m_shape) ? 
+            static_cast<Obstacle *> (pin->m_shape) : 
+            static_cast<Obstacle *> (pin->m_junction);
+    if (obstacle)
+    {
+        std::set<ConnEnd *>::iterator curr;
+        for (curr = obstacle->m_following_conns.begin(); 
+                curr != obstacle->m_following_conns.end(); ++curr)
+        {
+            if ((*curr)->m_conn_ref)
+            {
+                (*curr)->m_conn_ref->makePathInvalid();
+            }
+        }
+    }
+
     ActionInfo modInfo(ConnectionPinChange, pin);
     
     ActionInfoList::iterator found = 
@@ -470,6 +708,8 @@ void Router::processActions(void)
     m_abort_transaction = false;
 
     std::list<unsigned int> deletedObstacles;
+    std::vector<Box> freedRegions;
+    std::vector<Box> blockedRegions;
     actionList.sort();
     ActionInfoList::iterator curr;
     ActionInfoList::iterator finish = actionList.end();
@@ -493,6 +733,13 @@ void Router::processActions(void)
 
         unsigned int pid = obstacle->id();
 
+        if (m_allows_orthogonal_routing)
+        {
+            // Routes near the space this obstacle occupied may now be
+            // improved.
+            freedRegions.push_back(obstacle->routingBox());
+        }
+
         // o  Remove entries related to this shape's vertices
         obstacle->removeFromGraph();
 
@@ -595,6 +842,13 @@ void Router::processActions(void)
         }
         const Polygon& shapePoly = obstacle->routingPolygon();
 
+        if (m_allows_orthogonal_routing)
+        {
+            // Routes through the space this obstacle now occupies are
+            // no longer valid.
+            blockedRegions.push_back(obstacle->routingBox());
+        }
+
         adjustContainsWithAdd(shapePoly, pid);
 
         if (m_allows_polyline_routing)
@@ -633,6 +887,13 @@ void Router::processActions(void)
             actInf.conn()->updateEndPoint(conn->first, conn->second);
         }
     }
+
+    if (m_allows_orthogonal_routing)
+    {
+        markOrthogonalConnectorsNeedingRerouting(freedRegions, 
+                blockedRegions);
+    }
+
     // Clear the actionList.
     actionList.clear();
 }
@@ -645,6 +906,20 @@ bool Router::processTransaction(void)
     {
         return false;
     }
+
+    if (m_settings_changes)
+    {
+        // Routing parameters and options affect the cost of every 
+        // orthogonal route, so they all need to be recomputed.
+        ConnRefList::const_iterator fin = connRefs.end();
+        for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i)
+        {
+            if ((*i)->routingType() == ConnType_Orthogonal)
+            {
+                (*i)->makePathInvalid();
+            }
+        }
+    }
     m_settings_changes = false;
 
     processActions();
@@ -924,6 +1199,7 @@ void Router::attachedShapes(IntList &shapes, const unsigned int shapeId,
 void Router::rerouteAndCallbackConnectors(void)
 {
     ConnRefList reroutedConns;
+    std::list<std::pair<ConnRef *, PolyLine> > keptConns;
     ConnRefList::const_iterator fin = connRefs.end();
     
     this->m_conn_reroute_flags.alertConns();
@@ -931,9 +1207,17 @@ void Router::rerouteAndCallbackConnectors(void)
     // Updating the orthogonal visibility graph if necessary. 
     regenerateStaticBuiltGraph();
 
+    // Only free the pins of connectors that will be rerouted, since other 
+    // connectors keep their existing routes and pin assignments.
+    const bool reroutingHyperedges = (m_hyperedge_rerouter.count() > 0);
     for (ConnRefList::const_iterator i = connRefs.begin(); i != fin; ++i) 
     {
-        (*i)->freeActivePins();
+        ConnRef *connector = *i;
+        if (reroutingHyperedges || connector->m_needs_reroute_flag || 
+                connector->m_false_path)
+        {
+            connector->freeActivePins();
+        }
     }
 
     // Calculate and return connectors that are part of hyperedges and will
@@ -975,6 +1259,15 @@ void Router::rerouteAndCallbackConnectors(void)
         {
             reroutedConns.push_back(connector);
         }
+        else if (connector->routingType() == ConnType_Orthogonal)
+        {
+            // The route is still valid, but nudging starts again from the
+            // unnudged route so that the result matches a full reroute.
+            // Keep the old display route to see whether it has changed.
+            keptConns.push_back(std::make_pair(connector, 
+                    connector->m_display_route));
+            connector->m_display_route.clear();
+        }
         TIMER_STOP(this);
     }
 
@@ -1009,6 +1302,19 @@ void Router::rerouteAndCallbackConnectors(void)
         deletedConns.merge(changedHyperedgeObjs.deletedConnectorList);
     }
 
+    // Connectors that were not rerouted only need redrawing if nudging 
+    // has moved them.
+    for (std::list<std::pair<ConnRef *, PolyLine> >::iterator it = 
+            keptConns.begin(); it != keptConns.end(); ++it)
+    {
+        if ((std::find(deletedConns.begin(), deletedConns.end(), 
+                    it->first) == deletedConns.end()) &&
+                (it->first->displayRoute().ps != it->second.ps))
+        {
+            reroutedConns.push_back(it->first);
+        }
+    }
+
     // Alert connectors that they need redrawing.
     fin = reroutedConns.end();
     for (ConnRefList::const_iterator i = reroutedConns.begin(); i != fin; ++i) 
@@ -1966,6 +2272,392 @@ void Router::markPolylineConnectorsNeedingReroutingForDeletedObstacle(
 }
 
 
+// A uniform grid over a set of boxes, used to find the boxes overlapping
+// a given area without testing every one of them.
+class RegionIndex
+{
+    public:
+        RegionIndex(const std::vector<Box>& boxes)
+            : m_boxes(boxes),
+              m_cols(1),
+              m_rows(1),
+              m_cell_width(1),
+              m_cell_height(1),
+              m_stamp(0)
+        {
+            if (m_boxes.empty())
+            {
+                return;
+            }
+
+            m_bounds = m_boxes[0];
+            for (size_t i = 1; i < m_boxes.size(); ++i)
+            {
+                m_bounds.min.x = std::min(m_bounds.min.x, m_boxes[i].min.x);
+                m_bounds.min.y = std::min(m_bounds.min.y, m_boxes[i].min.y);
+                m_bounds.max.x = std::max(m_bounds.max.x, m_boxes[i].max.x);
+                m_bounds.max.y = std::max(m_bounds.max.y, m_boxes[i].max.y);
+            }
+
+            // Aim for about one box per cell.
+            size_t side = (size_t) std::ceil(std::sqrt((double) m_boxes.size()));
+            side = std::min(side, (size_t) 256);
+            if (m_bounds.width() > 0)
+            {
+                m_cols = side;
+                m_cell_width = m_bounds.width() / m_cols;
+            }
+            if (m_bounds.height() > 0)
+            {
+                m_rows = side;
+                m_cell_height = m_bounds.height() / m_rows;
+            }
+
+            m_cells.resize(m_cols * m_rows);
+            m_seen.resize(m_boxes.size(), 0);
+            for (size_t i = 0; i < m_boxes.size(); ++i)
+            {
+                const Box& box = m_boxes[i];
+                size_t x1 = col(box.min.x), x2 = col(box.max.x);
+                size_t y1 = row(box.min.y), y2 = row(box.max.y);
+                for (size_t y = y1; y <= y2; ++y)
+                {
+                    for (size_t x = x1; x <= x2; ++x)
+                    {
+                        m_cells[y * m_cols + x].push_back(i);
+                    }
+                }
+            }
+        }
+
+        const Box& bounds(void) const
+        {
+            return m_bounds;
+        }
+
+        // Collects the indexes of the boxes that may overlap area.
+        void query(const Box& area, std::vector<size_t>& result)
+        {
+            result.clear();
+            if (m_boxes.empty() || (area.max.x < m_bounds.min.x) ||
+                    (area.min.x > m_bounds.max.x) ||
+                    (area.max.y < m_bounds.min.y) ||
+                    (area.min.y > m_bounds.max.y))
+            {
+                return;
+            }
+
+            ++m_stamp;
+            size_t x1 = col(area.min.x), x2 = col(area.max.x);
+            size_t y1 = row(area.min.y), y2 = row(area.max.y);
+            for (size_t y = y1; y <= y2; ++y)
+            {
+                for (size_t x = x1; x <= x2; ++x)
+                {
+                    const std::vector<size_t>& cell = m_cells[y * m_cols + x];
+                    for (size_t j = 0; j < cell.size(); ++j)
+                    {
+                        if (m_seen[cell[j]] != m_stamp)
+                        {
+                            m_seen[cell[j]] = m_stamp;
+                            result.push_back(cell[j]);
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        size_t col(double x) const
+        {
+            double index = std::floor((x - m_bounds.min.x) / m_cell_width);
+            return (size_t) std::max(0.0, std::min(index, (double) m_cols - 1));
+        }
+
+        size_t row(double y) const
+        {
+            double index = std::floor((y - m_bounds.min.y) / m_cell_height);
+            return (size_t) std::max(0.0, std::min(index, (double) m_rows - 1));
+        }
+
+        const std::vector<Box>& m_boxes;
+        Box m_bounds;
+        size_t m_cols;
+        size_t m_rows;
+        double m_cell_width;
+        double m_cell_height;
+        std::vector<std::vector<size_t> > m_cells;
+        std::vector<unsigned int> m_seen;
+        unsigned int m_stamp;
+};
+
+
+static bool boxesOverlap(const Box& a, const Box& b)
+{
+    return (a.min.x <= b.max.x) && (b.min.x <= a.max.x) &&
+            (a.min.y <= b.max.y) && (b.min.y <= a.max.y);
+}
+
+
+// Returns the rectilinear distance between two boxes.
+static double boxDistance(const Box& a, const Box& b)
+{
+    double dx = std::max(0.0, std::max(a.min.x - b.max.x, b.min.x - a.max.x));
+    double dy = std::max(0.0, std::max(a.min.y - b.max.y, b.min.y - a.max.y));
+    return dx + dy;
+}
+
+
+static Box segmentBox(const Point& a, const Point& b)
+{
+    Box box;
+    box.min.x = std::min(a.x, b.x);
+    box.min.y = std::min(a.y, b.y);
+    box.max.x = std::max(a.x, b.x);
+    box.max.y = std::max(a.y, b.y);
+    return box;
+}
+
+
+// Returns the segment penalty charged by the path search for the turn at b,
+// or more if the turn is degenerate.
+static double bendPenalty(const Point& a, const Point& b, const Point& c,
+        const double segmt_penalty)
+{
+    double ux = b.x - a.x, uy = b.y - a.y;
+    double vx = c.x - b.x, vy = c.y - b.y;
+    double cross = (ux * vy) - (uy * vx);
+    double dot = (ux * vx) + (uy * vy);
+    if (cross == 0)
+    {
+        if (dot > 0)
+        {
+            // Straight on.
+            return 0;
+        }
+        // Doubles back, or has a zero length segment.
+        return 2 * segmt_penalty;
+    }
+    return segmt_penalty;
+}
+
+
+// Returns the area the end of a connector may be routed from.  This is the
+// whole shape for connectors attached to pins, since the route may move to
+// a different pin.
+static Box endpointRegion(Obstacle *anchor, const Point& point)
+{
+    if (anchor)
+    {
+        return anchor->routingBox();
+    }
+    return segmentBox(point, point);
+}
+
+
+void Router::connectorRouteChanged(ConnRef *conn)
+{
+    m_route_index->invalidate(conn);
+}
+
+
+void Router::connectorDeleted(ConnRef *conn)
+{
+    m_route_index->remove(conn);
+}
+
+
+// Returns an upper bound on the cost of the current route of an orthogonal
+// connector, along with the regions each of its ends may be routed from.
+double Router::orthogonalRouteCostBound(ConnRef *conn, Box& srcRegion,
+        Box& dstRegion) const
+{
+    const double segmt_penalty = routingParameter(segmentPenalty);
+    const double reverse_penalty = routingParameter(reverseDirectionPenalty);
+    const double port_penalty = routingParameter(portDirectionPenalty);
+    const PolyLine& route = conn->m_route;
+
+    std::pair<Obstacle *, Obstacle *> anchors = conn->endpointAnchors();
+    srcRegion = endpointRegion(anchors.first, route.ps.front());
+    dstRegion = endpointRegion(anchors.second, route.ps.back());
+
+    double cost = 2 * (port_penalty + segmt_penalty);
+    for (size_t i = 1; i < route.size(); ++i)
+    {
+        cost += manhattanDist(route.ps[i - 1], route.ps[i]) +
+                reverse_penalty;
+        if (i + 1 < route.size())
+        {
+            cost += bendPenalty(route.ps[i - 1], route.ps[i], 
+                    route.ps[i + 1], segmt_penalty);
+        }
+    }
+    return cost;
+}
+
+
+// Returns the box any route through a region must stay within to cost less
+// than the given bound.
+static Box reachBox(const Box& srcRegion, const Box& dstRegion, double cost)
+{
+    double slack = (cost - boxDistance(srcRegion, dstRegion)) / 2;
+
+    Box reach;
+    reach.min.x = std::min(srcRegion.min.x, dstRegion.min.x) - slack;
+    reach.min.y = std::min(srcRegion.min.y, dstRegion.min.y) - slack;
+    reach.max.x = std::max(srcRegion.max.x, dstRegion.max.x) + slack;
+    reach.max.y = std::max(srcRegion.max.y, dstRegion.max.y) + slack;
+    return reach;
+}
+
+
+// Reenters the connectors whose routes have changed into the route index.
+void Router::updateRouteIndex(void)
+{
+    const std::set<ConnRef *>& dirty = m_route_index->dirty();
+    std::vector<Box> segments;
+    for (std::set<ConnRef *>::const_iterator it = dirty.begin(); 
+            it != dirty.end(); ++it)
+    {
+        ConnRef *conn = *it;
+        const PolyLine& route = conn->m_route;
+        segments.clear();
+        if ((conn->routingType() != ConnType_Orthogonal) || route.empty())
+        {
+            m_route_index->update(conn, segments, nullptr);
+            continue;
+        }
+
+        for (size_t i = 1; i < route.size(); ++i)
+        {
+            segments.push_back(segmentBox(route.ps[i - 1], route.ps[i]));
+        }
+        Box srcRegion, dstRegion;
+        double cost = orthogonalRouteCostBound(conn, srcRegion, dstRegion);
+        Box reach = reachBox(srcRegion, dstRegion, cost);
+        m_route_index->update(conn, segments, &reach);
+    }
+    m_route_index->clearDirty();
+}
+
+
+// Orthogonal connectors are not rerouted every transaction.  Instead, after
+// obstacles have been added, moved or removed, we mark just the orthogonal
+// connectors whose routes may have changed:
+//  -  routes that pass through the space an obstacle now occupies, and
+//  -  routes that could be improved by passing through the space an
+//     obstacle used to occupy.  A route through a region costs at least
+//     the rectilinear distance from its source to the region and on to its
+//     target, so only connectors where this is less than an upper bound on
+//     the cost of their current route need to be considered.
+//
+void Router::markOrthogonalConnectorsNeedingRerouting(
+        const std::vector<Box>& freedRegions,
+        const std::vector<Box>& blockedRegions)
+{
+    if (freedRegions.empty() && blockedRegions.empty())
+    {
+        return;
+    }
+
+    // Crossing and shared path penalties depend on the other routes, and
+    // cluster crossing penalties on the whole route.  The bound below
+    // doesn't account for these, so just reroute everything when they
+    // are in use.
+    const bool rerouteAll = 
+            (routingParameter(crossingPenalty) > 0) ||
+            (routingParameter(fixedSharedPathPenalty) > 0) ||
+            (ClusteredRouting && !clusterRefs.empty() &&
+             (routingParameter(clusterCrossingPenalty) > 0));
+
+    RegionIndex freed(freedRegions);
+    RegionIndex blocked(blockedRegions);
+    std::vector<size_t> candidates;
+
+    // Only the connectors the route index finds near a changed region are
+    // examined, unless every connector is to be rerouted.
+    std::set<ConnRef *> nearby;
+    if (!rerouteAll)
+    {
+        updateRouteIndex();
+        for (size_t i = 0; i < blockedRegions.size(); ++i)
+        {
+            m_route_index->querySegments(blockedRegions[i], nearby);
+        }
+        for (size_t i = 0; i < freedRegions.size(); ++i)
+        {
+            m_route_index->queryReach(freedRegions[i], nearby);
+        }
+    }
+    ConnRefList all;
+    if (rerouteAll)
+    {
+        all = connRefs;
+    }
+    else
+    {
+        all.assign(nearby.begin(), nearby.end());
+    }
+
+    ConnRefList::const_iterator end = all.end();
+    for (ConnRefList::const_iterator it = all.begin(); it != end; ++it)
+    {
+        ConnRef *conn = *it;
+        const PolyLine& route = conn->m_route;
+
+        if (!conn->m_active || 
+                (conn->routingType() != ConnType_Orthogonal) ||
+                conn->m_needs_reroute_flag || conn->m_false_path ||
+                route.empty())
+        {
+            // Inactive, not orthogonal, already marked, or not routed yet.
+            continue;
+        }
+
+        if (rerouteAll)
+        {
+            conn->m_needs_reroute_flag = true;
+            continue;
+        }
+
+        // Check whether an obstacle now blocks the existing route.
+        bool reroute = false;
+        for (size_t i = 1; (i < route.size()) && !reroute; ++i)
+        {
+            Box segment = segmentBox(route.ps[i - 1], route.ps[i]);
+            blocked.query(segment, candidates);
+            for (size_t j = 0; (j < candidates.size()) && !reroute; ++j)
+            {
+                reroute = boxesOverlap(segment, blockedRegions[candidates[j]]);
+            }
+        }
+
+        // Check whether freed space may allow a cheaper route.  This
+        // overestimates the cost of the existing route, so that we never
+        // miss an improvement.
+        if (!reroute && !freedRegions.empty())
+        {
+            Box srcRegion, dstRegion;
+            double cost = orthogonalRouteCostBound(conn, srcRegion, dstRegion);
+            Box reach = reachBox(srcRegion, dstRegion, cost);
+
+            freed.query(reach, candidates);
+            for (size_t j = 0; (j < candidates.size()) && !reroute; ++j)
+            {
+                const Box& region = freedRegions[candidates[j]];
+                reroute = (boxDistance(srcRegion, region) + 
+                        boxDistance(region, dstRegion)) < cost;
+            }
+        }
+
+        if (reroute)
+        {
+            conn->m_needs_reroute_flag = true;
+        }
+    }
+}
+
+
 ConnType Router::validConnType(const ConnType select) const
 {
     if (select != ConnType_None)
@@ -33,6 +33,7 @@
 #include <list>
 #include <utility>
 #include <string>
+#include <vector>
 
 #include "libavoid/dllexport.h"
 #include "libavoid/connector.h"
@@ -62,6 +63,8 @@ class JunctionRef;
 class ClusterRef;
 typedef std::list<ClusterRef *> ClusterRefList;
 class Obstacle;
+class NudgingCache;
+class ConnectorRouteIndex;
 typedef std::list<Obstacle *> ObstacleList;
 class DebugHandler;
 
@@ -776,6 +779,14 @@ class AVOID_EXPORT Router {
                 const unsigned int type);
         void markPolylineConnectorsNeedingReroutingForDeletedObstacle(
                 Obstacle *obstacle);
+        void markOrthogonalConnectorsNeedingRerouting(
+                const std::vector<Box>& freedRegions,
+                const std::vector<Box>& blockedRegions);
+        double orthogonalRouteCostBound(ConnRef *conn, Box& srcRegion,
+                Box& dstRegion) const;
+        void updateRouteIndex(void);
+        void connectorRouteChanged(ConnRef *conn);
+        void connectorDeleted(ConnRef *conn);
         void generateContains(VertInf *pt);
         void printInfo(void);
         void regenerateStaticBuiltGraph(void);
@@ -828,6 +839,7 @@ class AVOID_EXPORT Router {
         friend struct HyperedgeTreeNode;
         friend class HyperedgeRerouter;
         friend class HyperedgeImprover;
+        friend class ImproveOrthogonalRoutes;
 
         unsigned int assignId(const unsigned int suggestedId);
         void addShape(ShapeRef *shape);
@@ -877,6 +889,10 @@ class AVOID_EXPORT Router {
     
         HyperedgeImprover m_hyperedge_improver;
 
+        NudgingCache *m_nudging_cache;
+
+        ConnectorRouteIndex *m_route_index;
+
         DebugHandler *m_debug_handler;
 };
 
@@ -0,0 +1,217 @@
+/*
+ * vim: ts=4 sw=4 et tw=0 wm=0
+ *
+ * libavoid - Fast, Incremental, Object-avoiding Line Router
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * See the file LICENSE.LGPL distributed with the library.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+#include "libavoid/libavoid.h"
+
+// Timing test for moving a single shape in a large orthogonal diagram.
+// Only the connectors near the moved shape should need rerouting.  The
+// final routes are checked against those from routing the same diagram
+// from scratch.  Where there are several equally good routes the two may
+// pick different ones, so it is the cost of the routes that is compared.
+
+static const int GRID = 40;
+static const int CONNECTORS = 3000;
+static const int MOVES = 3;
+static const unsigned int CENTRE = 1;
+
+static unsigned int lcg(unsigned int& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+static Avoid::Rectangle shapeRect(int index, double dx, double dy)
+{
+    double x = (index % GRID) * 80 + dx;
+    double y = (index / GRID) * 80 + dy;
+    return Avoid::Rectangle(Avoid::Point(x, y), Avoid::Point(x + 30, y + 20));
+}
+
+static std::vector<Avoid::ConnRef *> buildDiagram(Avoid::Router *router,
+        std::vector<Avoid::ShapeRef *>& shapes, int moved, double dx, double dy)
+{
+    router->setRoutingParameter(Avoid::segmentPenalty, 50);
+    router->setRoutingParameter(Avoid::shapeBufferDistance, 4);
+    router->setRoutingParameter(Avoid::idealNudgingDistance, 4);
+
+    for (int i = 0; i < GRID * GRID; ++i)
+    {
+        Avoid::Rectangle rect = (i == moved) ?
+                shapeRect(i, dx, dy) : shapeRect(i, 0, 0);
+        Avoid::ShapeRef *shape = new Avoid::ShapeRef(router, rect);
+        new Avoid::ShapeConnectionPin(shape, CENTRE,
+                Avoid::ATTACH_POS_CENTRE, Avoid::ATTACH_POS_CENTRE, true,
+                0.0, Avoid::ConnDirNone);
+        shapes.push_back(shape);
+    }
+
+    // Connect shapes to others up to three rows and columns away.
+    std::vector<Avoid::ConnRef *> conns;
+    unsigned int state = 1;
+    for (int i = 0; i < CONNECTORS; ++i)
+    {
+        int src = lcg(state) % (GRID * GRID);
+        int col = (src % GRID) + (int) (lcg(state) % 7) - 3;
+        int row = (src / GRID) + (int) (lcg(state) % 7) - 3;
+        col = (col < 0) ? 0 : ((col >= GRID) ? GRID - 1 : col);
+        row = (row < 0) ? 0 : ((row >= GRID) ? GRID - 1 : row);
+        int dst = row * GRID + col;
+        if (dst == src)
+        {
+            dst = (src + 1) % (GRID * GRID);
+        }
+        Avoid::ConnEnd srcEnd(shapes[src], CENTRE);
+        Avoid::ConnEnd dstEnd(shapes[dst], CENTRE);
+        conns.push_back(new Avoid::ConnRef(router, srcEnd, dstEnd));
+    }
+    return conns;
+}
+
+// The cost of a route as seen by the path search: its length plus a
+// penalty for each bend.
+static double routeCost(const Avoid::PolyLine& route)
+{
+    double cost = 0;
+    for (size_t i = 1; i < route.size(); ++i)
+    {
+        const Avoid::Point& a = route.ps[i - 1];
+        const Avoid::Point& b = route.ps[i];
+        cost += fabs(b.x - a.x) + fabs(b.y - a.y);
+        if ((i + 1 < route.size()) && (a.x != route.ps[i + 1].x) &&
+                (a.y != route.ps[i + 1].y))
+        {
+            cost += 50;
+        }
+    }
+    return cost;
+}
+
+static double elapsed(clock_t start)
+{
+    return (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+// A router that adds up the time spent in each phase of a transaction, as
+// reported through the progress callback.  Time between two callbacks is
+// counted towards the phase of the earlier one.
+class TimingRouter : public Avoid::Router
+{
+    public:
+        TimingRouter()
+            : Avoid::Router(Avoid::OrthogonalRouting)
+        {
+            reset();
+        }
+
+        void reset(void)
+        {
+            for (int i = 0; i <= Avoid::TransactionPhaseCompleted; ++i)
+            {
+                phaseTime[i] = 0;
+            }
+            lastPhase = 0;
+            lastTime = 0;
+        }
+
+        bool shouldContinueTransactionWithProgress(unsigned int elapsedTime,
+                unsigned int phaseNumber, unsigned int totalPhases,
+                double proportion)
+        {
+            (void) totalPhases;
+            (void) proportion;
+
+            phaseTime[lastPhase] += elapsedTime - lastTime;
+            lastPhase = phaseNumber;
+            lastTime = elapsedTime;
+            return true;
+        }
+
+        void print(void) const
+        {
+            printf("    visibility graph %u ms, route search %u ms, "
+                    "nudging %u ms\n",
+                    phaseTime[Avoid::TransactionPhaseOrthogonalVisibilityGraphScanX] +
+                    phaseTime[Avoid::TransactionPhaseOrthogonalVisibilityGraphScanY],
+                    phaseTime[Avoid::TransactionPhaseRouteSearch] +
+                    phaseTime[Avoid::TransactionPhaseCrossingDetection] +
+                    phaseTime[Avoid::TransactionPhaseRerouteSearch],
+                    phaseTime[Avoid::TransactionPhaseOrthogonalNudgingX] +
+                    phaseTime[Avoid::TransactionPhaseOrthogonalNudgingY]);
+        }
+
+    private:
+        unsigned int phaseTime[Avoid::TransactionPhaseCompleted + 1];
+        unsigned int lastPhase;
+        unsigned int lastTime;
+};
+
+int main(void)
+{
+    const int moved = (GRID / 2) * GRID + (GRID / 2);
+
+    TimingRouter *router = new TimingRouter();
+    std::vector<Avoid::ShapeRef *> shapes;
+    std::vector<Avoid::ConnRef *> conns =
+            buildDiagram(router, shapes, moved, 0, 0);
+
+    clock_t start = clock();
+    router->processTransaction();
+    printf("initial routing: %.1f ms\n", elapsed(start));
+    router->print();
+
+    double total = 0;
+    for (int i = 1; i <= MOVES; ++i)
+    {
+        router->moveShape(shapes[moved], 7, 5);
+        router->reset();
+        start = clock();
+        router->processTransaction();
+        double time = elapsed(start);
+        total += time;
+        printf("move %d: %.1f ms\n", i, time);
+        router->print();
+    }
+    printf("mean move: %.1f ms\n", total / MOVES);
+    router->outputDiagram("output/incrementalMove01");
+
+    // Route the final layout from scratch and compare.
+    Avoid::Router *reference = new Avoid::Router(Avoid::OrthogonalRouting);
+    std::vector<Avoid::ShapeRef *> referenceShapes;
+    std::vector<Avoid::ConnRef *> referenceConns = buildDiagram(reference,
+            referenceShapes, moved, 7 * MOVES, 5 * MOVES);
+    reference->processTransaction();
+
+    int differences = 0;
+    for (size_t i = 0; i < conns.size(); ++i)
+    {
+        if (fabs(routeCost(conns[i]->route()) - 
+                routeCost(referenceConns[i]->route())) > 0.001)
+        {
+            ++differences;
+        }
+    }
+    printf("routes costing more than after a full reroute: %d\n", differences);
+
+    delete reference;
+    delete router;
+    return (differences == 0) ? 0 : 1;
+}
@@ -20,6 +20,7 @@
 #include "2geom/line.h"
 
 #include "conn-avoid-ref.h"
+#include "conn-router.h"
 #include "desktop.h"
 #include "document-undo.h"
 #include "document.h"
@@ -65,6 +66,7 @@ SPAvoidRef::~SPAvoidRef()
 
     if (shapeRef && router) {
         router->deleteShape(shapeRef);
+        item->document->getConnRouter().markChanged();
     }
     shapeRef = nullptr;
 }
@@ -119,12 +121,14 @@ void SPAvoidRef::handleSettingChange()
             GQuark itemID = g_quark_from_string(id);
 
             shapeRef = new Avoid::ShapeRef(router, poly, itemID);
+            item->document->getConnRouter().markChanged();
         }
     }
     else if (shapeRef)
     {
         router->deleteShape(shapeRef);
         shapeRef = nullptr;
+        item->document->getConnRouter().markChanged();
     }
 }
 
@@ -359,10 +363,12 @@ void avoid_item_move(Geom::Affine const */*mp*/, SPItem *moved_item)
     Avoid::ShapeRef *shapeRef = moved_item->getAvoidRef().shapeRef;
     g_assert(shapeRef);
 
-    Router *router = moved_item->document->getRouter();
     Avoid::Polygon poly = avoid_item_poly(moved_item);
     if (!poly.empty()) {
-        router->moveShape(shapeRef, poly);
+        // Called for every step of a drag; don't wait for background routing.
+        moved_item->document->getConnRouter().edit([shapeRef, poly] (Router &router) {
+            router.moveShape(shapeRef, poly);
+        });
     }
 }
 
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** \file
+ * Connector routing off the main thread.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "conn-router.h"
+
+#include <tuple>
+#include <utility>
+
+#include "3rdparty/adaptagrams/libavoid/router.h"
+#include "object/sp-conn-end.h"
+
+namespace Inkscape {
+
+namespace {
+
+/// Set on the worker threads of ConnRouter.
+thread_local bool in_background = false;
+
+} // namespace
+
+ConnRouter::ConnRouter(std::unique_ptr<Avoid::Router> router)
+    : _router(std::move(router))
+{
+    std::tie(_source, _dest) = Async::Channel::create();
+}
+
+ConnRouter::~ConnRouter()
+{
+    _dest.close();
+    if (_worker.joinable()) {
+        {
+            auto lock = std::lock_guard(_mutex);
+            _quit = true;
+        }
+        _cond.notify_all();
+        _worker.join();
+    }
+}
+
+Avoid::Router *ConnRouter::get()
+{
+    _wait();
+    return _router.get();
+}
+
+void ConnRouter::wait()
+{
+    _wait();
+}
+
+void ConnRouter::markChanged()
+{
+    _pending = true;
+}
+
+void ConnRouter::edit(std::function<void(Avoid::Router &)> change)
+{
+    _pending = true;
+    if (busy()) {
+        _queued.push_back(std::move(change));
+        _stale = true;
+    } else {
+        change(*_router);
+    }
+}
+
+void ConnRouter::routeInBackground()
+{
+    auto lock = std::lock_guard(_mutex);
+    if (_busy || !_pending) {
+        // Anything queued meanwhile makes the running transaction stale, and
+        // collect() starts another one.
+        return;
+    }
+
+    if (!_worker.joinable()) {
+        _worker = std::thread([this] { _run(); });
+    }
+    _pending = false;
+    _stale = false;
+    _busy = true;
+    _requested = true;
+    _cond.notify_all();
+}
+
+void ConnRouter::route()
+{
+    _wait();
+    {
+        // The routes of a transaction the worker has finished are redrawn below with the others.
+        auto lock = std::lock_guard(_mutex);
+        _finished = false;
+    }
+    _pending = false;
+    _stale = false;
+    _router->processTransaction();
+    _redraw();
+}
+
+void ConnRouter::collect()
+{
+    bool finished;
+    {
+        auto lock = std::lock_guard(_mutex);
+        if (_busy) {
+            return;
+        }
+        finished = std::exchange(_finished, false);
+    }
+    _wait(); // Only applies the queued edits, as the worker is idle.
+
+    if (finished && !_stale) {
+        _redraw();
+    }
+    if (_pending || _stale) {
+        // The user has moved on; route the latest state instead of showing a stale one.
+        routeInBackground();
+    }
+}
+
+bool ConnRouter::busy() const
+{
+    auto lock = std::lock_guard(_mutex);
+    return _busy;
+}
+
+bool ConnRouter::deferRedraw(SPPath *path)
+{
+    if (!in_background) {
+        return false;
+    }
+    auto lock = std::lock_guard(_mutex);
+    _rerouted.insert(path);
+    return true;
+}
+
+void ConnRouter::forget(SPPath *path)
+{
+    auto lock = std::lock_guard(_mutex);
+    _rerouted.erase(path);
+}
+
+void ConnRouter::_run()
+{
+    in_background = true;
+    auto lock = std::unique_lock(_mutex);
+    while (true) {
+        _cond.wait(lock, [this] { return _requested || _quit; });
+        if (_quit) {
+            return;
+        }
+        _requested = false;
+
+        lock.unlock();
+        _router->processTransaction();
+        lock.lock();
+
+        _busy = false;
+        _finished = true;
+        _cond.notify_all();
+        _source.run([this] { collect(); });
+    }
+}
+
+void ConnRouter::_wait()
+{
+    {
+        auto lock = std::unique_lock(_mutex);
+        _cond.wait(lock, [this] { return !_busy; });
+    }
+    for (auto &change : _queued) {
+        change(*_router);
+    }
+    _queued.clear();
+}
+
+void ConnRouter::_redraw()
+{
+    std::unordered_set<SPPath *> rerouted;
+    {
+        auto lock = std::lock_guard(_mutex);
+        std::swap(rerouted, _rerouted);
+    }
+    for (auto path : rerouted) {
+        sp_conn_redraw_path(path);
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** \file
+ * Connector routing off the main thread.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_CONN_ROUTER_H
+#define SEEN_CONN_ROUTER_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "async/channel.h"
+
+class SPPath;
+namespace Avoid { class Router; }
+
+namespace Inkscape {
+
+/**
+ * Owns a document's libavoid router and routes connectors on a worker thread.
+ *
+ * Each router has a single long-lived worker, started the first time routing is requested.
+ * libavoid is not thread-safe, so while the worker runs a transaction the main thread must not
+ * touch the router. The frequent changes made during a drag (shapes moving, connector ends
+ * following them) are therefore queued with edit() and handed to the router once it is idle
+ * again. Everything else goes through get(), which waits for the worker.
+ *
+ * Only the idle rerouting handler routes in the background. Connectors rerouted on the worker
+ * keep their last drawn route until collect() finds the transaction finished. If newer edits
+ * were queued in the meantime, the result is stale: it is not shown, and routing starts again
+ * with the new edits. Document updates call route() instead, which routes on the main thread,
+ * so that exports, undo steps and anything else reading geometry after an update see the final
+ * routes.
+ */
+class ConnRouter
+{
+public:
+    explicit ConnRouter(std::unique_ptr<Avoid::Router> router);
+    ~ConnRouter();
+    ConnRouter(ConnRouter const &) = delete;
+    ConnRouter &operator=(ConnRouter const &) = delete;
+
+    /// Wait for the worker and apply queued edits, then give direct access to the router.
+    Avoid::Router *get();
+
+    /// Wait for the worker and apply queued edits.
+    void wait();
+
+    /// Note a change made through get() that needs rerouting.
+    void markChanged();
+
+    /// Apply a change to the router, or queue it if the worker is busy with it.
+    void edit(std::function<void(Avoid::Router &)> change);
+
+    /// Hand pending changes to the worker; the routes are applied by collect() once it finishes.
+    void routeInBackground();
+
+    /// Wait for the worker, then route on this thread and redraw every rerouted connector.
+    void route();
+
+    /**
+     * Redraw the connectors rerouted by a finished transaction, and hand any changes made since
+     * to the worker. Does nothing while the worker is busy.
+     */
+    void collect();
+
+    /// Whether the worker is running a transaction.
+    bool busy() const;
+
+    /**
+     * Called from the libavoid callback of a rerouted connector.
+     * @return true if the redraw has been postponed until collect() takes the results.
+     */
+    bool deferRedraw(SPPath *path);
+
+    /// Drop a connector that is going away from the postponed redraws.
+    void forget(SPPath *path);
+
+private:
+    void _run();
+    void _wait();
+    void _redraw();
+
+    std::unique_ptr<Avoid::Router> _router;
+    std::thread _worker;
+    Async::Channel::Source _source;
+    Async::Channel::Dest _dest;
+
+    // Only used on the main thread.
+    bool _pending = false; ///< The router has changes no transaction has seen yet.
+    bool _stale = false;   ///< Edits arrived after the running transaction started.
+    std::vector<std::function<void(Avoid::Router &)>> _queued;
+
+    mutable std::mutex _mutex; ///< Guards the members below, shared with the worker.
+    std::condition_variable _cond;
+    bool _requested = false; ///< The worker should start a transaction.
+    bool _busy = false;      ///< A transaction has been requested and has not finished yet.
+    bool _finished = false;  ///< A transaction has finished and its results not been taken.
+    bool _quit = false;      ///< The worker should exit.
+    std::unordered_set<SPPath *> _rerouted;
+};
+
+} // namespace Inkscape
+
+#endif // SEEN_CONN_ROUTER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -19,7 +19,10 @@
 #include <2geom/point.h>
 #include <2geom/sbasis-to-bezier.h>
 #include <2geom/transforms.h>
+#include <array>
+#include <cmath>
 #include <atomic>
+#include <functional>
 #include <boost/algorithm/string.hpp>
 #include <boost/operators.hpp>
 #include <boost/optional/optional.hpp>
@@ -973,6 +976,18 @@ void set_num_filter_threads(int n)
     num_filter_threads.store(n, std::memory_order_relaxed);
 }
 
+static std::atomic<bool> precise_linear_rgb = false;
+
+bool get_precise_linear_rgb()
+{
+    return precise_linear_rgb.load(std::memory_order_relaxed);
+}
+
+void set_precise_linear_rgb(bool precise)
+{
+    precise_linear_rgb.store(precise, std::memory_order_relaxed);
+}
+
 SPColorInterpolation
 get_cairo_surface_ci(cairo_surface_t *surface) {
     void* data = cairo_surface_get_user_data( surface, &ink_color_interpolation_key );
@@ -1336,7 +1351,9 @@ void ink_cairo_surface_average_color_premul(cairo_surface_t *surface, double &r,
     a = CLAMP(a, 0.0, 1.0);
 }
 
-static guint32 srgb_to_linear( const guint32 c, const guint32 a ) {
+/* The result is truncated unless 'precise' is set, in which case it is rounded. Truncating in both
+ * directions darkens every round trip (white comes back as 254) and merges neighbouring dark shades. */
+static guint32 srgb_to_linear( const guint32 c, const guint32 a, bool precise ) {
 
     const guint32 c1 = unpremul_alpha( c, a );
 
@@ -1349,12 +1366,12 @@ static guint32 srgb_to_linear( const guint32 c, const guint32 a ) {
     }
     cc *= 255.0;
 
-    const guint32 c2 = (int)cc;
+    const guint32 c2 = precise ? std::lround(cc) : (int)cc;
 
     return premul_alpha( c2, a );
 }
 
-static guint32 linear_to_srgb( const guint32 c, const guint32 a ) {
+static guint32 linear_to_srgb( const guint32 c, const guint32 a, bool precise ) {
 
     const guint32 c1 = unpremul_alpha( c, a );
 
@@ -1367,22 +1384,43 @@ static guint32 linear_to_srgb( const guint32 c, const guint32 a ) {
     }
     cc *= 255.0;
 
-    const guint32 c2 = (int)cc;
+    const guint32 c2 = precise ? std::lround(cc) : (int)cc;
 
     return premul_alpha( c2, a );
 }
 
-static uint32_t srgb_to_linear_argb32(uint32_t in)
+/**
+ * Lookup table of a conversion of premultiplied channels, indexed by alpha * 256 + channel.
+ * The values are exactly those of the per-channel functions, without their division and pow().
+ * Called on a pixel, converts its color channels.
+ */
+class ConversionTable
 {
-    EXTRACT_ARGB32(in, a, r, g, b);
-    if (a != 0) {
-        r = srgb_to_linear(r, a);
-        g = srgb_to_linear(g, a);
-        b = srgb_to_linear(b, a);
+public:
+    ConversionTable(guint32 (*convert)(guint32, guint32, bool), bool precise)
+    {
+        for (guint32 a = 1; a < 256; a++) {
+            for (guint32 c = 0; c < 256; c++) {
+                _table[a * 256 + c] = convert(c, a, precise);
+            }
+        }
     }
-    ASSEMBLE_ARGB32(out, a, r, g, b);
-    return out;
-}
+
+    guint32 operator()(guint32 in) const
+    {
+        EXTRACT_ARGB32(in, a, r, g, b);
+        if (a != 0) {
+            r = _table[a * 256 + r];
+            g = _table[a * 256 + g];
+            b = _table[a * 256 + b];
+        }
+        ASSEMBLE_ARGB32(out, a, r, g, b);
+        return out;
+    }
+
+private:
+    std::array<guint8, 256 * 256> _table{};
+};
 
 int ink_cairo_surface_srgb_to_linear(cairo_surface_t *surface)
 {
@@ -1390,23 +1428,14 @@ int ink_cairo_surface_srgb_to_linear(cairo_surface_t *surface)
     int width = cairo_image_surface_get_width(surface);
     int height = cairo_image_surface_get_height(surface);
 
-    ink_cairo_surface_filter(surface, surface, srgb_to_linear_argb32);
+    // Built on first use; the pixel loop only reads it.
+    static ConversionTable const table(srgb_to_linear, false);
+    static ConversionTable const precise_table(srgb_to_linear, true);
+    ink_cairo_surface_filter(surface, surface, std::cref(get_precise_linear_rgb() ? precise_table : table));
 
     return width * height;
 }
 
-static uint32_t linear_to_srgb_argb32(uint32_t in)
-{
-    EXTRACT_ARGB32(in, a, r, g, b);
-    if (a != 0) {
-        r = linear_to_srgb(r, a);
-        g = linear_to_srgb(g, a);
-        b = linear_to_srgb(b, a);
-    }
-    ASSEMBLE_ARGB32(out, a, r, g, b);
-    return out;
-}
-
 SPBlendMode ink_cairo_operator_to_css_blend(cairo_operator_t cairo_operator)
 {
     // All of the blend modes are implemented in Cairo as of 1.10.
@@ -1502,7 +1531,9 @@ int ink_cairo_surface_linear_to_srgb(cairo_surface_t *surface)
     int width = cairo_image_surface_get_width(surface);
     int height = cairo_image_surface_get_height(surface);
 
-    ink_cairo_surface_filter(surface, surface, linear_to_srgb_argb32);
+    static ConversionTable const table(linear_to_srgb, false);
+    static ConversionTable const precise_table(linear_to_srgb, true);
+    ink_cairo_surface_filter(surface, surface, std::cref(get_precise_linear_rgb() ? precise_table : table));
 
     return width * height;
 }
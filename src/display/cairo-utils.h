@@ -93,6 +93,10 @@ public:
 int  get_num_filter_threads();
 void set_num_filter_threads(int);
 
+// Atomic accessors to global variable selecting rounded rather than truncated sRGB/linearRGB conversions.
+bool get_precise_linear_rgb();
+void set_precise_linear_rgb(bool);
+
 SPColorInterpolation get_cairo_surface_ci(cairo_surface_t *surface);
 void set_cairo_surface_ci(cairo_surface_t *surface, SPColorInterpolation cif);
 void copy_cairo_surface_ci(cairo_surface_t *in, cairo_surface_t *out);
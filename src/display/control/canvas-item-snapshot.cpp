@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * A class to display a pre-rendered bitmap of part of the drawing under an arbitrary transform.
+ */
+
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "canvas-item-snapshot.h"
+
+#include <2geom/transforms.h>
+
+#include "display/cairo-utils.h"
+
+namespace Inkscape {
+
+/**
+ * Create a snapshot item. The surface holds the pixels of 'area', which is given in canvas units
+ * for the desktop to canvas affine 'world_affine' in effect when the snapshot was rendered.
+ */
+CanvasItemSnapshot::CanvasItemSnapshot(CanvasItemGroup *group, Cairo::RefPtr<Cairo::ImageSurface> surface,
+                                       Geom::IntRect const &area, Geom::Affine const &world_affine)
+    : CanvasItem(group)
+    , _surface(std::move(surface))
+    , _area(area)
+    , _world_affine(world_affine)
+{
+    _name = "CanvasItemSnapshot";
+    request_update();
+}
+
+/**
+ * Set the transform to apply to the snapshot, in desktop coordinates.
+ */
+void CanvasItemSnapshot::set_transform(Geom::Affine const &transform)
+{
+    defer([=, this] {
+        if (_transform == transform) return;
+        _transform = transform;
+        request_update();
+    });
+}
+
+/**
+ * Map snapshot pixels to current canvas coordinates.
+ */
+Geom::Affine CanvasItemSnapshot::_pixels_to_world() const
+{
+    return Geom::Translate(_area.min()) * _world_affine.inverse() * _transform * affine();
+}
+
+void CanvasItemSnapshot::_update(bool)
+{
+    // Queue redraw of old area (erase previous content).
+    request_redraw();
+
+    _bounds = Geom::Rect(Geom::Point(0, 0), Geom::Point(_area.dimensions())) * _pixels_to_world();
+    _bounds->expandBy(1); // Room for smoothing at the edges.
+
+    // Queue redraw of new area.
+    request_redraw();
+}
+
+void CanvasItemSnapshot::_render(Inkscape::CanvasItemBuffer &buf) const
+{
+    if (!_surface) {
+        return;
+    }
+
+    buf.cr->save();
+    buf.cr->translate(-buf.rect.left(), -buf.rect.top());
+    buf.cr->transform(geom_to_cairo(_pixels_to_world()));
+    buf.cr->set_source(_surface, 0, 0);
+    // Nearest-neighbour is good enough for a pure translation; anything else needs smoothing.
+    cairo_pattern_set_filter(cairo_get_source(buf.cr->cobj()), _transform.isTranslation() ? CAIRO_FILTER_FAST : CAIRO_FILTER_GOOD);
+    buf.cr->paint();
+    buf.cr->restore();
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
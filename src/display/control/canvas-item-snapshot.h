@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#ifndef SEEN_CANVAS_ITEM_SNAPSHOT_H
+#define SEEN_CANVAS_ITEM_SNAPSHOT_H
+
+/**
+ * A class to display a pre-rendered bitmap of part of the drawing under an arbitrary transform.
+ * Used as a cheap stand-in for large selections while they are being dragged.
+ */
+
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <2geom/affine.h>
+#include <2geom/rect.h>
+#include <cairomm/surface.h>
+
+#include "canvas-item.h"
+
+namespace Inkscape {
+
+class CanvasItemSnapshot final : public CanvasItem
+{
+public:
+    CanvasItemSnapshot(CanvasItemGroup *group, Cairo::RefPtr<Cairo::ImageSurface> surface,
+                       Geom::IntRect const &area, Geom::Affine const &world_affine);
+
+    // Geometry
+    void set_transform(Geom::Affine const &transform);
+
+    // Selection
+    bool contains(Geom::Point const &p, double tolerance = 0) override { return false; }
+
+protected:
+    ~CanvasItemSnapshot() override = default;
+
+    void _update(bool propagate) override;
+    void _render(Inkscape::CanvasItemBuffer &buf) const override;
+
+    Geom::Affine _pixels_to_world() const;
+
+    Cairo::RefPtr<Cairo::ImageSurface> _surface;
+    Geom::IntRect _area;         ///< Area covered by the snapshot, in canvas units at the time it was taken.
+    Geom::Affine _world_affine;  ///< Desktop to canvas affine at the time the snapshot was taken.
+    Geom::Affine _transform;     ///< Additional transform in desktop coordinates.
+};
+
+} // namespace Inkscape
+
+#endif // SEEN_CANVAS_ITEM_SNAPSHOT_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
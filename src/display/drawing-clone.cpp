@@ -0,0 +1,328 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Drawing subtrees shared between clones.
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "drawing-clone.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "drawing-context.h"
+#include "drawing-surface.h"
+#include "drawing.h"
+#include "initlock.h"
+
+namespace Inkscape {
+
+/// The subtree rendered once for the clones displaying it under the same transform.
+struct DrawingCloneSource::Raster
+{
+    Raster(Geom::IntRect const &area, int device_scale)
+        : surface(area, device_scale)
+        , device_scale(device_scale)
+        , size(std::size_t(area.area()) * 4 * device_scale * device_scale)
+    {}
+
+    DrawingSurface surface;
+    Geom::Affine transform; ///< From the user space of the subtree to display pixels.
+    int device_scale;
+    unsigned flags = 0;
+    std::optional<Antialiasing> antialiasing;
+    bool dithering = false;
+    std::uint32_t outline_color = 0;
+    std::size_t size;
+    InitLock rendered; ///< Rendered once, by the first clone to use it, without holding the table.
+};
+
+// Rasters per source, enough for every quarter pixel offset at one scale.
+static constexpr std::size_t MAX_RASTERS = 16;
+
+DrawingCloneSource::DrawingCloneSource(Drawing &drawing)
+    : DrawingGroup(drawing)
+{
+}
+
+DrawingCloneSource::~DrawingCloneSource()
+{
+    _dropRasters();
+    for (auto clone : _clones) {
+        clone->_source = nullptr;
+    }
+}
+
+void DrawingCloneSource::setCacheRasters(bool enabled)
+{
+    _cache_rasters = enabled;
+    if (!enabled) {
+        _dropRasters();
+    }
+}
+
+/// Called instead of propagating to a parent, which a shared subtree does not have.
+void DrawingCloneSource::_markClonesForUpdate(unsigned flags, bool content)
+{
+    _dropRasters();
+    for (auto clone : _clones) {
+        clone->_markForRendering(content);
+        clone->_markForUpdate(flags, false, content);
+    }
+}
+
+void DrawingCloneSource::_markClonesForRendering(bool content)
+{
+    _dropRasters();
+    if (_updating) {
+        return;
+    }
+    for (auto clone : _clones) {
+        clone->_markForRendering(content);
+    }
+}
+
+/**
+ * Get the raster of the subtree under a transform, rendering it if there is none yet.
+ *
+ * Rasters are only kept while there are several clones to share them, and they take at most a
+ * quarter of the cache budget of the drawing together; the oldest ones of this source make room
+ * for new ones. A raster is only rendered for a transform asked for before, since markers
+ * oriented along a path are mostly drawn under transforms of their own.
+ */
+std::shared_ptr<DrawingCloneSource::Raster> DrawingCloneSource::_raster(Geom::Affine const &transform, int device_scale, RenderContext &rc, unsigned flags)
+{
+    auto const budget = _drawing._cache_budget;
+    if (!_cache_rasters || !budget || rc.subset || _clones.size() < 2 || !_drawbox) {
+        return {};
+    }
+
+    auto raster = _findRaster(transform, device_scale, rc, flags);
+    if (raster) {
+        raster->rendered.init([&] {
+            auto dc = DrawingContext(raster->surface);
+            dc.transform(transform);
+            render(dc, rc, (raster->surface.area() * transform.inverse()).roundOutwards(), flags);
+        });
+    }
+    return raster;
+}
+
+/// Look up or make room for the raster of the subtree under a transform, which may be yet to render.
+std::shared_ptr<DrawingCloneSource::Raster> DrawingCloneSource::_findRaster(Geom::Affine const &transform, int device_scale, RenderContext &rc, unsigned flags)
+{
+    auto const budget = _drawing._cache_budget;
+    std::lock_guard lock(_rasters_mutex);
+
+    for (auto const &raster : _rasters) {
+        if (raster->device_scale == device_scale && raster->flags == flags &&
+            raster->antialiasing == rc.antialiasing_override && raster->dithering == rc.dithering &&
+            raster->outline_color == rc.outline_color && Geom::are_near(raster->transform, transform, 1e-9))
+        {
+            return raster;
+        }
+    }
+
+    auto request = std::find_if(_raster_requests.begin(), _raster_requests.end(), [&] (Geom::Affine const &t) {
+        return Geom::are_near(t, transform, 1e-9);
+    });
+    if (request == _raster_requests.end()) {
+        if (_raster_requests.size() >= MAX_RASTERS) {
+            _raster_requests.erase(_raster_requests.begin());
+        }
+        _raster_requests.push_back(transform);
+        return {};
+    }
+    _raster_requests.erase(request);
+
+    auto area = (Geom::Rect(*_drawbox) * transform).roundOutwards();
+    area.expandBy(1); // for hairlines, as in DrawingClone::_updateItem()
+    auto const size = std::size_t(area.area()) * 4 * device_scale * device_scale;
+    if (size > budget / 64) {
+        return {};
+    }
+
+    auto &used = _drawing._clone_rasters_size;
+    while (!_rasters.empty() && (_rasters.size() >= MAX_RASTERS || used + size > budget / 4)) {
+        used -= _rasters.front()->size;
+        _rasters.erase(_rasters.begin());
+    }
+    if (used + size > budget / 4) {
+        return {};
+    }
+
+    auto raster = std::make_shared<Raster>(area, device_scale);
+    raster->transform = transform;
+    raster->flags = flags;
+    raster->antialiasing = rc.antialiasing_override;
+    raster->dithering = rc.dithering;
+    raster->outline_color = rc.outline_color;
+
+    used += raster->size;
+    _rasters.push_back(raster);
+    return raster;
+}
+
+void DrawingCloneSource::_dropRasters()
+{
+    std::lock_guard lock(_rasters_mutex);
+    for (auto const &raster : _rasters) {
+        _drawing._clone_rasters_size -= raster->size;
+    }
+    _rasters.clear();
+    _raster_requests.clear();
+}
+
+DrawingClone::DrawingClone(Drawing &drawing)
+    : DrawingItem(drawing)
+{
+}
+
+DrawingClone::~DrawingClone()
+{
+    _detach();
+}
+
+void DrawingClone::setSource(DrawingCloneSource *source)
+{
+    defer([=, this] {
+        if (source == _source) return;
+        _markForRendering();
+        _detach();
+        _source = source;
+        if (_source) {
+            _source->_clones.push_back(this);
+        }
+        _markForUpdate(STATE_ALL, false);
+    });
+}
+
+void DrawingClone::setChildrenStyle(SPStyle const *context_style)
+{
+    DrawingItem::setChildrenStyle(context_style);
+    // The clones are all in the same context, so one of them is enough.
+    if (_source && _source->_context_from_clones && _source->_clones.front() == this) {
+        _source->setChildrenStyle(context_style);
+    }
+}
+
+void DrawingClone::_detach()
+{
+    if (_source) {
+        auto &clones = _source->_clones;
+        clones.erase(std::find(clones.begin(), clones.end(), this));
+        _source = nullptr;
+    }
+}
+
+unsigned DrawingClone::_updateItem(Geom::IntRect const &/*area*/, UpdateContext const &ctx, unsigned flags, unsigned /*reset*/)
+{
+    _bbox = {};
+    if (!_source) {
+        return STATE_ALL;
+    }
+
+    // The first clone to get here brings the shared subtree up to date; for the others this is
+    // a no-op. Transform changes of this clone do not concern the subtree.
+    UpdateContext source_ctx;
+    source_ctx.shared = true;
+    _source->_updating = true;
+    _source->update(Geom::IntRect::infinite(), source_ctx, flags);
+    _source->_updating = false;
+
+    bool const outline = _drawing.renderMode() == RenderMode::OUTLINE || _drawing.outlineOverlay();
+    if (auto box = outline ? _source->bbox() : _source->drawbox()) {
+        // The shared bounding box is rounded to whole user units, so it is already generous;
+        // one more pixel covers hairlines, which are a pixel wide whatever the transform.
+        auto rect = (Geom::Rect(*box) * ctx.ctm).roundOutwards();
+        rect.expandBy(1);
+        _bbox = rect;
+    }
+    _update_complexity += _source->getUpdateComplexity();
+
+    return STATE_ALL;
+}
+
+/// Convert an area in display pixels to the user space of the shared subtree.
+Geom::OptIntRect DrawingClone::_sourceArea(Geom::IntRect const &area) const
+{
+    if (!_source || _ctm.isSingular(1e-18)) {
+        return {};
+    }
+    return (Geom::Rect(area) * _ctm.inverse()).roundOutwards();
+}
+
+unsigned DrawingClone::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const
+{
+    auto source_area = _sourceArea(area);
+    if (!source_area) {
+        return RENDER_OK;
+    }
+
+    if (!stop_at) {
+        // Render from the raster for this transform, with the translation rounded to a quarter
+        // of a pixel and the whole pixels taken out, so that clones only moved by whole pixels
+        // relative to each other share it.
+        auto const quarters = Geom::Point(std::round(_ctm[4] * 4), std::round(_ctm[5] * 4)) / 4;
+        auto const whole = Geom::Point(std::floor(quarters.x()), std::floor(quarters.y()));
+        auto transform = _ctm;
+        transform.setTranslation(quarters - whole);
+
+        if (auto raster = _source->_raster(transform, dc.surface()->device_scale(), rc, flags)) {
+            Inkscape::DrawingContext::Save save(dc);
+            dc.rectangle(area);
+            dc.translate(whole);
+            dc.setSource(&raster->surface);
+            dc.fill();
+            return RENDER_OK;
+        }
+    }
+
+    Inkscape::DrawingContext::Save save(dc);
+    dc.transform(_ctm);
+    return _source->render(dc, rc, *source_area, flags, stop_at);
+}
+
+void DrawingClone::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area) const
+{
+    auto source_area = _sourceArea(area);
+    if (!source_area) {
+        return;
+    }
+
+    Inkscape::DrawingContext::Save save(dc);
+    dc.transform(_ctm);
+    _source->clip(dc, rc, *source_area);
+}
+
+DrawingItem *DrawingClone::_pickItem(Geom::Point const &p, double delta, unsigned flags)
+{
+    if (!_source || _ctm.isSingular(1e-18)) {
+        return nullptr;
+    }
+
+    // Pick in the user space of the shared subtree, with the tolerance scaled to match. Outlines
+    // are half a display pixel wide whatever the transform, so the outermost clone adds that
+    // width to the tolerance before scaling it, and the shared shapes leave it out.
+    if ((flags & PICK_OUTLINE) && !(flags & PICK_SHARED)) {
+        delta += 0.5;
+    }
+    double const scale = _ctm.descrim();
+    auto picked = _source->pick(p * _ctm.inverse(), delta / scale, flags | PICK_SHARED);
+    return picked ? this : nullptr;
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Drawing subtrees shared between clones.
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_DRAWING_CLONE_H
+#define INKSCAPE_DISPLAY_DRAWING_CLONE_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "display/drawing-group.h"
+
+namespace Inkscape {
+
+/**
+ * Root of a drawing subtree shared by several clones of the same original.
+ *
+ * The subtree is not part of the rendering tree. It is updated once, in its own user space
+ * rather than in display pixels, and every DrawingClone referring to it renders it under its
+ * own transform. Changes to the subtree are forwarded to the clones.
+ *
+ * Only subtrees that render the same under any transform may be shared: nothing in them may
+ * need an intermediate surface (opacity, clips, masks, filters, blending), a pattern tile
+ * or a vector effect, since those work in display pixels.
+ *
+ * Context paint is resolved against the context style of the subtree, which is only meaningful
+ * if all the clones are in the same context, like the markers on one shape.
+ */
+class DrawingCloneSource
+    : public DrawingGroup
+{
+public:
+    DrawingCloneSource(Drawing &drawing);
+    int tag() const override { return tag_of<decltype(*this)>; }
+
+    /// Let setChildrenStyle() on the clones set the context style of the subtree.
+    void setContextFromClones(bool enabled) { _context_from_clones = enabled; }
+
+    /**
+     * Let the clones render the subtree from rasters of it, each shared by the clones displaying
+     * it under the same scale and rotation. Their positions are rounded to a quarter of a
+     * display pixel. Only done in drawings with a cache budget, that is on the canvas.
+     */
+    void setCacheRasters(bool enabled);
+
+protected:
+    ~DrawingCloneSource() override;
+
+    void _markClonesForUpdate(unsigned flags, bool content);
+    void _markClonesForRendering(bool content);
+
+    struct Raster;
+    std::shared_ptr<Raster> _raster(Geom::Affine const &transform, int device_scale, RenderContext &rc, unsigned flags);
+    std::shared_ptr<Raster> _findRaster(Geom::Affine const &transform, int device_scale, RenderContext &rc, unsigned flags);
+    void _dropRasters();
+
+    std::vector<DrawingClone *> _clones;
+    bool _updating = false; ///< Clones mark their own area after updating the subtree.
+    bool _context_from_clones = false;
+    bool _cache_rasters = false;
+
+    std::mutex _rasters_mutex; ///< Guards the table only; clones render from several threads.
+    std::vector<std::shared_ptr<Raster>> _rasters; ///< Oldest first.
+    std::vector<Geom::Affine> _raster_requests; ///< Transforms asked for once, oldest first.
+
+    friend class DrawingClone;
+    friend class DrawingItem;
+};
+
+/**
+ * Display of a DrawingCloneSource under this item's transform.
+ */
+class DrawingClone
+    : public DrawingItem
+{
+public:
+    DrawingClone(Drawing &drawing);
+    int tag() const override { return tag_of<decltype(*this)>; }
+
+    void setSource(DrawingCloneSource *source);
+    void setChildrenStyle(SPStyle const *context_style) override;
+
+protected:
+    ~DrawingClone() override;
+
+    unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) override;
+    unsigned _renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const override;
+    void _clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area) const override;
+    DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
+    bool _canClip() const override { return true; }
+
+    Geom::OptIntRect _sourceArea(Geom::IntRect const &area) const;
+    void _detach();
+
+    DrawingCloneSource *_source = nullptr;
+
+    friend class DrawingCloneSource;
+    friend class DrawingItem;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_DRAWING_CLONE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
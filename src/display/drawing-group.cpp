@@ -79,6 +79,18 @@ unsigned DrawingGroup::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
     if (!stop_at) {
         // normal rendering
         for (auto &i : _children) {
+            if (rc.subset) {
+                if (rc.subset->items.contains(&i)) {
+                    // Render the whole subtree of an item in the subset.
+                    auto const subset = std::exchange(rc.subset, nullptr);
+                    i.render(dc, rc, area, flags, stop_at);
+                    rc.subset = subset;
+                    continue;
+                }
+                if (!rc.subset->ancestors.contains(&i)) {
+                    continue;
+                }
+            }
             i.render(dc, rc, area, flags, stop_at);
         }
     } else {
@@ -10,6 +10,8 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cmath>
+
 #include <2geom/bezier-curve.h>
 
 #include "drawing.h"
@@ -184,7 +186,10 @@ unsigned DrawingImage::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
             dc.lineTo(c01);
         }
 
-        dc.setLineWidth(0.5);
+        // Half a display pixel, also in a subtree shared by clones.
+        double dx = 0.5, dy = 0.0;
+        dc.device_to_user_distance(dx, dy);
+        dc.setLineWidth(std::hypot(dx, dy));
         dc.setSource(rgba);
         dc.stroke();
     }
@@ -12,10 +12,12 @@
 
 #include <climits>
 
+#include "display/drawing-clone.h"
 #include "display/drawing-context.h"
 #include "display/drawing-group.h"
 #include "display/drawing-item.h"
 #include "display/drawing-pattern.h"
+#include "display/drawing-shape.h"
 #include "display/drawing-surface.h"
 #include "display/drawing-text.h"
 #include "display/drawing.h"
@@ -535,7 +537,7 @@ void DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, un
         if (_cache && _cache->surface) {
             _cache->surface->markDirty();
         }
-        _dropPatternCache();
+        // Pattern tiles are kept per resolution, so a new transform does not invalidate them.
     }
 
     // Decide whether this node should be a totally-invalidating node.
@@ -627,7 +629,8 @@ void DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, un
 
         // Determine whether to make this item eligible for caching, by creating a cache iterator.
         double score = _cacheScore();
-        if (score >= CACHE_SCORE_THRESHOLD && cacheable) {
+        // Items shared by clones are not in display pixels, so their cache would be useless.
+        if (score >= CACHE_SCORE_THRESHOLD && cacheable && !ctx.shared) {
             CacheRecord cr;
             cr.score = score;
             // if _cacheRect() is empty, a negative score will be returned from _cacheScore(),
@@ -670,7 +673,9 @@ void DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, un
         }
         if (!totally_invalidated) {
             if (!is<DrawingGroup>(this) || (_filter && filters) || totally_invalidate) {
-                _markForRendering();
+                // Content changes were marked when they happened, so this is only about the new
+                // transform, which leaves pattern tiles valid.
+                _markForRendering(false);
             }
         }
     }
@@ -810,6 +815,10 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
      * value corresponding to the opacity. If there is no clipping path,
      * the entire intermediate surface is painted with alpha corresponding
      * to the opacity value.
+     *
+     * When there is nothing to composite through, because the item is opaque
+     * and unmasked and its clip (if any) covers the whole area, the object is
+     * rendered directly into the intermediate surface instead.
      * 
      */
     // Short-circuit the simple case.
@@ -839,38 +848,59 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
 
     unsigned render_result = RENDER_OK;
 
-    // 1. Render clipping path with alpha = opacity.
-    ict.setSource(0,0,0,_opacity);
-    // Since clip can be combined with opacity, the result could be incorrect
-    // for overlapping clip children. To fix this we use the SOURCE operator
-    // instead of the default OVER.
-    ict.setOperator(CAIRO_OPERATOR_SOURCE);
-    ict.paint();
-    if (_clip) {
-        ict.pushGroup();
-        _clip->clip(ict, rc, *carea);
-        ict.popGroupToSource();
-        ict.setOperator(CAIRO_OPERATOR_IN);
-        ict.paint();
-    }
-    ict.setOperator(CAIRO_OPERATOR_OVER); // reset back to default
+    // A clip made of a single path is filled straight into the intermediate surface, which gives
+    // the same coverage as compositing it in. A rectangle containing the whole area is skipped.
+    auto const clip_shape = _opacity == 1.0 ? _singleClipShape() : nullptr;
+    bool const clip_covers = clip_shape && clip_shape->clipCovers(*carea);
+    bool const clipped = _clip && !clip_covers;
+
+    // Unless something is left to composite the object through, it is rendered directly
+    // into the intermediate surface.
+    bool const composite = clipped || _mask || _opacity != 1.0 || (_filter && render_filters);
+
+    if (composite) {
+        // 1. Render clipping path with alpha = opacity.
+        if (clipped && clip_shape) {
+            DrawingItem const *clip_item = clip_shape;
+            ict.setSource(0, 0, 0, 1);
+            if (carea->intersects(clip_item->_bbox)) {
+                clip_item->_clipItem(ict, rc, *carea);
+            }
+        } else {
+            ict.setSource(0,0,0,_opacity);
+            // Since clip can be combined with opacity, the result could be incorrect
+            // for overlapping clip children. To fix this we use the SOURCE operator
+            // instead of the default OVER.
+            ict.setOperator(CAIRO_OPERATOR_SOURCE);
+            ict.paint();
+            if (clipped) {
+                ict.pushGroup();
+                _clip->clip(ict, rc, *carea);
+                ict.popGroupToSource();
+                ict.setOperator(CAIRO_OPERATOR_IN);
+                ict.paint();
+            }
+            ict.setOperator(CAIRO_OPERATOR_OVER); // reset back to default
+        }
 
-    // 2. Render the mask if present and compose it with the clipping path + opacity.
-    if (_mask) {
-        ict.pushGroup();
-        _mask->render(ict, rc, *carea, flags);
+        // 2. Render the mask if present and compose it with the clipping path + opacity.
+        if (_mask) {
+            ict.pushGroup();
+            _mask->render(ict, rc, *carea, flags);
+
+            cairo_surface_t *mask_s = ict.rawTarget();
+            // Convert mask's luminance to alpha
+            ink_cairo_surface_filter(mask_s, mask_s, MaskLuminanceToAlpha());
+            ict.popGroupToSource();
+            ict.setOperator(CAIRO_OPERATOR_IN);
+            ict.paint();
+            ict.setOperator(CAIRO_OPERATOR_OVER);
+        }
 
-        cairo_surface_t *mask_s = ict.rawTarget();
-        // Convert mask's luminance to alpha
-        ink_cairo_surface_filter(mask_s, mask_s, MaskLuminanceToAlpha());
-        ict.popGroupToSource();
-        ict.setOperator(CAIRO_OPERATOR_IN);
-        ict.paint();
-        ict.setOperator(CAIRO_OPERATOR_OVER);
+        ict.pushGroup();
     }
 
     // 3. Render object itself
-    ict.pushGroup();
     apply_antialias(ict, antialias);
     render_result = _renderItem(ict, rc, *carea, flags, stop_at);
 
@@ -904,9 +934,11 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
     }
 
     // 5. Render object inside the composited mask + clip
-    ict.popGroupToSource();
-    ict.setOperator(CAIRO_OPERATOR_IN);
-    ict.paint();
+    if (composite) {
+        ict.popGroupToSource();
+        ict.setOperator(CAIRO_OPERATOR_IN);
+        ict.paint();
+    }
 
     // 6. Paint the completed rendering onto the base context (or into cache)
     if (_cache && !(flags & RENDER_BYPASS_CACHE)) {
@@ -938,6 +970,36 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
     return render_result;
 }
 
+/**
+ * Return the shape making up the clipping path, if it consists of a single path
+ * that can be filled directly instead of being rendered through clip().
+ */
+DrawingShape const *DrawingItem::_singleClipShape() const
+{
+    for (DrawingItem const *item = _clip; item && item->_visible && !item->_clip; ) {
+        if (auto shape = cast<DrawingShape>(item)) {
+            return shape;
+        }
+        if (!is<DrawingGroup>(item) || item->_children.size() != 1) {
+            return nullptr;
+        }
+        item = &item->_children.front();
+    }
+    return nullptr;
+}
+
+RenderSubset::RenderSubset(std::vector<DrawingItem const *> const &items)
+    : items(items.begin(), items.end())
+{
+    for (auto item : items) {
+        for (auto parent = item->parent(); parent; parent = parent->parent()) {
+            if (!ancestors.insert(parent).second) {
+                break; // The rest of the chain is already there.
+            }
+        }
+    }
+}
+
 /**
  * A stand alone render, ignoring all other objects in the document.
  */
@@ -1107,29 +1169,43 @@ void DrawingItem::recursivePrintTree(unsigned level) const
  * This is called whenever the object changes its visible appearance.
  * For some cases (such as setting opacity) this is enough, but for others
  * _markForUpdate() also needs to be called.
+ *
+ * @param content Whether the content changed, rather than just the transform of the item.
+ *                Only then are the pattern tiles containing the item dropped.
  */
-void DrawingItem::_markForRendering()
+void DrawingItem::_markForRendering(bool content)
 {
     bool outline = _drawing.renderMode() == RenderMode::OUTLINE || _drawing.outlineOverlay();
     Geom::OptIntRect dirty = outline ? _bbox : _drawbox;
     if (!dirty) return;
 
+    if (content) {
+        _dropAncestorPatternCaches();
+    }
+
     // dirty the caches of all parents
     DrawingItem *bkg_root = nullptr;
+    DrawingItem *top = this;
 
     for (auto i = this; i; i = i->_parent) {
+        top = i;
         if (i != this && i->_filter) {
             i->_filter->area_enlarge(*dirty, i);
         }
         if (i->_cache && i->_cache->surface) {
             i->_cache->surface->markDirty(*dirty);
         }
-        i->_dropPatternCache();
         if (i->_background_accumulate) {
             bkg_root = i;
         }
     }
 
+    if (auto source = cast<DrawingCloneSource>(top)) {
+        // A shared subtree is not on the canvas; its clones are.
+        source->_markClonesForRendering(content);
+        return;
+    }
+
     if (bkg_root && bkg_root->_parent && bkg_root->_parent->_parent) {
         bkg_root->_invalidateFilterBackground(*dirty);
     }
@@ -1139,6 +1215,57 @@ void DrawingItem::_markForRendering()
     }
 }
 
+/**
+ * Drops the pattern tiles containing this item, walking up through its ancestors and, from a
+ * shared subtree, through its clones.
+ *
+ * The walk stops at the first ancestor whose tiles were already dropped since a pattern above it
+ * last rendered new ones; everything above that ancestor has been dropped as well. The item
+ * itself is always handled, since it may have just been attached below a new parent.
+ */
+void DrawingItem::_dropAncestorPatternCaches()
+{
+    DrawingItem *top = this;
+    for (auto i = this; i; i = i->_parent) {
+        if (i != this && i->_pattern_cache_dropped.load(std::memory_order_relaxed)) {
+            return;
+        }
+        i->_pattern_cache_dropped.store(true, std::memory_order_relaxed);
+        i->_dropPatternCache();
+        top = i;
+    }
+
+    if (auto source = cast<DrawingCloneSource>(top)) {
+        for (auto clone : source->_clones) {
+            clone->_dropAncestorPatternCaches();
+        }
+    }
+}
+
+/**
+ * Lets content changes in this subtree drop the pattern tiles above it again. Called by a
+ * pattern about to render new tiles. Only descends into items that were marked, which by
+ * construction have marked parents, so the cost is paid once per marking.
+ */
+void DrawingItem::_clearPatternCacheDropped() const
+{
+    if (!_pattern_cache_dropped.exchange(false, std::memory_order_relaxed)) {
+        return;
+    }
+
+    for (auto &i : _children) {
+        i._clearPatternCacheDropped();
+    }
+    for (DrawingItem const *i : {_clip, _mask, static_cast<DrawingItem *>(_fill_pattern), static_cast<DrawingItem *>(_stroke_pattern)}) {
+        if (i) {
+            i->_clearPatternCacheDropped();
+        }
+    }
+    if (auto clone = cast<DrawingClone>(this); clone && clone->_source) {
+        clone->_source->_clearPatternCacheDropped();
+    }
+}
+
 void DrawingItem::_invalidateFilterBackground(Geom::IntRect const &area)
 {
     if (!_drawbox.intersects(area)) return;
@@ -1166,9 +1293,17 @@ void DrawingItem::_invalidateFilterBackground(Geom::IntRect const &area)
  * of the tree. Without this we would need to unset state bits in all children.
  * With _propagate we do this during the update call, when we have to recurse
  * into children anyway.
+ *
+ * If @a content is set, the pattern tiles containing the item are dropped as well.
  */
-void DrawingItem::_markForUpdate(unsigned flags, bool propagate)
+void DrawingItem::_markForUpdate(unsigned flags, bool propagate, bool content)
 {
+    if (content) {
+        // Content changes that do not mark rendering, like appending children, still invalidate
+        // pattern tiles containing this item.
+        _dropAncestorPatternCaches();
+    }
+
     if (propagate) {
         _propagate_state |= flags;
     }
@@ -1178,7 +1313,10 @@ void DrawingItem::_markForUpdate(unsigned flags, bool propagate)
         _state &= ~flags;
         if (oldstate != _state && _parent) {
             // If we actually reset anything in state, recurse on the parent.
-            _parent->_markForUpdate(flags, false);
+            _parent->_markForUpdate(flags, false, content);
+        } else if (auto source = cast<DrawingCloneSource>(this); source && oldstate != _state) {
+            // A shared subtree is updated by its clones.
+            source->_markClonesForUpdate(flags, content);
         } else {
             // If nothing changed, it means our ancestors are already invalidated
             // up to the root. Do not bother recursing, because it won't change anything.
@@ -13,13 +13,16 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_ITEM_H
 #define INKSCAPE_DISPLAY_DRAWING_ITEM_H
 
+#include <atomic>
 #include <cstdint>
 #include <exception>
 #include <memory>
 #include <list>
 #include <optional>
 #include <type_traits>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 #include <boost/operators.hpp>
 #include <boost/intrusive/list.hpp>
 #include <2geom/rect.h>
@@ -40,6 +43,7 @@ class DrawingCache;
 class DrawingItem;
 class DrawingPattern;
 class DrawingContext;
+class DrawingShape;
 
 namespace Filters { class Filter; }
 
@@ -48,16 +52,29 @@ enum class Antialiasing : unsigned char
     None, Fast, Good, Best
 };
 
+/**
+ * A part of the drawing to render on its own, such as a selection, with the opacity, clipping,
+ * masking and filters of its ancestors but without any of their other descendants.
+ */
+struct RenderSubset
+{
+    explicit RenderSubset(std::vector<DrawingItem const *> const &items);
+    std::unordered_set<DrawingItem const *> items;     ///< Rendered together with their whole subtree.
+    std::unordered_set<DrawingItem const *> ancestors; ///< Rendered only on the way to the items.
+};
+
 struct RenderContext
 {
     std::uint32_t outline_color;
     std::optional<Antialiasing> antialiasing_override;
     bool dithering = false;
+    RenderSubset const *subset = nullptr; ///< If set, render only this part of the drawing.
 };
 
 struct UpdateContext
 {
     Geom::Affine ctm;
+    bool shared = false; ///< Updating a subtree shared by clones, in its own user space.
 };
 
 struct CacheData;
@@ -107,7 +124,8 @@ public:
         PICK_NORMAL  = 0,      // normal pick
         PICK_STICKY  = 1 << 0, // sticky pick - ignore visibility and sensitivity
         PICK_AS_CLIP = 1 << 1, // pick with no stroke and opaque fill regardless of item style
-        PICK_OUTLINE = 1 << 2  // pick in outline mode
+        PICK_OUTLINE = 1 << 2, // pick in outline mode
+        PICK_SHARED  = 1 << 3  // pick in a subtree shared by clones, in its own user space
     };
 
     DrawingItem(Drawing &drawing);
@@ -183,11 +201,14 @@ protected:
     };
     virtual ~DrawingItem(); // Private to prevent deletion of items that are still in use by a snapshot.
     void _renderOutline(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags) const;
-    void _markForUpdate(unsigned state, bool propagate);
-    void _markForRendering();
+    void _markForUpdate(unsigned state, bool propagate, bool content = true);
+    void _markForRendering(bool content = true);
+    void _dropAncestorPatternCaches();
+    void _clearPatternCacheDropped() const;
     void _invalidateFilterBackground(Geom::IntRect const &area);
     double _cacheScore();
     Geom::OptIntRect _cacheRect() const;
+    DrawingShape const *_singleClipShape() const;
     void _setCached(bool cached, bool persistent = false);
     virtual unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) { return 0; }
     virtual unsigned _renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const { return RENDER_OK; }
@@ -231,6 +252,9 @@ protected:
     std::unique_ptr<CacheData> _cache;
     int _update_complexity = 0;
     bool _contains_unisolated_blend : 1;
+    /// Set once the pattern tiles of this item and its ancestors have been dropped, so that further
+    /// content changes below it can stop there. Cleared when a pattern above renders new tiles.
+    mutable std::atomic<bool> _pattern_cache_dropped = false;
 
     CacheList::iterator _cache_iterator;
 
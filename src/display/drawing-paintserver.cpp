@@ -1,6 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #include "drawing-paintserver.h"
+
+#include <cmath>
+
 #include "cairo-utils.h"
+#include "mesh-rasterizer.h"
+#include "helper/geom.h"
 
 namespace Inkscape {
 
@@ -109,7 +114,142 @@ cairo_pattern_t *DrawingRadialGradient::create_pattern(cairo_t *ct, Geom::OptRec
     return pat;
 }
 
-cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *, Geom::OptRect const &bbox, double opacity) const
+namespace {
+
+/// Convert a patch to the control points of a tensor-product patch, filling in what cairo would.
+MeshPatch to_mesh_patch(DrawingMeshGradient::PatchData const &data)
+{
+    MeshPatch patch;
+    auto &b = patch.control;
+
+    // The sides go round the patch in the same order as cairo's.
+    auto side_point = [&] (int side, int t) -> Geom::Point & {
+        switch (side) {
+            case 0: return b[0][t];
+            case 1: return b[t][3];
+            case 2: return b[3][3 - t];
+            default: return b[3 - t][0];
+        }
+    };
+
+    for (int k = 0; k < 4; k++) {
+        auto const &p = data.points[k];
+        side_point(k, 0) = p[0];
+        switch (data.pathtype[k]) {
+            case 'c':
+            case 'C':
+                side_point(k, 1) = p[1];
+                side_point(k, 2) = p[2];
+                break;
+            default:
+                side_point(k, 1) = Geom::lerp(1.0 / 3.0, p[0], p[3]);
+                side_point(k, 2) = Geom::lerp(2.0 / 3.0, p[0], p[3]);
+                break;
+        }
+        side_point(k, 3) = p[3];
+    }
+
+    for (int k = 0; k < 4; k++) {
+        // Rows and columns counted from the corner of this control point.
+        auto const I = [k] (int i) { return k < 2 ? i : 3 - i; };
+        auto const J = [k] (int j) { return k == 0 || k == 3 ? j : 3 - j; };
+
+        if (data.tensorIsSet[k]) {
+            b[I(1)][J(1)] = data.tensorpoints[k];
+        } else {
+            // Same as a Coons patch, as in cairo.
+            b[I(1)][J(1)] = (-4 * b[I(0)][J(0)]
+                             + 6 * (b[I(0)][J(1)] + b[I(1)][J(0)])
+                             - 2 * (b[I(0)][J(3)] + b[I(3)][J(0)])
+                             + 3 * (b[I(3)][J(1)] + b[I(1)][J(3)])
+                             - b[I(3)][J(3)]) / 9;
+        }
+
+        patch.color[k] = {data.color[k][0], data.color[k][1], data.color[k][2], static_cast<float>(data.opacity[k])};
+    }
+
+    return patch;
+}
+
+} // namespace
+
+std::shared_ptr<MeshTessellation const> DrawingMeshGradient::tessellation(double expansion) const
+{
+    int const level = std::ceil(std::log2(std::max(expansion, 1e-6)));
+
+    auto lock = std::lock_guard(tessellation_mutex);
+    auto &result = tessellations[level];
+    if (!result) {
+        std::vector<MeshPatch> patches;
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                patches.push_back(to_mesh_patch(patchdata[i][j]));
+            }
+        }
+        result = std::make_shared<MeshTessellation const>(patches, std::ldexp(1.0, level));
+
+        // Keep the neighbouring levels, to avoid rebuilding when zooming back and forth.
+        std::erase_if(tessellations, [level] (auto const &entry) { return std::abs(entry.first - level) > 1; });
+    }
+    return result;
+}
+
+cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const
+{
+    auto const target = cairo_get_target(ct);
+    if (cairo_surface_get_type(target) != CAIRO_SURFACE_TYPE_IMAGE) {
+        return create_cairo_mesh_pattern(bbox, opacity);
+    }
+
+    Geom::Affine gs2user = transform;
+    if (units == SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX && bbox) {
+        Geom::Affine bbox2user(bbox->width(), 0, 0, bbox->height(), bbox->left(), bbox->top());
+        gs2user *= bbox2user;
+    }
+
+    cairo_matrix_t matrix;
+    cairo_get_matrix(ct, &matrix);
+    auto const user2dev = ink_matrix_to_2geom(matrix);
+    auto const gs2dev = gs2user * user2dev;
+
+    double sx, sy;
+    cairo_surface_get_device_scale(target, &sx, &sy);
+
+    // The cells must be fine enough along the direction the mesh is stretched most.
+    auto const tess = tessellation(max_expansion(gs2dev) * std::max(sx, sy));
+
+    // Only the part of the mesh that can be drawn on is needed.
+    double x0, y0, x1, y1;
+    cairo_save(ct);
+    cairo_identity_matrix(ct);
+    cairo_clip_extents(ct, &x0, &y0, &x1, &y1);
+    cairo_restore(ct);
+
+    Geom::OptRect area = Geom::Rect(x0, y0, x1, y1);
+    if (tess->bounds()) {
+        area.intersectWith(*tess->bounds() * gs2dev);
+    } else {
+        area = {};
+    }
+    auto const rect = area ? area->roundOutwards() : Geom::OptIntRect();
+    if (!rect || rect->hasZeroArea()) {
+        return cairo_pattern_create_rgba(0, 0, 0, 0);
+    }
+
+    int const width = std::ceil(rect->width() * sx);
+    int const height = std::ceil(rect->height() * sy);
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    cairo_surface_set_device_scale(surface, sx, sy);
+    tess->rasterize(surface, gs2dev * Geom::Translate(-rect->min()) * Geom::Scale(sx, sy), opacity);
+
+    auto pat = cairo_pattern_create_for_surface(surface);
+    cairo_surface_destroy(surface);
+    ink_cairo_pattern_set_matrix(pat, user2dev * Geom::Translate(-rect->min()));
+
+    return pat;
+}
+
+cairo_pattern_t *DrawingMeshGradient::create_cairo_mesh_pattern(Geom::OptRect const &bbox, double opacity) const
 {
 #ifdef MESH_DEBUG
     std::cout << "sp_meshgradient_create_pattern: " << bbox << " " << opacity << std::endl;
@@ -12,6 +12,9 @@
  */
 
 #include <array>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <cairo.h>
 #include <2geom/rect.h>
@@ -24,6 +27,8 @@ class SPGradient;
 
 namespace Inkscape {
 
+class MeshTessellation;
+
 /**
  * A DrawingPaintServer is a lightweight copy of the resources needed to paint using a paint server.
  *
@@ -46,6 +51,9 @@ public:
     /// Return whether create_pattern() uses its cairo_t argument. Such pattern cannot be cached, but recreated each time.
     /// Fixme: The only reson this exists is to work around https://gitlab.freedesktop.org/cairo/cairo/-/issues/146.
     virtual bool uses_cairo_ctx() const { return false; }
+
+    /// Return whether the pattern depends on the transform and clip of the cairo_t, and so must be recreated for every draw.
+    virtual bool varies_per_draw() const { return false; }
 };
 
 // Todo: Remove, merging with existing implementation for solid colours.
@@ -163,12 +171,31 @@ public:
         , cols(cols)
         , patchdata(std::move(patchdata)) {}
 
-    cairo_pattern_t *create_pattern(cairo_t*, Geom::OptRect const &bbox, double opacity) const override;
+    /**
+     * When drawing to an image surface, return an image of the mesh covering the clip extents.
+     * It is painted from a tessellation cached per zoom level, which is much faster than letting
+     * cairo subdivide every patch again on every draw. Other targets get a cairo mesh pattern.
+     */
+    cairo_pattern_t *create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const override;
+
+    bool uses_cairo_ctx() const override { return true; }
+
+    /// The image covers the clip extents at the current scale.
+    bool varies_per_draw() const override { return true; }
+
+    /// Produce a cairo mesh pattern, which works on any target.
+    cairo_pattern_t *create_cairo_mesh_pattern(Geom::OptRect const &bbox, double opacity) const;
 
 private:
+    std::shared_ptr<MeshTessellation const> tessellation(double expansion) const;
+
     int rows;
     int cols;
     std::vector<std::vector<PatchData>> patchdata;
+
+    mutable std::mutex tessellation_mutex;
+    /// Tessellations by zoom level, as the base-2 logarithm of the scale they are built for.
+    mutable std::map<int, std::shared_ptr<MeshTessellation const>> tessellations;
 };
 
 } // namespace Inkscape
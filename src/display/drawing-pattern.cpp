@@ -10,6 +10,10 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
 #include <cairomm/region.h>
 #include <cairo.h>
 #include "cairo-utils.h"
@@ -19,16 +23,100 @@
 #include "drawing-surface.h"
 #include "drawing.h"
 #include "helper/geom.h"
+#include "initlock.h"
 #include "ui/util.h"
 
 namespace Inkscape {
 
-DrawingPattern::Surface::Surface(Geom::IntRect const &rect, int device_scale)
-    : rect(rect)
-    , surface(Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32, rect.width() * device_scale, rect.height() * device_scale))
+namespace {
+
+/// Size of the blocks a large pattern tile is split into.
+constexpr int BLOCK_SIZE = 256;
+
+/// Tiles up to this size along both sides are rendered as a single block, which is then painted
+/// from directly. Larger tiles are split into blocks, and only the blocks under the requested
+/// area are rendered and assembled.
+constexpr int MAX_WHOLE_TILE = 1024;
+
+/// Upper limit on the tile resolution along each side. Beyond it, the tile is scaled up instead,
+/// as cairo fails with the pattern matrix and the block indices could overflow.
+constexpr int MAX_RESOLUTION = 1 << 22;
+
+/// Number of blocks kept for a tile. When exceeded, the blocks not in use are dropped.
+constexpr std::size_t MAX_KEPT_BLOCKS = 256;
+
+/// Number of recent resolutions to keep tiles for.
+constexpr int KEPT_RESOLUTIONS = 3;
+
+} // namespace
+
+/**
+ * A pattern tile rendered at one resolution, split into blocks so that render threads needing
+ * different parts of it do not wait for each other. Each block is rendered once, on first use.
+ * Blocks are only allocated once used, so a tile covering a huge area when zoomed far in only
+ * costs the blocks that are actually drawn.
+ */
+struct DrawingPattern::Tiles
 {
-    cairo_surface_set_device_scale(surface->cobj(), device_scale, device_scale);
-}
+    struct Key
+    {
+        Geom::IntPoint resolution;
+        int device_scale;
+        int opacity; ///< In 1/255.
+        std::optional<Antialiasing> antialias;
+        bool dithering;
+        bool operator==(Key const &) const = default;
+    };
+
+    struct Block
+    {
+        InitLock rendered;
+        Cairo::RefPtr<Cairo::ImageSurface> surface;
+    };
+
+    Tiles(Key const &key)
+        : key(key)
+    {
+        bool const whole = key.resolution.x() <= MAX_WHOLE_TILE && key.resolution.y() <= MAX_WHOLE_TILE;
+        block_size = whole ? key.resolution : Geom::IntPoint(BLOCK_SIZE, BLOCK_SIZE);
+        for (int i = 0; i < 2; i++) {
+            count[i] = (key.resolution[i] + block_size[i] - 1) / block_size[i];
+        }
+    }
+
+    /// Return the block, creating it if needed.
+    std::shared_ptr<Block> block(int x, int y) const
+    {
+        auto const index = static_cast<std::int64_t>(y) * count.x() + x;
+        auto lock = std::lock_guard(blocks_mutex);
+        if (auto it = blocks.find(index); it != blocks.end()) {
+            return it->second;
+        }
+        if (blocks.size() >= MAX_KEPT_BLOCKS) {
+            // Panning around while zoomed far in. Threads still using blocks keep them alive.
+            blocks.clear();
+        }
+        return blocks.emplace(index, std::make_shared<Block>()).first->second;
+    }
+
+    /// Size of the blocks with the given index along dimension i; the last one may be smaller.
+    int blockExtent(int i, int index) const
+    {
+        return std::min(block_size[i], key.resolution[i] - index * block_size[i]);
+    }
+
+    Geom::IntRect blockRect(int x, int y) const
+    {
+        auto const min = Geom::IntPoint(x, y) * block_size;
+        return Geom::IntRect::from_xywh(min, {blockExtent(Geom::X, x), blockExtent(Geom::Y, y)});
+    }
+
+    Key key;
+    Geom::IntPoint block_size;
+    Geom::IntPoint count;
+    mutable std::mutex blocks_mutex; ///< Guards the table only; blocks are rendered without holding it.
+    mutable std::unordered_map<std::int64_t, std::shared_ptr<Block>> blocks;
+};
 
 DrawingPattern::DrawingPattern(Drawing &drawing)
     : DrawingGroup(drawing)
@@ -42,9 +130,10 @@ void DrawingPattern::setPatternToUserTransform(Geom::Affine const &transform)
         auto constexpr EPS = 1e-18;
         auto current = _pattern_to_user ? *_pattern_to_user : Geom::identity();
         if (Geom::are_near(transform, current, EPS)) return;
-        _markForRendering();
+        // Tiles only depend on the resolution, so they are kept.
+        _markForRendering(false);
         _pattern_to_user = transform.isIdentity(EPS) ? nullptr : std::make_unique<Geom::Affine>(transform);
-        _markForUpdate(STATE_ALL, true);
+        _markForUpdate(STATE_ALL, true, false);
     });
 }
 
@@ -62,6 +151,7 @@ void DrawingPattern::setOverflow(Geom::Affine const &initial_transform, int step
         _overflow_initial_transform = initial_transform;
         _overflow_steps = steps;
         _overflow_step_transform = step_transform;
+        _dropPatternCache();
     });
 }
 
@@ -79,7 +169,6 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
 
     // Calculate various transforms.
     auto const dt = Geom::Translate(-_tile_rect->min()) * Geom::Scale(_pattern_resolution / _tile_rect->dimensions()); // AKA user_to_tile.
-    auto const idt = dt.inverse();
     auto const pattern_to_tile = _pattern_to_user ? _pattern_to_user->inverse() * dt : dt;
     auto const screen_to_tile = _ctm.inverse() * pattern_to_tile;
 
@@ -95,183 +184,162 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
         return rect;
     };
 
-    // Return whether the periodic tiling of a contains the periodic tiling of b.
-    auto wrapped_contains = [&] (Geom::IntRect const &a, Geom::IntRect const &b) {
-        auto check = [&] (int i) {
-            int const period = _pattern_resolution[i];
-            if (a[i].extent() >= period) return true;
-            if (b[i].extent() > a[i].extent()) return false;
-            return Util::round_down(b[i].min() - a[i].min(), period) >= b[i].max() - a[i].max();
-        };
-        return check(0) && check(1);
-    };
+    // Calculate the requested area to draw within tile rasterisation space.
+    auto const area_orig = (Geom::Rect(area) * screen_to_tile).roundOutwards();
+    auto const area_tile = canonicalised(area_orig);
 
-    // Return whether the periodic tiling of a intersects with or touches the periodic tiling of b.
-    auto wrapped_touches = [&] (Geom::IntRect const &a, Geom::IntRect const &b) {
-        auto check = [&] (int i) {
-            int const period = _pattern_resolution[i];
-            if (a[i].extent() >= period) return true;
-            if (b[i].extent() >= period) return true;
-            return Util::round_down(b[i].max() - a[i].min(), period) >= b[i].min() - a[i].max();
-        };
-        return check(0) && check(1);
-    };
+    auto const tiles = _getTiles(rc, opacity, device_scale);
+
+    // Find the blocks covering the requested area along each axis, as pairs of a block index
+    // and the position of that block in area_tile, which may wrap round the end of the tile.
+    std::vector<std::pair<int, int>> spans[2];
+    for (int i = 0; i < 2; i++) {
+        int const period = _pattern_resolution[i];
+        for (int pos = area_tile[i].min(); pos < area_tile[i].max(); ) {
+            int const wrapped = pos - Util::round_down(pos, period);
+            int const index = wrapped / tiles->block_size[i];
+            int const start = pos - (wrapped - index * tiles->block_size[i]);
+            spans[i].emplace_back(index, start);
+            pos = start + tiles->blockExtent(i, index);
+        }
+    }
 
-    // Calculate the minimum and maximum translates of a that overlap with b.
-    auto overlapping_translates = [&, this] (Geom::IntRect const &a, Geom::IntRect const &b) {
-        Geom::IntPoint min, max;
-        for (int i = 0; i < 2; i++) {
-            min[i] = Util::round_up  (b[i].min() - a[i].max() + 1, _pattern_resolution[i]);
-            max[i] = Util::round_down(b[i].max() - a[i].min() - 1, _pattern_resolution[i]);
+    // Render the blocks that are still missing. Threads only wait for each other on the same block.
+    std::vector<std::shared_ptr<Tiles::Block>> blocks;
+    for (auto const &[y, ypos] : spans[Geom::Y]) {
+        for (auto const &[x, xpos] : spans[Geom::X]) {
+            auto &block = blocks.emplace_back(tiles->block(x, y));
+            block->rendered.init([&, x = x, y = y] { block->surface = _renderBlock(*tiles, x, y, rc); });
         }
-        return std::make_pair(min, max);
-    };
+    }
 
-    // Paint the periodic tiling of a into b, and remove the painted region from dirty.
-    auto wrapped_paint = [&, this] (Surface const &a, Geom::IntRect &b, Cairo::RefPtr<Cairo::Context> const &cr, Cairo::RefPtr<Cairo::Region> const &dirty) {
-        auto const [min, max] = overlapping_translates(a.rect, b);
-        for (int x = min.x(); x <= max.x(); x += _pattern_resolution.x()) {
-            for (int y = min.y(); y <= max.y(); y += _pattern_resolution.y()) {
-                auto const rect = a.rect + Geom::IntPoint(x, y);
-                dirty->subtract(geom_to_cairo(rect));
-                cr->set_source(a.surface, rect.left(), rect.top());
-                cr->paint();
+    Cairo::RefPtr<Cairo::ImageSurface> surface;
+    Geom::IntRect surface_rect;
+
+    if (spans[Geom::X].size() == 1 && spans[Geom::Y].size() == 1) {
+        // The area lies within a single block, which can be used as is. This is always the case
+        // for tiles rendered whole.
+        auto const x = spans[Geom::X].front().first;
+        auto const y = spans[Geom::Y].front().first;
+        surface = blocks.front()->surface;
+        surface_rect = tiles->blockRect(x, y);
+    } else {
+        // Otherwise, assemble the blocks into a surface covering only the area, which is never
+        // larger than the area plus one block along each side.
+        surface_rect = area_tile;
+        surface = Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32, surface_rect.width() * device_scale, surface_rect.height() * device_scale);
+        cairo_surface_set_device_scale(surface->cobj(), device_scale, device_scale);
+        Inkscape::DrawingContext dc(surface->cobj(), surface_rect.min());
+        dc.setOperator(CAIRO_OPERATOR_SOURCE);
+        auto block = blocks.begin();
+        for (auto const &[y, ypos] : spans[Geom::Y]) {
+            for (auto const &[x, xpos] : spans[Geom::X]) {
+                dc.setSource((*block++)->surface->cobj(), xpos, ypos);
+                dc.paint();
             }
         }
-    };
-
-    // Calculate the requested area to draw within tile rasterisation space.
-    auto const area_orig = (Geom::Rect(area) * screen_to_tile).roundOutwards();
-    auto const area_tile = canonicalised(area_orig);
+    }
 
-    // Simplest solution for now to protecting pattern cache is a mutex. This makes all
-    // pattern rendering single-threaded, however patterns are typically not the bottleneck.
-    auto lock = std::lock_guard(mutables);
+    // Debug: Show pattern tile.
+    // surface->write_to_png("/tmp/patternsurface.png");
 
-    auto get_surface = [&, this] () -> std::pair<Surface*, Cairo::RefPtr<Cairo::Region>> {
-        // If there is a rectangle containing the requested area, just use that.
-        for (auto &s : surfaces) {
-            if (wrapped_contains(s.rect, area_tile)) {
-                return { &s, {} };
-            }
-        }
+    // Create and return pattern.
+    auto cp = cairo_pattern_create_for_surface(surface->cobj());
+    auto const shift = surface_rect.min() + round_down(area_orig.min() - surface_rect.min(), _pattern_resolution);
+    ink_cairo_pattern_set_matrix(cp, pattern_to_tile * Geom::Translate(-shift));
+    cairo_pattern_set_extend(cp, CAIRO_EXTEND_REPEAT);
+    if (rc.antialiasing_override && rc.antialiasing_override.value() == Antialiasing::None) {
+        cairo_pattern_set_filter(cp, CAIRO_FILTER_NEAREST);
+    }
+    return cp;
+}
 
-        // Otherwise, recursively merge the requested area with all overlapping or touching rectangles, and paint the missing part.
-        std::vector<Surface> merged;
-        auto expanded = area_tile;
-
-        while (true) {
-            bool modified = false;
-
-            for (auto it = surfaces.begin(); it != surfaces.end(); ) {
-                if (wrapped_touches(expanded, it->rect)) {
-                    expanded.unionWith(it->rect + round_down(expanded.max() - it->rect.min(), _pattern_resolution));
-                    merged.emplace_back(std::move(*it));
-                    *it = std::move(surfaces.back());
-                    surfaces.pop_back();
-                    modified = true;
-                } else {
-                    ++it;
-                }
-            }
+/**
+ * Return the tiles for the current resolution and rendering settings, creating them if needed.
+ */
+auto DrawingPattern::_getTiles(RenderContext const &rc, float opacity, int device_scale) const -> std::shared_ptr<Tiles>
+{
+    auto const key = Tiles::Key{
+        .resolution = _pattern_resolution,
+        .device_scale = device_scale,
+        .opacity = static_cast<int>(std::round(opacity * 255)),
+        .antialias = rc.antialiasing_override,
+        .dithering = rc.dithering
+    };
 
-            if (!modified) break;
-        }
+    auto lock = std::lock_guard(_tiles_mutex);
 
-        // Canonicalise the expanded rectangle. (Stops Cairo's coordinates overflowing and the pattern disappearing.)
-        expanded = canonicalised(expanded);
+    auto it = std::find_if(_tiles.begin(), _tiles.end(), [&] (auto const &t) { return t->key == key; });
+    if (it != _tiles.end()) {
+        std::rotate(_tiles.begin(), it, it + 1);
+        return _tiles.front();
+    }
 
-        // Create a new surface covering the expanded rectangle.
-        auto surface = Surface(expanded, device_scale);
-        auto cr = Cairo::Context::create(surface.surface);
-        cr->translate(-surface.rect.left(), -surface.rect.top());
+    _tiles.insert(_tiles.begin(), std::make_shared<Tiles>(key));
 
-        // Paste all the old surfaces into the new surface, tracking the remaining dirty region.
-        auto dirty = Cairo::Region::create(geom_to_cairo(expanded));
+    // The new tiles show the current content, so the next change to it has to drop them again.
+    _clearPatternCacheDropped();
 
-        for (auto &m : merged) {
-            wrapped_paint(m, expanded, cr, dirty);
+    // Forget the tiles for all but the most recent resolutions. Threads still using them keep
+    // them alive until they are done.
+    std::vector<Geom::IntPoint> resolutions;
+    std::erase_if(_tiles, [&] (auto const &t) {
+        if (std::find(resolutions.begin(), resolutions.end(), t->key.resolution) != resolutions.end()) {
+            return false;
         }
+        if (resolutions.size() < KEPT_RESOLUTIONS) {
+            resolutions.push_back(t->key.resolution);
+            return false;
+        }
+        return true;
+    });
 
-        // Emplace the surface, and return it along with the remaining dirty region.
-        surfaces.emplace_back(std::move(surface));
-        return std::make_pair(&surfaces.back(), std::move(dirty));
-    };
+    return _tiles.front();
+}
+
+auto DrawingPattern::_renderBlock(Tiles const &tiles, int x, int y, RenderContext &rc) const -> Cairo::RefPtr<Cairo::ImageSurface>
+{
+    auto const rect = tiles.blockRect(x, y);
+    int const device_scale = tiles.key.device_scale;
 
-    // Find an already-drawn surface containing the requested area, or create if it none exists.
-    auto [surface, dirty] = get_surface();
+    auto surface = Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32, rect.width() * device_scale, rect.height() * device_scale);
+    cairo_surface_set_device_scale(surface->cobj(), device_scale, device_scale);
 
-    // Draw the pattern contents to the dirty areas of the surface, taking care of possible wrapping.
-    Inkscape::DrawingContext dc(surface->surface->cobj(), surface->rect.min());
+    Inkscape::DrawingContext dc(surface->cobj(), rect.min());
     if (rc.antialiasing_override) {
         apply_antialias(dc, rc.antialiasing_override.value());
     }
 
-    auto paint = [&, this] (Geom::IntRect const &rect) {
-        if (_overflow_steps == 1) {
-            render(dc, rc, rect);
-        } else {
-            // Overflow transforms need to be transformed to the old coordinate system
-            // before stretching to the pattern resolution.
-            auto const initial_transform = idt * _overflow_initial_transform * dt;
-            auto const step_transform    = idt * _overflow_step_transform    * dt;
-            dc.transform(initial_transform);
-            for (int i = 0; i < _overflow_steps; i++) {
-                // render() fails to handle transforms applied here when using cache.
-                render(dc, rc, rect, RENDER_BYPASS_CACHE);
-                dc.transform(step_transform);
-                // auto raw = pattern_surface.raw();
-                // auto filename = "drawing-pattern" + std::to_string(i) + ".png";
-                // cairo_surface_write_to_png(pattern_surface.raw(), filename.c_str());
-            }
+    // Draw the pattern.
+    if (_overflow_steps == 1) {
+        render(dc, rc, rect);
+    } else {
+        // Overflow transforms need to be transformed to the old coordinate system
+        // before stretching to the pattern resolution.
+        auto const dt = Geom::Translate(-_tile_rect->min()) * Geom::Scale(_pattern_resolution / _tile_rect->dimensions());
+        auto const idt = dt.inverse();
+        auto const initial_transform = idt * _overflow_initial_transform * dt;
+        auto const step_transform    = idt * _overflow_step_transform    * dt;
+        dc.transform(initial_transform);
+        for (int i = 0; i < _overflow_steps; i++) {
+            // render() fails to handle transforms applied here when using cache.
+            render(dc, rc, rect, RENDER_BYPASS_CACHE);
+            dc.transform(step_transform);
         }
-    };
-
-    if (dirty) {
-        for (int i = 0; i < dirty->get_num_rectangles(); i++) {
-            auto const rect = cairo_to_geom(dirty->get_rectangle(i));
-            for (int x = 0; x <= 1; x++) {
-                for (int y = 0; y <= 1; y++) {
-                    auto const wrap = _pattern_resolution * Geom::IntPoint(x, y);
-                    auto const rect2 = rect & Geom::IntRect(wrap, wrap + _pattern_resolution);
-                    if (!rect2) continue;
-                    auto save = DrawingContext::Save(dc);
-                    // Clip to rectangle to be drawn.
-                    dc.rectangle(*rect2);
-                    dc.clip();
-                    // Draw the pattern.
-                    dc.translate(wrap);
-                    paint(*rect2 - wrap);
-                    // Apply opacity, if necessary.
-                    if (opacity < 1.0 - 1e-3) {
-                        dc.setOperator(CAIRO_OPERATOR_DEST_IN);
-                        dc.setSource(0.0, 0.0, 0.0, opacity);
-                        dc.paint();
-                    }
-                }
-            }
-        }
-        dirty.reset();
     }
 
-    // Debug: Show pattern tile.
-    // surface->surface->write_to_png("/tmp/patternsurface.png");
-
-    // Create and return pattern.
-    auto cp = cairo_pattern_create_for_surface(surface->surface->cobj());
-    auto const shift = surface->rect.min() + round_down(area_orig.min() - surface->rect.min(), _pattern_resolution);
-    ink_cairo_pattern_set_matrix(cp, pattern_to_tile * Geom::Translate(-shift));
-    cairo_pattern_set_extend(cp, CAIRO_EXTEND_REPEAT);
-    if (rc.antialiasing_override && rc.antialiasing_override.value() == Antialiasing::None) {
-        cairo_pattern_set_filter(cp, CAIRO_FILTER_NEAREST);
+    // Apply opacity, if necessary.
+    if (tiles.key.opacity < 255) {
+        dc.setOperator(CAIRO_OPERATOR_DEST_IN);
+        dc.setSource(0.0, 0.0, 0.0, tiles.key.opacity / 255.0);
+        dc.paint();
     }
-    return cp;
+
+    return surface;
 }
 
 unsigned DrawingPattern::_updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset)
 {
-    _dropPatternCache();
-
     if (!_tile_rect || _tile_rect->hasZeroArea()) {
         return STATE_NONE;
     }
@@ -280,22 +348,25 @@ unsigned DrawingPattern::_updateItem(Geom::IntRect const &area, UpdateContext co
     double const det_ctm = ctx.ctm.det();
     double const det_ps2user = _pattern_to_user ? _pattern_to_user->det() : 1.0;
     double scale = std::sqrt(std::abs(det_ctm * det_ps2user));
-    // Fixme: When scale is too big (zooming in a pattern), Cairo doesn't render the pattern.
-    // More precisely it fails when setting pattern matrix in DrawingPattern::renderPattern.
-    // Correct solution should make use of visible area and change pattern tile rect accordingly.
+    // When zoomed in far enough, Cairo fails when setting the pattern matrix in renderPattern(),
+    // so the resolution is limited and the tile scaled up from there.
     auto const c = _tile_rect->dimensions() * scale;
-    _pattern_resolution = c.ceil();
+    for (int i = 0; i < 2; i++) {
+        _pattern_resolution[i] = std::clamp<double>(std::ceil(c[i]), 1, MAX_RESOLUTION);
+    }
 
     // Map tile rect to the origin and stretch it to the desired resolution.
     auto const dt = Geom::Translate(-_tile_rect->min()) * Geom::Scale(_pattern_resolution / _tile_rect->dimensions());
 
-    // Apply this transform to the actual pattern tree.
+    // Apply this transform to the actual pattern tree. The content is unchanged, so the tiles
+    // already rendered at other resolutions remain valid.
     return DrawingGroup::_updateItem(Geom::IntRect::infinite(), { dt }, flags, reset);
 }
 
 void DrawingPattern::_dropPatternCache()
 {
-    surfaces.clear();
+    auto lock = std::lock_guard(_tiles_mutex);
+    _tiles.clear();
 }
 
 } // namespace Inkscape
@@ -13,7 +13,9 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_PATTERN_H
 #define INKSCAPE_DISPLAY_DRAWING_PATTERN_H
 
+#include <memory>
 #include <mutex>
+#include <vector>
 #include <cairomm/surface.h>
 #include "drawing-group.h"
 
@@ -81,17 +83,15 @@ protected:
     // Set on update.
     Geom::IntPoint _pattern_resolution;
 
-    struct Surface
-    {
-        Surface(Geom::IntRect const &rect, int device_scale);
-        Geom::IntRect rect;
-        Cairo::RefPtr<Cairo::ImageSurface> surface;
-    };
+    struct Tiles;
+    std::shared_ptr<Tiles> _getTiles(RenderContext const &rc, float opacity, int device_scale) const;
+    Cairo::RefPtr<Cairo::ImageSurface> _renderBlock(Tiles const &tiles, int x, int y, RenderContext &rc) const;
 
-    mutable std::mutex mutables;
+    mutable std::mutex _tiles_mutex; ///< Guards _tiles only; blocks are rendered without holding it.
 
-    // Parts of the pattern tile that have been rendered. Read/written on render, cleared on update.
-    mutable std::vector<Surface> surfaces;
+    // Pattern tiles rendered at recent resolutions, most recently used first. They only depend on
+    // the resolution, not on the rest of the transform, so they are kept until the content changes.
+    mutable std::vector<std::shared_ptr<Tiles>> _tiles;
 };
 
 } // namespace Inkscape
@@ -237,7 +237,11 @@ unsigned DrawingShape::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
         {
             Inkscape::DrawingContext::Save save(dc);
             dc.setSource(rgba);
-            dc.setLineWidth(0.5);
+            // Half a display pixel, also in a subtree shared by clones, which is drawn in the
+            // user space of the clone.
+            double dx = 0.5, dy = 0.0;
+            dc.device_to_user_distance(dx, dy);
+            dc.setLineWidth(std::hypot(dx, dy));
             dc.setTolerance(0.5);
             dc.stroke();
         }
@@ -333,12 +337,50 @@ void DrawingShape::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRec
     dc.fill();
 }
 
+bool DrawingShape::clipCovers(Geom::IntRect const &area) const
+{
+    if (!_curve) return false;
+
+    // Only a single rectangle on screen is recognised: a path along its sides, going round once.
+    auto const &pathv = _curve->get_pathvector();
+    if (pathv.size() != 1) return false;
+
+    std::vector<Geom::Point> nodes;
+    nodes.push_back(pathv.front().initialPoint() * _ctm);
+    for (auto const &curve : pathv.front()) {
+        if (!curve.isLineSegment()) return false;
+        nodes.push_back(curve.finalPoint() * _ctm);
+    }
+
+    constexpr double eps = 1e-6;
+    auto const rect = Geom::Rect::from_range(nodes.begin(), nodes.end());
+    auto on_side = [&] (double v, Geom::Dim2 d) {
+        return std::abs(v - rect[d].min()) < eps || std::abs(v - rect[d].max()) < eps;
+    };
+
+    double twice_area = 0;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        auto const &a = nodes[i];
+        auto const &b = nodes[(i + 1) % nodes.size()];
+        if (!on_side(a[Geom::X], Geom::X) || !on_side(a[Geom::Y], Geom::Y)) return false;
+        if (std::abs(a[Geom::X] - b[Geom::X]) > eps && std::abs(a[Geom::Y] - b[Geom::Y]) > eps) return false;
+        twice_area += Geom::cross(b, a);
+    }
+    if (std::abs(std::abs(twice_area) - 2 * rect.area()) > eps * (1 + rect.area())) return false;
+
+    return rect.left() <= area.left() + eps && rect.top() <= area.top() + eps
+        && rect.right() >= area.right() - eps && rect.bottom() >= area.bottom() - eps;
+}
+
 DrawingItem *DrawingShape::_pickItem(Geom::Point const &p, double delta, unsigned flags)
 {
-    if (_repick_after > 0)
+    // A shape shared by clones is picked once per clone, so the last pick says nothing.
+    bool const shared = flags & PICK_SHARED;
+
+    if (_repick_after > 0 && !shared)
         --_repick_after;
 
-    if (_repick_after > 0) { // we are a slow, huge path
+    if (_repick_after > 0 && !shared) { // we are a slow, huge path
         return _last_pick;   // skip this pick, returning what was returned last time
     }
 
@@ -358,7 +400,9 @@ DrawingItem *DrawingShape::_pickItem(Geom::Point const &p, double delta, unsigne
         width = 0; // no width should be applied to clip picking
                    // this overrides display mode and stroke style considerations
     } else if (outline) {
-        width = 0.5; // in outline mode, everything is stroked with the same 0.5px line width
+        // in outline mode, everything is stroked with the same 0.5px line width; in a shared
+        // subtree the clone has already added it to delta, since it is in display pixels
+        width = shared ? 0 : 0.5;
     } else if (_nrstyle.data.stroke.type != NRStyleData::PaintType::NONE && (_nrstyle.data.stroke.opacity > 1e-3 || _drawing.selectZeroOpacity())) {
         // for normal picking calculate the distance corresponding top the stroke width
         float scale = max_expansion(_ctm);
@@ -373,7 +417,7 @@ DrawingItem *DrawingShape::_pickItem(Geom::Point const &p, double delta, unsigne
     bool wind_evenodd = (pick_as_clip ? style_clip_rule : style_fill_rule) == SP_WIND_RULE_EVENODD;
 
     // actual shape picking
-    if (_drawing.getCanvasItemDrawing()) {
+    if (_drawing.getCanvasItemDrawing() && !shared) {
         Geom::Rect viewbox = _drawing.getCanvasItemDrawing()->get_canvas()->get_area_world();
         viewbox.expandBy (width);
         pathv_matrix_point_bbox_wind_distance(_curve->get_pathvector(), _ctm, p, nullptr, needfill? &wind : nullptr, &dist, 0.5, &viewbox);
@@ -405,7 +449,7 @@ DrawingItem *DrawingShape::_pickItem(Geom::Point const &p, double delta, unsigne
 
     // close to the edge, as defined by strokewidth and delta?
     // this ignores dashing (as if the stroke is solid) and always works as if caps are round
-    if (needfill || width > 0) { // if either fill or stroke visible,
+    if (needfill || width > 0 || outline) { // if either fill or stroke visible,
         if ((dist - width) < delta) {
             _last_pick = this;
             return this;
@@ -32,6 +32,9 @@ public:
     void setStyle(SPStyle const *style, SPStyle const *context_style = nullptr) override;
     void setChildrenStyle(SPStyle const *context_style) override;
 
+    /// Whether the path, used as a clip, lets every pixel of the area through.
+    bool clipCovers(Geom::IntRect const &area) const;
+
 protected:
     ~DrawingShape() override = default;
 
@@ -175,6 +175,18 @@ void Drawing::setBlurQuality(int quality)
     });
 }
 
+void Drawing::setPreciseLinearRGB(bool precise)
+{
+    defer([=, this] {
+        // The conversions are global, like the number of filter threads.
+        set_precise_linear_rgb(precise);
+        if (!(_rendermode == RenderMode::OUTLINE || _rendermode == RenderMode::NO_FILTERS)) {
+            _root->_markForUpdate(DrawingItem::STATE_ALL, true);
+            _clearCache();
+        }
+    });
+}
+
 void Drawing::setDithering(bool use_dithering)
 {
     defer([=, this] {
@@ -201,7 +213,7 @@ void Drawing::setCacheLimit(Geom::OptIntRect const &rect)
     defer([=, this] {
         _cache_limit = rect;
         for (auto item : _cached_items) {
-            item->_markForUpdate(DrawingItem::STATE_CACHE, false);
+            item->_markForUpdate(DrawingItem::STATE_CACHE, false, false);
         }
     });
 }
@@ -235,14 +247,15 @@ void Drawing::update(Geom::IntRect const &area, Geom::Affine const &affine, unsi
     }
 }
 
-void Drawing::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flags) const
+void Drawing::render(DrawingContext &dc, Geom::IntRect const &area, unsigned flags, RenderSubset const *subset) const
 {
     apply_antialias(dc, _antialiasing_override.value_or(Antialiasing(_root->_antialias)));
 
     auto rc = RenderContext{
         .outline_color = 0xff,
         .antialiasing_override = _antialiasing_override,
-        .dithering = _use_dithering
+        .dithering = _use_dithering,
+        .subset = subset
     };
     flags |= rendermode_to_renderflags(_rendermode);
 
@@ -338,6 +351,7 @@ void Drawing::_loadPrefs()
 
     // Set the global variable governing the number of filter threads, and track it too. (This is ugly, but hopefully transitional.)
     set_num_filter_threads(prefs->getIntLimited("/options/threading/numthreads", default_numthreads(), 1, 256));
+    set_precise_linear_rgb(prefs->getBool("/options/rendering/preciselinearrgb", false));
 
     // Similarly, enable preference tracking only for the Canvas's drawing.
     if (_canvas_item_drawing) {
@@ -355,6 +369,7 @@ void Drawing::_loadPrefs()
         actions.emplace("/options/selection/zeroopacity",        [this] (auto &entry) { setSelectZeroOpacity(entry.getBool(false)); });
         actions.emplace("/options/renderingcache/size",          [this] (auto &entry) { setCacheBudget((1 << 20) * entry.getIntLimited(64, 0, 4096)); });
         actions.emplace("/options/threading/numthreads",         [this] (auto &entry) { set_num_filter_threads(entry.getIntLimited(default_numthreads(), 1, 256)); });
+        actions.emplace("/options/rendering/preciselinearrgb",   [this] (auto &entry) { setPreciseLinearRGB(entry.getBool(false)); });
 
         _pref_tracker = Inkscape::Preferences::PreferencesObserver::create("/options", [actions = std::move(actions)] (auto &entry) {
             auto it = actions.find(entry.getPath());
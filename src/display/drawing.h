@@ -13,6 +13,7 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_H
 #define INKSCAPE_DISPLAY_DRAWING_H
 
+#include <atomic>
 #include <optional>
 #include <set>
 #include <cstdint>
@@ -57,6 +58,7 @@ public:
     void setFilterQuality(int);
     void setBlurQuality(int);
     void setDithering(bool);
+    void setPreciseLinearRGB(bool);
     void setCursorTolerance(double tol) { _cursor_tolerance = tol; }
     void setSelectZeroOpacity(bool select_zero_opacity) { _select_zero_opacity = select_zero_opacity; }
     void setCacheBudget(size_t bytes);
@@ -81,7 +83,7 @@ public:
 
     void update(Geom::IntRect const &area = Geom::IntRect::infinite(), Geom::Affine const &affine = Geom::identity(),
                 unsigned flags = DrawingItem::STATE_ALL, unsigned reset = 0);
-    void render(DrawingContext &dc, Geom::IntRect const &area, unsigned flags = 0) const;
+    void render(DrawingContext &dc, Geom::IntRect const &area, unsigned flags = 0, RenderSubset const *subset = nullptr) const;
     DrawingItem *pick(Geom::Point const &p, double delta, unsigned flags);
 
     void snapshot();
@@ -122,6 +124,7 @@ private:
 
     std::set<DrawingItem*> _cached_items; // modified by DrawingItem::_setCached()
     CacheList _candidate_items;           // keep this list always sorted with std::greater
+    std::atomic<size_t> _clone_rasters_size{0}; ///< Bytes used by DrawingCloneSource rasters.
 
     /*
      * Simple cacheline separator compatible with x86 (64 bytes) and M* (128 bytes).
@@ -137,6 +140,7 @@ private:
     void defer(F &&f) { _snapshotted ? _funclog.emplace(std::forward<F>(f)) : f(); }
 
     friend class DrawingItem;
+    friend class DrawingCloneSource;
 };
 
 } // namespace Inkscape
@@ -0,0 +1,511 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Rasterizer for mesh gradients.
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"  // only include where actually required!
+#endif
+
+#include "mesh-rasterizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <tuple>
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif // HAVE_OPENMP
+
+#include "cairo-utils.h"
+
+namespace Inkscape {
+
+namespace {
+
+/// Height of the bands of the surface painted in parallel.
+constexpr int BAND_HEIGHT = 32;
+
+/// Width of the pieces of a band whose triangles are set up together.
+constexpr int BIN_WIDTH = 256;
+
+/// Most cells along each side of a patch, only reached by patches far larger than any screen.
+constexpr int MAX_CELLS = 1024;
+
+void bernstein(double t, double (&b)[4])
+{
+    double const s = 1.0 - t;
+    b[0] = s * s * s;
+    b[1] = 3.0 * s * s * t;
+    b[2] = 3.0 * s * t * t;
+    b[3] = t * t * t;
+}
+
+Geom::Point evaluate(Geom::Point const (&control)[4][4], double const (&bu)[4], double const (&bv)[4])
+{
+    Geom::Point p(0, 0);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            p += control[i][j] * (bu[i] * bv[j]);
+        }
+    }
+    return p;
+}
+
+/**
+ * A triangle in pixel space, as the planes of its barycentric coordinates and of its color,
+ * so that both can be evaluated at any pixel as a * (x - x0) + b * (y - y0) + c. The planes
+ * are taken relative to a vertex (x0, y0), so that they stay precise far from the origin.
+ */
+struct Triangle
+{
+    double x0, y0;
+    double a[3], b[3], c[3];
+    float color_a[4], color_b[4], color_c[4];
+    int row_min, row_max;
+    double col_min, col_max;
+};
+
+/// Return whether two transforms only differ by their translation.
+bool same_linear_part(Geom::Affine const &a, Geom::Affine const &b)
+{
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+/// Index of the band containing a pixel coordinate.
+int band_of(double y)
+{
+    return static_cast<int>(std::floor(y / BAND_HEIGHT));
+}
+
+/// Index of the bin of a band containing a pixel coordinate.
+int bin_of(double x)
+{
+    return static_cast<int>(std::floor(x / BIN_WIDTH));
+}
+
+bool setup_triangle(Triangle &t, Geom::Point const *p[3], std::array<float, 4> const *color[3])
+{
+    double const det = (p[1]->y() - p[2]->y()) * (p[0]->x() - p[2]->x())
+                     + (p[2]->x() - p[1]->x()) * (p[0]->y() - p[2]->y());
+    if (std::abs(det) < 1e-12) {
+        return false;
+    }
+
+    auto const ys = std::minmax({p[0]->y(), p[1]->y(), p[2]->y()});
+    t.row_min = static_cast<int>(std::floor(ys.first));
+    t.row_max = static_cast<int>(std::ceil(ys.second));
+    std::tie(t.col_min, t.col_max) = std::minmax({p[0]->x(), p[1]->x(), p[2]->x()});
+
+    t.x0 = p[2]->x();
+    t.y0 = p[2]->y();
+    t.a[0] = (p[1]->y() - p[2]->y()) / det;
+    t.b[0] = (p[2]->x() - p[1]->x()) / det;
+    t.a[1] = (p[2]->y() - p[0]->y()) / det;
+    t.b[1] = (p[0]->x() - p[2]->x()) / det;
+    t.a[2] = -t.a[0] - t.a[1];
+    t.b[2] = -t.b[0] - t.b[1];
+    t.c[0] = t.c[1] = 0.0;
+    t.c[2] = 1.0;
+
+    for (int ch = 0; ch < 4; ch++) {
+        t.color_a[ch] = t.color_b[ch] = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            t.color_a[ch] += t.a[i] * (*color[i])[ch];
+            t.color_b[ch] += t.b[i] * (*color[i])[ch];
+        }
+        t.color_c[ch] = (*color[2])[ch];
+    }
+    return true;
+}
+
+/**
+ * Paint the pixels whose centers lie in the triangle, on one row.
+ *
+ * @param yc The y coordinate of the centers of the row, in the space of the triangle.
+ * @param x_begin, x_end The pixels of the row that may be painted.
+ * @param dx Offset from the x coordinates of the row to the space of the triangle.
+ */
+void fill_span(Triangle const &t, double yc, std::uint32_t *row, int x_begin, int x_end, double dx, float opacity)
+{
+    // Slightly inclusive, so that no pixel is missed on the edges shared by two triangles.
+    constexpr double eps = 1e-7;
+
+    // Relative to the vertex, as a function of the x coordinate of the pixel centers in the row.
+    double const ox = dx - t.x0;
+    double const oy = yc - t.y0;
+
+    double lo = x_begin;
+    double hi = x_end;
+    for (int i = 0; i < 3; i++) {
+        double const c = t.a[i] * ox + t.b[i] * oy + t.c[i];
+        if (t.a[i] > 0) {
+            lo = std::max(lo, (-eps - c) / t.a[i]);
+        } else if (t.a[i] < 0) {
+            hi = std::min(hi, (-eps - c) / t.a[i]);
+        } else if (c < -eps) {
+            return;
+        }
+    }
+    if (lo > hi) {
+        return;
+    }
+    int const x0 = static_cast<int>(std::ceil(lo - 0.5));
+    int const x1 = static_cast<int>(std::min(x_end - 1.0, std::floor(hi - 0.5)));
+
+    float color[4];
+    for (int ch = 0; ch < 4; ch++) {
+        color[ch] = t.color_a[ch] * ox + t.color_b[ch] * oy + t.color_c[ch];
+    }
+
+    for (int x = x0; x <= x1; x++) {
+        float const xc = x + 0.5f;
+        float v[4];
+        for (int ch = 0; ch < 4; ch++) {
+            v[ch] = std::clamp(t.color_a[ch] * xc + color[ch], 0.0f, 1.0f);
+        }
+        // Colors are interpolated unpremultiplied, then premultiplied per pixel, like cairo.
+        float const alpha = v[3] * opacity;
+        auto const a = static_cast<std::uint32_t>(alpha * 255.0f + 0.5f);
+        auto const r = static_cast<std::uint32_t>(v[0] * alpha * 255.0f + 0.5f);
+        auto const g = static_cast<std::uint32_t>(v[1] * alpha * 255.0f + 0.5f);
+        auto const b = static_cast<std::uint32_t>(v[2] * alpha * 255.0f + 0.5f);
+        row[x] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+/// Largest second difference of the control points along either parameter, which bounds how
+/// far the patch strays from a flat grid of cells.
+double curvature(Geom::Point const (&control)[4][4])
+{
+    double along_u = 0.0;
+    double along_v = 0.0;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 1; j < 3; j++) {
+            along_v = std::max(along_v, Geom::L2(control[i][j - 1] - 2 * control[i][j] + control[i][j + 1]));
+            along_u = std::max(along_u, Geom::L2(control[j - 1][i] - 2 * control[j][i] + control[j + 1][i]));
+        }
+    }
+    return along_u + along_v;
+}
+
+/// Largest coefficient of the u * v term of the bilinear color interpolation, over all channels.
+float color_twist(std::array<float, 4> const (&color)[4])
+{
+    float twist = 0.0f;
+    for (int ch = 0; ch < 4; ch++) {
+        twist = std::max(twist, std::abs(color[0][ch] - color[1][ch] + color[2][ch] - color[3][ch]));
+    }
+    return twist;
+}
+
+} // namespace
+
+/**
+ * The triangles of a tessellation for one transform, binned by the parts of the surface they touch.
+ *
+ * Only the patches are binned by band upfront. The triangles of each bin of a band are set up
+ * when it is first drawn. The cells of a patch are only built, transformed and binned once a bin
+ * it touches is drawn, so that patches outside the drawn area are never tessellated, and zooming
+ * far into a large mesh doesn't set up triangles that are never seen.
+ */
+struct MeshTessellation::Setup
+{
+    /// The cells of one patch, binned by the bands they touch.
+    struct Patch
+    {
+        std::once_flag once;
+        Grid const *grid = nullptr;
+        std::vector<Geom::Point> points;    ///< The corners of the grid, in pixels.
+        int first_band = 0;
+        std::vector<std::uint32_t> offsets; ///< Where the cells of each band start, and where the last ends.
+        std::vector<std::uint32_t> cells;   ///< Index of the corner at the lowest u and v of each cell.
+    };
+
+    struct Bin
+    {
+        std::once_flag once;
+        std::vector<Triangle> triangles;
+    };
+
+    Setup(MeshTessellation const &tessellation, Geom::Affine const &gs2px);
+
+    /// Return the triangles touching a bin of a band, in painting order.
+    std::vector<Triangle> const &triangles(int band, int bin);
+
+    /// Return the cells of a patch, building and binning them on first use.
+    Patch const &patch(std::uint32_t index);
+
+    MeshTessellation const &tessellation;
+    Geom::Affine gs2px;
+    std::vector<Patch> patches;
+    std::vector<Geom::Rect> hulls; ///< Bounding box of the control points of each patch, in pixels.
+    int first_band = 0;
+    std::vector<std::vector<std::uint32_t>> bands; ///< The patches that may touch each band, in painting order.
+
+    std::mutex bins_mutex;
+    std::map<std::pair<int, int>, Bin> bins; ///< By band and bin, only those drawn so far.
+};
+
+MeshTessellation::Setup::Setup(MeshTessellation const &tessellation, Geom::Affine const &gs2px)
+    : tessellation{tessellation}
+    , gs2px{gs2px}
+    , patches(tessellation._patches.size())
+{
+    // A patch lies within the hull of its control points.
+    hulls.reserve(patches.size());
+    for (auto const &patch : tessellation._patches) {
+        auto const first = patch.control[0][0] * gs2px;
+        Geom::Rect hull(first, first);
+        for (auto const &row : patch.control) {
+            for (auto const &pt : row) {
+                hull.expandTo(pt * gs2px);
+            }
+        }
+        hulls.push_back(hull);
+    }
+    if (hulls.empty()) {
+        return;
+    }
+
+    first_band = band_of(std::min_element(hulls.begin(), hulls.end(), [] (auto const &a, auto const &b) {
+        return a.top() < b.top();
+    })->top());
+    int const last_band = band_of(std::max_element(hulls.begin(), hulls.end(), [] (auto const &a, auto const &b) {
+        return a.bottom() < b.bottom();
+    })->bottom());
+    bands.resize(last_band - first_band + 1);
+
+    for (std::size_t p = 0; p < hulls.size(); p++) {
+        for (int band = band_of(hulls[p].top()); band <= band_of(hulls[p].bottom()); band++) {
+            bands[band - first_band].push_back(static_cast<std::uint32_t>(p));
+        }
+    }
+}
+
+MeshTessellation::Setup::Patch const &MeshTessellation::Setup::patch(std::uint32_t index)
+{
+    auto &p = patches[index];
+    std::call_once(p.once, [&, this] {
+        auto const &grid = tessellation._grid(index);
+        p.grid = &grid;
+
+        double ymin = std::numeric_limits<double>::infinity();
+        double ymax = -std::numeric_limits<double>::infinity();
+        p.points.reserve(grid.points.size());
+        for (auto const &pt : grid.points) {
+            p.points.push_back(pt * gs2px);
+            ymin = std::min(ymin, p.points.back().y());
+            ymax = std::max(ymax, p.points.back().y());
+        }
+        p.first_band = band_of(ymin);
+        p.offsets.assign(band_of(ymax) - p.first_band + 2, 0);
+
+        // Bin the cells by band, keeping them in painting order within each band.
+        int const n = grid.n;
+        auto const for_each_cell_band = [&] (auto &&f) {
+            for (int i = 0; i < n; i++) {
+                for (int j = 0; j < n; j++) {
+                    int const k = i * (n + 1) + j;
+                    auto const ys = std::minmax({p.points[k].y(), p.points[k + 1].y(),
+                                                 p.points[k + n + 1].y(), p.points[k + n + 2].y()});
+                    for (int band = band_of(ys.first); band <= band_of(ys.second); band++) {
+                        f(band - p.first_band, k);
+                    }
+                }
+            }
+        };
+        for_each_cell_band([&] (int band, int) { p.offsets[band + 1]++; });
+        std::partial_sum(p.offsets.begin(), p.offsets.end(), p.offsets.begin());
+        p.cells.resize(p.offsets.back());
+        auto next = p.offsets;
+        for_each_cell_band([&] (int band, int k) { p.cells[next[band]++] = static_cast<std::uint32_t>(k); });
+    });
+    return p;
+}
+
+std::vector<Triangle> const &MeshTessellation::Setup::triangles(int band, int bin)
+{
+    Bin *b;
+    {
+        auto lock = std::lock_guard(bins_mutex);
+        b = &bins[{band, bin}];
+    }
+    std::call_once(b->once, [&, this] {
+        double const left = static_cast<double>(bin) * BIN_WIDTH;
+        double const right = left + BIN_WIDTH;
+        for (auto const index : bands[band - first_band]) {
+            if (hulls[index].right() < left || hulls[index].left() > right) {
+                continue;
+            }
+            auto const &p = patch(index);
+            int const i = band - p.first_band;
+            if (i < 0 || i + 1 >= static_cast<int>(p.offsets.size())) {
+                continue;
+            }
+            int const n = p.grid->n;
+            for (auto c = p.offsets[i]; c < p.offsets[i + 1]; c++) {
+                int const corner = p.cells[c];
+                int const k[4] = {corner, corner + 1, corner + n + 2, corner + n + 1};
+                // Split the cell into two triangles.
+                for (int half = 0; half < 2; half++) {
+                    int const idx[3] = {k[0], k[1 + half], k[2 + half]};
+                    Geom::Point const *pt[3];
+                    std::array<float, 4> const *color[3];
+                    for (int v = 0; v < 3; v++) {
+                        pt[v] = &p.points[idx[v]];
+                        color[v] = &p.grid->colors[idx[v]];
+                    }
+                    Triangle t;
+                    if (setup_triangle(t, pt, color) && t.col_max >= left && t.col_min <= right) {
+                        b->triangles.push_back(t);
+                    }
+                }
+            }
+        }
+    });
+    return b->triangles;
+}
+
+MeshTessellation::MeshTessellation(std::vector<MeshPatch> const &patches, double scale)
+    : _patches{patches}
+    , _scale{scale}
+    , _grids(patches.size())
+{
+    for (auto const &patch : patches) {
+        Geom::Rect extent(patch.control[0][0], patch.control[0][0]);
+        for (auto const &row : patch.control) {
+            for (auto const &pt : row) {
+                extent.expandTo(pt);
+            }
+        }
+        _bounds.unionWith(extent);
+    }
+}
+
+MeshTessellation::Grid const &MeshTessellation::_grid(std::size_t index) const
+{
+    auto &grid = _grids[index];
+    std::call_once(grid.once, [&, this] {
+        auto const &patch = _patches[index];
+
+        // Flat cells stray from a cubic patch by at most 3/4 of the largest second difference
+        // of its control points over n², so keep that below a quarter of a pixel at this scale.
+        // Linear interpolation of the colors over the two triangles of a cell is off by at most
+        // a quarter of their twist over n², so keep that below half a color step as well.
+        double const bend = 3.0 * curvature(patch.control) * _scale;
+        double const twist = 127.5 * color_twist(patch.color);
+        int const n = std::clamp(static_cast<int>(std::ceil(std::sqrt(std::max(bend, twist)))), 4, MAX_CELLS);
+
+        grid.n = n;
+        grid.points.reserve((n + 1) * (n + 1));
+        grid.colors.reserve((n + 1) * (n + 1));
+
+        for (int i = 0; i <= n; i++) {
+            double const u = static_cast<double>(i) / n;
+            double bu[4];
+            bernstein(u, bu);
+            for (int j = 0; j <= n; j++) {
+                double const v = static_cast<double>(j) / n;
+                double bv[4];
+                bernstein(v, bv);
+                grid.points.push_back(evaluate(patch.control, bu, bv));
+
+                // Bilinear in the parameters, with the corners at (0, 0), (0, 1), (1, 1), (1, 0).
+                std::array<float, 4> color;
+                for (int ch = 0; ch < 4; ch++) {
+                    color[ch] = (1 - u) * (1 - v) * patch.color[0][ch] + (1 - u) * v * patch.color[1][ch]
+                              + u * v * patch.color[2][ch] + u * (1 - v) * patch.color[3][ch];
+                }
+                grid.colors.push_back(color);
+            }
+        }
+    });
+    return grid;
+}
+
+MeshTessellation::~MeshTessellation() = default;
+
+std::shared_ptr<MeshTessellation::Setup> MeshTessellation::_setup_for(Geom::Affine const &gs2px) const
+{
+    auto lock = std::lock_guard(_setup_mutex);
+    if (!_setup || !same_linear_part(_setup->gs2px, gs2px)) {
+        _setup = std::make_shared<Setup>(*this, gs2px);
+    }
+    return _setup;
+}
+
+void MeshTessellation::rasterize(cairo_surface_t *surface, Geom::Affine const &gs2px, double opacity) const
+{
+    assert(cairo_image_surface_get_format(surface) == CAIRO_FORMAT_ARGB32);
+
+    cairo_surface_flush(surface);
+    int const width = cairo_image_surface_get_width(surface);
+    int const height = cairo_image_surface_get_height(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    unsigned char *const data = cairo_image_surface_get_data(surface);
+
+    auto const setup = _setup_for(gs2px);
+
+    // The pixels of the surface are offset from those the triangles were set up in.
+    auto const offset = setup->gs2px.translation() - gs2px.translation();
+
+    int const band_min = std::max(setup->first_band, band_of(offset.y()));
+    int const band_max = std::min(setup->first_band + static_cast<int>(setup->bands.size()) - 1, band_of(height + offset.y()));
+    int const bin_min = bin_of(offset.x());
+    int const bin_max = bin_of(width + offset.x());
+    float const alpha = opacity;
+
+#if HAVE_OPENMP
+    int const num_threads = get_num_filter_threads();
+    #pragma omp parallel for schedule(dynamic) if(band_max > band_min) num_threads(num_threads)
+#endif // HAVE_OPENMP
+    for (int band = band_min; band <= band_max; band++) {
+        // The rows of the surface whose centers lie in the band.
+        int const band_begin = std::max(0, static_cast<int>(std::ceil(band * BAND_HEIGHT - 0.5 - offset.y())));
+        int const band_end = std::min(height, static_cast<int>(std::ceil((band + 1) * BAND_HEIGHT - 0.5 - offset.y())));
+        if (band_begin >= band_end) {
+            continue;
+        }
+        // Each bin only paints its own columns, so that triangles in a later bin cannot paint
+        // over later patches in an earlier one.
+        for (int bin = bin_min; bin <= bin_max; bin++) {
+            int const bin_begin = std::max(0, static_cast<int>(std::ceil(bin * BIN_WIDTH - 0.5 - offset.x())));
+            int const bin_end = std::min(width, static_cast<int>(std::ceil((bin + 1) * BIN_WIDTH - 0.5 - offset.x())));
+            if (bin_begin >= bin_end) {
+                continue;
+            }
+            for (auto const &t : setup->triangles(band, bin)) {
+                int const y0 = std::max(band_begin, static_cast<int>(std::ceil(t.row_min - 0.5 - offset.y())));
+                int const y1 = std::min(band_end, static_cast<int>(std::ceil(t.row_max + 0.5 - offset.y())));
+                for (int y = y0; y < y1; y++) {
+                    fill_span(t, y + 0.5 + offset.y(), reinterpret_cast<std::uint32_t *>(data + y * stride),
+                              bin_begin, bin_end, offset.x(), alpha);
+                }
+            }
+        }
+    }
+
+    cairo_surface_mark_dirty(surface);
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Rasterizer for mesh gradients.
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_MESH_RASTERIZER_H
+#define INKSCAPE_DISPLAY_MESH_RASTERIZER_H
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cairo.h>
+#include <2geom/affine.h>
+#include <2geom/point.h>
+#include <2geom/rect.h>
+
+namespace Inkscape {
+
+/**
+ * One patch of a mesh gradient, as a tensor-product Bézier patch.
+ */
+struct MeshPatch
+{
+    /// Control points, indexed by [u][v]. The corners numbered 0 to 3 by cairo are at
+    /// [0][0], [0][3], [3][3] and [3][0].
+    Geom::Point control[4][4];
+    std::array<float, 4> color[4]; ///< Unpremultiplied RGBA of each corner.
+};
+
+/**
+ * A mesh gradient subdivided into grids of cells, which are small enough at a given scale
+ * to be shaded by linear interpolation between their corners.
+ *
+ * Building it is the expensive part of drawing a mesh. It only depends on the zoom level,
+ * so it can be reused for every tile and every scroll position. The grid of a patch is only
+ * built once the patch is first drawn on, so patches outside every drawn area cost nothing.
+ * The triangles it is drawn with are set up once per transform too, and reused for every
+ * surface that only differs from the previous one by a translation.
+ */
+class MeshTessellation
+{
+public:
+    /**
+     * @param patches The patches, in gradient space.
+     * @param scale Size of a unit of gradient space in pixels, which determines the cell size.
+     */
+    MeshTessellation(std::vector<MeshPatch> const &patches, double scale);
+    ~MeshTessellation();
+
+    /**
+     * Paint the mesh into an ARGB32 image surface, like cairo's mesh pattern would. Like cairo,
+     * later patches are painted over earlier ones, and pixels outside the mesh are left alone.
+     *
+     * Bands of the surface are painted in parallel.
+     *
+     * @param gs2px Transform from gradient space to the pixels of the surface.
+     * @param opacity Multiplies the alpha of every color.
+     */
+    void rasterize(cairo_surface_t *surface, Geom::Affine const &gs2px, double opacity) const;
+
+    /// The area covered by the mesh, in gradient space.
+    Geom::OptRect const &bounds() const { return _bounds; }
+
+private:
+    struct Grid
+    {
+        std::once_flag once;
+        int n; ///< Number of cells along each side.
+        std::vector<Geom::Point> points;          ///< The (n + 1)² cell corners, at u * (n + 1) + v.
+        std::vector<std::array<float, 4>> colors; ///< Unpremultiplied RGBA of each corner.
+    };
+
+    struct Setup;
+
+    /// Return the grid of a patch, building it on first use.
+    Grid const &_grid(std::size_t patch) const;
+
+    /// Return the triangles for @a gs2px, reusing the last ones if only the translation differs.
+    std::shared_ptr<Setup> _setup_for(Geom::Affine const &gs2px) const;
+
+    std::vector<MeshPatch> _patches;
+    double _scale;
+    mutable std::vector<Grid> _grids;
+    Geom::OptRect _bounds;
+
+    mutable std::mutex _setup_mutex;
+    mutable std::shared_ptr<Setup> _setup;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_MESH_RASTERIZER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
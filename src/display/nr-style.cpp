@@ -309,6 +309,13 @@ auto NRStyle::preparePaint(Inkscape::DrawingContext &dc, Inkscape::RenderContext
         return CairoPatternUniqPtr(pattern->renderPattern(rc, area, paint.opacity, dc.surface()->device_scale()));
     }
 
+    if (paint.type == NRStyleData::PaintType::SERVER && paint.server && paint.server->varies_per_draw()) {
+        // Only mesh gradients; the radial gradient merely reads the cairo_t and can be cached.
+        auto pat = CairoPatternUniqPtr(paint.server->create_pattern(dc.raw(), paintbox, paint.opacity));
+        ink_cairo_pattern_set_dither(pat.get(), rc.dithering && paint.server->ditherable());
+        return pat;
+    }
+
     // Otherwise, init or re-use cached pattern.
     cp.inited.init([&] {
         // Handle remaining non-DrawingPattern cases.
@@ -17,10 +17,12 @@ X(DrawingItem,\
     X(DrawingShape)\
     X(DrawingImage)\
     X(DrawingGroup,\
+        X(DrawingCloneSource)\
         X(DrawingPattern)\
         X(DrawingText)\
     )\
     X(DrawingGlyphs)\
+    X(DrawingClone)\
 )
 
 namespace Inkscape {
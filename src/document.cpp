@@ -45,6 +45,7 @@
 
 #include <2geom/transforms.h>
 
+#include "conn-router.h"
 #include "desktop.h"
 #include "document-undo.h"
 #include "event-log.h"
@@ -79,6 +80,7 @@
 #include "object/sp-page.h"
 #include "object/sp-root.h"
 #include "object/sp-symbol.h"
+#include "object/sp-use.h"
 #include "ui/widget/canvas.h"
 #include "ui/widget/desktop-widget.h"
 #include "util/units.h"
@@ -115,7 +117,8 @@ SPDocument::SPDocument() :
     document_name(nullptr),
     actionkey(),
     object_id_counter(1),
-    _router(std::make_unique<Avoid::Router>(Avoid::PolyLineRouting|Avoid::OrthogonalRouting)),
+    _conn_router(std::make_unique<Inkscape::ConnRouter>(
+        std::make_unique<Avoid::Router>(Avoid::PolyLineRouting|Avoid::OrthogonalRouting))),
     current_persp3d(nullptr),
     current_persp3d_impl(nullptr),
     _activexmltree(nullptr)
@@ -137,7 +140,7 @@ SPDocument::SPDocument() :
 
     // Penalise libavoid for choosing paths with needless extra segments.
     // This results in much better looking orthogonal connector paths.
-    _router->setRoutingPenalty(Avoid::segmentPenalty);
+    getRouter()->setRoutingPenalty(Avoid::segmentPenalty);
 
     _serial = next_serial++;
 
@@ -1328,6 +1331,16 @@ std::string SPDocument::generate_unique_id(char const *prefix)
     return result;
 }
 
+unsigned long &SPDocument::id_clash_counter(std::string const &id)
+{
+    // Start over rather than keep a counter for every ID ever renamed in this document.
+    constexpr size_t MAX_ID_CLASH_COUNTERS = 1024;
+    if (_id_clash_counters.size() >= MAX_ID_CLASH_COUNTERS && !_id_clash_counters.contains(id)) {
+        _id_clash_counters.clear();
+    }
+    return _id_clash_counters[id];
+}
+
 void SPDocument::bindObjectToRepr(Inkscape::XML::Node *repr, SPObject *object)
 {
     if (object) {
@@ -1461,7 +1474,8 @@ gint SPDocument::ensureUpToDate()
 {
     // Bring the document up-to-date, specifically via the following:
     //   1a) Process all document updates.
-    //   1b) When completed, process connector routing changes.
+    //   1b) When completed, process connector routing changes, waiting for
+    //       any routing still running in the background.
     //   2a) Process any updates resulting from connector reroutings.
     int counter = 32;
     for (unsigned int pass = 1; pass <= 2; ++pass) {
@@ -1480,9 +1494,9 @@ gint SPDocument::ensureUpToDate()
 
         // After updates on the first pass we get libavoid to process all the
         // changed objects and provide new routings.  This may cause some objects
-            // to be modified, hence the second update pass.
+        // to be modified, hence the second update pass.
         if (pass == 1) {
-            _router->processTransaction();
+            _conn_router->route();
         }
     }
 
@@ -1507,6 +1521,32 @@ SPDocument::idle_handler()
     return status;
 }
 
+/**
+ * Returns the connector router, after waiting for any routing still
+ * running in the background.
+ */
+Avoid::Router *SPDocument::getRouter() const
+{
+    return _conn_router->get();
+}
+
+SPUseSharedDrawings &SPDocument::getUseSharedDrawings()
+{
+    if (!_use_shared_drawings) {
+        _use_shared_drawings = std::make_unique<SPUseSharedDrawings>();
+    }
+    return *_use_shared_drawings;
+}
+
+/**
+ * Waits for any routing still running in the background, so that connector
+ * objects owned by the router may be changed directly.
+ */
+void SPDocument::waitForRouter() const
+{
+    _conn_router->wait();
+}
+
 /**
  * An idle handler to reroute connectors in the document.
  */
@@ -1514,9 +1554,10 @@ bool
 SPDocument::rerouting_handler()
 {
     // Process any queued movement actions and determine new routings for
-    // object-avoiding connectors.  Callbacks will be used to update and
-    // redraw affected connectors.
-    _router->processTransaction();
+    // object-avoiding connectors.  This runs on a worker thread so that
+    // dragging stays smooth however many connectors there are; affected
+    // connectors are redrawn once the new routes are known.
+    _conn_router->routeInBackground();
 
     // We don't need to handle rerouting again until there are further
     // diagram updates.
@@ -2003,14 +2044,17 @@ void SPDocument::importDefs(SPDocument *source)
     Inkscape::XML::Node *target_defs = this->getDefs()->getRepr();
     std::vector<Inkscape::XML::Node const *> defsNodes = sp_repr_lookup_name_many(root, "svg:defs");
 
-    prevent_id_clashes(source, this);
+    // Found once, as merging every duplicate definition changes references in the source.
+    IdReferences source_refs(source);
+    prevent_id_clashes(source, this, source_refs);
 
     for (auto & defsNode : defsNodes) {
-       _importDefsNode(source, const_cast<Inkscape::XML::Node *>(defsNode), target_defs);
+       _importDefsNode(source, const_cast<Inkscape::XML::Node *>(defsNode), target_defs, source_refs);
     }
 }
 
-void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs, Inkscape::XML::Node *target_defs)
+void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs, Inkscape::XML::Node *target_defs,
+                                 IdReferences &source_refs)
 {
     int stagger=0;
 
@@ -2074,7 +2118,7 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
                         // Change object references to the existing equivalent gradient
                         Glib::ustring newid = trg.getId();
                         if (newid != defid) { // id could be the same if it is a second paste into the same document
-                            change_def_references(src, &trg);
+                            change_def_references(src, &trg, source_refs);
                         }
                         gchar *longid = g_strdup_printf("%s_%9.9d", DuplicateDefString.c_str(), stagger++);
                         def->setAttribute("id", longid);
@@ -2088,7 +2132,7 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
                         // Change object references to the existing equivalent gradient
                         Glib::ustring newid = trg.getId();
                         if (newid != defid) { // id could be the same if it is a second paste into the same document
-                            change_def_references(src, &trg);
+                            change_def_references(src, &trg, source_refs);
                         }
                         gchar *longid = g_strdup_printf("%s_%9.9d", DuplicateDefString.c_str(), stagger++);
                         def->setAttribute("id", longid);
@@ -2119,7 +2163,7 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
                     if (t_gr && s_gr->isEquivalent(t_gr)) {
                         // Change object references to the existing equivalent gradient
                         // two id's in the clipboard should never be the same, so always change references
-                        change_def_references(trg, src);
+                        change_def_references(trg, src, source_refs);
                         gchar *longid = g_strdup_printf("%s_%9.9d", DuplicateDefString.c_str(), stagger++);
                         laterDef->setAttribute("id", longid);
                         g_free(longid);
@@ -2134,7 +2178,7 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
                     if (t_lpeobj->is_similar(s_lpeobj)) {
                         // Change object references to the existing equivalent gradient
                         // two id's in the clipboard should never be the same, so always change references
-                        change_def_references(trg, src);
+                        change_def_references(trg, src, source_refs);
                         gchar *longid = g_strdup_printf("%s_%9.9d", DuplicateDefString.c_str(), stagger++);
                         laterDef->setAttribute("id", longid);
                         g_free(longid);
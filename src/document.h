@@ -25,6 +25,7 @@
 #include <queue>                               // for queue
 #include <span>
 #include <string>                              // for string
+#include <unordered_map>                       // for unordered_map
 #include <vector>                              // for vector
 
 #include <boost/ptr_container/ptr_list.hpp>    // for ptr_list
@@ -70,6 +71,7 @@ class Router;
 
 class Persp3D;
 class Persp3DImpl;
+class IdReferences;
 class SPDefs;
 class SPGroup;
 class SPItem;
@@ -77,8 +79,10 @@ class SPItemCtx;
 class SPNamedView;
 class SPObject;
 class SPRoot;
+class SPUseSharedDrawings;
 
 namespace Inkscape {
+    class ConnRouter;
     class DocumentUndo;
     class Event;
     class EventLog;
@@ -170,7 +174,8 @@ public:
 
 
 private:
-    void _importDefsNode(SPDocument *source, Inkscape::XML::Node *defs, Inkscape::XML::Node *target_defs);
+    void _importDefsNode(SPDocument *source, Inkscape::XML::Node *defs, Inkscape::XML::Node *target_defs,
+                         IdReferences &source_refs);
     SPObject *_activexmltree;
 
     std::unique_ptr<Inkscape::PageManager> _page_manager;
@@ -192,7 +197,12 @@ public:
 
     // Document structure -----------------
     Inkscape::ProfileManager &getProfileManager() const { return *_profileManager; }
-    Avoid::Router* getRouter() const { return _router.get(); }
+    Avoid::Router* getRouter() const;
+    void waitForRouter() const;
+    Inkscape::ConnRouter &getConnRouter() const { return *_conn_router; }
+
+    /// The drawings shared between clones of the same original, see SPUse.
+    SPUseSharedDrawings &getUseSharedDrawings();
 
     
     /** Returns our SPRoot */
@@ -296,6 +306,15 @@ public:
      */
     std::string generate_unique_id(char const *prefix);
 
+    /**
+     * @brief Last number appended to an ID to resolve a clash with it.
+     *
+     * Kept with the document that receives the renamed objects, so pasting the same content
+     * again continues the numbering instead of probing the taken IDs from 1. The counters only
+     * save probing, so they are forgotten once there are too many of them.
+     */
+    unsigned long &id_clash_counter(std::string const &id);
+
     /**
      * @brief Set the reference document object.
      * Use this function to extend functionality of getObjectById() - it will search in reference document.
@@ -368,7 +387,8 @@ private:
 
     // Document ------------------------------
     std::unique_ptr<Inkscape::ProfileManager> _profileManager;   // Color profile.
-    std::unique_ptr<Avoid::Router> _router; // Instance of the connector router
+    std::unique_ptr<Inkscape::ConnRouter> _conn_router; // Instance of the connector router
+    std::unique_ptr<SPUseSharedDrawings> _use_shared_drawings; // Created on first use
     std::unique_ptr<Inkscape::Selection> _selection;
 
     // Document status -----------------------
@@ -437,6 +457,7 @@ private:
     unsigned long _serial; // Unique document number (used by undo/redo).
     Glib::ustring actionkey; // Last action key, used to combine actions in undo.
     unsigned long object_id_counter; // Steadily-incrementing counter used to assign unique ids to objects.
+    std::unordered_map<std::string, unsigned long> _id_clash_counters; // See id_clash_counter().
 
     // Garbage collecting ----------------------
 
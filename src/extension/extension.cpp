@@ -194,6 +194,14 @@ Extension::set_state (state_t in_state)
         /** \todo Need some more error checking here! */
         switch (in_state) {
             case STATE_LOADED:
+                if (_check_deferred) {
+                    // Startup trusted the registry cache; do the real check now that we need it.
+                    _check_deferred = false;
+                    if (!check()) {
+                        deactivate();
+                        break;
+                    }
+                }
                 if (imp->load(this))
                     _state = STATE_LOADED;
 
@@ -920,6 +928,7 @@ Extension::error_file_close ()
 {
     if (error_file) {
         fclose(error_file);
+        error_file = nullptr;
     }
 };
 
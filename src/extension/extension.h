@@ -161,7 +161,9 @@ protected:
                                                  *  (currently only used by Effects) */
     std::string _base_directory;               /**< Directory containing the .inx file,
                                                  *  relative paths in the extension should usually be relative to it */
+    std::string _inx_file;                     /**< Path of the .inx file the extension was built from, if any */
     std::unique_ptr<ExpirationTimer> timer;    /**< Timeout to unload after a given time */
+    bool _check_deferred = false;              /**< check() was skipped at startup and must run before loading */
     bool _translation_enabled = true;          /**< Attempt translation of strings provided by the extension? */
 
 private:
@@ -192,6 +194,9 @@ public:
     ExecutionEnv *get_execution_env () { return execution_env; };
     auto const   &get_base_directory() const { return _base_directory; };
     void          set_base_directory(std::string const &base_directory) { _base_directory = base_directory; };
+    auto const   &get_inx_file () const { return _inx_file; };
+    void          set_inx_file (std::string const &inx_file) { _inx_file = inx_file; };
+    void          defer_check  () { _check_deferred = true; };
     std::string   get_dependency_location(char const *name);
     char const   *get_translation(char const *msgid, char const *msgctxt = nullptr) const;
     void          set_environment(SPDocument const *doc = nullptr);
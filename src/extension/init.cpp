@@ -25,6 +25,7 @@
 #include <glibmm/ustring.h>
 
 #include "db.h"
+#include "registry-cache.h"
 #include "internal/emf-inout.h"
 #include "internal/emf-print.h"
 #include "internal/svgz.h"
@@ -327,9 +328,20 @@ check_extensions_internal(Extension *in_plug, gpointer in_data)
 {
     int *count = (int *)in_data;
 
-    if (in_plug == nullptr) return;
-    if (!in_plug->deactivated() && !in_plug->check()) {
-         in_plug->deactivate();
+    if (in_plug == nullptr || in_plug->deactivated()) return;
+
+    // Probing dependencies can be slow (file system lookups along PATH); skip it for extensions
+    // that passed before with an identical .inx file. They get checked when first loaded.
+    auto &cache = RegistryCache::get();
+    if (cache.passed(in_plug)) {
+        in_plug->defer_check();
+        return;
+    }
+
+    bool const ok = in_plug->check();
+    cache.record(in_plug, ok);
+    if (!ok) {
+        in_plug->deactivate();
         (*count)++;
     }
 }
@@ -344,6 +356,7 @@ static void check_extensions()
         db.foreach(check_extensions_internal, (gpointer)&count);
     }
     Inkscape::Extension::Extension::error_file_close();
+    RegistryCache::get().save();
 }
 
 } } /* namespace Inkscape::Extension */
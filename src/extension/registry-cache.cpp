@@ -0,0 +1,493 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Persistent cache of extension descriptors and check results.
+ *
+ * Copyright (C) 2026 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "registry-cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <glib/gstdio.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+#include <glibmm/regex.h>
+
+#include "extension.h"
+#include "inkscape-version.h"
+#include "io/resource.h"
+#include "io/sys.h"
+#include "xml/simple-document.h"
+#include "xml/text-node.h"
+
+namespace Inkscape::Extension {
+
+namespace {
+
+constexpr char MAGIC[4] = {'I', 'X', 'R', 'C'};
+constexpr std::uint32_t FORMAT_VERSION = 2;
+
+constexpr std::uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+
+// FNV-1a, good enough to notice edits that keep a file's size and mtime. Named apart from the
+// string overload, so that a string literal cannot take the seed for a length.
+std::uint64_t fnv1a_bytes(void const *data, std::size_t len, std::uint64_t h = FNV_OFFSET)
+{
+    auto p = static_cast<unsigned char const *>(data);
+    for (std::size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+std::uint64_t fnv1a(std::string const &s, std::uint64_t h)
+{
+    // Include the terminator so that consecutive strings cannot run into each other.
+    return fnv1a_bytes(s.c_str(), s.size() + 1, h);
+}
+
+template <typename T>
+void write_pod(std::string &out, T const &v)
+{
+    out.append(reinterpret_cast<char const *>(&v), sizeof(T));
+}
+
+template <typename T>
+bool read_pod(FILE *f, T &v)
+{
+    return std::fread(&v, sizeof(T), 1, f) == 1;
+}
+
+bool read_string(FILE *f, std::string &s, std::uint32_t max_len)
+{
+    std::uint32_t len = 0;
+    if (!read_pod(f, len) || len > max_len) {
+        return false;
+    }
+    s.resize(len);
+    return std::fread(s.data(), 1, len, f) == len;
+}
+
+bool stat_file(std::string const &path, std::int64_t &mtime, std::int64_t &size)
+{
+    GStatBuf st;
+    if (g_stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    mtime = st.st_mtime;
+    size = st.st_size;
+    return true;
+}
+
+void write_string(std::string &out, char const *s)
+{
+    auto const len = static_cast<std::uint32_t>(s ? std::strlen(s) : 0);
+    write_pod(out, len);
+    out.append(s, len);
+}
+
+/// Cursor over a descriptor read back from the cache; every read fails once one has.
+class Reader
+{
+public:
+    explicit Reader(std::string const &data) : _data{data} {}
+
+    template <typename T>
+    bool pod(T &v)
+    {
+        if (_data.size() - _pos < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&v, _data.data() + _pos, sizeof(T));
+        _pos += sizeof(T);
+        return true;
+    }
+
+    bool string(std::string &s)
+    {
+        std::uint32_t len = 0;
+        if (!pod(len) || _data.size() - _pos < len) {
+            return false;
+        }
+        s.assign(_data, _pos, len);
+        _pos += len;
+        return true;
+    }
+
+private:
+    std::string const &_data;
+    std::size_t _pos = 0;
+};
+
+/**
+ * Serialize a node and its descendants in the order they are built back by read_node(). Names
+ * are stored qualified, as the parser left them, so no namespace handling is repeated on reading.
+ */
+void write_node(std::string &out, XML::Node const *node)
+{
+    write_pod(out, static_cast<std::uint8_t>(node->type()));
+    switch (node->type()) {
+        case XML::NodeType::ELEMENT_NODE: {
+            write_string(out, node->name());
+            auto const &attributes = node->attributeList();
+            write_pod(out, static_cast<std::uint32_t>(attributes.size()));
+            for (auto const &attr : attributes) {
+                write_string(out, g_quark_to_string(attr.key));
+                write_string(out, attr.value.pointer());
+            }
+            write_pod(out, static_cast<std::uint32_t>(node->childCount()));
+            for (auto child = node->firstChild(); child; child = child->next()) {
+                write_node(out, child);
+            }
+            break;
+        }
+        case XML::NodeType::TEXT_NODE: {
+            auto const text = dynamic_cast<XML::TextNode const *>(node);
+            write_pod(out, static_cast<std::uint8_t>(text && text->is_CData()));
+            write_string(out, node->content());
+            break;
+        }
+        case XML::NodeType::PI_NODE:
+            write_string(out, node->name());
+            [[fallthrough]];
+        case XML::NodeType::COMMENT_NODE:
+            write_string(out, node->content());
+            break;
+        default:
+            break;
+    }
+}
+
+/// Build the node written by write_node(), or return nullptr if the data is truncated.
+XML::Node *read_node(Reader &in, XML::Document *doc)
+{
+    std::uint8_t type = 0;
+    std::string name, content;
+    if (!in.pod(type)) {
+        return nullptr;
+    }
+    switch (static_cast<XML::NodeType>(type)) {
+        case XML::NodeType::ELEMENT_NODE: {
+            std::uint32_t count = 0;
+            if (!in.string(name) || !in.pod(count)) {
+                return nullptr;
+            }
+            auto repr = doc->createElement(name.c_str());
+            for (std::uint32_t i = 0; i < count; i++) {
+                if (!in.string(name) || !in.string(content)) {
+                    Inkscape::GC::release(repr);
+                    return nullptr;
+                }
+                repr->setAttribute(name, content);
+            }
+            if (!in.pod(count)) {
+                Inkscape::GC::release(repr);
+                return nullptr;
+            }
+            for (std::uint32_t i = 0; i < count; i++) {
+                auto child = read_node(in, doc);
+                if (!child) {
+                    Inkscape::GC::release(repr);
+                    return nullptr;
+                }
+                repr->appendChild(child);
+                Inkscape::GC::release(child);
+            }
+            return repr;
+        }
+        case XML::NodeType::TEXT_NODE: {
+            std::uint8_t cdata = 0;
+            if (!in.pod(cdata) || !in.string(content)) {
+                return nullptr;
+            }
+            return doc->createTextNode(content.c_str(), cdata);
+        }
+        case XML::NodeType::PI_NODE:
+            if (!in.string(name) || !in.string(content)) {
+                return nullptr;
+            }
+            return doc->createPI(name.c_str(), content.c_str());
+        case XML::NodeType::COMMENT_NODE:
+            if (!in.string(content)) {
+                return nullptr;
+            }
+            return doc->createComment(content.c_str());
+        default:
+            return nullptr;
+    }
+}
+
+} // namespace
+
+RegistryCache &RegistryCache::get()
+{
+    static RegistryCache instance;
+    return instance;
+}
+
+RegistryCache::RegistryCache()
+    : _filename{IO::Resource::get_path_string(IO::Resource::CACHE, IO::Resource::NONE, "extension-registry.bin")}
+    , _stamp{environment_stamp()}
+{
+    load();
+}
+
+/**
+ * Hash what, outside the .inx files themselves, changes the outcome of a check and can be read
+ * cheaply: the Inkscape version, the executable search path with the mtimes of its directories,
+ * and the locations of the extension directories. Scripts and modules below those directories
+ * are not looked at; an extension whose entry is trusted is still checked in full when it is
+ * first loaded, and deactivated then if one of its dependencies went away.
+ */
+std::uint64_t RegistryCache::environment_stamp()
+{
+    std::uint64_t h = fnv1a(std::string(Inkscape::version_string), FNV_OFFSET);
+
+    // Installing or removing a program changes the mtime of its directory in the search path.
+    auto const path = Glib::getenv("PATH");
+    h = fnv1a(path, h);
+    for (auto const &dir : Glib::Regex::split_simple(G_SEARCHPATH_SEPARATOR_S, path)) {
+        std::int64_t mtime = 0, size = 0;
+        stat_file(dir, mtime, size);
+        h = fnv1a_bytes(&mtime, sizeof(mtime), h);
+    }
+
+    using namespace IO::Resource;
+    for (auto domain : {SYSTEM, SHARED, USER}) {
+        h = fnv1a(get_path_string(domain, EXTENSIONS), h);
+    }
+    return h;
+}
+
+std::uint64_t RegistryCache::file_hash(std::string const &path)
+{
+    try {
+        auto contents = Glib::file_get_contents(path);
+        return fnv1a_bytes(contents.data(), contents.size());
+    } catch (Glib::FileError const &) {
+        return 0;
+    }
+}
+
+RegistryCache::Key RegistryCache::make_key(Extension *ext)
+{
+    Key key = ext->get_inx_file();
+    key += '\0';
+    key += ext->get_id();
+    return key;
+}
+
+void RegistryCache::load()
+{
+    FILE *f = IO::fopen_utf8name(_filename.c_str(), "rb");
+    if (!f) {
+        return;
+    }
+
+    char magic[sizeof(MAGIC)];
+    std::uint32_t version = 0;
+    std::uint64_t stamp = 0;
+    std::uint32_t count = 0;
+    if (std::fread(magic, sizeof(magic), 1, f) != 1 || std::memcmp(magic, MAGIC, sizeof(MAGIC)) ||
+        !read_pod(f, version) || version != FORMAT_VERSION ||
+        !read_pod(f, stamp) || stamp != _stamp ||
+        !read_pod(f, count))
+    {
+        std::fclose(f);
+        _dirty = true; // Stale or foreign; rewrite it.
+        return;
+    }
+
+    bool ok = true;
+    for (std::uint32_t i = 0; ok && i < count; i++) {
+        Key key;
+        Entry entry;
+        std::uint8_t passed = 0;
+        ok = read_string(f, key, 4096) &&
+             read_pod(f, entry.mtime) && read_pod(f, entry.size) && read_pod(f, entry.hash) &&
+             read_pod(f, passed);
+        if (ok) {
+            entry.passed = passed;
+            _entries.emplace(std::move(key), entry);
+        }
+    }
+
+    ok = ok && read_pod(f, count);
+    for (std::uint32_t i = 0; ok && i < count; i++) {
+        std::string path;
+        Descriptor descriptor;
+        ok = read_string(f, path, 4096) &&
+             read_pod(f, descriptor.mtime) && read_pod(f, descriptor.size) &&
+             read_string(f, descriptor.data, 1 << 24);
+        if (ok) {
+            _descriptors.emplace(std::move(path), std::move(descriptor));
+        }
+    }
+
+    std::fclose(f);
+    if (!ok) {
+        _entries.clear();
+        _descriptors.clear();
+        _dirty = true;
+    }
+}
+
+void RegistryCache::save()
+{
+    if (!_dirty || _filename.empty()) {
+        return;
+    }
+
+    auto dir = Glib::path_get_dirname(_filename);
+    g_mkdir_with_parents(dir.c_str(), 0755);
+
+    std::string data;
+    data.append(MAGIC, sizeof(MAGIC));
+    write_pod(data, FORMAT_VERSION);
+    write_pod(data, _stamp);
+    write_pod(data, static_cast<std::uint32_t>(_entries.size()));
+    for (auto const &[key, entry] : _entries) {
+        write_pod(data, static_cast<std::uint32_t>(key.size()));
+        data.append(key);
+        write_pod(data, entry.mtime);
+        write_pod(data, entry.size);
+        write_pod(data, entry.hash);
+        write_pod(data, static_cast<std::uint8_t>(entry.passed));
+    }
+
+    // Only keep the descriptors of files that were read on this run.
+    std::uint32_t used = 0;
+    for (auto const &[path, descriptor] : _descriptors) {
+        used += descriptor.used;
+    }
+    write_pod(data, used);
+    for (auto const &[path, descriptor] : _descriptors) {
+        if (descriptor.used) {
+            write_string(data, path.c_str());
+            write_pod(data, descriptor.mtime);
+            write_pod(data, descriptor.size);
+            write_pod(data, static_cast<std::uint32_t>(descriptor.data.size()));
+            data.append(descriptor.data);
+        }
+    }
+
+    // This writes a uniquely named file next to the cache and renames it into place, so concurrent
+    // Inkscape processes neither read a partial cache nor mix their writes; the last one wins.
+    if (!g_file_set_contents(_filename.c_str(), data.data(), data.size(), nullptr)) {
+        return;
+    }
+    _dirty = false;
+}
+
+bool RegistryCache::passed(Extension *ext)
+{
+    if (ext->get_inx_file().empty()) {
+        return false; // Internal extension, nothing to key on.
+    }
+
+    auto it = _entries.find(make_key(ext));
+    if (it == _entries.end() || !it->second.passed) {
+        return false;
+    }
+
+    auto &entry = it->second;
+    std::int64_t mtime, size;
+    if (!stat_file(ext->get_inx_file(), mtime, size) || size != entry.size) {
+        return false;
+    }
+    if (mtime != entry.mtime) {
+        // Touched; only trust the entry if the content is the same.
+        if (file_hash(ext->get_inx_file()) != entry.hash) {
+            return false;
+        }
+        entry.mtime = mtime;
+        _dirty = true;
+    }
+    return true;
+}
+
+void RegistryCache::record(Extension *ext, bool passed)
+{
+    if (ext->get_inx_file().empty()) {
+        return;
+    }
+
+    Entry entry;
+    if (!stat_file(ext->get_inx_file(), entry.mtime, entry.size)) {
+        return;
+    }
+    entry.hash = file_hash(ext->get_inx_file());
+    entry.passed = passed;
+
+    _entries[make_key(ext)] = entry;
+    _dirty = true;
+}
+
+XML::Document *RegistryCache::descriptor(std::string const &path)
+{
+    auto it = _descriptors.find(path);
+    if (it == _descriptors.end()) {
+        return nullptr;
+    }
+
+    auto &descriptor = it->second;
+    std::int64_t mtime, size;
+    if (!stat_file(path, mtime, size) || mtime != descriptor.mtime || size != descriptor.size) {
+        _descriptors.erase(it);
+        return nullptr;
+    }
+
+    auto doc = new XML::SimpleDocument();
+    Reader in{descriptor.data};
+    std::uint32_t count = 0;
+    bool ok = in.pod(count);
+    for (std::uint32_t i = 0; ok && i < count; i++) {
+        auto node = read_node(in, doc);
+        if (node) {
+            doc->appendChild(node);
+            Inkscape::GC::release(node);
+        }
+        ok = node != nullptr;
+    }
+    if (!ok || !doc->root()) {
+        Inkscape::GC::release(doc);
+        _descriptors.erase(it);
+        _dirty = true;
+        return nullptr;
+    }
+
+    descriptor.used = true;
+    return doc;
+}
+
+void RegistryCache::remember(std::string const &path, XML::Document const *doc)
+{
+    Descriptor descriptor;
+    if (!stat_file(path, descriptor.mtime, descriptor.size)) {
+        return;
+    }
+    write_pod(descriptor.data, static_cast<std::uint32_t>(doc->childCount()));
+    for (auto node = doc->firstChild(); node; node = node->next()) {
+        write_node(descriptor.data, node);
+    }
+    descriptor.used = true;
+
+    _descriptors[path] = std::move(descriptor);
+    _dirty = true;
+}
+
+} // namespace Inkscape::Extension
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Persistent cache of extension descriptors and check results, used to skip
+ * parsing and dependency probing at startup for unchanged .inx files.
+ *
+ * Copyright (C) 2026 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_EXTENSION_REGISTRY_CACHE_H
+#define INKSCAPE_EXTENSION_REGISTRY_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace Inkscape::XML {
+class Document;
+} // namespace Inkscape::XML
+
+namespace Inkscape::Extension {
+
+class Extension;
+
+/**
+ * Remembers, per .inx file, whether the extensions it defines passed Extension::check() on a
+ * previous run. The cache is only trusted when the environment that influences dependency
+ * probing (Inkscape version, PATH, extension directories) is unchanged, and an entry only
+ * when the .inx file it describes is unchanged (same size and mtime, or same content hash).
+ *
+ * Extensions with a valid entry have their check deferred until they are first loaded. Failed
+ * checks are recorded too, but always run again.
+ *
+ * It also keeps the XML tree parsed from each .inx file, so that startup only stats the files
+ * that did not change since the previous run instead of reading and parsing them again.
+ */
+class RegistryCache
+{
+public:
+    static RegistryCache &get();
+
+    /** Whether 'ext' is known to have passed its checks with an identical descriptor. */
+    bool passed(Extension *ext);
+
+    /** Record the result of a full check of 'ext'. */
+    void record(Extension *ext, bool passed);
+
+    /**
+     * The descriptor parsed from the .inx file at 'path' on a previous run, or nullptr if the file
+     * has changed since. The caller owns the returned document.
+     */
+    XML::Document *descriptor(std::string const &path);
+
+    /** Keep the descriptor parsed from the .inx file at 'path' for the next runs. */
+    void remember(std::string const &path, XML::Document const *doc);
+
+    /** Write the cache to disk if anything changed. */
+    void save();
+
+private:
+    RegistryCache();
+
+    struct Entry
+    {
+        std::int64_t mtime = 0;
+        std::int64_t size = 0;
+        std::uint64_t hash = 0;
+        bool passed = false;
+    };
+
+    struct Descriptor
+    {
+        std::int64_t mtime = 0;
+        std::int64_t size = 0;
+        std::string data; ///< The serialized tree.
+        bool used = false; ///< Asked for on this run; others belong to files that went away.
+    };
+
+    using Key = std::string; ///< .inx path and extension id, separated by a NUL.
+
+    static Key make_key(Extension *ext);
+    static std::uint64_t environment_stamp();
+    static std::uint64_t file_hash(std::string const &path);
+
+    void load();
+
+    std::string _filename;
+    std::uint64_t _stamp = 0;
+    std::unordered_map<Key, Entry> _entries;
+    std::unordered_map<std::string, Descriptor> _descriptors;
+    bool _dirty = false;
+};
+
+} // namespace Inkscape::Extension
+
+#endif // INKSCAPE_EXTENSION_REGISTRY_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -36,6 +36,7 @@
 #include "patheffect.h"
 #include "preferences.h"
 #include "print.h"
+#include "registry-cache.h"
 #include "template.h"
 #include "ui/interface.h"
 #include "xml/rebase-hrefs.h"
@@ -428,6 +429,9 @@ build_from_reprdoc(Inkscape::XML::Document *doc, std::unique_ptr<Implementation:
     }
 
     assert(module);
+    if (baseDir && file_name) {
+        module->set_inx_file(Glib::build_filename(*baseDir, *file_name));
+    }
     db.take_ownership(std::move(module));
     return true;
 }
@@ -437,7 +441,8 @@ build_from_reprdoc(Inkscape::XML::Document *doc, std::unique_ptr<Implementation:
  *           XML description.
  * \param    filename  The file holding the XML description of the module.
  *
- * This function calls build_from_reprdoc with using sp_repr_read_file to create the reprdoc.
+ * This function calls build_from_reprdoc with using sp_repr_read_file to create the reprdoc,
+ * unless the registry cache still holds the description parsed from an unchanged file.
  */
 void
 build_from_file(gchar const *filename)
@@ -445,10 +450,15 @@ build_from_file(gchar const *filename)
     std::string dir = Glib::path_get_dirname(filename);
     auto file_name = Glib::path_get_basename(filename);
 
-    Inkscape::XML::Document *doc = sp_repr_read_file(filename, INKSCAPE_EXTENSION_URI);
+    auto &cache = RegistryCache::get();
+    Inkscape::XML::Document *doc = cache.descriptor(filename);
     if (!doc) {
-        g_critical("Inkscape::Extension::build_from_file() - XML description loaded from '%s' not valid.", filename);
-        return;
+        doc = sp_repr_read_file(filename, INKSCAPE_EXTENSION_URI);
+        if (!doc) {
+            g_critical("Inkscape::Extension::build_from_file() - XML description loaded from '%s' not valid.", filename);
+            return;
+        }
+        cache.remember(filename, doc);
     }
 
     if (!build_from_reprdoc(doc, {}, &dir, &file_name)) {
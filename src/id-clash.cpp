@@ -14,12 +14,11 @@
 
 #include "id-clash.h"
 
-#include <cstdlib>
 #include <cstring>
-#include <list>
-#include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <glibmm/regex.h>
 
@@ -46,10 +45,11 @@ struct IdReference {
     const char *attr;  // property or href-like attribute
 };
 
-typedef std::map<Glib::ustring, std::list<IdReference> > refmap_type;
+/// Every reference in a tree, by the ID it refers to.
+typedef std::unordered_map<std::string, std::vector<IdReference>> refmap_type;
 
 typedef std::pair<SPObject*, Glib::ustring> id_changeitem_type;
-typedef std::list<id_changeitem_type> id_changelist_type;
+typedef std::vector<id_changeitem_type> id_changelist_type;
 
 const char *href_like_attributes[] = {"inkscape:connection-end",
                                       "inkscape:connection-end-point",
@@ -373,12 +373,53 @@ static void find_references(SPObject *elem, refmap_type &refmap, bool from_clipb
     }
 }
 
+namespace {
+
+/**
+ * Hands out replacement IDs, made of the old ID followed by a hyphen and a number,
+ * which are in use in none of the given documents.
+ *
+ * The last number tried for every old ID is kept in the target document, so renaming
+ * many elements that share an ID, or pasting the same content repeatedly, never probes
+ * the same candidates twice.
+ */
+class IdAllocator
+{
+public:
+    IdAllocator(SPDocument *target, SPDocument const *other = nullptr)
+        : _target{target}
+        , _other{other}
+    {}
+
+    std::string allocate(std::string const &old_id)
+    {
+        auto &counter = _target->id_clash_counter(old_id);
+        auto id = old_id + '-';
+        auto const base_len = id.size();
+        do {
+            id.replace(base_len, std::string::npos, std::to_string(++counter));
+        } while (_taken(id));
+        return id;
+    }
+
+private:
+    bool _taken(std::string const &id) const
+    {
+        return _target->getObjectById(id) || (_other && _other->getObjectById(id));
+    }
+
+    SPDocument *_target;
+    SPDocument const *_other;
+};
+
+} // namespace
+
 /**
  *  Change any IDs that clash with IDs in the current document, and make
  *  a list of those changes that will require fixing up references.
  */
-static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_doc, SPObject *elem,
-                                refmap_type const &refmap, id_changelist_type *id_changes, bool from_clipboard)
+static void change_clashing_ids(SPDocument *current_doc, SPObject *elem, refmap_type const &refmap,
+                                IdAllocator &ids, id_changelist_type *id_changes, bool from_clipboard)
 {
     const gchar *id = elem->getId();
     bool fix_clashing_ids = true;
@@ -387,7 +428,7 @@ static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_do
         // Choose a new ID.
         // To try to preserve any meaningfulness that the original ID
         // may have had, the new ID is the old ID followed by a hyphen
-        // and one or more digits.
+        // and a number.
 
         if (is<SPGradient>(elem)) {
             SPObject *cd_obj =  current_doc->getObjectById(id);
@@ -411,13 +452,7 @@ static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_do
 
         if (fix_clashing_ids) {
             std::string old_id(id);
-            std::string new_id(old_id + '-');
-            for (;;) {
-                new_id += "0123456789"[std::rand() % 10];
-                const char *str = new_id.c_str();
-                if (current_doc->getObjectById(str) == nullptr &&
-                    imported_doc->getObjectById(str) == nullptr) break;
-            }
+            auto new_id = ids.allocate(old_id);
             // Change to the new ID
 
             elem->setAttribute("id", new_id);
@@ -431,7 +466,7 @@ static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_do
     // recurse
     for (auto& child: elem->children)
     {
-        change_clashing_ids(imported_doc, current_doc, &child, refmap, id_changes, from_clipboard);
+        change_clashing_ids(current_doc, &child, refmap, ids, id_changes, from_clipboard);
     }
 }
 
@@ -441,19 +476,46 @@ static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_do
 static void
 fix_up_refs(refmap_type const &refmap, const id_changelist_type &id_changes)
 {
-    id_changelist_type::const_iterator pp;
-    const id_changelist_type::const_iterator pp_end = id_changes.end();
-    for (pp = id_changes.begin(); pp != pp_end; ++pp) {
-        SPObject *obj = pp->first;
-        refmap_type::const_iterator pos = refmap.find(pp->second);
-        std::list<IdReference>::const_iterator it;
-        const std::list<IdReference>::const_iterator it_end = pos->second.end();
-        for (it = pos->second.begin(); it != it_end; ++it) {
-            fix_ref(*it, obj, pp->second.c_str());
+    for (auto const &[obj, old_id] : id_changes) {
+        auto pos = refmap.find(old_id.raw());
+        if (pos == refmap.end()) {
+            continue;
+        }
+        for (auto const &idref : pos->second) {
+            fix_ref(idref, obj, old_id.c_str());
         }
     }
 }
 
+/**
+ *  Make the references to old_id, which now point to to_obj, be found under its ID.
+ */
+static void
+move_refs(refmap_type &refmap, std::string const &old_id, SPObject *to_obj)
+{
+    auto pos = refmap.find(old_id);
+    if (pos == refmap.end() || !to_obj->getId() || old_id == to_obj->getId()) {
+        return;
+    }
+    auto refs = std::move(pos->second);
+    refmap.erase(pos);
+    auto &moved = refmap[to_obj->getId()];
+    moved.insert(moved.end(), refs.begin(), refs.end());
+}
+
+struct IdReferences::Map
+{
+    refmap_type refmap;
+};
+
+IdReferences::IdReferences(SPDocument *document, bool from_clipboard)
+    : _map{std::make_unique<Map>()}
+{
+    find_references(document->getRoot(), _map->refmap, from_clipboard);
+}
+
+IdReferences::~IdReferences() = default;
+
 /**
  *  This function resolves ID clashes between the document being imported
  *  and the current open document: IDs in the imported document that would
@@ -462,13 +524,28 @@ fix_up_refs(refmap_type const &refmap, const id_changelist_type &id_changes)
  */
 void prevent_id_clashes(SPDocument *imported_doc, SPDocument *current_doc, bool from_clipboard)
 {
-    refmap_type refmap;
+    IdReferences imported_refs(imported_doc, from_clipboard);
+    prevent_id_clashes(imported_doc, current_doc, imported_refs, from_clipboard);
+}
+
+/**
+ *  Resolve ID clashes as above, with the references of the imported document already found,
+ *  and keep them up to date for further changes.
+ */
+void prevent_id_clashes(SPDocument *imported_doc, SPDocument *current_doc, IdReferences &imported_refs,
+                        bool from_clipboard)
+{
+    auto &refmap = imported_refs._map->refmap;
     id_changelist_type id_changes;
     SPObject *imported_root = imported_doc->getRoot();
 
-    find_references(imported_root, refmap, from_clipboard);
-    change_clashing_ids(imported_doc, current_doc, imported_root, refmap, &id_changes, from_clipboard);
+    IdAllocator ids(current_doc, imported_doc);
+
+    change_clashing_ids(current_doc, imported_root, refmap, ids, &id_changes, from_clipboard);
     fix_up_refs(refmap, id_changes);
+    for (auto const &[obj, old_id] : id_changes) {
+        move_refs(refmap, old_id.raw(), obj);
+    }
 }
 
 /*
@@ -477,20 +554,27 @@ void prevent_id_clashes(SPDocument *imported_doc, SPDocument *current_doc, bool
 void
 change_def_references(SPObject *from_obj, SPObject *to_obj)
 {
-    refmap_type refmap;
-    SPDocument *current_doc = from_obj->document;
-    std::string old_id(from_obj->getId());
+    IdReferences refs(from_obj->document);
+    change_def_references(from_obj, to_obj, refs);
+}
 
-    find_references(current_doc->getRoot(), refmap, false);
+/*
+ * Change any references of svg:def from_obj into to_obj, with the references of the document
+ * of from_obj already found
+ */
+void
+change_def_references(SPObject *from_obj, SPObject *to_obj, IdReferences &refs)
+{
+    auto &refmap = refs._map->refmap;
+    std::string old_id(from_obj->getId());
 
-    refmap_type::const_iterator pos = refmap.find(old_id);
+    auto pos = refmap.find(old_id);
     if (pos != refmap.end()) {
-        std::list<IdReference>::const_iterator it;
-        const std::list<IdReference>::const_iterator it_end = pos->second.end();
-        for (it = pos->second.begin(); it != it_end; ++it) {
-            fix_ref(*it, to_obj, from_obj->getId());
+        for (auto const &idref : pos->second) {
+            fix_ref(idref, to_obj, from_obj->getId());
         }
     }
+    move_refs(refmap, old_id, to_obj);
 }
 
 const char valid_id_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_.:";
@@ -570,13 +654,8 @@ void rename_id(SPObject *elem, Glib::ustring const &new_name)
         // Choose a new ID.
         // To try to preserve any meaningfulness that the original ID
         // may have had, the new ID is the old ID followed by a hyphen
-        // and one or more digits.
-        new_name2 += '-';
-        for (;;) {
-            new_name2 += "0123456789"[std::rand() % 10];
-            if (current_doc->getObjectById(new_name2) == nullptr)
-                break;
-        }
+        // and a number.
+        new_name2 = IdAllocator(current_doc).allocate(new_name2.raw());
     }
     g_free (id);
     // Change to the new ID
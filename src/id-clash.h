@@ -10,14 +10,39 @@
 #ifndef SEEN_ID_CLASH_H
 #define SEEN_ID_CLASH_H
 
+#include <memory>
+
 #include <glibmm/ustring.h>  // for ustring
 
 class SPDocument;
 class SPObject;
 
+/**
+ * The places where IDs are referenced in a document, found with a single walk over it and kept
+ * up to date by the functions below that take it, so that many IDs can be changed in a row.
+ */
+class IdReferences
+{
+public:
+    explicit IdReferences(SPDocument *document, bool from_clipboard = false);
+    ~IdReferences();
+    IdReferences(IdReferences const &) = delete;
+    IdReferences &operator=(IdReferences const &) = delete;
+
+private:
+    struct Map;
+    std::unique_ptr<Map> _map;
+
+    friend void prevent_id_clashes(SPDocument *, SPDocument *, IdReferences &, bool);
+    friend void change_def_references(SPObject *, SPObject *, IdReferences &);
+};
+
 void prevent_id_clashes(SPDocument *imported_doc, SPDocument *current_doc, bool from_clipboard = false);
+void prevent_id_clashes(SPDocument *imported_doc, SPDocument *current_doc, IdReferences &imported_refs,
+                        bool from_clipboard = false);
 void rename_id(SPObject *elem, Glib::ustring const &newname);
 void change_def_references(SPObject *replace_obj, SPObject *with_obj);
+void change_def_references(SPObject *replace_obj, SPObject *with_obj, IdReferences &refs);
 Glib::ustring generate_similar_unique_id(SPDocument *document, Glib::ustring const &base_name);
 
 #endif /* !SEEN_ID_CLASH_H */
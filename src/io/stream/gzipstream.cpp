@@ -17,10 +17,12 @@
  */
 
 #include "gzipstream.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <glib.h>
 
 namespace Inkscape
 {
@@ -293,41 +295,38 @@ int GzipInputStream::fetchMore()
 //# G Z I P   O U T P U T    S T R E A M
 //#########################################################################
 
+// Amount of input compressed at a time.
+#define CHUNK_SIZE (256 * 1024)
+
 /**
  *
  */ 
-GzipOutputStream::GzipOutputStream(OutputStream &destinationStream)
-                     : BasicOutputStream(destinationStream)
+GzipOutputStream::GzipOutputStream(OutputStream &destinationStream, int level, bool threaded)
+                     : BasicOutputStream(destinationStream),
+                       threaded(threaded),
+                       totalIn(0),
+                       crc(crc32(0L, Z_NULL, 0))
 {
+    inputBuf.reserve(CHUNK_SIZE);
+    pendingBuf.reserve(CHUNK_SIZE);
+    outputBuf.resize(CHUNK_SIZE);
 
-    totalIn         = 0;
-    totalOut        = 0;
-    crc             = crc32(0L, Z_NULL, 0);
-
-    //Gzip header
-    destination.put(0x1f);
-    destination.put(0x8b);
-
-    //Say it is compressed
-    destination.put(Z_DEFLATED);
-
-    //flags
-    destination.put(0);
-
-    //time
-    destination.put(0);
-    destination.put(0);
-    destination.put(0);
-    destination.put(0);
-
-    //xflags
-    destination.put(0);
-
-    //OS code - from zutil.h
-    //destination.put(OS_CODE);
-    //apparently, we should not explicitly include zutil.h
-    destination.put(0);
+    memset( &d_stream, 0, sizeof(d_stream) );
+    //raw deflate, as the gzip header and trailer are written here
+    int zerr = deflateInit2(&d_stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    if (zerr != Z_OK) {
+        throw StreamException(Glib::ustring("deflateInit2 failed: ") + zError(zerr));
+    }
 
+    unsigned char const header[] = {
+        0x1f, 0x8b,     //Gzip header
+        Z_DEFLATED,     //Say it is compressed
+        0,              //flags
+        0, 0, 0, 0,     //time
+        0,              //xflags
+        0               //OS code - we should not explicitly include zutil.h for OS_CODE
+    };
+    destination.write(reinterpret_cast<char const *>(header), sizeof(header));
 }
 
 /**
@@ -335,7 +334,12 @@ GzipOutputStream::GzipOutputStream(OutputStream &destinationStream)
  */ 
 GzipOutputStream::~GzipOutputStream()
 {
-    close();
+    // Errors can only be passed on by an explicit close(); here they can only be reported.
+    try {
+        close();
+    } catch (std::exception const &e) {
+        g_warning("GzipOutputStream: %s", e.what());
+    }
 }
 
 /**
@@ -346,23 +350,32 @@ void GzipOutputStream::close()
 {
     if (closed)
         return;
+    closed = true;
 
-    flush();
+    try {
+        submit(Z_FINISH);
+        wait();
+    } catch (...) {
+        deflateEnd(&d_stream);
+        throw;
+    }
+    deflateEnd(&d_stream);
 
-    //# Send the CRC
+    //# Send the CRC and the file length
+    unsigned char trailer[8];
     uLong outlong = crc;
     for (int n = 0; n < 4; n++)
         {
-        destination.put(static_cast<char>(outlong & 0xff));
+        trailer[n] = static_cast<unsigned char>(outlong & 0xff);
         outlong >>= 8;
         }
-    //# send the file length
     outlong = totalIn & 0xffffffffL;
-    for (int n = 0; n < 4; n++)
+    for (int n = 4; n < 8; n++)
         {
-        destination.put(static_cast<char>(outlong & 0xff));
+        trailer[n] = static_cast<unsigned char>(outlong & 0xff);
         outlong >>= 8;
         }
+    destination.write(reinterpret_cast<char const *>(trailer), sizeof(trailer));
 
     destination.close();
     closed = true;
@@ -374,55 +387,14 @@ void GzipOutputStream::close()
  */ 
 void GzipOutputStream::flush()
 {
-    if (closed || inputBuf.empty())
-	{
-        return;
-    }
-	
-    uLong srclen = inputBuf.size();
-    Bytef *srcbuf = new (std::nothrow) Bytef [srclen];
-    if (!srcbuf)
-        {
-        return;
-        }
-        
-    uLong destlen = srclen;
-    Bytef *destbuf = new (std::nothrow) Bytef [(destlen + (srclen/100) + 13)];
-    if (!destbuf)
-        {
-        delete[] srcbuf;
+    if (closed)
         return;
-        }
-        
-    std::vector<unsigned char>::iterator iter;
-    Bytef *p = srcbuf;
-    for (iter=inputBuf.begin() ; iter != inputBuf.end() ; ++iter)
-        *p++ = *iter;
-        
-    crc = crc32(crc, const_cast<const Bytef *>(srcbuf), srclen);
-    
-    int zerr = compress(destbuf, static_cast<uLongf *>(&destlen), srcbuf, srclen);
-    if (zerr != Z_OK)
-        {
-        printf("Some kind of problem\n");
-        }
 
-    totalOut += destlen;
-    //skip the redundant zlib header and checksum
-    for (uLong i=2; i<destlen-4 ; i++)
-        {
-        destination.put((int)destbuf[i]);
-        }
-        
+    submit(Z_SYNC_FLUSH);
+    wait();
     destination.flush();
-
-    inputBuf.clear();
-    delete[] srcbuf;
-    delete[] destbuf;
 }
 
-
-
 /**
  * Writes the specified byte to this output stream.
  */ 
@@ -434,6 +406,9 @@ int GzipOutputStream::put(char ch)
         return -1;
         }
 
+    if (inputBuf.size() == CHUNK_SIZE) {
+        submit(Z_NO_FLUSH);
+    }
 
     //Add char to buffer
     inputBuf.push_back(ch);
@@ -441,6 +416,76 @@ int GzipOutputStream::put(char ch)
     return 1;
 }
 
+/**
+ * Writes a block of bytes to this output stream.
+ */
+void GzipOutputStream::write(char const *data, size_t len)
+{
+    if (closed)
+        return;
+
+    totalIn += len;
+    while (len > 0) {
+        if (inputBuf.size() == CHUNK_SIZE) {
+            submit(Z_NO_FLUSH);
+        }
+        size_t n = std::min(len, CHUNK_SIZE - inputBuf.size());
+        inputBuf.insert(inputBuf.end(), data, data + n);
+        data += n;
+        len -= n;
+    }
+}
+
+/**
+ * Hands the buffered input over for compression, waiting for the
+ * previous chunk to be done first.
+ */
+void GzipOutputStream::submit(int flushMode)
+{
+    wait();
+    std::swap(inputBuf, pendingBuf);
+    inputBuf.clear();
+
+    if (threaded && flushMode == Z_NO_FLUSH) {
+        pending = std::async(std::launch::async, [this] {
+            deflateChunk(pendingBuf, Z_NO_FLUSH);
+        });
+    } else {
+        deflateChunk(pendingBuf, flushMode);
+    }
+}
+
+/**
+ * Waits for the chunk being compressed on the worker thread, if any,
+ * passing on its exceptions.
+ */
+void GzipOutputStream::wait()
+{
+    if (pending.valid()) {
+        pending.get();
+    }
+}
+
+void GzipOutputStream::deflateChunk(std::vector<unsigned char> const &chunk, int flushMode)
+{
+    crc = crc32(crc, chunk.data(), chunk.size());
+
+    d_stream.next_in  = const_cast<Bytef *>(chunk.data());
+    d_stream.avail_in = chunk.size();
+    do {
+        d_stream.next_out  = outputBuf.data();
+        d_stream.avail_out = outputBuf.size();
+        int zerr = deflate(&d_stream, flushMode);
+        if (zerr == Z_STREAM_ERROR) {
+            throw StreamException(Glib::ustring("deflate failed: ") + zError(zerr));
+        }
+        size_t have = outputBuf.size() - d_stream.avail_out;
+        if (have) {
+            destination.write(reinterpret_cast<char const *>(outputBuf.data()), have);
+        }
+    } while (d_stream.avail_out == 0);
+}
+
 
 
 } // namespace IO
@@ -18,6 +18,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <future>
 #include <vector>
 #include "inkscapestream.h"
 #include <zlib.h>
@@ -81,13 +82,23 @@ private:
  * This class is for gzip-compressing data going to the
  * destination OutputStream
  *
+ * The data is compressed in chunks as it comes in, so memory use does
+ * not grow with the size of the output.
  */
 class GzipOutputStream : public BasicOutputStream
 {
 
 public:
 
-    GzipOutputStream(OutputStream &destinationStream);
+    /**
+     * @param level The zlib compression level, from 0 (store) to 9 (smallest),
+     *              or Z_DEFAULT_COMPRESSION.
+     * @param threaded Compress each chunk on a worker thread while the next one
+     *                 is being written.
+     */
+    GzipOutputStream(OutputStream &destinationStream,
+                     int level = Z_DEFAULT_COMPRESSION,
+                     bool threaded = false);
     
     ~GzipOutputStream() override;
     
@@ -97,12 +108,24 @@ public:
     
     int put(char ch) override;
 
+    void write(char const *data, size_t len) override;
+
 private:
 
-    std::vector<unsigned char> inputBuf;
+    void submit(int flushMode);
+    void deflateChunk(std::vector<unsigned char> const &chunk, int flushMode);
+    void wait();
+
+    std::vector<unsigned char> inputBuf;   // being filled by put() and write()
+    std::vector<unsigned char> pendingBuf; // being compressed
+    std::vector<unsigned char> outputBuf;
+
+    bool threaded;
+    std::future<void> pending;
+
+    z_stream d_stream;
 
     long totalIn;
-    long totalOut;
     unsigned long crc;
 
 }; // class GzipOutputStream
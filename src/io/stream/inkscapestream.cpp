@@ -13,6 +13,7 @@
  */
 
 #include <cstdlib>
+#include <cstring>
 #include "inkscapestream.h"
 
 namespace Inkscape
@@ -87,6 +88,17 @@ int BasicInputStream::get()
    
 
 
+//#########################################################################
+//# O U T P U T    S T R E A M
+//#########################################################################
+
+void OutputStream::write(char const *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        put(data[i]);
+    }
+}
+
 //#########################################################################
 //# B A S I C    O U T P U T    S T R E A M
 //#########################################################################
@@ -469,6 +481,17 @@ void BasicWriter::put(char ch)
         destination->put(ch);
 }
 
+/**
+ * Writes a block of bytes to this output writer.  Subclasses that
+ * only override put() get their bytes one at a time.
+ */
+void BasicWriter::write(char const *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        put(data[i]);
+    }
+}
+
 /**
  * Provide printf()-like formatting
  */ 
@@ -508,9 +531,7 @@ Writer &BasicWriter::writeUString(const Glib::ustring &str)
  */ 
 Writer &BasicWriter::writeStdString(const std::string &str)
 {
-    for (char it : str) {
-        put(it);
-    }
+    write(str.data(), str.size());
     return *this;
 }
 
@@ -519,12 +540,9 @@ Writer &BasicWriter::writeStdString(const std::string &str)
  */ 
 Writer &BasicWriter::writeString(const char *str)
 {
-    std::string tmp;
-    if (str)
-        tmp = str;
-    else
-        tmp = "null";
-    writeStdString(tmp);
+    if (!str)
+        str = "null";
+    write(str, strlen(str));
     return *this;
 }
 
@@ -740,6 +758,14 @@ void OutputStreamWriter::put(char ch)
     outputStream.put(ch);
 }
 
+/**
+ *  Passes blocks of bytes on to the OutputStream in one piece.
+ */
+void OutputStreamWriter::write(char const *data, size_t len)
+{
+    outputStream.write(data, len);
+}
+
 //#########################################################################
 //# S T D    W R I T E R
 //#########################################################################
@@ -194,6 +194,12 @@ public:
      */
     virtual int put(char ch) = 0;
 
+    /**
+     * Send a block of bytes to the destination stream.  The default
+     * implementation calls put() for each of them.
+     */
+    virtual void write(char const *data, size_t len);
+
 
 }; // class OutputStream
 
@@ -217,6 +223,9 @@ public:
     
     int put(char ch) override;
 
+    // write() is left to call put() for each byte, since subclasses filter the output there.
+    // Streams that pass blocks on unchanged may override it.
+
 protected:
 
     bool closed;
@@ -474,6 +483,11 @@ public:
     virtual void flush() = 0;
     
     virtual void put(char ch) = 0;
+
+    /**
+     * Write a block of bytes, unchanged.
+     */
+    virtual void write(char const *data, size_t len) = 0;
     
     /* Formatted output */
     virtual Writer& printf(char const *fmt, ...) G_GNUC_PRINTF(2,3) = 0;
@@ -528,6 +542,8 @@ public:
     void flush() override;
     
     void put(char ch) override;
+
+    void write(char const *data, size_t len) override;
     
     
     
@@ -620,6 +636,8 @@ public:
     
     void put(char ch) override;
 
+    void write(char const *data, size_t len) override;
+
 
 private:
 
@@ -115,6 +115,12 @@ int StringOutputStream::put(char ch)
 	return 1;
 }
 
+void StringOutputStream::write(char const *data, size_t len)
+{
+    // Appended as bytes: a block may end in the middle of a UTF-8 sequence.
+    buffer += std::string(data, len);
+}
+
 
 } // namespace IO
 } // namespace Inkscape
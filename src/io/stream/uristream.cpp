@@ -156,6 +156,19 @@ int FileOutputStream::put(char ch)
     return 1;
 }
 
+/**
+ * Writes a block of bytes to this output stream.
+ */
+void FileOutputStream::write(char const *data, size_t len)
+{
+    if (!outf)
+        return;
+    if (fwrite(data, 1, len, outf) != len) {
+        Glib::ustring err = "ERROR writing to file ";
+        throw StreamException(err);
+    }
+}
+
 
 
 
@@ -80,6 +80,8 @@ public:
 
     int put(char ch) override;
 
+    void write(char const *data, size_t len) override;
+
 private:
 
     bool ownsFile;
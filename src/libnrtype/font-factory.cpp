@@ -32,6 +32,7 @@
 #include "io/resource.h"
 
 #include "libnrtype/font-factory.h"
+#include "libnrtype/font-index.h"
 #include "libnrtype/font-instance.h"
 #include "libnrtype/OpenTypeUtil.h"
 
@@ -207,6 +208,9 @@ FontFactory::FontFactory()
 
 FontFactory::~FontFactory()
 {
+    if (fontIndex) {
+        fontIndex->save(); // Keep the styles looked up this session.
+    }
     loaded.clear();
     g_object_unref(fontContext);
     g_object_unref(fontServer);
@@ -215,6 +219,10 @@ FontFactory::~FontFactory()
 void FontFactory::refreshConfig()
 {
     pango_fc_font_map_config_changed(PANGO_FC_FONT_MAP(fontServer));
+
+    // Families and the index stamp are stale now.
+    fontIndex.reset();
+    uiFamilies.reset();
 }
 
 Glib::ustring FontFactory::ConstructFontSpecification(PangoFontDescription *font)
@@ -398,6 +406,52 @@ std::map<std::string, PangoFontFamily *> FontFactory::GetUIFamilies()
     return result;
 }
 
+FontIndex &FontFactory::getIndex()
+{
+    if (!fontIndex) {
+        auto conf = pango_fc_font_map_get_config(PANGO_FC_FONT_MAP(fontServer));
+        fontIndex = std::make_unique<FontIndex>(conf ? conf : FcConfigGetCurrent());
+    }
+    return *fontIndex;
+}
+
+std::vector<std::string> const &FontFactory::GetUIFamilyNames()
+{
+    auto &idx = getIndex();
+    if (!idx.families()) {
+        uiFamilies = GetUIFamilies();
+        std::vector<std::string> names;
+        names.reserve(uiFamilies->size());
+        for (auto const &[name, family] : *uiFamilies) {
+            names.push_back(name);
+        }
+        idx.set_families(std::move(names));
+        idx.save();
+    }
+    return *idx.families();
+}
+
+std::vector<StyleNames> FontFactory::GetUIStyles(std::string const &family)
+{
+    auto &idx = getIndex();
+    if (auto styles = idx.styles(family)) {
+        return *styles;
+    }
+
+    // Not indexed yet; this needs the Pango family, so enumerate them once.
+    if (!uiFamilies) {
+        uiFamilies = GetUIFamilies();
+    }
+    auto it = uiFamilies->find(family);
+    if (it == uiFamilies->end()) {
+        return {};
+    }
+
+    auto styles = GetUIStyles(it->second);
+    idx.set_styles(family, styles);
+    return styles;
+}
+
 std::vector<StyleNames> FontFactory::GetUIStyles(PangoFontFamily *in)
 {
     if (!in) {
@@ -13,6 +13,8 @@
 #include <utility>
 #include <memory>
 #include <map>
+#include <optional>
+#include <vector>
 
 #include <pango/pango.h>
 #include "style.h"
@@ -24,6 +26,7 @@
 
 #include "util/cached_map.h"
 
+class FontIndex;
 class FontInstance;
 
 // Constructs a PangoFontDescription from SPStyle. Font size is not included.
@@ -81,6 +84,12 @@ public:
     // Retrieves style information about a font family.
     std::vector<StyleNames> GetUIStyles(PangoFontFamily *in);
 
+    /// Sorted names of the font families shown in the UI. Served from the on-disk font index
+    /// when the installed fonts haven't changed, so Pango is only queried when needed.
+    std::vector<std::string> const &GetUIFamilyNames();
+    /// Styles of a font family by name, served from the font index if possible.
+    std::vector<StyleNames> GetUIStyles(std::string const &family);
+
     /// Retrieve a FontInstance from a style object, first trying to use the font-specification, the CSS information
     std::shared_ptr<FontInstance> FaceFromStyle(SPStyle const *style);
     // Various functions to get a FontInstance from different descriptions.
@@ -124,6 +133,11 @@ private:
     };
     Inkscape::Util::cached_map<PangoFontDescription*, FontInstance, Hash, Compare> loaded;
 
+    // Lazily built from the font configuration; reset by refreshConfig().
+    std::unique_ptr<FontIndex> fontIndex;
+    FontIndex &getIndex();
+    std::optional<std::map<std::string, PangoFontFamily *>> uiFamilies;
+
     // The following two commented out maps were an attempt to allow Inkscape to use font faces
     // that could not be distinguished by CSS values alone. In practice, they never were that
     // useful as PangoFontDescription, which is used throughout our code, cannot distinguish
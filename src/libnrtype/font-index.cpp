@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * On-disk index of the font families and styles shown in the UI.
+ *//*
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "font-index.h"
+
+#include <cstdio>
+#include <cstring>
+#include <glib/gstdio.h>
+#include <glibmm/miscutils.h>
+#include <pango/pango.h>
+
+#include "io/resource.h"
+#include "io/sys.h"
+
+namespace {
+
+constexpr char MAGIC[4] = {'I', 'F', 'N', 'T'};
+constexpr std::uint32_t FORMAT_VERSION = 1;
+constexpr std::uint32_t MAX_STRING = 1 << 16;
+
+void hash_bytes(std::uint64_t &h, void const *data, std::size_t len)
+{
+    auto p = static_cast<unsigned char const *>(data);
+    for (std::size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ull; // FNV-1a
+    }
+}
+
+/// Hash the names and modification times of a list of fontconfig paths.
+void hash_paths(std::uint64_t &h, FcStrList *list)
+{
+    if (!list) {
+        return;
+    }
+    while (auto path = reinterpret_cast<char const *>(FcStrListNext(list))) {
+        hash_bytes(h, path, std::strlen(path) + 1);
+        GStatBuf st;
+        std::int64_t mtime = g_stat(path, &st) == 0 ? st.st_mtime : 0;
+        hash_bytes(h, &mtime, sizeof(mtime));
+    }
+    FcStrListDone(list);
+}
+
+void write_u32(std::string &out, std::uint32_t v)
+{
+    out.append(reinterpret_cast<char const *>(&v), sizeof(v));
+}
+
+void write_string(std::string &out, std::string const &s)
+{
+    write_u32(out, s.size());
+    out.append(s);
+}
+
+bool read_u32(FILE *f, std::uint32_t &v)
+{
+    return std::fread(&v, sizeof(v), 1, f) == 1;
+}
+
+bool read_string(FILE *f, std::string &s)
+{
+    std::uint32_t len;
+    if (!read_u32(f, len) || len > MAX_STRING) {
+        return false;
+    }
+    s.resize(len);
+    return std::fread(s.data(), 1, len, f) == len;
+}
+
+} // namespace
+
+FontIndex::FontIndex(FcConfig *config)
+    : _filename{Inkscape::IO::Resource::get_path_string(Inkscape::IO::Resource::CACHE, Inkscape::IO::Resource::NONE,
+                                                        "font-index.bin")}
+    , _stamp{compute_stamp(config)}
+{
+    load();
+}
+
+std::uint64_t FontIndex::compute_stamp(FcConfig *config)
+{
+    std::uint64_t h = 0xcbf29ce484222325ull;
+
+    int const versions[] = {FORMAT_VERSION, FcGetVersion(), pango_version()};
+    hash_bytes(h, versions, sizeof(versions));
+
+    hash_paths(h, FcConfigGetFontDirs(config));
+    hash_paths(h, FcConfigGetCacheDirs(config));
+    hash_paths(h, FcConfigGetConfigFiles(config));
+
+    // Fonts added with AddFontFile() don't show up in any directory list.
+    auto app_fonts = FcConfigGetFonts(config, FcSetApplication);
+    int const napp = app_fonts ? app_fonts->nfont : 0;
+    hash_bytes(h, &napp, sizeof(napp));
+
+    return h;
+}
+
+void FontIndex::set_families(std::vector<std::string> families)
+{
+    _families = std::move(families);
+    _dirty = true;
+}
+
+std::vector<StyleNames> const *FontIndex::styles(std::string const &family) const
+{
+    auto it = _styles.find(family);
+    return it != _styles.end() ? &it->second : nullptr;
+}
+
+void FontIndex::set_styles(std::string const &family, std::vector<StyleNames> styles)
+{
+    _styles[family] = std::move(styles);
+    _dirty = true;
+}
+
+void FontIndex::load()
+{
+    FILE *f = Inkscape::IO::fopen_utf8name(_filename.c_str(), "rb");
+    if (!f) {
+        return;
+    }
+
+    char magic[sizeof(MAGIC)];
+    std::uint32_t version;
+    std::uint64_t stamp;
+    if (std::fread(magic, sizeof(magic), 1, f) != 1 || std::memcmp(magic, MAGIC, sizeof(MAGIC)) ||
+        !read_u32(f, version) || version != FORMAT_VERSION ||
+        std::fread(&stamp, sizeof(stamp), 1, f) != 1 || stamp != _stamp)
+    {
+        std::fclose(f);
+        return;
+    }
+
+    std::vector<std::string> families;
+    std::unordered_map<std::string, std::vector<StyleNames>> styles;
+    bool ok = true;
+
+    std::uint32_t nfamilies = 0;
+    ok = read_u32(f, nfamilies);
+    for (std::uint32_t i = 0; ok && i < nfamilies; i++) {
+        ok = read_string(f, families.emplace_back());
+    }
+
+    std::uint32_t nstyled = 0;
+    ok = ok && read_u32(f, nstyled);
+    for (std::uint32_t i = 0; ok && i < nstyled; i++) {
+        std::string family;
+        std::uint32_t count = 0;
+        ok = read_string(f, family) && read_u32(f, count) && count < MAX_STRING;
+        auto &list = styles[family];
+        for (std::uint32_t j = 0; ok && j < count; j++) {
+            std::string css, display;
+            ok = read_string(f, css) && read_string(f, display);
+            list.emplace_back(css, display);
+        }
+    }
+
+    std::fclose(f);
+
+    // Only use complete indexes; a truncated one is rewritten on the next save.
+    if (ok) {
+        _families = std::move(families);
+        _styles = std::move(styles);
+    }
+}
+
+void FontIndex::save()
+{
+    if (!_dirty || !_families) {
+        return;
+    }
+
+    auto dir = Glib::path_get_dirname(_filename);
+    g_mkdir_with_parents(dir.c_str(), 0755);
+
+    std::string data;
+    data.append(MAGIC, sizeof(MAGIC));
+    write_u32(data, FORMAT_VERSION);
+    data.append(reinterpret_cast<char const *>(&_stamp), sizeof(_stamp));
+
+    write_u32(data, _families->size());
+    for (auto const &family : *_families) {
+        write_string(data, family);
+    }
+
+    write_u32(data, _styles.size());
+    for (auto const &[family, list] : _styles) {
+        write_string(data, family);
+        write_u32(data, list.size());
+        for (auto const &style : list) {
+            write_string(data, style.css_name.raw());
+            write_string(data, style.display_name.raw());
+        }
+    }
+
+    // Written to a uniquely named file in the same directory, then renamed into place, so that
+    // Inkscape processes saving at the same time cannot interleave their writes.
+    if (!g_file_set_contents(_filename.c_str(), data.data(), data.size(), nullptr)) {
+        return;
+    }
+    _dirty = false;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8 :
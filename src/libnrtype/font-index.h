@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * On-disk index of the font families and styles shown in the UI.
+ *//*
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef LIBNRTYPE_FONT_INDEX_H
+#define LIBNRTYPE_FONT_INDEX_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fontconfig/fontconfig.h>
+
+#include "font-factory.h"
+
+/**
+ * Persistent copy of what FontFactory::GetUIFamilies() and FontFactory::GetUIStyles() return,
+ * so that the font lists do not need to be rebuilt from Pango on every start.
+ *
+ * The index is keyed on a stamp derived from the fontconfig configuration: the modification
+ * times of its font directories, cache directories and configuration files, plus the number of
+ * application fonts. Any change to the installed fonts changes the stamp and discards the index.
+ * Styles are recorded per family as they are looked up.
+ */
+class FontIndex
+{
+public:
+    explicit FontIndex(FcConfig *config);
+
+    std::vector<std::string> const *families() const { return _families ? &*_families : nullptr; }
+    void set_families(std::vector<std::string> families);
+
+    std::vector<StyleNames> const *styles(std::string const &family) const;
+    void set_styles(std::string const &family, std::vector<StyleNames> styles);
+
+    /// Write the index to disk if it changed since it was loaded.
+    void save();
+
+private:
+    static std::uint64_t compute_stamp(FcConfig *config);
+    void load();
+
+    std::string _filename;
+    std::uint64_t _stamp;
+    std::optional<std::vector<std::string>> _families;
+    std::unordered_map<std::string, std::vector<StyleNames>> _styles;
+    bool _dirty = false;
+};
+
+#endif // LIBNRTYPE_FONT_INDEX_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8 :
@@ -19,6 +19,7 @@
 
 #include "font-lister.h"
 
+#include <algorithm>
 #include <glibmm/markup.h>
 #include <glibmm/regex.h>
 #include <gtkmm/cellrenderertext.h>
@@ -67,8 +68,8 @@ FontLister::FontLister()
         {"Bold Italic"}
     });
 
-    pango_family_map = FontFactory::get().GetUIFamilies();
-    init_font_families();
+    // The family list is filled on first use; headless sessions never need it.
+    font_list_store = Gtk::ListStore::create(font_list);
 
     style_list_store = Gtk::ListStore::create(font_style_list);
     init_default_styles();
@@ -77,8 +78,9 @@ FontLister::FontLister()
     if (auto settings = Gtk::Settings::get_default()) {
         settings->property_gtk_fontconfig_timestamp().signal_changed().connect([this]() {
             FontFactory::get().refreshConfig();
-            pango_family_map = FontFactory::get().GetUIFamilies();
-            init_font_families(-1);
+            if (font_list_filled) {
+                init_font_families(-1);
+            }
             new_fonts_signal.emit();
         });
     }
@@ -88,18 +90,39 @@ FontLister::~FontLister() = default;
 
 bool FontLister::font_installed_on_system(Glib::ustring const &font) const
 {
-    return pango_family_map.find(font) != pango_family_map.end();
+    auto const &families = FontFactory::get().GetUIFamilyNames();
+    return std::binary_search(families.begin(), families.end(), font.raw());
 }
 
-void FontLister::init_font_families(int group_offset, int group_size)
+int FontLister::get_font_families_size() const
 {
-    static bool first_call = true;
+    return FontFactory::get().GetUIFamilyNames().size();
+}
 
-    if (first_call)
-    {
-        font_list_store = Gtk::ListStore::create(font_list);
-        first_call = false;
+void FontLister::ensure_font_list()
+{
+    if (!font_list_filled) {
+        init_font_families();
     }
+}
+
+Glib::RefPtr<Gtk::ListStore> const &FontLister::get_font_list()
+{
+    ensure_font_list();
+    return font_list_store;
+}
+
+std::shared_ptr<FontLister::Styles> FontLister::get_system_styles(Glib::ustring const &family)
+{
+    if (!font_installed_on_system(family)) {
+        return default_styles;
+    }
+    return std::make_shared<Styles>(FontFactory::get().GetUIStyles(family.raw()));
+}
+
+void FontLister::init_font_families(int group_offset, int group_size)
+{
+    font_list_filled = true;
 
     if (group_offset <= 0) {
         font_list_store->clear();
@@ -110,15 +133,13 @@ void FontLister::init_font_families(int group_offset, int group_size)
     font_list_store->freeze_notify();
 
     // Traverse through the family names and set up the list store
-    for (auto const &key_val : pango_family_map) {
-        if (!key_val.first.empty()) {
+    for (auto const &family : FontFactory::get().GetUIFamilyNames()) {
+        if (!family.empty()) {
             auto row = *font_list_store->append();
-            row[font_list.family] = key_val.first;
+            row[font_list.family] = family;
             // we don't set this now (too slow) but the style will be cached if the user
             // ever decides to use this font
             row[font_list.styles] = nullptr;
-            // store the pango representation for generating the style
-            row[font_list.pango_family] = key_val.second;
             row[font_list.onSystem] = true;
         }
     }
@@ -140,11 +161,11 @@ void FontLister::init_default_styles()
     update_signal.emit();
 }
 
-std::string FontLister::get_font_count_label() const
+std::string FontLister::get_font_count_label()
 {
     std::string label;
 
-    int size = font_list_store->children().size();
+    int size = get_font_list()->children().size();
     int total_families = get_font_families_size();
 
     if (size >= total_families) {
@@ -189,13 +210,14 @@ void FontLister::show_results(Glib::ustring const &search_text)
         return;
     }
 
-    // Clear the list store.
+    // Clear the list store. It is being refilled, so there's no need to list all fonts first.
+    font_list_filled = true;
     font_list_store->freeze_notify();
     font_list_store->clear();
 
     // Start iterating over the families.
     // Take advantage of sorted families to speed up the search.
-    for (auto const &[family_str, pango_family] : pango_family_map) {
+    for (auto const &family_str : FontFactory::get().GetUIFamilyNames()) {
         if (find_string_case_insensitive(family_str, search_text)) {
             auto row = *font_list_store->append();
             row.set_value(font_list.family, Glib::ustring{family_str});
@@ -204,8 +226,6 @@ void FontLister::show_results(Glib::ustring const &search_text)
             // ever decides to use this font
             // row.set_value(FontList.styles, nullptr); // not needed: default on new row
 
-            // store the pango representation for generating the style
-            row.set_value(font_list.pango_family, pango_family);
             row.set_value(font_list.onSystem, true);
         }
     }
@@ -245,6 +265,7 @@ void FontLister::apply_collections(std::set <Glib::ustring>& selected_collection
     }
 
     // Freeze the font list.
+    font_list_filled = true;
     font_list_store->freeze_notify();
     font_list_store->clear();
 
@@ -264,9 +285,6 @@ void FontLister::apply_collections(std::set <Glib::ustring>& selected_collection
         // we don't set this now (too slow) but the style will be cached if the user
         // ever decides to use this font
         row[font_list.styles] = nullptr;
-
-        // store the pango representation for generating the style
-        row[font_list.pango_family] = pango_family_map[f];
         row[font_list.onSystem] = true;
     }
 
@@ -286,8 +304,8 @@ void FontLister::ensureRowStyles(Gtk::TreeModel::iterator iter)
         return;
     }
 
-    if (row[font_list.pango_family]) {
-        row[font_list.styles] = std::make_shared<Styles>(FontFactory::get().GetUIStyles(row[font_list.pango_family]));
+    if (row[font_list.onSystem]) {
+        row[font_list.styles] = get_system_styles(row[font_list.family]);
     } else {
         row[font_list.styles] = default_styles;
     }
@@ -367,6 +385,8 @@ Glib::ustring FontLister::get_font_family_markup(Gtk::TreeModel::const_iterator
 // Used to insert a font that was not in the document and not on the system into the font list.
 void FontLister::insert_font_family(Glib::ustring const &new_family)
 {
+    ensure_font_list();
+
     auto styles = default_styles;
 
     // In case this is a fallback list, check if first font-family on system.
@@ -377,7 +397,7 @@ void FontLister::insert_font_family(Glib::ustring const &new_family)
 
             if (row[font_list.onSystem] && familyNamesAreEqual(tokens[0], row[font_list.family])) {
                 if (!row_styles) {
-                    row_styles = std::make_shared<Styles>(FontFactory::get().GetUIStyles(row[font_list.pango_family]));
+                    row_styles = get_system_styles(row[font_list.family]);
                 }
                 styles = row_styles;
                 break;
@@ -389,7 +409,6 @@ void FontLister::insert_font_family(Glib::ustring const &new_family)
     row[font_list.family] = new_family;
     row[font_list.styles] = styles;
     row[font_list.onSystem] = false;
-    row[font_list.pango_family] = nullptr;
 
     current_family = new_family;
     current_family_row = 0;
@@ -409,6 +428,8 @@ int FontLister::add_document_fonts_at_top(SPDocument *document)
         return 0;
     }
 
+    ensure_font_list();
+
     // Clear all old document font-family entries.
     {
         auto children = font_list_store->children();
@@ -484,7 +505,6 @@ int FontLister::add_document_fonts_at_top(SPDocument *document)
         row[font_list.styles] = std::make_shared<Styles>(std::move(data_styles));
         /* These are not needed as they are the default values.
         row.set_value(font_list.onSystem, false);    // false if document font
-        row.set_value(font_list.pango_family, nullptr); // CHECK ME (set to pango_family if on system?)
         */
     }
 
@@ -504,6 +524,8 @@ void FontLister::update_font_list(SPDocument *document)
         return;
     }
 
+    ensure_font_list();
+
     font_list_store->freeze_notify();
 
     /* Find if current row is in document or system part of list */
@@ -662,7 +684,8 @@ std::pair<Glib::ustring, Glib::ustring> FontLister::ui_from_fontspec(Glib::ustri
 void FontLister::font_family_row_update(int start)
 {
     if (this->current_family_row > -1 && start > -1) {
-        int length = this->font_list_store->children().size();
+        ensure_font_list();
+        int length = font_list_store->children().size();
         for (int i = 0; i < length; ++i) {
             int row = i + start;
             if (row >= length)
@@ -794,11 +817,11 @@ std::pair<Glib::ustring, Glib::ustring> FontLister::new_font_family(Glib::ustrin
 
     // For finding style list, use list of first family in font-family list.
     std::shared_ptr<Styles> styles;
-    for (auto row : font_list_store->children()) {
+    for (auto row : get_font_list()->children()) {
         if (familyNamesAreEqual(new_family, row[font_list.family])) {
             auto row_styles = row.get_value(font_list.styles);
             if (!row_styles) {
-                row_styles = std::make_shared<Styles>(FontFactory::get().GetUIStyles(row[font_list.pango_family]));
+                row_styles = get_system_styles(row[font_list.family]);
             }
             styles = std::move(row_styles);
             break;
@@ -882,7 +905,7 @@ std::pair<Glib::ustring, Glib::ustring> FontLister::set_font_family(int row, boo
     Gtk::TreePath path;
     path.push_back(row);
     Glib::ustring new_family = current_family;
-    if (auto iter = font_list_store->get_iter(path)) {
+    if (auto iter = get_font_list()->get_iter(path)) {
         new_family = (*iter)[font_list.family];
     }
 
@@ -1084,7 +1107,7 @@ Glib::ustring FontLister::fontspec_from_style(SPStyle *style) const
 
 Gtk::TreeModel::Row FontLister::get_row_for_font(Glib::ustring const &family)
 {
-    for (auto const &row : font_list_store->children()) {
+    for (auto const &row : get_font_list()->children()) {
         if (familyNamesAreEqual(family, row[font_list.family])) {
             return row;
         }
@@ -1095,12 +1118,12 @@ Gtk::TreeModel::Row FontLister::get_row_for_font(Glib::ustring const &family)
 
 Gtk::TreePath FontLister::get_path_for_font(Glib::ustring const &family)
 {
-    return font_list_store->get_path(get_row_for_font(family).get_iter());
+    return get_font_list()->get_path(get_row_for_font(family).get_iter());
 }
 
 bool FontLister::is_path_for_font(Gtk::TreePath path, Glib::ustring family)
 {
-    if (auto iter = font_list_store->get_iter(path)) {
+    if (auto iter = get_font_list()->get_iter(path)) {
         return familyNamesAreEqual(family, (*iter)[font_list.family]);
     }
 
@@ -1109,7 +1132,7 @@ bool FontLister::is_path_for_font(Gtk::TreePath path, Glib::ustring family)
 
 Gtk::TreeModel::Row FontLister::get_row_for_style(Glib::ustring const &style)
 {
-    for (auto const &row : font_list_store->children()) {
+    for (auto const &row : get_font_list()->children()) {
         if (familyNamesAreEqual(style, row[font_style_list.cssStyle])) {
             return row;
         }
@@ -1200,7 +1223,7 @@ Glib::ustring FontLister::get_best_style_match(Glib::ustring const &family, Glib
 
     auto styles = default_styles;
     if (row[font_list.onSystem] && !row.get_value(font_list.styles)) {
-        row[font_list.styles] = std::make_shared<Styles>(FontFactory::get().GetUIStyles(row[font_list.pango_family]));
+        row[font_list.styles] = get_system_styles(row[font_list.family]);
         styles = row[font_list.styles];
     }
 
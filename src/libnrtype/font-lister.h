@@ -104,22 +104,12 @@ public:
 
         /// Whether font is on system
         Gtk::TreeModelColumn<bool> onSystem;
-        
-        /**
-         * Not actually a column.
-         * Necessary for quick initialization of FontLister;
-         * we initially store the pango family and if the
-         * font style is actually used we'll cache it in
-         * %styles.
-         */
-        Gtk::TreeModelColumn<PangoFontFamily *> pango_family;
-        
+
         FontListClass()
         {
             add(family);
             add(styles);
             add(onSystem);
-            add(pango_family);
         }
     };
 
@@ -142,19 +132,13 @@ public:
 
     FontStyleListClass font_style_list;
 
-    /**
-     * The list of fonts, sorted by the order they will appear in the UI.
-     * Also used to give log-time access to each font's PangoFontFamily, owned by the FontFactory.
-     */
-    std::map<std::string, PangoFontFamily *> pango_family_map;
-
     /** 
      * @return the ListStore with the family names
      *
-     * The ListStore is ready to be used after class instantiation
+     * The ListStore is filled with the system fonts on first use
      * and should not be modified.
      */
-    Glib::RefPtr<Gtk::ListStore> const &get_font_list() const { return font_list_store; }
+    Glib::RefPtr<Gtk::ListStore> const &get_font_list();
 
     /**
      * @return the ListStore with the styles
@@ -327,12 +311,12 @@ public:
 
     bool blocked() const { return block; }
 
-    int get_font_families_size() const { return pango_family_map.size(); }
+    int get_font_families_size() const;
     bool font_installed_on_system(Glib::ustring const &font) const;
 
     void init_font_families(int group_offset = -1, int group_size = -1);
     void init_default_styles();
-    std::string get_font_count_label() const;
+    std::string get_font_count_label();
 
 private:
     FontLister();
@@ -342,7 +326,14 @@ private:
 
     void font_family_row_update(int start = 0);
 
+    /// Fill the family list with the system fonts if that hasn't happened yet.
+    void ensure_font_list();
+
+    /// Styles of an installed font family, or the default styles if it isn't installed.
+    std::shared_ptr<Styles> get_system_styles(Glib::ustring const &family);
+
     Glib::RefPtr<Gtk::ListStore> font_list_store;
+    bool font_list_filled = false;
     Glib::RefPtr<Gtk::ListStore> style_list_store;
 
     /**
@@ -20,6 +20,21 @@
  * but computing offsets of the path is faster...
  */
 
+namespace {
+
+// Half turn state of OutlineJoin(), see there. It is per thread, so that outlines can be computed
+// concurrently, and reset for every outline, so that the result doesn't depend on which outlines
+// were computed before on the same thread.
+struct HalfTurnState
+{
+    bool turn_inside = true;
+    Geom::Point prev_pos = {0, 0};
+};
+
+thread_local HalfTurnState half_turn;
+
+} // namespace
+
 // outline of a path.
 // computed by making 2 offsets, one of the "left" side of the path, one of the right side, and then glueing the two
 // the left side has to be reversed to make a contour
@@ -37,6 +52,7 @@ void Path::Outline(Path *dest, double width, JoinType join, ButtType butt, doubl
 
     dest->Reset();
     dest->SetBackData(false);
+    half_turn = {};
 
     outline_callbacks calls;
     Geom::Point endButt;
@@ -183,6 +199,7 @@ Path::OutsideOutline (Path * dest, double width, JoinType join, ButtType butt,
 	if (dest == nullptr) return;
 	dest->Reset ();
 	dest->SetBackData (false);
+	half_turn = {};
 
 	outline_callbacks calls;
 	Geom::Point endButt, endPos;
@@ -204,6 +221,7 @@ Path::InsideOutline (Path * dest, double width, JoinType join, ButtType butt,
 	if (dest == nullptr) return;
 	dest->Reset ();
 	dest->SetBackData (false);
+	half_turn = {};
 
 	outline_callbacks calls;
 	Geom::Point endButt, endPos;
@@ -877,10 +895,8 @@ Path::OutlineJoin (Path * dest, Geom::Point pos, Geom::Point stNor, Geom::Point
         extra nodes (due to rounding errors). Solution: for the 'half turn'-case toggle 
         inside/outside each time the same node is processed 2 consecutive times.
     */
-    static bool TurnInside = true;
-    static Geom::Point PrevPos(0, 0);
-    TurnInside ^= PrevPos == pos;
-    PrevPos = pos;
+    half_turn.turn_inside ^= half_turn.prev_pos == pos;
+    half_turn.prev_pos = pos;
 
 	const double angSi = cross (stNor, enNor);
 	const double angCo = dot (stNor, enNor);
@@ -903,7 +919,7 @@ Path::OutlineJoin (Path * dest, Geom::Point pos, Geom::Point stNor, Geom::Point
 //                dest->LineTo (pos);	// redundant
                 dest->LineTo (pos + width*enNor);
             }
-        } else if (angSi == 0 && TurnInside) { // Half turn (180 degrees) ... inside (see above).
+        } else if (angSi == 0 && half_turn.turn_inside) { // Half turn (180 degrees) ... inside (see above).
             dest->LineTo (pos + width*enNor);
         } else { // This is an outside join -> chosen JoinType should be applied.
             if (join == join_round) {
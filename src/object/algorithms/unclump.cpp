@@ -16,70 +16,100 @@
 
 #include <2geom/transforms.h>
 #include <algorithm>
-#include <map>
+#include <cmath>
+#include <utility>
+#include <vector>
 
 #include "object/sp-item.h"
 
 class Unclump
 {
 public:
-    double dist(SPItem *item1, SPItem *item2);
-    double average(SPItem *item, std::list<SPItem *> &others);
-    SPItem *closest(SPItem *item, std::list<SPItem *> &others);
-    SPItem *farthest(SPItem *item, std::list<SPItem *> &others);
-    std::vector<SPItem *> unclump_remove_behind(SPItem *item, SPItem *closest, std::list<SPItem *> &rest);
-    void push(SPItem *from, SPItem *what, double dist);
-    void pull(SPItem *to, SPItem *what, double dist);
+    Unclump(std::vector<SPItem *> const &items);
+
+    void run();
 
 private:
-    Geom::Point unclump_center(SPItem *item);
-    Geom::Point unclump_wh(SPItem *item);
+    double dist(int item1, int item2) const;
+    double average(int item, std::vector<int> const &others) const;
+    int closest(int item, std::vector<int> const &others) const;
+    int farthest(int item, std::vector<int> const &others) const;
+    std::vector<int> neighbours(int item);
+    void move(int item, Geom::Point const &by);
+
+    std::pair<int, int> cellOf(Geom::Point const &p) const;
+    std::vector<int> &cell(std::pair<int, int> const &c) { return _cells[c.second * _columns + c.first]; }
 
     // Taking bbox of an item is an expensive operation, and we need to do it many times, so here we
     // cache the centers, widths, and heights of items
-
-    std::map<const gchar *, Geom::Point> c_cache;
-    std::map<const gchar *, Geom::Point> wh_cache;
+    struct Entry
+    {
+        SPItem *item;
+        Geom::Point center; ///< Center of the visual bounding box, following the moves of the item.
+        Geom::Point wh;     ///< Size of the visual bounding box.
+        double radius;      ///< Half the larger side: dist() never measures from farther off the center.
+        bool has_bbox;
+    };
+    std::vector<Entry> _entries;
+
+    // The centers in a uniform grid, to find the items near a point.
+    Geom::Point _origin;
+    double _cell_size = 1.0;
+    int _columns = 1;
+    int _rows = 1;
+    std::vector<std::vector<int>> _cells;
+
+    Geom::Point _min, _max; ///< Bounds of all centers.
+    double _max_radius = 0.0;
 };
 
-/**
-Center of bbox of item
-*/
-Geom::Point Unclump::unclump_center(SPItem *item)
+Unclump::Unclump(std::vector<SPItem *> const &items)
 {
-    std::map<const gchar *, Geom::Point>::iterator i = c_cache.find(item->getId());
-    if (i != c_cache.end()) {
-        return i->second;
+    if (items.empty()) {
+        return;
     }
 
-    Geom::OptRect r = item->desktopVisualBounds();
-    if (r) {
-        Geom::Point const c = r->midpoint();
-        c_cache[item->getId()] = c;
-        return c;
-    } else {
-        // FIXME
-        return Geom::Point(0, 0);
-    }
-}
-
-Geom::Point Unclump::unclump_wh(SPItem *item)
-{
-    Geom::Point wh;
-    std::map<const gchar *, Geom::Point>::iterator i = wh_cache.find(item->getId());
-    if (i != wh_cache.end()) {
-        wh = i->second;
-    } else {
+    _entries.reserve(items.size());
+    for (auto item : items) {
         Geom::OptRect r = item->desktopVisualBounds();
         if (r) {
-            wh = r->dimensions();
-            wh_cache[item->getId()] = wh;
+            _entries.push_back({item, r->midpoint(), r->dimensions(), r->maxExtent() / 2, true});
         } else {
-            wh = Geom::Point(0, 0);
+            // FIXME
+            _entries.push_back({item, Geom::Point(0, 0), Geom::Point(0, 0), 0.0, false});
         }
     }
 
-    return wh;
+    _min = _max = _entries.front().center;
+    for (auto const &e : _entries) {
+        for (int d = 0; d < 2; d++) {
+            _min[d] = std::min(_min[d], e.center[d]);
+            _max[d] = std::max(_max[d], e.center[d]);
+        }
+        _max_radius = std::max(_max_radius, e.radius);
+    }
+
+    // About one item per cell.
+    auto const size = _max - _min;
+    double const n = _entries.size();
+    _cell_size = std::max({std::sqrt(size[Geom::X] * size[Geom::Y] / n), size[Geom::X] / n, size[Geom::Y] / n, 1e-6});
+    _origin = _min;
+    _columns = static_cast<int>(size[Geom::X] / _cell_size) + 1;
+    _rows = static_cast<int>(size[Geom::Y] / _cell_size) + 1;
+    _cells.resize(static_cast<size_t>(_columns) * _rows);
+
+    for (int i = 0; i < static_cast<int>(_entries.size()); i++) {
+        cell(cellOf(_entries[i].center)).push_back(i);
+    }
+}
+
+std::pair<int, int> Unclump::cellOf(Geom::Point const &p) const
+{
+    // Centers that have moved out of the grid go into its border cells.
+    auto const q = p - _origin;
+    int const x = static_cast<int>(std::clamp(std::floor(q[Geom::X] / _cell_size), 0.0, _columns - 1.0));
+    int const y = static_cast<int>(std::clamp(std::floor(q[Geom::Y] / _cell_size), 0.0, _rows - 1.0));
+    return {x, y};
 }
 
 /**
@@ -87,13 +117,13 @@ Distance between "edges" of item1 and item2. An item is considered to be an elli
 so its radius (distance from center to edge) depends on the w/h and the angle towards the other item.
 May be negative if the edge of item1 is between the center and the edge of item2.
 */
-double Unclump::dist(SPItem *item1, SPItem *item2)
+double Unclump::dist(int item1, int item2) const
 {
-    Geom::Point c1 = unclump_center(item1);
-    Geom::Point c2 = unclump_center(item2);
+    Geom::Point c1 = _entries[item1].center;
+    Geom::Point c2 = _entries[item2].center;
 
-    Geom::Point wh1 = unclump_wh(item1);
-    Geom::Point wh2 = unclump_wh(item2);
+    Geom::Point wh1 = _entries[item1].wh;
+    Geom::Point wh2 = _entries[item2].wh;
 
     // angle from each item's center to the other's, unsqueezed by its w/h, normalized to 0..pi/2
     double a1 = atan2((c2 - c1)[Geom::Y], (c2 - c1)[Geom::X] * wh1[Geom::Y] / wh1[Geom::X]);
@@ -181,11 +211,11 @@ double Unclump::dist(SPItem *item1, SPItem *item2)
 /**
 Average dist from item to others
 */
-double Unclump::average(SPItem *item, std::list<SPItem *> &others)
+double Unclump::average(int item, std::vector<int> const &others) const
 {
     int n = 0;
     double sum = 0;
-    for (SPItem *other : others) {
+    for (int other : others) {
         if (other == item)
             continue;
 
@@ -202,12 +232,12 @@ double Unclump::average(SPItem *item, std::list<SPItem *> &others)
 /**
 Closest to item among others
  */
-SPItem *Unclump::closest(SPItem *item, std::list<SPItem *> &others)
+int Unclump::closest(int item, std::vector<int> const &others) const
 {
     double min = HUGE_VAL;
-    SPItem *closest = nullptr;
+    int closest = -1;
 
-    for (SPItem *other : others) {
+    for (int other : others) {
         if (other == item)
             continue;
 
@@ -224,12 +254,12 @@ SPItem *Unclump::closest(SPItem *item, std::list<SPItem *> &others)
 /**
 Most distant from item among others
  */
-SPItem *Unclump::farthest(SPItem *item, std::list<SPItem *> &others)
+int Unclump::farthest(int item, std::vector<int> const &others) const
 {
     double max = -HUGE_VAL;
-    SPItem *farthest = nullptr;
+    int farthest = -1;
 
-    for (SPItem *other : others) {
+    for (int other : others) {
         if (other == item)
             continue;
 
@@ -244,147 +274,197 @@ SPItem *Unclump::farthest(SPItem *item, std::list<SPItem *> &others)
 }
 
 /**
-Removes from the \a rest list those items that are "behind" \a closest as seen from \a item,
-i.e. those on the other side of the line through \a closest perpendicular to the direction from \a
-item to \a closest. Returns a newly created list which must be freed.
+Neighbours of item, as found by repeatedly taking the closest of the remaining items and dropping
+those that are "behind" it as seen from item, i.e. on the other side of the line through the
+closest item perpendicular to the direction from item to it. Returned most recently found first.
+
+Instead of measuring the distance to every item each time, the grid is searched in rings of cells
+around item, until no item farther out can be closer, or lie in front of all neighbours found.
  */
-std::vector<SPItem *> Unclump::unclump_remove_behind(SPItem *item, SPItem *closest, std::list<SPItem *> &rest)
+std::vector<int> Unclump::neighbours(int item)
 {
-    Geom::Point it = unclump_center(item);
-    Geom::Point p1 = unclump_center(closest);
-
-    // perpendicular through closest to the direction to item:
-    Geom::Point perp = Geom::rot90(it - p1);
-    Geom::Point p2 = p1 + perp;
-
-    // get the standard Ax + By + C = 0 form for p1-p2:
-    double A = p1[Geom::Y] - p2[Geom::Y];
-    double B = p2[Geom::X] - p1[Geom::X];
-    double C = p2[Geom::Y] * p1[Geom::X] - p1[Geom::Y] * p2[Geom::X];
+    Geom::Point const it = _entries[item].center;
+
+    // Lines dropping the items behind each neighbour, as Ax + By + C = 0, with the value at item.
+    struct Line
+    {
+        double A, B, C, val_item;
+        bool behind(Geom::Point const &o) const { return val_item * (A * o[Geom::X] + B * o[Geom::Y] + C) <= 1e-6; }
+    };
+    std::vector<Line> lines;
+
+    // The region in front of all lines, slightly enlarged, as a convex polygon.
+    double const slack = 1e-6 * (1.0 + std::max(_max[Geom::X] - _min[Geom::X], _max[Geom::Y] - _min[Geom::Y]));
+    std::vector<Geom::Point> region = {
+        {_min[Geom::X] - 1, _min[Geom::Y] - 1}, {_max[Geom::X] + 1, _min[Geom::Y] - 1},
+        {_max[Geom::X] + 1, _max[Geom::Y] + 1}, {_min[Geom::X] - 1, _max[Geom::Y] + 1}};
+
+    std::vector<int> candidates; // items found in the grid and in front of all lines
+    std::vector<int> nei;
+
+    auto const [cx, cy] = cellOf(it);
+    int const last_ring = std::max({cx, _columns - 1 - cx, cy, _rows - 1 - cy});
+    int ring = 0;
+
+    while (true) {
+        // Items not found yet are at least this far from item, so at least bound from its edge.
+        double const reach = (ring - 1) * _cell_size;
+        double const bound = reach - _entries[item].radius - _max_radius - slack;
+
+        bool exhausted = ring > last_ring;
+        if (!exhausted) {
+            double region_reach = -1.0;
+            for (auto const &p : region) {
+                region_reach = std::max(region_reach, Geom::L2(p - it));
+            }
+            exhausted = region_reach < reach;
+        }
 
-    // substitute the item into it:
-    double val_item = A * it[Geom::X] + B * it[Geom::Y] + C;
+        // The closest candidate, preferring the earliest in the selection among equals.
+        double min = HUGE_VAL;
+        int closest = -1;
+        for (int other : candidates) {
+            double dist = this->dist(item, other);
+            if ((dist < min || (dist == min && other < closest)) && fabs(dist) < 1e6) {
+                min = dist;
+                closest = other;
+            }
+        }
 
-    std::vector<SPItem *> out;
-    for (SPItem *other : rest) {
-        if (other == item)
+        if (!exhausted && !(closest != -1 && min < bound)) {
+            // Look further out.
+            for (int y = cy - ring; y <= cy + ring; y++) {
+                bool const edge = y == cy - ring || y == cy + ring;
+                for (int x = cx - ring; x <= cx + ring; x += edge ? 1 : std::max(1, 2 * ring)) {
+                    if (x < 0 || y < 0 || x >= _columns || y >= _rows) {
+                        continue;
+                    }
+                    for (int other : cell({x, y})) {
+                        if (other != item && std::none_of(lines.begin(), lines.end(), [&] (Line const &l) { return l.behind(_entries[other].center); })) {
+                            candidates.push_back(other);
+                        }
+                    }
+                }
+            }
+            ring++;
             continue;
+        }
 
-        Geom::Point o = unclump_center(other);
-        double val_other = A * o[Geom::X] + B * o[Geom::Y] + C;
-
-        if (val_item * val_other <= 1e-6) {
-            // different signs, which means item and other are on the different sides of p1-p2 line; skip
-        } else {
-            out.push_back(other);
+        if (closest == -1) {
+            break;
         }
-    }
 
-    return out;
-}
+        nei.push_back(closest);
+        candidates.erase(std::find(candidates.begin(), candidates.end(), closest));
 
-/**
-Moves \a what away from \a from by \a dist
- */
-void Unclump::push(SPItem *from, SPItem *what, double dist)
-{
-    Geom::Point it = unclump_center(what);
-    Geom::Point p = unclump_center(from);
-    Geom::Point by = dist * Geom::unit_vector(-(p - it));
+        // perpendicular through closest to the direction to item:
+        Geom::Point p1 = _entries[closest].center;
+        Geom::Point perp = Geom::rot90(it - p1);
+        Geom::Point p2 = p1 + perp;
 
-    Geom::Affine move = Geom::Translate(by);
+        // get the standard Ax + By + C = 0 form for p1-p2:
+        Line line;
+        line.A = p1[Geom::Y] - p2[Geom::Y];
+        line.B = p2[Geom::X] - p1[Geom::X];
+        line.C = p2[Geom::Y] * p1[Geom::X] - p1[Geom::Y] * p2[Geom::X];
+        line.val_item = line.A * it[Geom::X] + line.B * it[Geom::Y] + line.C;
+        lines.push_back(line);
 
-    std::map<const gchar *, Geom::Point>::iterator i = c_cache.find(what->getId());
-    if (i != c_cache.end()) {
-        i->second *= move;
-    }
+        std::erase_if(candidates, [&] (int other) { return line.behind(_entries[other].center); });
 
-    // g_print ("push %s at %g,%g from %g,%g by %g,%g, dist %g\n", what->getId(), it[Geom::X],it[Geom::Y],
-    // p[Geom::X],p[Geom::Y], by[Geom::X],by[Geom::Y], dist);
+        // Clip the region to the front of the line, allowing for rounding.
+        double const grad = std::abs(line.val_item) * std::hypot(line.A, line.B);
+        if (grad == 0) {
+            region.clear();
+        }
+        auto front = [&] (Geom::Point const &p) {
+            return line.val_item * (line.A * p[Geom::X] + line.B * p[Geom::Y] + line.C) + grad * slack;
+        };
+        std::vector<Geom::Point> clipped;
+        for (size_t k = 0; k < region.size(); k++) {
+            auto const &p = region[k];
+            auto const &q = region[(k + 1) % region.size()];
+            double const fp = front(p);
+            double const fq = front(q);
+            if (fp >= 0) {
+                clipped.push_back(p);
+            }
+            if ((fp >= 0) != (fq >= 0)) {
+                clipped.push_back(p + (q - p) * (fp / (fp - fq)));
+            }
+        }
+        region = std::move(clipped);
+    }
 
-    what->set_i2d_affine(what->i2dt_affine() * move);
-    what->doWriteTransform(what->transform);
+    std::reverse(nei.begin(), nei.end());
+    return nei;
 }
 
 /**
-Moves \a what towards \a to by \a dist
+Moves \a item by \a by
  */
-void Unclump::pull(SPItem *to, SPItem *what, double dist)
+void Unclump::move(int item, Geom::Point const &by)
 {
-    Geom::Point it = unclump_center(what);
-    Geom::Point p = unclump_center(to);
-    Geom::Point by = dist * Geom::unit_vector(p - it);
-
-    Geom::Affine move = Geom::Translate(by);
-
-    std::map<const gchar *, Geom::Point>::iterator i = c_cache.find(what->getId());
-    if (i != c_cache.end()) {
-        i->second *= move;
+    auto &e = _entries[item];
+    if (e.has_bbox) {
+        auto &from = cell(cellOf(e.center));
+        from.erase(std::find(from.begin(), from.end(), item));
+        e.center += by;
+        cell(cellOf(e.center)).push_back(item);
+
+        for (int d = 0; d < 2; d++) {
+            _min[d] = std::min(_min[d], e.center[d]);
+            _max[d] = std::max(_max[d], e.center[d]);
+        }
     }
 
-    // g_print ("pull %s at %g,%g to %g,%g by %g,%g, dist %g\n", what->getId(), it[Geom::X],it[Geom::Y],
-    // p[Geom::X],p[Geom::Y], by[Geom::X],by[Geom::Y], dist);
-
-    what->set_i2d_affine(what->i2dt_affine() * move);
-    what->doWriteTransform(what->transform);
+    Geom::Affine move = Geom::Translate(by);
+    e.item->set_i2d_affine(e.item->i2dt_affine() * move);
+    e.item->doWriteTransform(e.item->transform);
 }
 
-/**
-Unclumps the items in \a items, reducing local unevenness in their distribution. Produces an effect
-similar to "engraver dots". The only distribution which is unchanged by unclumping is a hexagonal
-grid. May be called repeatedly for stronger effect.
- */
-void unclump(std::vector<SPItem *> &items)
+void Unclump::run()
 {
-    Unclump unclump;
+    for (int item = 0; item < static_cast<int>(_entries.size()); item++) { //  for each original/clone x:
+        auto const nei = neighbours(item);
 
-    for (SPItem *item : items) { //  for each original/clone x:
-        std::list<SPItem *> nei;
+        if (nei.size() >= 2) {
+            double ave = average(item, nei);
 
-        std::list<SPItem *> rest;
-        for (size_t i = 0; i < items.size(); i++) {
-            rest.push_front(items[items.size() - i - 1]);
-        }
-        rest.remove(item);
-
-        while (!rest.empty()) {
-            SPItem *closest = unclump.closest(item, rest);
-            if (closest) {
-                nei.push_front(closest);
-                rest.remove(closest);
-                std::vector<SPItem *> new_rest = unclump.unclump_remove_behind(item, closest, rest);
-                rest.clear();
-                for (size_t i = 0; i < new_rest.size(); i++) {
-                    rest.push_front(new_rest[new_rest.size() - i - 1]);
-                }
-            } else {
-                break;
-            }
-        }
-
-        if ((nei.size()) >= 2) {
-            double ave = unclump.average(item, nei);
+            int closest = this->closest(item, nei);
+            int farthest = this->farthest(item, nei);
 
-            SPItem *closest = unclump.closest(item, nei);
-            SPItem *farthest = unclump.farthest(item, nei);
-
-            double dist_closest = unclump.dist(closest, item);
-            double dist_farthest = unclump.dist(farthest, item);
-
-            // g_print ("NEI %d for item %s    closest %s at %g  farthest %s at %g  ave %g\n", g_slist_length(nei),
-            // item->getId(), closest->getId(), dist_closest, farthest->getId(), dist_farthest, ave);
+            double dist_closest = dist(closest, item);
+            double dist_farthest = dist(farthest, item);
 
             if (fabs(ave) < 1e6 && fabs(dist_closest) < 1e6 && fabs(dist_farthest) < 1e6) { // otherwise the items are
                                                                                             // bogus
                 // increase these coefficients to make unclumping more aggressive and less stable
                 // the pull coefficient is a bit bigger to counteract the long-term expansion trend
-                unclump.push(closest, item, 0.3 * (ave - dist_closest));
-                unclump.pull(farthest, item, 0.35 * (dist_farthest - ave));
+
+                // push away from closest
+                Geom::Point it = _entries[item].center;
+                move(item, 0.3 * (ave - dist_closest) * Geom::unit_vector(-(_entries[closest].center - it)));
+
+                // pull towards farthest
+                it = _entries[item].center;
+                move(item, 0.35 * (dist_farthest - ave) * Geom::unit_vector(_entries[farthest].center - it));
             }
         }
     }
 }
 
+/**
+Unclumps the items in \a items, reducing local unevenness in their distribution. Produces an effect
+similar to "engraver dots". The only distribution which is unchanged by unclumping is a hexagonal
+grid. May be called repeatedly for stronger effect.
+ */
+void unclump(std::vector<SPItem *> &items)
+{
+    Unclump unclump(items);
+    unclump.run();
+}
+
 /*
   Local Variables:
   mode:c++
@@ -456,6 +456,12 @@ public:
     // path operations
     // in path/path-object-set.cpp
     bool strokesToPaths(bool legacy = false, bool skip_undo = false);
+    /**
+     * Simplify the selected paths. On a desktop, unless skip_undo is set, this happens in the
+     * background: false is returned and the outcome is shown on the desktop once it is done.
+     *
+     * @return Whether any path was simplified before returning.
+     */
     bool simplifyPaths(bool skip_undo = false);
 
     // Boolean operations
@@ -19,6 +19,7 @@
 #include <glibmm/stringutils.h>
 
 #include "attributes.h"
+#include "conn-router.h"
 #include "document.h"
 #include "sp-conn-end.h"
 #include "sp-item-group.h"
@@ -67,12 +68,15 @@ void SPConnEndPair::release()
 
     // If the document is being destroyed then the router instance
     // and the ConnRefs will have been destroyed with it.
-    const bool routerInstanceExists = (_path->document->getRouter() != nullptr);
+    Avoid::Router *router = _path->document->getRouter();
 
-    if (_connRef && routerInstanceExists) {
-        _connRef->router()->deleteConnector(_connRef);
+    if (_connRef && router) {
+        router->deleteConnector(_connRef);
+        _path->document->getConnRouter().markChanged();
     }
     _connRef = nullptr;
+    _initialised = false;
+    _path->document->getConnRouter().forget(_path);
 
     _transformed_connection.disconnect();
 }
@@ -110,19 +114,24 @@ void SPConnEndPair::setAttr(const SPAttr key, gchar const *const value)
                 _connRef = new Avoid::ConnRef(router);
                 _connRef->setRoutingType(new_conn_type == SP_CONNECTOR_POLYLINE ?
                     Avoid::ConnType_PolyLine : Avoid::ConnType_Orthogonal);
+                _path->document->getConnRouter().markChanged();
                 _transformed_connection = _path->connectTransformed(sigc::ptr_fun(&avoid_conn_transformed));
             } else if (new_conn_type != _connType) {
                 _connType = new_conn_type;
+                _path->document->waitForRouter();
                 _connRef->setRoutingType(new_conn_type == SP_CONNECTOR_POLYLINE ?
                     Avoid::ConnType_PolyLine : Avoid::ConnType_Orthogonal);
+                _path->document->getConnRouter().markChanged();
                 sp_conn_reroute_path(_path);
             }
         } else {
             _connType = SP_CONNECTOR_NOAVOID;
 
             if (_connRef) {
-                _connRef->router()->deleteConnector(_connRef);
+                _path->document->getRouter()->deleteConnector(_connRef);
+                _path->document->getConnRouter().markChanged();
                 _connRef = nullptr;
+                _initialised = false;
                 _transformed_connection.disconnect();
             }
         }
@@ -130,7 +139,7 @@ void SPConnEndPair::setAttr(const SPAttr key, gchar const *const value)
     case SPAttr::CONNECTOR_CURVATURE:
         if (value) {
             _connCurvature = g_strtod(value, nullptr);
-            if (_connRef && _connRef->isInitialised()) {
+            if (_connRef && _initialised) {
                 // Redraw the connector, but only if it has been initialised.
                 sp_conn_reroute_path(_path);
             }
@@ -260,6 +269,10 @@ static void redrawConnectorCallback(void *ptr)
         // This can happen when the document is being destroyed.
         return;
     }
+    if (path->document->getConnRouter().deferRedraw(path)) {
+        // Routed in the background; redrawn on the main thread once routing finishes.
+        return;
+    }
     sp_conn_redraw_path(path);
 }
 
@@ -274,14 +287,16 @@ void SPConnEndPair::update()
 {
     if (_connType != SP_CONNECTOR_NOAVOID) {
         g_assert(_connRef != nullptr);
-        if (!_connRef->isInitialised()) {
-            _updateEndPoints();
+        if (!_initialised) {
+            _initialised = true;
+            _path->document->waitForRouter();
             _connRef->setCallback(&redrawConnectorCallback, _path);
+            _updateEndPoints();
         }
     }
 }
 
-void SPConnEndPair::_updateEndPoints()
+void SPConnEndPair::_updateEndPoints(bool const invalidate)
 {
     Geom::Point endPt[2];
     getEndpoints(endPt);
@@ -289,7 +304,14 @@ void SPConnEndPair::_updateEndPoints()
     Avoid::Point src(endPt[0][Geom::X], endPt[0][Geom::Y]);
     Avoid::Point dst(endPt[1][Geom::X], endPt[1][Geom::Y]);
 
-    _connRef->setEndpoints(src, dst);
+    // The router may be busy routing in the background, so leave it to
+    // apply the change when it can.
+    _path->document->getConnRouter().edit([connRef = _connRef, src, dst, invalidate] (Avoid::Router &) {
+        if (invalidate) {
+            connRef->makePathInvalid();
+        }
+        connRef->setEndpoints(src, dst);
+    });
 }
 
 
@@ -352,11 +374,13 @@ void SPConnEndPair::tellLibavoidNewEndpoints(bool const processTransaction)
         // Do nothing
         return;
     }
-    makePathInvalid();
-
-    _updateEndPoints();
     if (processTransaction) {
-        _connRef->router()->processTransaction();
+        Avoid::Router *router = _path->document->getRouter();
+        makePathInvalid();
+        _updateEndPoints();
+        router->processTransaction();
+    } else {
+        _updateEndPoints(true);
     }
     return;
 }
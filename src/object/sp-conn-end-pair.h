@@ -54,7 +54,7 @@ public:
     void rerouteFromManipulation();
 
 private:
-    void _updateEndPoints();
+    void _updateEndPoints(bool invalidate = false);
 
     SPConnEnd *_connEnd[2];
 
@@ -63,6 +63,9 @@ private:
     // libavoid's internal representation of the item.
     Avoid::ConnRef *_connRef;
 
+    // Whether the endpoints and callback of _connRef have been set up.
+    bool _initialised = false;
+
     int _connType;
     double _connCurvature;
 
@@ -43,6 +43,7 @@
 #include "sp-pattern.h"
 #include "sp-rect.h"
 #include "sp-root.h"
+#include "sp-shape.h"
 #include "sp-switch.h"
 #include "sp-text.h"
 #include "sp-textpath.h"
@@ -1336,6 +1337,11 @@ void SPItem::invoke_hide_except(unsigned key, const std::vector<SPItem const *>
 {
     // If item is not in the list of items to keep.
     if (to_keep.end() == find(to_keep.begin(), to_keep.end(), this)) {
+        // The child of a use may display a drawing shared with other uses, so hide the use instead.
+        if (auto use = cast<SPUse>(this); use && use->sharesDrawing(key)) {
+            invoke_hide(key);
+            return;
+        }
         // Only hide the item if it's not a group, root or use.
         if (!is<SPRoot>(this) &&
             !is<SPGroup>(this) &&
@@ -1352,6 +1358,60 @@ void SPItem::invoke_hide_except(unsigned key, const std::vector<SPItem const *>
     }
 }
 
+bool SPItem::isDrawingTransformInvariant() const
+{
+    if (getClipObject() || getMaskObject()) {
+        return false;
+    }
+
+    if (style) {
+        if (style->getFilter() ||
+            style->opacity.value != SP_SCALE24_MAX ||
+            style->mix_blend_mode.value != SP_CSS_BLEND_NORMAL ||
+            style->isolation.value == SP_CSS_ISOLATION_ISOLATE ||
+            style->vector_effect.stroke || style->vector_effect.size ||
+            style->vector_effect.rotate || style->vector_effect.fixed)
+        {
+            return false;
+        }
+        for (auto server : {style->getFillPaintServer(), style->getStrokePaintServer()}) {
+            if (is<SPPattern>(server) || is<SPHatch>(server)) {
+                return false;
+            }
+        }
+    }
+
+    // Markers are drawn as instances themselves.
+    if (auto shape = cast<SPShape>(this); shape && shape->hasMarkers()) {
+        return false;
+    }
+
+    for (auto &obj : children) {
+        auto child = cast<SPItem>(&obj);
+        if (child && !child->isDrawingTransformInvariant()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SPItem::usesContextPaint() const
+{
+    if (style && (style->fill.paintOrigin != SP_CSS_PAINT_ORIGIN_NORMAL ||
+                  style->stroke.paintOrigin != SP_CSS_PAINT_ORIGIN_NORMAL))
+    {
+        return true;
+    }
+
+    for (auto &obj : children) {
+        auto child = cast<SPItem>(&obj);
+        if (child && child->usesContextPaint()) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // Adjusters
 
 void SPItem::adjust_pattern(Geom::Affine const &postmul, bool set, PaintServerTransform pt)
@@ -334,6 +334,16 @@ public:
     void invoke_hide(unsigned int key);
     void invoke_hide_except(unsigned key, const std::vector<SPItem const *> &to_keep);
 
+    /**
+     * Whether the drawing of this item looks the same under any transform, so that a single
+     * drawing can be shown in several places, as for clones and markers. Anything drawn in
+     * display pixels, through an intermediate surface or a pattern tile, rules that out.
+     */
+    bool isDrawingTransformInvariant() const;
+
+    /// Whether this item or anything in it is painted with context-fill or context-stroke.
+    bool usesContextPaint() const;
+
     void getSnappoints(std::vector<Inkscape::SnapCandidatePoint> &p, Inkscape::SnapPreferences const *snapprefs=nullptr) const;
     void adjust_pattern(/* Geom::Affine const &premul, */ Geom::Affine const &postmul, bool set = false,
                         PaintServerTransform = TRANSFORM_BOTH);
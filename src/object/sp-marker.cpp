@@ -17,7 +17,9 @@
 
 #include "sp-marker.h"
 
+#include <algorithm>
 #include <cstring>
+#include <optional>
 
 #include <glib/gi18n.h>
 
@@ -30,6 +32,7 @@
 #include "preferences.h"
 #include "sp-defs.h"
 
+#include "display/drawing-clone.h"
 #include "display/drawing-group.h"
 #include "display/drawing-item-ptr.h"
 #include "object/object-set.h"
@@ -41,8 +44,46 @@
 using Inkscape::DocumentUndo;
 using Inkscape::ObjectSet;
 
+namespace {
+
+/// How the instances of a marker are drawn.
+enum class MarkerDrawingMode
+{
+    SEPARATE, ///< Every instance has a drawing of its own.
+    PER_VIEW, ///< The instances on one shape share a drawing, since they depend on the shape.
+    SHARED    ///< All instances in a drawing share one.
+};
+
+MarkerDrawingMode marker_drawing_mode(SPMarker const *marker)
+{
+    if (!marker->isDrawingTransformInvariant()) {
+        return MarkerDrawingMode::SEPARATE;
+    }
+    return marker->usesContextPaint() ? MarkerDrawingMode::PER_VIEW : MarkerDrawingMode::SHARED;
+}
+
+} // namespace
+
+/**
+ * A drawing of a marker, shown once and stamped at every marker position by a DrawingClone.
+ *
+ * A marker painted with context-fill or context-stroke has one per view, shown with the view's
+ * key, since the shape a view belongs to supplies the context. Otherwise all views in a drawing
+ * share one, shown with a key of its own.
+ */
+struct SPMarkerDrawing
+{
+    Inkscape::Drawing *drawing = nullptr;
+    bool shared = false;
+    unsigned users = 0; ///< Number of views stamping it.
+    DrawingItemPtr<Inkscape::DrawingCloneSource> source;
+    Inkscape::DrawingGroup *group = nullptr; ///< The marker's own drawing item, in source.
+};
+
 struct SPMarkerView
 {
+    MarkerDrawingMode mode = MarkerDrawingMode::SEPARATE;
+    std::optional<unsigned> drawing_key; ///< The SPMarkerDrawing stamped by the items, if any.
     std::vector<DrawingItemPtr<Inkscape::DrawingItem>> items;
 };
 
@@ -111,6 +152,11 @@ void SPMarker::release() {
     }
     views_map.clear();
 
+    for (auto &it : drawings_map) {
+        SPGroup::hide(it.first);
+    }
+    drawings_map.clear();
+
     SPGroup::release();
 }
 
@@ -218,12 +264,16 @@ void SPMarker::update(SPCtx *ctx, guint flags) {
     // As last step set additional transform of drawing group
     for (auto &it : views_map) {
         for (auto &item : it.second.items) {
-            if (item) {
-                auto g = cast<Inkscape::DrawingGroup>(item.get());
+            if (auto g = cast<Inkscape::DrawingGroup>(item.get())) {
                 g->setChildTransform(c2p);
             }
         }
     }
+    for (auto &it : drawings_map) {
+        if (auto g = it.second.group) {
+            g->setChildTransform(c2p);
+        }
+    }
 }
 
 Inkscape::XML::Node* SPMarker::write(Inkscape::XML::Document *xml_doc, Inkscape::XML::Node *repr, guint flags) {
@@ -406,6 +456,63 @@ void SPMarker::print(SPPrintContext* /*ctx*/) {
 
 /* fixme: Remove link if zero-sized (Lauris) */
 
+/**
+ * Gets the drawing stamped by the instances of a view, showing the marker if necessary.
+ */
+static Inkscape::DrawingCloneSource *
+sp_marker_acquire_drawing (SPMarker *marker, SPMarkerView &view, unsigned int key, Inkscape::Drawing &drawing)
+{
+    if (!view.drawing_key) {
+        if (view.mode == MarkerDrawingMode::SHARED) {
+            auto found = std::find_if(marker->drawings_map.begin(), marker->drawings_map.end(), [&] (auto const &it) {
+                return it.second.shared && it.second.drawing == &drawing;
+            });
+            view.drawing_key = found != marker->drawings_map.end() ? found->first : SPItem::display_key_new(1);
+        } else {
+            view.drawing_key = key;
+        }
+
+        auto &shown = marker->drawings_map[*view.drawing_key];
+        if (!shown.source) {
+            shown.drawing = &drawing;
+            shown.shared = view.mode == MarkerDrawingMode::SHARED;
+            shown.source = make_drawingitem<Inkscape::DrawingCloneSource>(drawing);
+            shown.source->setContextFromClones(!shown.shared);
+            shown.source->setCacheRasters(true);
+            if (auto item = marker->private_show(drawing, *view.drawing_key, SP_ITEM_REFERENCE_FLAGS)) {
+                shown.source->appendChild(item);
+                if ((shown.group = cast<Inkscape::DrawingGroup>(item))) {
+                    shown.group->setChildTransform(marker->c2p);
+                }
+            }
+        }
+        shown.users++;
+    }
+
+    return marker->drawings_map[*view.drawing_key].source.get();
+}
+
+/**
+ * Removes the instances of a view, and the drawing they stamp if nothing else does.
+ */
+static void
+sp_marker_hide_view (SPMarker *marker, unsigned int key, SPMarkerView &view)
+{
+    if (view.mode == MarkerDrawingMode::SEPARATE) {
+        marker->hide(key);
+    }
+    view.items.clear();
+
+    if (view.drawing_key) {
+        auto it = marker->drawings_map.find(*view.drawing_key);
+        if (--it->second.users == 0) {
+            marker->hide(it->first);
+            marker->drawings_map.erase(it);
+        }
+        view.drawing_key.reset();
+    }
+}
+
 /**
  * Removes any SPMarkerViews that a marker has with a specific key.
  * Set up the DrawingItem array's size in the specified SPMarker's SPMarkerView.
@@ -422,27 +529,23 @@ void SPMarker::print(SPPrintContext* /*ctx*/) {
 void
 sp_marker_show_dimension (SPMarker *marker, unsigned int key, unsigned int size)
 {
-    auto it = marker->views_map.find(key);
-    if (it != marker->views_map.end()) {
-        if (it->second.items.size() != size ) {
-            // Need to change size of vector! (We should not really need to do this.)
-            marker->hide(key);
-            it->second.items.clear();
-            for (unsigned int i = 0; i < size; ++i) {
-                it->second.items.push_back(nullptr);
-            }
-        }
-    } else {
-        marker->views_map[key] = SPMarkerView();
-        for (unsigned int i = 0; i < size; ++i) {
-            marker->views_map[key].items.push_back(nullptr);
-        }
+    auto const mode = marker_drawing_mode(marker);
+
+    auto &view = marker->views_map[key];
+    if (view.items.size() != size || view.mode != mode) {
+        // Need to change size of vector! (We should not really need to do this.)
+        sp_marker_hide_view(marker, key, view);
+        view.mode = mode;
+        view.items.resize(size);
     }
 }
 
 /**
  * Shows an instance of a marker.  This is called during sp_shape_update_marker_view()
  * show and transform a child item in the drawing for all views with the given key.
+ *
+ * Unless the marker needs a drawing of its own at each position (see SPItem::isDrawingTransformInvariant),
+ * the instance is a DrawingClone stamping a drawing shown once for all of them.
  */
 Inkscape::DrawingItem *
 sp_marker_show_instance ( SPMarker *marker, Inkscape::DrawingItem *parent,
@@ -470,16 +573,23 @@ sp_marker_show_instance ( SPMarker *marker, Inkscape::DrawingItem *parent,
 
     // If not already created
     if (!view->items[pos]) {
+        if (view->mode == MarkerDrawingMode::SEPARATE) {
+            /* Parent class ::show method */
+            view->items[pos].reset(marker->private_show(parent->drawing(), key, SP_ITEM_REFERENCE_FLAGS));
 
-        /* Parent class ::show method */
-        view->items[pos].reset(marker->private_show(parent->drawing(), key, SP_ITEM_REFERENCE_FLAGS));
+            if (auto g = cast<Inkscape::DrawingGroup>(view->items[pos].get())) {
+                g->setChildTransform(marker->c2p);
+            }
+        } else {
+            auto source = sp_marker_acquire_drawing(marker, *view, key, parent->drawing());
+            auto clone = new Inkscape::DrawingClone(parent->drawing());
+            clone->setSource(source);
+            view->items[pos].reset(clone);
+        }
 
         if (view->items[pos]) {
             /* fixme: Position (Lauris) */
             parent->prependChild(view->items[pos].get());
-            if (auto g = cast<Inkscape::DrawingGroup>(view->items[pos].get())) {
-                g->setChildTransform(marker->c2p);
-            }
         }
     }
 
@@ -500,8 +610,13 @@ sp_marker_show_instance ( SPMarker *marker, Inkscape::DrawingItem *parent,
 void
 sp_marker_hide (SPMarker *marker, unsigned int key)
 {
-    marker->hide(key);
-    marker->views_map.erase(key);
+    auto it = marker->views_map.find(key);
+    if (it == marker->views_map.end()) {
+        marker->hide(key);
+        return;
+    }
+    sp_marker_hide_view(marker, key, it->second);
+    marker->views_map.erase(it);
 }
 
 
@@ -19,6 +19,7 @@
  */
 
 class SPMarkerView;
+struct SPMarkerDrawing;
 
 #include <map>
 
@@ -71,6 +72,11 @@ public:
 	 */
 	std::map<unsigned int, SPMarkerView> views_map;
 
+	/* Drawings of the marker that instances are stamped from, indexed
+	 * by the key they are shown with. See SPMarkerDrawing.
+	 */
+	std::map<unsigned int, SPMarkerDrawing> drawings_map;
+
 	void build(SPDocument *document, Inkscape::XML::Node *repr) override;
 	void release() override;
 	void set(SPAttr key, gchar const* value) override;
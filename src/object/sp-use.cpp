@@ -14,9 +14,11 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
 #include <cstring>
 
 #include <2geom/transforms.h>
+#include <boost/container_hash/hash.hpp>
 #include <glibmm/i18n.h>
 #include <glibmm/markup.h>
 
@@ -41,6 +43,7 @@
 #include "style.h"
 #include "uri.h"
 
+#include "display/drawing-clone.h"
 #include "display/drawing-group.h"
 #include "xml/document.h"                            // for Document
 #include "xml/href-attribute-helper.h"               // for getHrefAttribute
@@ -51,6 +54,32 @@ class SnapCandidatePoint;
 class SnapPreferences;
 } // namespace Inkscape
 
+/**
+ * Drawing of the child shared by clones of the same original that display it the same way.
+ *
+ * The first user owns it: the shared subtree is the drawing of that user's child. When the owner
+ * goes, the next user shows its own child instead, which is a copy of the same original.
+ */
+struct SPUse::SharedDrawing
+{
+    struct User
+    {
+        SPUse *use;
+        unsigned key;
+        Inkscape::DrawingClone *clone;
+    };
+
+    Inkscape::Drawing *drawing;
+    SPItem const *original;
+    std::size_t context; ///< The _contextHash() of the first user.
+    unsigned flags;
+    DrawingItemPtr<Inkscape::DrawingCloneSource> source;
+    std::vector<User> users;
+};
+
+SPUseSharedDrawings::SPUseSharedDrawings() = default;
+SPUseSharedDrawings::~SPUseSharedDrawings() = default;
+
 SPUse::SPUse()
     : SPItem(),
       SPDimensions(),
@@ -98,6 +127,9 @@ void SPUse::build(SPDocument *document, Inkscape::XML::Node *repr) {
 
 void SPUse::release() {
     if (this->child) {
+        for (auto &v : views) {
+            _hideChild(v.key);
+        }
         this->detach(this->child);
         this->child = nullptr;
     }
@@ -308,7 +340,7 @@ Inkscape::DrawingItem* SPUse::show(Inkscape::Drawing &drawing, unsigned int key,
     ai->setStyle(this->style, this->context_style);
     
     if (this->child) {
-        Inkscape::DrawingItem *ac = this->child->invoke_show(drawing, key, flags);
+        Inkscape::DrawingItem *ac = _showChild(drawing, key, flags);
 
         if (ac) {
             ai->prependChild(ac);
@@ -323,12 +355,167 @@ Inkscape::DrawingItem* SPUse::show(Inkscape::Drawing &drawing, unsigned int key,
 
 void SPUse::hide(unsigned int key) {
     if (this->child) {
-        this->child->invoke_hide(key);
+        _hideChild(key);
     }
 
 //  SPItem::onHide(key);
 }
 
+/**
+ * Show the child for a view of this use, sharing the drawing of another clone if possible.
+ * @return The drawing item to insert in the view.
+ */
+Inkscape::DrawingItem *SPUse::_showChild(Inkscape::Drawing &drawing, unsigned key, unsigned flags)
+{
+    auto original = ref->getObject();
+    if (!original || !child->isDrawingTransformInvariant() || child->usesContextPaint()) {
+        return child->invoke_show(drawing, key, flags);
+    }
+
+    auto const context = _contextHash();
+    auto &candidates = document->getUseSharedDrawings()._drawings[{&drawing, original, context}];
+    auto shared = std::find_if(candidates.begin(), candidates.end(), [&, this] (SharedDrawing const &s) {
+        return s.flags == flags && _sameContext(*s.users.front().use);
+    });
+
+    if (shared == candidates.end()) {
+        candidates.push_back({&drawing, original, context, flags, make_drawingitem<Inkscape::DrawingCloneSource>(drawing), {}});
+        shared = std::prev(candidates.end());
+        shared->source->setCacheRasters(true);
+        if (auto master = child->invoke_show(drawing, key, flags)) {
+            shared->source->appendChild(master);
+        }
+    }
+
+    auto clone = new Inkscape::DrawingClone(drawing);
+    clone->setSource(shared->source.get());
+    shared->users.push_back({this, key, clone});
+    _shared[key] = &*shared;
+
+    return clone;
+}
+
+/// Undo _showChild() for a view of this use.
+void SPUse::_hideChild(unsigned key)
+{
+    auto found = _shared.find(key);
+    if (found == _shared.end()) {
+        child->invoke_hide(key);
+        return;
+    }
+
+    auto shared = found->second;
+    _shared.erase(found);
+
+    auto &users = shared->users;
+    auto user = std::find_if(users.begin(), users.end(), [&, this] (SharedDrawing::User const &u) {
+        return u.use == this && u.key == key;
+    });
+    bool const owner = user == users.begin();
+    user->clone->unlink();
+    users.erase(user);
+
+    if (owner) {
+        child->invoke_hide(key);
+        if (!users.empty()) {
+            auto const &next = users.front();
+            if (auto master = next.use->child->invoke_show(*shared->drawing, next.key, shared->flags)) {
+                shared->source->appendChild(master);
+            }
+        }
+    }
+
+    if (users.empty()) {
+        auto &drawings = document->getUseSharedDrawings()._drawings;
+        auto candidates = drawings.find({shared->drawing, shared->original, shared->context});
+        candidates->second.remove_if([=] (SharedDrawing const &s) { return &s == shared; });
+        if (candidates->second.empty()) {
+            drawings.erase(candidates);
+        }
+    }
+}
+
+/// Show the child for a view again, as the clone or what it inherits has changed.
+void SPUse::_reshowChild(unsigned key)
+{
+    auto view = std::find_if(views.begin(), views.end(), [=] (SPItemView const &v) { return v.key == key; });
+    if (view == views.end()) {
+        return;
+    }
+
+    auto g = cast<Inkscape::DrawingGroup>(view->drawingitem.get());
+    _hideChild(key);
+    if (auto ai = _showChild(g->drawing(), key, view->flags)) {
+        g->prependChild(ai);
+    }
+}
+
+/**
+ * Whether the child of this use is displayed the same as the child of another use of the same
+ * original, which is the case if they inherit the same style and have the same viewport.
+ */
+bool SPUse::_sameContext(SPUse const &other) const
+{
+    if (width.computed != other.width.computed || height.computed != other.height.computed) {
+        return false;
+    }
+
+    auto const props = style->properties();
+    auto const other_props = other.style->properties();
+    for (std::size_t i = 0; i < props.size(); i++) {
+        if (props[i]->inherits && *props[i] != *other_props[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Hash of the properties compared by _sameContext() that usually tell contexts apart, so that
+ * a shared drawing is found without comparing the whole style with that of every other one.
+ */
+std::size_t SPUse::_contextHash() const
+{
+    std::size_t seed = 0;
+    boost::hash_combine(seed, width.computed);
+    boost::hash_combine(seed, height.computed);
+    boost::hash_combine(seed, style->fill.get_value().raw());
+    boost::hash_combine(seed, style->stroke.get_value().raw());
+    boost::hash_combine(seed, style->stroke_width.computed);
+    boost::hash_combine(seed, style->fill_opacity.value);
+    boost::hash_combine(seed, style->stroke_opacity.value);
+    boost::hash_combine(seed, style->font_size.computed);
+    boost::hash_combine(seed, style->color.get_value().raw());
+    return seed;
+}
+
+/// Leave or join shared drawings after a change to the child or to what it inherits.
+void SPUse::_recheckShared()
+{
+    bool const shareable = ref->getObject() && child->isDrawingTransformInvariant() && !child->usesContextPaint();
+
+    std::vector<unsigned> keys;
+    for (auto &v : views) {
+        if (auto found = _shared.find(v.key); found != _shared.end()) {
+            auto const &users = found->second->users;
+            auto other = users.front().use;
+            if (other == this && users.size() > 1) {
+                other = users[1].use;
+            }
+            if (shareable && _sameContext(*other)) {
+                continue;
+            }
+        } else if (!shareable) {
+            continue;
+        }
+        keys.push_back(v.key);
+    }
+
+    for (auto key : keys) {
+        _reshowChild(key);
+    }
+}
+
 
 /**
  * Returns the ultimate original of a SPUse (i.e. the first object in the chain of its originals
@@ -596,6 +783,9 @@ void SPUse::href_changed() {
     this->_transformed_connection.disconnect();
 
     if (this->child) {
+        for (auto &v : views) {
+            _hideChild(v.key);
+        }
         this->detach(this->child);
         this->child = nullptr;
     }
@@ -618,7 +808,7 @@ void SPUse::href_changed() {
                 this->child->invoke_build(refobj->document, childrepr, TRUE);
 
                 for (auto &v : views) {
-                    auto ai = this->child->invoke_show(v.drawingitem->drawing(), v.key, v.flags);
+                    auto ai = _showChild(v.drawingitem->drawing(), v.key, v.flags);
                     if (ai) {
                         v.drawingitem->prependChild(ai);
                     }
@@ -673,10 +863,13 @@ void SPUse::update(SPCtx *ctx, unsigned flags) {
 
     childflags &= ~SP_OBJECT_USER_MODIFIED_FLAG_B;
 
+    bool child_modified = false;
+
     if (this->child) {
         sp_object_ref(this->child);
 
-        if (childflags || (this->child->uflags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_CHILD_MODIFIED_FLAG))) {
+        child_modified = this->child->uflags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_CHILD_MODIFIED_FLAG);
+        if (childflags || child_modified) {
             g_assert(child);
             cctx.i2doc = child->transform * ictx->i2doc;
             cctx.i2vp = child->transform * ictx->i2vp;
@@ -696,6 +889,10 @@ void SPUse::update(SPCtx *ctx, unsigned flags) {
         }
     }
 
+    if (child && (child_modified || (flags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_STYLE_MODIFIED_FLAG)))) {
+        _recheckShared();
+    }
+
     /* As last step set additional transform of arena group */
     for (auto &v : views) {
         auto g = cast<Inkscape::DrawingGroup>(v.drawingitem.get());
@@ -17,6 +17,11 @@
  */
 
 
+#include <list>
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
 #include "sp-dimensions.h"
 #include "sp-item.h"
 
@@ -76,10 +81,48 @@ public:
     bool anyInChain(bool (*predicate)(SPItem const *)) const;
 
     void getLinked(std::vector<SPObject *> &objects, LinkedObjectNature direction = LinkedObjectNature::ANY) const override;
+
+    /// Whether the view for this key displays a drawing shared with other clones of the original.
+    bool sharesDrawing(unsigned key) const { return _shared.count(key); }
+
 private:
+    struct SharedDrawing;
+
+    // The child's drawing is shared between clones of the same original wherever possible,
+    // so every view goes through these instead of the child's invoke_show()/invoke_hide().
+    Inkscape::DrawingItem *_showChild(Inkscape::Drawing &drawing, unsigned key, unsigned flags);
+    void _hideChild(unsigned key);
+    void _reshowChild(unsigned key);
+    bool _sameContext(SPUse const &other) const;
+    std::size_t _contextHash() const;
+    void _recheckShared();
+
+    std::unordered_map<unsigned, SharedDrawing *> _shared; ///< Keyed by view key.
+
     void href_changed();
     void move_compensate(Geom::Affine const *mp);
     void delete_self();
+
+    friend class SPUseSharedDrawings;
+};
+
+/**
+ * The drawings shared between clones of the same original in one document, which the document
+ * keeps for its clones.
+ */
+class SPUseSharedDrawings
+{
+public:
+    SPUseSharedDrawings();
+    ~SPUseSharedDrawings();
+    SPUseSharedDrawings(SPUseSharedDrawings const &) = delete;
+    SPUseSharedDrawings &operator=(SPUseSharedDrawings const &) = delete;
+
+private:
+    /// By drawing, original and hash of the context.
+    std::map<std::tuple<Inkscape::Drawing const *, SPItem const *, std::size_t>, std::list<SPUse::SharedDrawing>> _drawings;
+
+    friend class SPUse;
 };
 
 #endif
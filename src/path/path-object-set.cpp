@@ -12,7 +12,16 @@
  *
  */
 
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 #include <glibmm/i18n.h>
+#include <glibmm/main.h>
+#include <gtkmm/messagedialog.h>
+#include <gtkmm/progressbar.h>
 
 #include "attribute-rel-util.h"
 #include "desktop.h"
@@ -21,13 +30,205 @@
 #include "message-stack.h"
 #include "preferences.h"
 
+#include "async/async.h"
+#include "async/background-progress.h"
+#include "async/channel.h"
+#include "async/progress.h"
+#include "helper/auto-connection.h"
 #include "object/object-set.h"
+#include "object/weakptr.h"
 #include "path/path-outline.h"
 #include "path/path-simplify.h"
 #include "ui/icon-names.h"
+#include "util/parallel.h"
 
 using Inkscape::ObjectSet;
 
+namespace {
+
+/**
+ * Record a simplification for undo and tell the user how it went.
+ */
+void simplify_done(SPDocument *document, SPDesktop *desktop, int pathsSimplified, bool skip_undo)
+{
+    if (pathsSimplified > 0 && !skip_undo) {
+        Inkscape::DocumentUndo::done(document, _("Simplify"), INKSCAPE_ICON("path-simplify"));
+    }
+
+    if (desktop) {
+        desktop->clearWaitingCursor();
+        if (pathsSimplified > 0) {
+            desktop->messageStack()->flashF(Inkscape::NORMAL_MESSAGE, _("<b>%d</b> paths simplified."), pathsSimplified);
+        } else {
+            desktop->messageStack()->flash(Inkscape::ERROR_MESSAGE, _("<b>No paths</b> to simplify in the selection."));
+        }
+    }
+}
+
+/**
+ * Simplifies paths on a background thread and writes them back from the main loop once done, like
+ * tracing. Once the work has taken a while, a dialog shows its progress and lets the user cancel it.
+ *
+ * A desktop runs at most one task at a time. A request made while one is running is run once the
+ * paths have been written, on the simplified paths, just as it would have been had the first one
+ * finished immediately. Of several such requests only the last is kept, since repeated requests
+ * only raise the threshold.
+ *
+ * The task deletes itself once finished or cancelled, or when its desktop goes away.
+ */
+class SimplifyTask
+{
+public:
+    static void launch(SPDesktop *desktop, std::vector<SPItem *> const &items, float threshold, bool justCoalesce,
+                       double size);
+
+private:
+    struct Request
+    {
+        std::vector<Inkscape::SPWeakPtr<SPItem>> items;
+        float threshold;
+        bool justCoalesce;
+        double size;
+    };
+
+    SimplifyTask(SPDesktop *desktop, std::unique_ptr<PathSimplifyBatch> batch);
+
+    static constexpr auto DIALOG_DELAY = std::chrono::milliseconds(500);
+
+    /// The task running for each desktop.
+    static std::unordered_map<SPDesktop *, SimplifyTask *> &_running();
+
+    void _progress(double progress);
+    void _finished();
+    void _cancel();
+    void _createDialog();
+
+    SPDesktop *_desktop;
+    SPDocument *_document;
+    std::unique_ptr<PathSimplifyBatch> _batch;
+    std::optional<Request> _next;
+    Inkscape::Async::Channel::Dest _channel;
+    std::chrono::steady_clock::time_point _start;
+    std::unique_ptr<Gtk::MessageDialog> _dialog;
+    Gtk::ProgressBar *_bar = nullptr;
+    Inkscape::auto_connection _desktop_destroyed;
+};
+
+SimplifyTask::SimplifyTask(SPDesktop *desktop, std::unique_ptr<PathSimplifyBatch> batch)
+    : _desktop{desktop}
+    , _document{desktop->getDocument()}
+    , _batch{std::move(batch)}
+    , _start{std::chrono::steady_clock::now()}
+{
+    _desktop_destroyed = desktop->connectDestroy([this] (SPDesktop *) { _cancel(); });
+    _running()[desktop] = this;
+}
+
+std::unordered_map<SPDesktop *, SimplifyTask *> &SimplifyTask::_running()
+{
+    static std::unordered_map<SPDesktop *, SimplifyTask *> running;
+    return running;
+}
+
+void SimplifyTask::launch(SPDesktop *desktop, std::vector<SPItem *> const &items, float threshold, bool justCoalesce,
+                          double size)
+{
+    if (auto it = _running().find(desktop); it != _running().end()) {
+        it->second->_next = Request{{items.begin(), items.end()}, threshold, justCoalesce, size};
+        return;
+    }
+
+    auto task = new SimplifyTask(desktop, std::make_unique<PathSimplifyBatch>(items, threshold, justCoalesce, size));
+    auto [src, dst] = Inkscape::Async::Channel::create();
+    task->_channel = std::move(dst);
+
+    // The worker only holds on to the simplification, which touches no document. The task itself
+    // is only used by functions run over the channel, which it closes before going away.
+    Inkscape::Async::fire_and_forget([task, work = task->_batch->work(), nthreads = Inkscape::Util::get_num_threads(),
+                                      channel = std::move(src)] () mutable {
+        auto onprogress = std::function<void(double)>([task] (double progress) { task->_progress(progress); });
+        auto progress = Inkscape::Async::BackgroundProgress(channel, onprogress);
+        auto throttled = Inkscape::Async::ProgressTimeThrottler(progress, std::chrono::milliseconds(50));
+        if (work->run(throttled, nthreads)) {
+            channel.run([task] { task->_finished(); });
+        }
+    });
+}
+
+void SimplifyTask::_progress(double progress)
+{
+    if (!_dialog && std::chrono::steady_clock::now() - _start > DIALOG_DELAY) {
+        _createDialog();
+    }
+    if (_bar) {
+        _bar->set_fraction(progress);
+    }
+}
+
+void SimplifyTask::_finished()
+{
+    auto const desktop = _desktop;
+    auto const next = std::move(_next);
+
+    // The paths are only written if the desktop still shows the document they were read from.
+    bool const same_document = desktop->getDocument() == _document;
+    if (same_document) {
+        simplify_done(_document, desktop, _batch->write(), false);
+    } else {
+        desktop->clearWaitingCursor();
+    }
+    _cancel();
+
+    if (next && same_document) {
+        std::vector<SPItem *> items;
+        for (auto const &item : next->items) {
+            if (item) {
+                items.push_back(item.get());
+            }
+        }
+        if (!items.empty()) {
+            desktop->setWaitingCursor();
+            launch(desktop, items, next->threshold, next->justCoalesce, next->size);
+        }
+    }
+}
+
+void SimplifyTask::_cancel()
+{
+    if (!_channel) {
+        return;
+    }
+    _channel.close();
+    _next.reset();
+    _running().erase(_desktop);
+    _desktop_destroyed.disconnect();
+    if (_dialog) {
+        _dialog->set_visible(false);
+    }
+    // This may be called from a handler of the dialog, so it is deleted once that has returned.
+    Glib::signal_idle().connect_once([this] { delete this; });
+}
+
+void SimplifyTask::_createDialog()
+{
+    auto window = _desktop->getToplevel();
+    if (!window) {
+        return;
+    }
+    _dialog = std::make_unique<Gtk::MessageDialog>(*window, _("Simplifying paths..."), false, Gtk::MessageType::INFO,
+                                                   Gtk::ButtonsType::CANCEL, true);
+    _bar = Gtk::make_managed<Gtk::ProgressBar>();
+    _dialog->get_message_area()->append(*_bar);
+    _dialog->signal_response().connect([this] (int) {
+        _desktop->clearWaitingCursor();
+        _desktop->messageStack()->flash(Inkscape::NORMAL_MESSAGE, _("Simplification cancelled."));
+        _cancel();
+    });
+    _dialog->set_visible(true);
+}
+
+} // namespace
+
 bool
 ObjectSet::strokesToPaths(bool legacy, bool skip_undo)
 {
@@ -50,10 +251,14 @@ ObjectSet::strokesToPaths(bool legacy, bool skip_undo)
 
   std::vector<SPItem *> my_items(items().begin(), items().end());
 
+  // The outlines are independent of each other, so compute them all up front on worker
+  // threads. The document is then changed in one pass and the selection updated once.
+  auto const outlines = item_find_paths_parallel(my_items, legacy);
+
   for (auto item : my_items) {
     // Do not remove the object from the selection here 
     // as we want to keep it selected if the whole operation fails
-    Inkscape::XML::Node *new_node = item_to_paths(item, legacy);
+    Inkscape::XML::Node *new_node = item_to_paths(item, legacy, nullptr, &outlines);
     if (new_node) {
       SPObject* new_item = document()->getObjectByRepr(new_node);
 
@@ -67,10 +272,13 @@ ObjectSet::strokesToPaths(bool legacy, bool skip_undo)
       // unneeded properties from the style element.
       sp_attribute_clean_recursive(new_node, SP_ATTRCLEAN_STYLE_REMOVE | SP_ATTRCLEAN_DEFAULT_REMOVE);
 
-      add(new_item); // Add to selection.
+      add(new_item, true); // Add to selection.
       did = true;
     }
   }
+  if (did) {
+    _emitChanged();
+  }
 
   // Reset
   prefs->setBool("/options/transform/stroke", scale_stroke);
@@ -134,24 +342,21 @@ ObjectSet::simplifyPaths(bool skip_undo)
     }
     double size = L2(selectionBbox->dimensions());
 
-    int pathsSimplified = 0;
     std::vector<SPItem *> my_items(items().begin(), items().end());
-    for (auto item : my_items) {
-        pathsSimplified += path_simplify(item, threshold, justCoalesce, size);
-    }
 
-    if (pathsSimplified > 0 && !skip_undo) {
-        DocumentUndo::done(document(), _("Simplify"), INKSCAPE_ICON("path-simplify"));
+    // On a desktop, the paths are simplified in the background, so that the user can follow the
+    // progress and cancel without the main loop being run from here. Nothing has been changed yet
+    // when this returns; the outcome is reported on the desktop once the paths are written.
+    // Otherwise, or if the caller records the undo step itself, the simplification is done before
+    // returning.
+    if (desktop() && !skip_undo) {
+        SimplifyTask::launch(desktop(), my_items, threshold, justCoalesce, size);
+        return false;
     }
 
-    if (desktop()) {
-        desktop()->clearWaitingCursor();
-        if (pathsSimplified > 0) {
-            desktop()->messageStack()->flashF(Inkscape::NORMAL_MESSAGE, _("<b>%d</b> paths simplified."), pathsSimplified);
-        } else {
-            desktop()->messageStack()->flash(Inkscape::ERROR_MESSAGE, _("<b>No paths</b> to simplify in the selection."));
-        }
-    }
+    auto progress = Inkscape::Async::ProgressAlways<double>();
+    int pathsSimplified = path_simplify(my_items, threshold, justCoalesce, size, progress);
+    simplify_done(document(), desktop(), pathsSimplified, skip_undo);
 
     return (pathsSimplified > 0);
 }
@@ -41,9 +41,12 @@
 #include "object/sp-shape.h"
 #include "object/sp-text.h"
 #include "object/sp-flowtext.h"
+#include "object/sp-lpe-item.h"
 
 #include "svg/svg.h"
 
+#include "util/parallel.h"
+
 /**
  * Given an item, find a path representing the fill and a path representing the stroke.
  * Returns true if fill path found. Item may not have a stroke in which case stroke path is empty.
@@ -179,6 +182,74 @@ item_find_paths(const SPItem *item, Geom::PathVector& fill, Geom::PathVector& st
     return true;
 }
 
+/**
+ * Collect the shapes item_to_paths() would outline as they are now. Items that it first
+ * converts (path effects, text, 3D boxes) are skipped, as their geometry is not final yet.
+ */
+static void collect_outline_shapes(SPItem *item, bool legacy, std::vector<SPItem *> &shapes)
+{
+    if (auto lpeitem = cast<SPLPEItem>(item); lpeitem && lpeitem->hasPathEffect()) {
+        return;
+    }
+    if (is<SPText>(item) || is<SPFlowtext>(item) || is<SPBox3D>(item)) {
+        return;
+    }
+    if (auto group = cast<SPGroup>(item)) {
+        // In legacy mode groups are left alone.
+        if (legacy) {
+            return;
+        }
+        for (auto subitem : group->item_list()) {
+            collect_outline_shapes(subitem, legacy, shapes);
+        }
+    } else if (is<SPShape>(item)) {
+        shapes.push_back(item);
+    }
+}
+
+ItemPathsCache item_find_paths_parallel(std::vector<SPItem *> const &items, bool legacy)
+{
+    std::vector<SPItem *> shapes;
+    for (auto item : items) {
+        collect_outline_shapes(item, legacy, shapes);
+    }
+
+    // item_find_paths() only reads the item, and livarot keeps no shared state,
+    // so the shapes can be outlined independently.
+    std::vector<ItemPaths> results(shapes.size());
+    Inkscape::Util::parallel_for(shapes.size(), Inkscape::Util::get_num_threads(), [&] (std::size_t i) {
+        results[i].found = item_find_paths(shapes[i], results[i].fill, results[i].stroke);
+    });
+
+    ItemPathsCache cache;
+    cache._paths.reserve(shapes.size());
+    for (std::size_t i = 0; i < shapes.size(); i++) {
+        if (cache._paths.emplace(shapes[i], std::move(results[i])).second) {
+            sp_object_ref(shapes[i]);
+        }
+    }
+    return cache;
+}
+
+ItemPathsCache::ItemPathsCache(ItemPathsCache &&other) noexcept
+    : _paths(std::move(other._paths))
+{
+    other._paths.clear();
+}
+
+ItemPathsCache::~ItemPathsCache()
+{
+    for (auto &[item, paths] : _paths) {
+        sp_object_unref(item);
+    }
+}
+
+ItemPaths const *ItemPathsCache::find(SPItem const *item) const
+{
+    auto it = _paths.find(const_cast<SPItem *>(item));
+    return it != _paths.end() ? &it->second : nullptr;
+}
+
 
 // ======================== Item to Outline ===================== //
 
@@ -382,7 +453,7 @@ void item_to_paths_add_marker( SPItem *context,
  * The return value is used externally to update a selection. It is nullptr if no change is made.
  */
 Inkscape::XML::Node*
-item_to_paths(SPItem *item, bool legacy, SPItem *context)
+item_to_paths(SPItem *item, bool legacy, SPItem *context, ItemPathsCache const *cache)
 {
     char const *id = item->getAttribute("id");
     SPDocument *doc = item->document;
@@ -429,7 +500,7 @@ item_to_paths(SPItem *item, bool legacy, SPItem *context)
         std::vector<SPItem*> const item_list = group->item_list();
         bool did = false;
         for (auto subitem : item_list) {
-            if (item_to_paths(subitem, legacy)) {
+            if (item_to_paths(subitem, legacy, nullptr, cache)) {
                 did = true;
             }
         }
@@ -448,7 +519,14 @@ item_to_paths(SPItem *item, bool legacy, SPItem *context)
 
     Geom::PathVector fill_path;
     Geom::PathVector stroke_path;
-    bool status = item_find_paths(item, fill_path, stroke_path);
+    bool status;
+    if (auto cached = cache ? cache->find(item) : nullptr) {
+        fill_path = cached->fill;
+        stroke_path = cached->stroke;
+        status = cached->found;
+    } else {
+        status = item_find_paths(item, fill_path, stroke_path);
+    }
 
     if (!status) {
         // Was not a well structured shape (or text).
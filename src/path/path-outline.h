@@ -16,13 +16,13 @@
 #ifndef SEEN_PATH_OUTLINE_H
 #define SEEN_PATH_OUTLINE_H
 
+#include <unordered_map>
+#include <vector>
+#include <2geom/pathvector.h>
+
 class SPDesktop;
 class SPItem;
 
-namespace Geom {
-  class PathVector;
-}
-
 namespace Inkscape {
 namespace XML {
   class Node;
@@ -34,6 +34,44 @@ namespace XML {
  */
 bool item_find_paths(const SPItem *item, Geom::PathVector& fill, Geom::PathVector& stroke, bool bbox_only = false);
 
+/**
+ * Result of item_find_paths() for one item.
+ */
+struct ItemPaths
+{
+    Geom::PathVector fill;
+    Geom::PathVector stroke;
+    bool found = false;
+};
+
+/**
+ * Outlines computed ahead of item_to_paths() for several items.
+ * Holds a reference on every item, so that the address of an item deleted by the conversion
+ * cannot be taken by a new object while the cache is alive.
+ */
+class ItemPathsCache
+{
+public:
+    ItemPathsCache() = default;
+    ItemPathsCache(ItemPathsCache &&other) noexcept;
+    ItemPathsCache(ItemPathsCache const &) = delete;
+    ItemPathsCache &operator=(ItemPathsCache const &) = delete;
+    ~ItemPathsCache();
+
+    ItemPaths const *find(SPItem const *item) const;
+
+private:
+    std::unordered_map<SPItem *, ItemPaths> _paths;
+
+    friend ItemPathsCache item_find_paths_parallel(std::vector<SPItem *> const &items, bool legacy);
+};
+
+/**
+ * Run item_find_paths() on worker threads for all shapes among and inside the given items
+ * that item_to_paths() would outline unchanged. The document must not be modified meanwhile.
+ */
+ItemPathsCache item_find_paths_parallel(std::vector<SPItem *> const &items, bool legacy = false);
+
 /**
  * Find an outline that represents an item.
  */
@@ -41,8 +79,10 @@ Geom::PathVector* item_to_outline (SPItem const *item, bool exclude_markers = fa
 
 /**
  * Replace item by path objects (a.k.a. stroke to path).
+ * Fill and stroke found in the optional cache are used instead of being recomputed.
  */
-Inkscape::XML::Node* item_to_paths(SPItem *item, bool legacy = false, SPItem *context = nullptr);
+Inkscape::XML::Node* item_to_paths(SPItem *item, bool legacy = false, SPItem *context = nullptr,
+                                   ItemPathsCache const *cache = nullptr);
 
 /**
  * Replace selected items by path objects (a.k.a. stroke to >path).
@@ -14,6 +14,9 @@
 #ifdef HAVE_CONFIG_H
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <vector>
 
 #include "path-simplify.h"
@@ -22,33 +25,44 @@
 #include "document-undo.h"
 #include "preferences.h"
 
+#include "async/progress.h"
 #include "livarot/Path.h"
 
 #include "object/sp-item-group.h"
 #include "object/sp-path.h"
 
+#include "util/parallel.h"
+
 using Inkscape::DocumentUndo;
 
-// Return number of paths simplified (can be greater than one if group).
-int
-path_simplify(SPItem *item, float threshold, bool justCoalesce, double size)
+namespace {
+
+void collect_paths(SPItem *item, std::vector<SPItem *> &paths)
 {
     //If this is a group, do the children instead
-    auto group = cast<SPGroup>(item);
-    if (group) {
-        int pathsSimplified = 0;
-        std::vector<SPItem*> items = group->item_list();
-        for (auto item : items) {
-            pathsSimplified += path_simplify(item, threshold, justCoalesce, size);
+    if (auto group = cast<SPGroup>(item)) {
+        for (auto child : group->item_list()) {
+            collect_paths(child, paths);
         }
-        return pathsSimplified;
+    } else if (is<SPPath>(item)) {
+        paths.push_back(item);
     }
+}
 
-    auto path = cast<SPPath>(item);
-    if (!path) {
-        return 0;
-    }
+bool has_path_effect(SPItem *item)
+{
+    return item->getRepr()->attribute("inkscape:path-effect");
+}
 
+/// Whether resetting the transform of a path may change its path before effects, or other paths.
+bool in_path_effect(SPItem *item)
+{
+    return cast<SPPath>(item)->hasPathEffectRecursive();
+}
+
+/// The size that the simplification threshold is relative to, for one path.
+double path_size(SPItem *item, double size)
+{
     // There is actually no option in the preferences dialog for this!
     Inkscape::Preferences *prefs = Inkscape::Preferences::get();
     bool simplifyIndividualPaths = prefs->getBool("/options/simplifyindividualpaths/value");
@@ -62,40 +76,38 @@ path_simplify(SPItem *item, float threshold, bool justCoalesce, double size)
     }
 
     // Correct virtual size by full transform (bug #166937).
-    size /= item->i2doc_affine().descrim();
-
-    // Save the transform, to re-apply it after simplification.
-    Geom::Affine const transform(item->transform);
-
-    /*
-       reset the transform, effectively transforming the item by transform.inverse();
-       this is necessary so that the item is transformed twice back and forth,
-       allowing all compensations to cancel out regardless of the preferences
-    */
-    item->doWriteTransform(Geom::identity());
-
-    // SPLivarot: Start  -----------------
-
-    // Get path to simplify (note that the path *before* LPE calculation is needed)
-    auto orig = Path_for_item_before_LPE(item, false);
-    if (!orig) {
-        return 0;
-    }
+    return size / item->i2doc_affine().descrim();
+}
 
+void simplify(Path &path, float threshold, bool justCoalesce, double size)
+{
     if ( justCoalesce ) {
-        orig->Coalesce(threshold * size);
+        path.Coalesce(threshold * size);
     } else {
-        orig->ConvertEvenLines(threshold * size);
-        orig->Simplify(threshold * size);
+        path.ConvertEvenLines(threshold * size);
+        path.Simplify(threshold * size);
     }
+}
 
-    // Path
-    auto str = orig->svg_dump_path();
+/**
+ * Reset the transform of an item, effectively transforming it by transform.inverse();
+ * this is necessary so that the item is transformed twice back and forth,
+ * allowing all compensations to cancel out regardless of the preferences.
+ *
+ * @return The transform to re-apply after simplification.
+ */
+Geom::Affine reset_transform(SPItem *item)
+{
+    Geom::Affine const transform(item->transform);
+    item->doWriteTransform(Geom::identity());
+    return transform;
+}
 
-    // SPLivarot: End  -------------------
+void write_path(SPItem *item, Path const &path, Geom::Affine const &transform)
+{
+    auto str = path.svg_dump_path();
 
-    char const *patheffect = item->getRepr()->attribute("inkscape:path-effect");
-    if (patheffect) {
+    if (has_path_effect(item)) {
         item->setAttribute("inkscape:original-d", str.c_str());
     } else {
         item->setAttribute("d", str.c_str());
@@ -106,10 +118,133 @@ path_simplify(SPItem *item, float threshold, bool justCoalesce, double size)
 
     // remove irrelevant old nodetypes attibute
     item->removeAttribute("sodipodi:nodetypes");
+}
+
+/**
+ * Simplify a path with path effects on itself or its ancestors. Resetting its transform updates
+ * the effects, so that is done before reading the path.
+ */
+int simplify_item(SPItem *item, float threshold, bool justCoalesce, double size)
+{
+    size = path_size(item, size);
+    auto const transform = reset_transform(item);
+
+    // Get path to simplify (note that the path *before* LPE calculation is needed)
+    auto orig = Path_for_item_before_LPE(item, false);
+    if (!orig) {
+        return 0;
+    }
 
+    simplify(*orig, threshold, justCoalesce, size);
+    write_path(item, *orig, transform);
     return 1;
 }
 
+} // namespace
+
+// Return number of paths simplified (can be greater than one if group).
+int
+path_simplify(SPItem *item, float threshold, bool justCoalesce, double size)
+{
+    auto progress = Inkscape::Async::ProgressAlways<double>();
+    return path_simplify({item}, threshold, justCoalesce, size, progress);
+}
+
+int path_simplify(std::vector<SPItem *> const &items, float threshold, bool justCoalesce, double size,
+                  Inkscape::Async::Progress<double> &progress)
+{
+    PathSimplifyBatch batch(items, threshold, justCoalesce, size);
+    if (!batch.work()->run(progress, Inkscape::Util::get_num_threads())) {
+        return 0;
+    }
+    return batch.write();
+}
+
+PathSimplifyBatch::PathSimplifyBatch(std::vector<SPItem *> const &items, float threshold, bool justCoalesce,
+                                     double size)
+    : _work{std::make_shared<Work>()}
+    , _threshold{threshold}
+    , _justCoalesce{justCoalesce}
+    , _size{size}
+{
+    std::vector<SPItem *> paths;
+    for (auto item : items) {
+        collect_paths(item, paths);
+    }
+
+    // Paths without path effects are independent of each other and do not change when their
+    // transform is reset, so they are all read up front. Paths with path effects are left for
+    // the write pass, as resetting their transform updates the effects.
+    _work->_threshold = threshold;
+    _work->_justCoalesce = justCoalesce;
+    _work->_jobs.resize(paths.size());
+    _items.reserve(paths.size());
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        auto &item = _items.emplace_back();
+        item.item.reset(paths[i]);
+        if (in_path_effect(paths[i])) {
+            item.in_path_effect = true;
+        } else {
+            if (auto d = paths[i]->getAttribute("d")) {
+                item.d = d;
+            }
+            _work->_jobs[i] = {path_size(paths[i], size), Path_for_item_before_LPE(paths[i], false)};
+        }
+    }
+}
+
+PathSimplifyBatch::~PathSimplifyBatch() = default;
+
+PathSimplifyBatch::Work::~Work() = default;
+
+bool PathSimplifyBatch::Work::run(Inkscape::Async::Progress<double> &progress, int nthreads)
+{
+    // Livarot keeps no shared state, so the paths can be simplified on worker threads, while this
+    // thread reports progress. Workers skip the remaining paths once this thread sees a
+    // cancellation.
+    std::atomic<std::size_t> finished = 0;
+    std::atomic<bool> cancelled = false;
+    Inkscape::Util::parallel_for(_jobs.size(), nthreads, [&] (std::size_t i) {
+        if (!cancelled && _jobs[i].path) {
+            simplify(*_jobs[i].path, _threshold, _justCoalesce, _jobs[i].size);
+        }
+        finished++;
+    }, [&] {
+        if (!progress.report(static_cast<double>(finished) / _jobs.size())) {
+            cancelled = true;
+        }
+    }, std::chrono::milliseconds(20));
+
+    return !cancelled && progress.keepgoing();
+}
+
+int PathSimplifyBatch::write()
+{
+    // Write back in order, without reporting, so that nothing can observe a partly written result.
+    int pathsSimplified = 0;
+    for (std::size_t i = 0; i < _items.size(); i++) {
+        auto const item = _items[i].item.get();
+        if (!item) {
+            continue;
+        }
+        if (_items[i].in_path_effect) {
+            pathsSimplified += simplify_item(item, _threshold, _justCoalesce, _size);
+        } else if (auto const &path = _work->_jobs[i].path) {
+            auto const d = item->getAttribute("d");
+            if (_items[i].d != (d ? d : "")) {
+                continue;
+            }
+            // Without path effects, resetting the transform before writing the path and applying
+            // it again afterwards cancels out, so the transform is only written once.
+            Geom::Affine const transform = item->transform;
+            write_path(item, *path, transform);
+            pathsSimplified++;
+        }
+    }
+
+    return pathsSimplified;
+}
+
 /*
   Local Variables:
   mode:c++
@@ -10,10 +10,102 @@
 #ifndef PATH_SIMPLIFY_H
 #define PATH_SIMPLIFY_H
 
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "object/weakptr.h"
+
+class Path;
 class SPItem;
 
+namespace Inkscape::Async {
+template <typename... T>
+class Progress;
+} // namespace Inkscape::Async
+
+/**
+ * Simplification of the paths among some items and their descendants, split into steps so that
+ * the work can run on a background thread. Constructing the batch reads the paths and write()
+ * writes them back; both happen on the main thread. The simplification in between touches no
+ * document and is kept alive by whoever runs it, so the batch may go away in the meantime.
+ */
+class PathSimplifyBatch
+{
+public:
+    class Work
+    {
+    public:
+        ~Work();
+
+        /**
+         * Simplify the paths on several threads. May be called once, on any thread.
+         *
+         * @param progress Receives the fraction of paths done, on the calling thread.
+         * @return Whether all paths were simplified, i.e. the progress was not cancelled.
+         */
+        bool run(Inkscape::Async::Progress<double> &progress, int nthreads);
+
+    private:
+        struct Job
+        {
+            double size = 0;
+            std::unique_ptr<Path> path;
+        };
+
+        std::vector<Job> _jobs;
+        float _threshold = 0;
+        bool _justCoalesce = false;
+
+        friend class PathSimplifyBatch;
+    };
+
+    PathSimplifyBatch(std::vector<SPItem *> const &items, float threshold, bool justCoalesce, double size);
+    PathSimplifyBatch(PathSimplifyBatch const &) = delete;
+    PathSimplifyBatch &operator=(PathSimplifyBatch const &) = delete;
+    ~PathSimplifyBatch();
+
+    std::shared_ptr<Work> const &work() const { return _work; }
+
+    /**
+     * Write the simplified paths back to the document, once work() has run without being
+     * cancelled. Paths deleted or changed since they were read are left alone.
+     *
+     * @return The number of paths simplified.
+     */
+    int write();
+
+private:
+    struct Item
+    {
+        Inkscape::SPWeakPtr<SPItem> item;
+        /// Paths in or under a path effect are read and simplified while writing.
+        bool in_path_effect = false;
+        /// The path data that was read, to detect changes made in the meantime.
+        std::string d;
+    };
+
+    std::vector<Item> _items;
+    std::shared_ptr<Work> _work;
+    float _threshold;
+    bool _justCoalesce;
+    double _size;
+};
+
 int path_simplify(SPItem *item, float threshold, bool justCoalesce, double size);
 
+/**
+ * Simplify the paths among the items and their descendants, with the same result as calling
+ * path_simplify() on each item in turn. The paths are simplified on several threads, while the
+ * calling thread waits.
+ *
+ * @param progress Receives the fraction of paths done, on the calling thread, always before the
+ *                 document is changed. Once it is cancelled, all paths are left unchanged.
+ * @return The number of paths simplified.
+ */
+int path_simplify(std::vector<SPItem *> const &items, float threshold, bool justCoalesce, double size,
+                  Inkscape::Async::Progress<double> &progress);
+
 #endif // PATH_SIMPLIFY_H
 
 /*
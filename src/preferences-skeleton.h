@@ -318,7 +318,7 @@ static char const preferences_skeleton[] =
     <group id="cloneorphans" value="0"/>
     <group id="stickyzoom" value="0"/>
     <group id="selcue" value="2"/>
-    <group id="transform" stroke="1" rectcorners="1" pattern="1" gradient="1" />
+    <group id="transform" stroke="1" rectcorners="1" pattern="1" gradient="1" proxythreshold="5000" />
     <group id="dash" scale="1" />
     <group id="kbselection" inlayer="1" onlyvisible="1" onlysensitive="1" />
     <group id="selection" layerdeselect="1" />
@@ -355,7 +355,8 @@ static char const preferences_skeleton[] =
            check_on_reading="0"
            check_on_editing="0"
            check_on_writing="0"
-           sort_attributes="0"/>
+           sort_attributes="0"
+           compression_level="6"/>
     <group id="externalresources">
       <group id="xml"
            allow_net_access="0"/>
@@ -39,8 +39,14 @@
 #include "display/control/snap-indicator.h"
 #include "display/control/canvas-item-ctrl.h"
 #include "display/control/canvas-item-curve.h"
+#include "display/control/canvas-item-drawing.h"
 #include "display/control/canvas-item-enums.h"
 #include "display/control/canvas-item-group.h"
+#include "display/control/canvas-item-snapshot.h"
+#include "display/drawing.h"
+#include "display/drawing-context.h"
+#include "display/drawing-item.h"
+#include "display/rendermode.h"
 #include "live_effects/effect-enum.h"
 #include "live_effects/effect.h"
 
@@ -52,6 +58,7 @@
 #include "ui/modifiers.h"
 #include "ui/knot/knot.h"
 #include "ui/tools/select-tool.h"
+#include "ui/widget/canvas.h"
 #include "ui/widget/events/canvas-event.h"
 
 using Inkscape::DocumentUndo;
@@ -169,6 +176,7 @@ Inkscape::SelTrans::~SelTrans()
     }
 
     _clear_stamp();
+    _clearProxy();
 
     for (auto &_item : _items) {
         sp_object_unref(_item, nullptr);
@@ -356,12 +364,101 @@ void Inkscape::SelTrans::grab(Geom::Point const &p, gdouble x, gdouble y, bool s
     if (_show == SHOW_OUTLINE) {
         for (auto & i : _l)
             i->set_visible(true);
+    } else {
+        _createProxy();
     }
 
     _updateHandles();
     g_return_if_fail(_stamp_cache.empty());
 }
 
+/**
+ * If the selection is too complex to be updated and re-rendered on every motion event, snapshot
+ * its rendering once and drag that bitmap around instead. The items themselves are hidden until
+ * ungrab, when the accumulated transform is written to them in one go.
+ *
+ * @return Whether a proxy is now being shown in place of the selection.
+ */
+bool Inkscape::SelTrans::_createProxy()
+{
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    int const threshold = prefs->getInt("/options/transform/proxythreshold", 5000);
+    auto canvas = _desktop->getCanvas();
+    if (threshold <= 0 || canvas->get_render_mode() != Inkscape::RenderMode::NORMAL) {
+        return false;
+    }
+
+    int complexity = 0;
+    Geom::OptIntRect area;
+    for (auto item : _items) {
+        if (auto arenaitem = item->get_arenaitem(_desktop->dkey)) {
+            complexity += arenaitem->getUpdateComplexity();
+            area.unionWith(arenaitem->drawbox());
+        }
+    }
+    if (complexity < threshold) {
+        return false;
+    }
+
+    // Only snapshot what can be dragged into view, to bound memory use for huge selections.
+    auto visible = canvas->get_area_world();
+    visible.expandBy(visible.width() / 2, visible.height() / 2);
+    area.intersectWith(visible);
+    if (!area) {
+        return false;
+    }
+
+    int const device_scale = canvas->get_scale_factor();
+    auto surface = Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32, area->width() * device_scale,
+                                               area->height() * device_scale);
+    cairo_surface_set_device_scale(surface->cobj(), device_scale, device_scale);
+    {
+        // Render the items in place within the drawing, so that the opacity, clips, masks and
+        // filters of their ancestors show up in the snapshot as they do on the canvas.
+        std::vector<Inkscape::DrawingItem const *> arenaitems;
+        for (auto item : _items) {
+            if (auto arenaitem = item->get_arenaitem(_desktop->dkey)) {
+                arenaitems.push_back(arenaitem);
+            }
+        }
+        auto const subset = Inkscape::RenderSubset(arenaitems);
+        auto dc = Inkscape::DrawingContext(surface->cobj(), area->min());
+        _desktop->getCanvasDrawing()->get_drawing()->render(dc, *area, Inkscape::DrawingItem::RENDER_BYPASS_CACHE,
+                                                            &subset);
+    }
+    surface->flush();
+
+    _proxy = make_canvasitem<CanvasItemSnapshot>(_desktop->getCanvasSketch(), std::move(surface), *area,
+                                                 canvas->get_affine());
+
+    // The rest of the scene is rendered once without the selection, then left alone.
+    for (auto item : _items) {
+        if (auto arenaitem = item->get_arenaitem(_desktop->dkey)) {
+            arenaitem->setVisible(false);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Remove the drag proxy, if any, and show the real items again.
+ */
+void Inkscape::SelTrans::_clearProxy()
+{
+    if (!_proxy) {
+        return;
+    }
+
+    for (auto item : _items) {
+        if (auto arenaitem = item->get_arenaitem(_desktop->dkey)) {
+            arenaitem->setVisible(!item->isHidden());
+        }
+    }
+
+    _proxy.reset();
+}
+
 void Inkscape::SelTrans::transform(Geom::Affine const &rel_affine, Geom::Point const &norm)
 {
     g_return_if_fail(_grabbed);
@@ -369,7 +466,9 @@ void Inkscape::SelTrans::transform(Geom::Affine const &rel_affine, Geom::Point c
 
     Geom::Affine const affine( Geom::Translate(-norm) * rel_affine * Geom::Translate(norm) );
 
-    if (_show == SHOW_CONTENT) {
+    if (_proxy) {
+        _proxy->set_transform(affine);
+    } else if (_show == SHOW_CONTENT) {
         auto selection = _desktop->getSelection();
         // update the content
         for (unsigned i = 0; i < _items.size(); i++) {
@@ -428,6 +527,10 @@ void Inkscape::SelTrans::ungrab()
     Inkscape::Selection *selection = _desktop->getSelection();
     _updateVolatileState();
 
+    // With a proxy, the items were left in place during the drag just like in outline mode.
+    bool const live = _show == SHOW_CONTENT && !_proxy;
+    _clearProxy();
+
     for (auto & _item : _items) {
         sp_object_unref(_item, nullptr);
     }
@@ -449,7 +552,7 @@ void Inkscape::SelTrans::ungrab()
         if (!_current_relative_affine.isIdentity()) { // we can have a identity affine
             // when trying to stretch a perfectly vertical line in horizontal direction, which will not be allowed by the handles;
 
-            selection->applyAffine(_current_relative_affine, (_show == SHOW_OUTLINE) ? true : false);
+            selection->applyAffine(_current_relative_affine, !live);
             if (_center) {
                 *_center *= _current_relative_affine;
                 _center_is_set = true;
@@ -458,7 +561,7 @@ void Inkscape::SelTrans::ungrab()
             // If dragging showed content live, sp_selection_apply_affine cannot change the centers
             // appropriately - it does not know the original positions of the centers (all objects already have
             // the new bboxes). So we need to reset the centers from our saved array.
-            if (_show != SHOW_OUTLINE && !_current_relative_affine.isTranslation()) {
+            if (live && !_current_relative_affine.isTranslation()) {
                 for (unsigned i = 0; i < _items_centers.size(); i++) {
                     SPItem *currentItem = _items[i];
                     if (currentItem->isCenterSet()) { // only if it's already set
@@ -607,7 +710,8 @@ void Inkscape::SelTrans::stamp(bool clone)
 
             SPItem *copy_item = (SPItem *) _desktop->getDocument()->getObjectByRepr(copy_repr);
             Geom::Affine new_affine = Geom::identity();
-            if (_show == SHOW_OUTLINE || clone) {
+            // With a proxy, as in outline mode, the originals have not been moved yet.
+            if (_show == SHOW_OUTLINE || _proxy || clone) {
                 Geom::Affine const i2d(original_item->i2dt_affine());
                 Geom::Affine const i2dnew( i2d * _current_relative_affine );
                 copy_item->set_i2d_affine(i2dnew);
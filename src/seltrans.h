@@ -39,6 +39,7 @@ namespace Inkscape {
 
 class CanvasItemCtrl;
 class CanvasItemCurve;
+class CanvasItemSnapshot;
 
 Geom::Scale calcScaleFactors(Geom::Point const &initial_point, Geom::Point const &new_point, Geom::Point const &origin, bool const skew = false);
 
@@ -123,6 +124,8 @@ private:
     Geom::Point _calcAbsAffineDefault(Geom::Scale const default_scale);
     Geom::Point _calcAbsAffineGeom(Geom::Scale const geom_scale);
     void _keepClosestPointOnly(Geom::Point const &p);
+    bool _createProxy();
+    void _clearProxy();
 
     enum State {
         STATE_SCALE, //scale or stretch
@@ -184,6 +187,7 @@ private:
     CanvasItemPtr<CanvasItemCtrl> _norm;
     CanvasItemPtr<CanvasItemCtrl> _grip;
     std::array<CanvasItemPtr<CanvasItemCurve>, 4> _l;
+    CanvasItemPtr<CanvasItemSnapshot> _proxy; ///< bitmap stand-in for complex selections while dragging
     std::vector<SPItem*> _stamp_cache;
     bool _stamped = false;
     Geom::Point _origin; ///< position of origin for transforms
@@ -244,12 +244,12 @@ GrayMap grayMapCanny(GrayMap const &gm, double dLowThreshold, double dHighThresh
 ### Q U A N T I Z A T I O N
 #########################################################################*/
 
-GrayMap quantizeBand(RgbMap const &rgbMap, int nrColors)
+GrayMap quantizeBand(RgbMap const &rgbMap, int nrColors, int nthreads)
 {
     auto gaussMap = rgbMapGaussian(rgbMap);
     // gaussMap->writePPM(gaussMap, "rgbgauss.ppm");
 
-    auto qMap = rgbMapQuantize(gaussMap, nrColors);
+    auto qMap = rgbMapQuantize(gaussMap, nrColors, nthreads);
     // qMap->writePPM(qMap, "rgbquant.ppm");
 
     auto gm = GrayMap(rgbMap.width, rgbMap.height);
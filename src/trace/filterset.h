@@ -31,7 +31,7 @@ RgbMap rgbMapGaussian(RgbMap const &rgbmap);
 
 GrayMap grayMapCanny(GrayMap const &gmap, double lowThreshold, double highThreshold);
 
-GrayMap quantizeBand(RgbMap const &rgbmap, int nrColors);
+GrayMap quantizeBand(RgbMap const &rgbmap, int nrColors, int nthreads = 1);
 
 } // namespace Trace
 } // namespace Inkscape
@@ -14,7 +14,14 @@
  * is provided by the generosity of Peter Selinger, to whom we are grateful.
  *
  */
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <iomanip>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 #include <potracelib.h>
 
 #include "inkscape-potrace.h"
@@ -24,6 +31,7 @@
 #include "trace/filterset.h"
 #include "trace/quantize.h"
 #include "trace/imagemap-gdk.h"
+#include "util/parallel.h"
 #include "util-string/ustring-format.h"
 
 namespace {
@@ -39,6 +47,94 @@ Glib::ustring twohex(int value)
     return Inkscape::ustring::format_classic(std::hex, std::setfill('0'), std::setw(2), value);
 }
 
+void invertGrayMap(Inkscape::Trace::GrayMap &map)
+{
+    for (auto &brightness : map.pixels) {
+        brightness = Inkscape::Trace::GrayMap::WHITE - brightness;
+    }
+}
+
+/**
+ * Progress object handed to a job running on a worker thread. It only records the latest value,
+ * which the coordinating thread forwards to the real progress, and observes a shared cancel flag.
+ */
+class WorkerProgress final
+    : public Inkscape::Async::Progress<double>
+{
+public:
+    WorkerProgress(std::atomic<bool> const &cancelled) : _cancelled(&cancelled) {}
+    double value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> const *_cancelled;
+    std::atomic<double> _value = 0.0;
+
+    bool _keepgoing() const override { return !_cancelled->load(std::memory_order_relaxed); }
+    bool _report(double const &progress) override
+    {
+        _value.store(progress, std::memory_order_relaxed);
+        return _keepgoing();
+    }
+};
+
+/**
+ * Run \a count independent jobs \a job(i, progress) on up to \a nthreads worker threads and return
+ * their results in order.
+ *
+ * Progress of all jobs is merged and reported to \a progress from the calling thread, which is
+ * also where cancellation is checked; a cancellation is then propagated to all running jobs.
+ */
+template <typename F>
+auto runJobs(int count, int nthreads, Inkscape::Async::Progress<double> &progress, F &&job)
+{
+    using Result = std::invoke_result_t<F &, int, Inkscape::Async::Progress<double> &>;
+
+    std::vector<Result> results(count);
+    if (count <= 0) {
+        return results;
+    }
+
+    std::atomic<bool> cancelled = false;
+    std::vector<std::unique_ptr<WorkerProgress>> progresses;
+    for (int i = 0; i < count; i++) {
+        progresses.push_back(std::make_unique<WorkerProgress>(cancelled));
+    }
+
+    std::mutex mutex;
+    std::exception_ptr error;
+
+    auto job_at = [&] (std::size_t i) {
+        try {
+            results[i] = job(i, *progresses[i]);
+        } catch (...) {
+            cancelled = true;
+            auto lock = std::lock_guard(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    auto report = [&] {
+        double total = 0.0;
+        for (auto const &p : progresses) {
+            total += p->value();
+        }
+        if (!progress.report(total / count)) {
+            cancelled = true;
+        }
+    };
+
+    Inkscape::Util::parallel_for(count, nthreads, job_at, report, std::chrono::milliseconds(50));
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    progress.throw_if_cancelled();
+
+    return results;
+}
+
 } // namespace
 
 namespace Inkscape {
@@ -62,6 +158,7 @@ PotraceTracingEngine::PotraceTracingEngine(TraceType traceType, bool invert, int
 void PotraceTracingEngine::common_init()
 {
     potraceParams = potrace_param_default();
+    nthreads = Util::get_num_threads();
 }
 
 PotraceTracingEngine::~PotraceTracingEngine()
@@ -149,23 +246,12 @@ std::optional<GrayMap> PotraceTracingEngine::filter(Glib::RefPtr<Gdk::Pixbuf> co
         // Color quantization -- banding
         auto rgbmap = gdkPixbufToRgbMap(pixbuf);
         // rgbMap->writePPM(rgbMap, "rgb.ppm");
-        map = quantizeBand(rgbmap, quantizationNrColors);
+        map = quantizeBand(rgbmap, quantizationNrColors, nthreads);
 
     } else if (traceType == TraceType::BRIGHTNESS || traceType == TraceType::BRIGHTNESS_MULTI) {
 
         // Brightness threshold
-        auto gm = gdkPixbufToGrayMap(pixbuf);
-        map = GrayMap(gm.width, gm.height);
-
-        double floor = 3.0 * brightnessFloor * 256.0;
-        double cutoff = 3.0 * brightnessThreshold * 256.0;
-        for (int y = 0; y < gm.height; y++) {
-            for (int x = 0; x < gm.width; x++) {
-                double brightness = gm.getPixel(x, y);
-                bool black = brightness >= floor && brightness < cutoff;
-                map->setPixel(x, y, black ? GrayMap::BLACK : GrayMap::WHITE);
-            }
-        }
+        map = filterBrightness(gdkPixbufToGrayMap(pixbuf), brightnessFloor, brightnessThreshold);
 
         // map->writePPM(map, "brightness.ppm");
 
@@ -180,13 +266,25 @@ std::optional<GrayMap> PotraceTracingEngine::filter(Glib::RefPtr<Gdk::Pixbuf> co
 
     // Invert the image if necessary.
     if (map && invert) {
-        for (int y = 0; y < map->height; y++) {
-            for (int x = 0; x < map->width; x++) {
-                auto brightness = map->getPixel(x, y);
-                brightness = GrayMap::WHITE - brightness;
-                map->setPixel(x, y, brightness);
-            }
-        }
+        invertGrayMap(*map);
+    }
+
+    return map;
+}
+
+/**
+ * Threshold a gray map: pixels with brightness in [floor, threshold) become black, the rest white.
+ */
+GrayMap PotraceTracingEngine::filterBrightness(GrayMap const &gm, double floor, double threshold) const
+{
+    auto map = GrayMap(gm.width, gm.height);
+
+    double const lo = 3.0 * floor * 256.0;
+    double const hi = 3.0 * threshold * 256.0;
+    for (std::size_t i = 0; i < gm.pixels.size(); i++) {
+        double brightness = gm.pixels[i];
+        bool black = brightness >= lo && brightness < hi;
+        map.pixels[i] = black ? GrayMap::BLACK : GrayMap::WHITE;
     }
 
     return map;
@@ -200,7 +298,7 @@ IndexedMap PotraceTracingEngine::filterIndexed(Glib::RefPtr<Gdk::Pixbuf> const &
         map = rgbMapGaussian(map);
     }
 
-    auto imap = rgbMapQuantize(map, multiScanNrColors);
+    auto imap = rgbMapQuantize(map, multiScanNrColors, nthreads);
 
     auto tomono = [] (RGB c) -> RGB {
         unsigned char s = ((int)c.r + (int)c.g + (int)c.b) / 3;
@@ -239,9 +337,9 @@ Glib::RefPtr<Gdk::Pixbuf> PotraceTracingEngine::preview(Glib::RefPtr<Gdk::Pixbuf
 }
 
 /**
- * This is the actual wrapper of the call to Potrace.
+ * Convert a GrayMap to a Potrace bitmap and trace it.
  */
-Geom::PathVector PotraceTracingEngine::grayMapToPath(GrayMap const &grayMap, Async::Progress<double> &progress)
+Geom::PathVector PotraceTracingEngine::grayMapToPath(GrayMap const &grayMap, Async::Progress<double> &progress) const
 {
     auto potraceBitmap = potrace_bitmap_uniqptr(bm_new(grayMap.width, grayMap.height));
     if (!potraceBitmap) {
@@ -266,15 +364,24 @@ Geom::PathVector PotraceTracingEngine::grayMapToPath(GrayMap const &grayMap, Asy
     fclose(f);
     */
 
+    return bitmapToPath(potraceBitmap.get(), progress);
+}
+
+/**
+ * This is the actual wrapper of the call to Potrace.
+ *
+ * Safe to call concurrently from several threads, as each call uses its own copy of the parameters.
+ */
+Geom::PathVector PotraceTracingEngine::bitmapToPath(potrace_bitmap_t *bitmap, Async::Progress<double> &progress) const
+{
     // Trace the bitmap.
 
     auto throttled = Async::ProgressStepThrottler(progress, 0.02);
 
-    potraceParams->progress.data = &throttled;
-    potraceParams->progress.callback = [] (double progress, void *data) { reinterpret_cast<decltype(throttled)*>(data)->report(progress); };
-    auto potraceState = potrace_state_uniqptr(potrace_trace(potraceParams, potraceBitmap.get()));
-
-    potraceBitmap.reset();
+    auto params = *potraceParams;
+    params.progress.data = &throttled;
+    params.progress.callback = [] (double progress, void *data) { reinterpret_cast<decltype(throttled)*>(data)->report(progress); };
+    auto potraceState = potrace_state_uniqptr(potrace_trace(&params, bitmap));
 
     progress.throw_if_cancelled();
 
@@ -328,42 +435,68 @@ TraceResult PotraceTracingEngine::traceBrightnessMulti(Glib::RefPtr<Gdk::Pixbuf>
     double constexpr high  = 0.9; // top of range
     double const     delta = (high - low) / multiScanNrColors;
 
-    brightnessFloor = 0.0; // Set bottom to black
+    // The source brightness map is shared by all scans, which are then traced in parallel.
+    auto const gm = gdkPixbufToGrayMap(pixbuf);
+
+    auto scan = [&, this] (double floor, double threshold, Async::Progress<double> &subprogress) {
+        auto grayMap = filterBrightness(gm, floor, threshold);
+        if (invert) {
+            invertGrayMap(grayMap);
+        }
+
+        subprogress.report_or_throw(0.2);
+
+        auto sub_gmtopath = Async::SubProgress(subprogress, 0.2, 0.8);
+        auto pv = grayMapToPath(grayMap, sub_gmtopath);
+
+        subprogress.report_or_throw(1.0);
+        return pv;
+    };
+
+    progress.report_or_throw(0.05);
+
+    // When tiling, each scan's floor is the threshold of the last scan that produced a path. Guess
+    // that this is the previous scan, which is almost always true, and trace all scans at once.
+    auto guessedFloor = [&] (int i) { return multiScanStack || i == 0 ? 0.0 : low + delta * (i - 1); };
+
+    auto sub_scans = Async::SubProgress(progress, 0.05, 0.85);
+    auto paths = runJobs(multiScanNrColors, nthreads, sub_scans, [&] (int i, Async::Progress<double> &subprogress) {
+        return scan(guessedFloor(i), low + delta * i, subprogress);
+    });
+
+    // A scan following one that came out empty, e.g. because potrace dropped all its specks, is
+    // retraced with the lower floor, so that those pixels still end up in a layer.
+    auto sub_fixup = Async::SubProgress(progress, 0.85, 0.15);
+    double floor = 0.0;
 
     TraceResult results;
 
     for (int i = 0; i < multiScanNrColors; i++) {
-        auto subprogress = Async::SubProgress(progress, (double)i / multiScanNrColors, 1.0 / multiScanNrColors);
-
-        brightnessThreshold = low + delta * i;
+        double const threshold = low + delta * i;
 
-        auto grayMap = filter(pixbuf);
-        if (!grayMap) {
-            continue;
+        if (floor != guessedFloor(i)) {
+            auto subprogress = Async::SubProgress(sub_fixup, (double)i / multiScanNrColors, 1.0 / multiScanNrColors);
+            paths[i] = scan(floor, threshold, subprogress);
         }
 
-        subprogress.report_or_throw(0.2);
-
-        auto sub_gmtopath = Async::SubProgress(subprogress, 0.2, 0.8);
-        auto pv = grayMapToPath(*grayMap, sub_gmtopath);
-        if (pv.empty()) {
+        if (paths[i].empty()) {
             continue;
         }
 
         // get style info
-        int grayVal = 256.0 * brightnessThreshold;
+        int grayVal = 256.0 * threshold;
         auto style = Glib::ustring::compose("fill-opacity:1.0;fill:#%1%2%3", twohex(grayVal), twohex(grayVal), twohex(grayVal));
 
         // g_message("### GOT '%s' \n", style.c_str());
-        results.emplace_back(style.raw(), std::move(pv));
+        results.emplace_back(style.raw(), std::move(paths[i]));
 
         if (!multiScanStack) {
-            brightnessFloor = brightnessThreshold;
+            floor = threshold;
         }
-
-        subprogress.report_or_throw(1.0);
     }
 
+    progress.report_or_throw(1.0);
+
     // Remove the bottom-most scan, if requested.
     if (results.size() > 1 && multiScanRemoveBackground) {
         results.pop_back();
@@ -378,46 +511,51 @@ TraceResult PotraceTracingEngine::traceBrightnessMulti(Glib::RefPtr<Gdk::Pixbuf>
 TraceResult PotraceTracingEngine::traceQuant(Glib::RefPtr<Gdk::Pixbuf> const &pixbuf, Async::Progress<double> &progress)
 {
     auto imap = filterIndexed(pixbuf);
-
-    // Create and clear a gray map
-    auto gm = GrayMap(imap.width, imap.height);
-    for (int row = 0; row < gm.height; row++) {
-        for (int col = 0; col < gm.width; col++) {
-            gm.setPixel(col, row, GrayMap::WHITE);
+    int const nrColors = imap.nrColors;
+
+    // Build the bitmaps of all colors in a single pass over the image. When stacking, a pixel of
+    // color index i is black in the bitmaps of all colors from i onwards.
+    std::vector<potrace_bitmap_uniqptr> bitmaps;
+    for (int colorIndex = 0; colorIndex < nrColors; colorIndex++) {
+        auto &bitmap = bitmaps.emplace_back(bm_new(imap.width, imap.height));
+        if (!bitmap) {
+            return {};
         }
+        bm_clear(bitmap.get(), 0);
     }
 
-    TraceResult results;
-
-    for (int colorIndex = 0; colorIndex < imap.nrColors; colorIndex++) {
-        auto subprogress = Async::SubProgress(progress, (double)colorIndex / imap.nrColors, 1.0 / imap.nrColors);
-
-        // Update the graymap for the current color index
-        for (int row = 0; row < imap.height; row++) {
-            for (int col = 0; col < imap.width; col++) {
-                int index = imap.getPixel(col, row);
-                if (index == colorIndex) {
-                    gm.setPixel(col, row, GrayMap::BLACK);
-                } else if (!multiScanStack) {
-                    gm.setPixel(col, row, GrayMap::WHITE);
-                }
+    for (int row = 0; row < imap.height; row++) {
+        auto const pixels = imap.row(row);
+        for (int col = 0; col < imap.width; col++) {
+            int const index = pixels[col];
+            int const last = multiScanStack ? nrColors - 1 : index;
+            for (int colorIndex = index; colorIndex <= last; colorIndex++) {
+                BM_USET(bitmaps[colorIndex], col, row);
             }
         }
+    }
 
-        subprogress.report_or_throw(0.2);
+    progress.report_or_throw(0.1);
 
-        // Now we have a traceable graymap
-        auto sub_gmtopath = Async::SubProgress(subprogress, 0.2, 0.8);
-        auto pv = grayMapToPath(gm, sub_gmtopath);
+    // Now we have traceable bitmaps
+    auto sub_colors = Async::SubProgress(progress, 0.1, 0.9);
+    auto paths = runJobs(nrColors, nthreads, sub_colors, [&, this] (int colorIndex, Async::Progress<double> &subprogress) {
+        auto pv = bitmapToPath(bitmaps[colorIndex].get(), subprogress);
+        bitmaps[colorIndex].reset();
+        return pv;
+    });
 
-        if (!pv.empty()) {
-            // get style info
-            auto rgb = imap.clut[colorIndex];
-            auto style = Glib::ustring::compose("fill:#%1%2%3", twohex(rgb.r), twohex(rgb.g), twohex(rgb.b));
-            results.emplace_back(style.raw(), std::move(pv));
+    TraceResult results;
+
+    for (int colorIndex = 0; colorIndex < nrColors; colorIndex++) {
+        if (paths[colorIndex].empty()) {
+            continue;
         }
 
-        subprogress.report_or_throw(1.0);
+        // get style info
+        auto rgb = imap.clut[colorIndex];
+        auto style = Glib::ustring::compose("fill:#%1%2%3", twohex(rgb.r), twohex(rgb.g), twohex(rgb.b));
+        results.emplace_back(style.raw(), std::move(paths[colorIndex]));
     }
 
     // Remove the bottom-most scan, if requested.
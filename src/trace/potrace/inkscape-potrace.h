@@ -26,6 +26,7 @@
 #include "trace/imagemap.h"
 using potrace_param_t = struct potrace_param_s;
 using potrace_path_t  = struct potrace_path_s;
+using potrace_bitmap_t = struct potrace_bitmap_s;
 
 namespace Inkscape {
 namespace Trace {
@@ -96,6 +97,10 @@ private:
     bool multiScanSmooth = false; // do we use gaussian filter?
     bool multiScanRemoveBackground = false; // do we remove the bottom trace?
 
+    // Threads for the scans, read from the preferences when the engine is created on the main
+    // thread, as tracing runs on a worker thread.
+    int nthreads = 1;
+
     void common_init();
 
     TraceResult traceQuant          (Glib::RefPtr<Gdk::Pixbuf> const &pixbuf, Async::Progress<double> &progress);
@@ -104,8 +109,10 @@ private:
 
     IndexedMap filterIndexed(Glib::RefPtr<Gdk::Pixbuf> const &pixbuf) const;
     std::optional<GrayMap> filter(Glib::RefPtr<Gdk::Pixbuf> const &pixbuf) const;
+    GrayMap filterBrightness(GrayMap const &gm, double floor, double threshold) const;
 
-    Geom::PathVector grayMapToPath(GrayMap const &gm, Async::Progress<double> &progress);
+    Geom::PathVector grayMapToPath(GrayMap const &gm, Async::Progress<double> &progress) const;
+    Geom::PathVector bitmapToPath(potrace_bitmap_t *bitmap, Async::Progress<double> &progress) const;
 
     void writePaths(potrace_path_t *paths, Geom::PathBuilder &builder, std::unordered_set<Geom::Point> &points, Async::Progress<double> &progress) const;
 };
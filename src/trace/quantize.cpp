@@ -9,14 +9,17 @@
  *
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
+#include <algorithm>
 #include <memory>
 #include <cassert>
 #include <cstdio>
+#include <vector>
 #include <glib.h>
 
 #include "pool.h"
 #include "imagemap.h"
 #include "quantize.h"
+#include "util/parallel.h"
 
 namespace Inkscape {
 namespace Trace {
@@ -144,6 +147,20 @@ struct Ocnode
 - pool allocation is used to allocate nodes (increased performance on large
   images).
 
+- the tree is not built from individual pixels but from a color histogram
+  with 5 bits per channel, which is filled in parallel (one histogram per
+  thread, merged afterwards). each non-empty histogram bin becomes a leaf
+  of width 3 carrying the exact color sums of its pixels, so palette colors
+  are still true averages; only colors differing in the 3 low bits of every
+  channel can no longer be told apart, which the pruning never does for the
+  small palettes used in practice.
+
+- pixels are mapped to the palette through a lookup table indexed by
+  histogram bin instead of a palette search per pixel. a bin only gets a
+  table entry when one palette color is the closest to every color the bin
+  can hold; pixels of the bins straddling two palette colors are still
+  looked up one by one, so every pixel gets its exact closest color.
+
 */
 
 RGB operator>>(RGB rgb, int s)
@@ -230,23 +247,6 @@ void octreePrint(Ocnode *node)
 }
 #endif
 
-/**
- * builds a single <rgb> color leaf at location <ref>
- */
-void ocnodeLeaf(Pool<Ocnode> &pool, Ocnode **ref, RGB rgb)
-{
-    assert(ref);
-    Ocnode *node = ocnodeNew(pool);
-    node->width = 0;
-    node->rgb = rgb;
-    node->rs = rgb.r; node->gs = rgb.g; node->bs = rgb.b;
-    node->weight = 1;
-    node->nleaf = 1;
-    node->mi = 0;
-    node->ref = ref;
-    *ref = node;
-}
-
 /**
  *  merge nodes <node1> and <node2> at location <ref> with parent <parent>
  */
@@ -421,42 +421,143 @@ void octreePrune(Pool<Ocnode> &pool, Ocnode **ref, int ncolor)
 }
 
 /**
- * build an octree associated to the area of a color map <rgbmap>,
- * included in the specified (x1,y1)--(x2,y2) rectangle.
+ * color histogram with <BIN_BITS> bits per channel.
  */
-void octreeBuildArea(Pool<Ocnode> &pool, RgbMap const &rgbmap, Ocnode **ref, int x1, int y1, int x2, int y2, int ncolor)
+int constexpr BIN_BITS = 5;
+int constexpr BIN_SHIFT = 8 - BIN_BITS;
+int constexpr NBINS = 1 << (3 * BIN_BITS);
+
+struct Bin
 {
-    int dx = x2 - x1, dy = y2 - y1;
-    int xm = x1 + dx / 2, ym = y1 + dy / 2;
-    Ocnode *ref1 = nullptr;
-    Ocnode *ref2 = nullptr;
-    if (dx == 1 && dy == 1) {
-        ocnodeLeaf(pool, ref, rgbmap.getPixel(x1, y1));
-    } else if (dx > dy) {
-        octreeBuildArea(pool, rgbmap, &ref1, x1, y1, xm, y2, ncolor);
-        octreeBuildArea(pool, rgbmap, &ref2, xm, y1, x2, y2, ncolor);
-        octreeMerge(pool, nullptr, ref, ref1, ref2);
+    unsigned long weight = 0;     // number of pixels in this bin
+    unsigned long rs = 0, gs = 0, bs = 0; // sum of their colors
+};
+
+using Histogram = std::vector<Bin>;
+
+int binIndex(RGB rgb)
+{
+    return ((rgb.r >> BIN_SHIFT) << (2 * BIN_BITS)) | ((rgb.g >> BIN_SHIFT) << BIN_BITS) | (rgb.b >> BIN_SHIFT);
+}
+
+RGB binPrefix(int index)
+{
+    int constexpr mask = (1 << BIN_BITS) - 1;
+    RGB rgb;
+    rgb.r = (index >> (2 * BIN_BITS)) & mask;
+    rgb.g = (index >> BIN_BITS) & mask;
+    rgb.b = index & mask;
+    return rgb;
+}
+
+/**
+ * number of bands to split per-pixel work on an image of <height> rows into, one per thread.
+ */
+int bandCount(int height, int nthreads)
+{
+    int constexpr min_rows = 64; // don't bother splitting small images
+    return std::clamp(height / min_rows, 1, std::max(nthreads, 1));
+}
+
+/**
+ * run <f(band, y1, y2)> over <nbands> horizontal bands of an image of <height> rows, in parallel.
+ */
+template <typename F>
+void forEachBand(int height, int nbands, F &&f)
+{
+    Util::parallel_for(nbands, nbands, [&] (std::size_t band) {
+        int const t = band;
+        f(t, height * t / nbands, height * (t + 1) / nbands);
+    });
+}
+
+/**
+ * build the color histogram of <rgbmap>.
+ */
+Histogram histogramBuild(RgbMap const &rgbmap, int nthreads)
+{
+    int const nbands = bandCount(rgbmap.height, nthreads);
+    std::vector<Histogram> partials(nbands, Histogram(NBINS));
+
+    forEachBand(rgbmap.height, nbands, [&] (int t, int y1, int y2) {
+        auto &hist = partials[t];
+        for (int y = y1; y < y2; y++) {
+            auto const row = rgbmap.row(y);
+            for (int x = 0; x < rgbmap.width; x++) {
+                auto const rgb = row[x];
+                auto &bin = hist[binIndex(rgb)];
+                bin.weight++;
+                bin.rs += rgb.r; bin.gs += rgb.g; bin.bs += rgb.b;
+            }
+        }
+    });
+
+    auto &hist = partials[0];
+    for (int t = 1; t < nbands; t++) {
+        for (int i = 0; i < NBINS; i++) {
+            auto const &src = partials[t][i];
+            hist[i].weight += src.weight;
+            hist[i].rs += src.rs; hist[i].gs += src.gs; hist[i].bs += src.bs;
+        }
+    }
+
+    return std::move(hist);
+}
+
+/**
+ * builds a leaf for histogram bin <index> at location <ref>
+ */
+void ocnodeBin(Pool<Ocnode> &pool, Ocnode **ref, int index, Bin const &bin)
+{
+    assert(ref);
+    Ocnode *node = ocnodeNew(pool);
+    node->width = BIN_SHIFT;
+    node->rgb = binPrefix(index);
+    node->rs = bin.rs; node->gs = bin.gs; node->bs = bin.bs;
+    node->weight = bin.weight;
+    node->nleaf = 1;
+    node->mi = 0;
+    node->ref = ref;
+    *ref = node;
+}
+
+/**
+ * build an octree associated to the non-empty bins <bins[i1]>..<bins[i2 - 1]>
+ * of histogram <hist>, merging halves recursively.
+ */
+void octreeBuildBins(Pool<Ocnode> &pool, Histogram const &hist, std::vector<int> const &bins, Ocnode **ref, int i1, int i2)
+{
+    if (i2 - i1 == 1) {
+        ocnodeBin(pool, ref, bins[i1], hist[bins[i1]]);
     } else {
-        octreeBuildArea(pool, rgbmap, &ref1, x1, y1, x2, ym, ncolor);
-        octreeBuildArea(pool, rgbmap, &ref2, x1, ym, x2, y2, ncolor);
+        int im = i1 + (i2 - i1) / 2;
+        Ocnode *ref1 = nullptr;
+        Ocnode *ref2 = nullptr;
+        octreeBuildBins(pool, hist, bins, &ref1, i1, im);
+        octreeBuildBins(pool, hist, bins, &ref2, im, i2);
         octreeMerge(pool, nullptr, ref, ref1, ref2);
-	}
-
-    // octreePrune(ref, 2 * ncolor);
-    // affects result quality for almost same performance :/
+    }
 }
 
 /**
- * build an octree associated to the <rgbmap> color map,
+ * build an octree associated to the color histogram <hist>,
  * pruned to <ncolor> colors.
  */
-Ocnode *octreeBuild(Pool<Ocnode> &pool, RgbMap const &rgbmap, int ncolor)
+Ocnode *octreeBuild(Pool<Ocnode> &pool, Histogram const &hist, int ncolor)
 {
+    std::vector<int> bins;
+    for (int i = 0; i < NBINS; i++) {
+        if (hist[i].weight) {
+            bins.push_back(i);
+        }
+    }
+    if (bins.empty()) {
+        return nullptr;
+    }
+
     // create the octree
     Ocnode *node = nullptr;
-    octreeBuildArea(pool,
-                    rgbmap, &node,
-                    0, 0, rgbmap.width, rgbmap.height, ncolor);
+    octreeBuildBins(pool, hist, bins, &node, 0, bins.size());
 
     // prune the octree
     octreePrune(pool, &node, ncolor);
@@ -507,19 +608,63 @@ int findRGB(RGB const *rgbs, int ncolor, RGB rgb)
     return index;
 }
 
+unsigned constexpr STRADDLING = -1;
+
+/**
+ * find the index of the color in a palette that is the closest to every color of a histogram bin,
+ * or STRADDLING if different colors of the bin have different closest colors
+ */
+unsigned findBinRGB(RGB const *rgbs, int ncolor, int bin)
+{
+    auto const prefix = binPrefix(bin);
+
+    // the smallest and largest squared distances from a palette color to the colors of the bin
+    auto range = [&] (RGB rgb, int &dmin, int &dmax) {
+        dmin = dmax = 0;
+        for (auto [c, p] : {std::pair{rgb.r, prefix.r}, std::pair{rgb.g, prefix.g}, std::pair{rgb.b, prefix.b}}) {
+            int const lo = p << BIN_SHIFT;
+            int const hi = lo + (1 << BIN_SHIFT) - 1;
+            int const nearest = c < lo ? lo - c : c > hi ? c - hi : 0;
+            int const furthest = std::max(c - lo, hi - c);
+            dmin += nearest * nearest;
+            dmax += furthest * furthest;
+        }
+    };
+
+    // the color with the smallest largest distance is the only candidate
+    int best = -1, best_dmax = 0;
+    for (int k = 0; k < ncolor; k++) {
+        int dmin, dmax;
+        range(rgbs[k], dmin, dmax);
+        if (best == -1 || dmax < best_dmax) { best_dmax = dmax; best = k; }
+    }
+
+    // it wins everywhere if every other color is further away, everywhere in the bin
+    for (int k = 0; k < ncolor; k++) {
+        int dmin, dmax;
+        range(rgbs[k], dmin, dmax);
+        if (k != best && dmin <= best_dmax) {
+            return STRADDLING;
+        }
+    }
+    return best;
+}
+
 } // namespace
 
 /**
  * quantize an RGB image to a reduced number of colors.
  */
-IndexedMap rgbMapQuantize(RgbMap const &rgbmap, int ncolor)
+IndexedMap rgbMapQuantize(RgbMap const &rgbmap, int ncolor, int nthreads)
 {
     assert(ncolor > 0);
 
     auto imap = IndexedMap(rgbmap.width, rgbmap.height);
 
+    auto hist = histogramBuild(rgbmap, nthreads);
+
     Pool<Ocnode> pool;
-    auto tree = octreeBuild(pool, rgbmap, ncolor);
+    auto tree = octreeBuild(pool, hist, ncolor);
 
     auto rgbs = std::make_unique<RGB[]>(ncolor);
     int index = 0;
@@ -528,7 +673,7 @@ IndexedMap rgbMapQuantize(RgbMap const &rgbmap, int ncolor)
     octreeDelete(pool, tree);
 
     // stacking with increasing contrasts
-    std::sort(rgbs.get(), rgbs.get() + ncolor, [] (auto &ra, auto &rb) {
+    std::sort(rgbs.get(), rgbs.get() + index, [] (auto &ra, auto &rb) {
         return (ra.r + ra.g + ra.b) < (rb.r + rb.g + rb.b);
     });
 
@@ -539,15 +684,27 @@ IndexedMap rgbMapQuantize(RgbMap const &rgbmap, int ncolor)
     }
     imap.nrColors = index;
 
-    // fill in new map pixels
-    for (int y = 0; y < rgbmap.height; y++) {
-        for (int x = 0; x < rgbmap.width; x++) {
-            auto rgb = rgbmap.getPixel(x, y);
-            int index = findRGB(rgbs.get(), ncolor, rgb);
-            imap.setPixel(x, y, index);
+    // inverse palette: the closest color to every pixel of each non-empty bin, where one color is
+    // closer than the others everywhere in the bin; the other bins are resolved pixel by pixel
+    std::vector<unsigned> lut(NBINS, 0);
+    for (int i = 0; i < NBINS; i++) {
+        if (hist[i].weight) {
+            lut[i] = findBinRGB(rgbs.get(), index, i);
         }
     }
 
+    // fill in new map pixels
+    forEachBand(rgbmap.height, bandCount(rgbmap.height, nthreads), [&] (int, int y1, int y2) {
+        for (int y = y1; y < y2; y++) {
+            auto const src = rgbmap.row(y);
+            auto const dst = imap.row(y);
+            for (int x = 0; x < rgbmap.width; x++) {
+                auto const found = lut[binIndex(src[x])];
+                dst[x] = found != STRADDLING ? found : findRGB(rgbs.get(), index, src[x]);
+            }
+        }
+    });
+
     return imap;
 }
 
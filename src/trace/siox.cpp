@@ -12,9 +12,11 @@
 #include <algorithm>
 #include <cstdlib>
 #include <cassert>
+#include <limits>
 
 #include "siox.h"
 #include "async/progress.h"
+#include "util/parallel.h"
 
 namespace Inkscape {
 namespace Trace {
@@ -114,42 +116,76 @@ unsigned SioxImage::hash() const
     return result;
 }
 
+unsigned SioxImage::hashPixels() const
+{
+    unsigned result = width * height;
+
+    for (int i = 0; i < width * height; i++) {
+        result = 3 * result + (unsigned)pixdata[i];
+    }
+
+    return result;
+}
+
 //########################################################################
 //#  S I O X
 //########################################################################
 
 namespace {
 
+/**
+ * Below this many pixels, passes over the confidence matrix are not worth parallelizing.
+ */
+int constexpr PARALLEL_THRESHOLD = 2048;
+
+/**
+ * Number of pixels converted to CIELAB by each job.
+ */
+int constexpr LAB_CHUNK = 4096;
+
+/**
+ * Width of the column strips processed by each thread in vertical passes.
+ */
+int constexpr COLUMN_STRIP = 64;
+
 /**
  * Apply a function which updates each pixel depending on the value of its neighbours.
+ *
+ * Rows are independent in the horizontal passes, and columns in the vertical ones, so each
+ * is processed in parallel without changing the order of operations on any given pixel.
  */
 template <typename F>
-void apply_adjacent(float *cm, int xres, int yres, F f)
+void apply_adjacent(float *cm, int xres, int yres, int nthreads, F f)
 {
-    for (int y = 0; y < yres; y++) {
+    int const threads = xres * yres > PARALLEL_THRESHOLD ? nthreads : 1;
+
+    Util::parallel_for(yres, threads, [&] (std::size_t y) {
+        float *row = cm + y * xres;
         for (int x = 0; x < xres - 1; x++) {
-            int idx = y * xres + x;
-            f(cm[idx], cm[idx + 1]);
+            f(row[x], row[x + 1]);
         }
-    }
-    for (int y = 0; y < yres; y++) {
         for (int x = xres - 1; x >= 1; x--) {
-            int idx = y * xres + x;
-            f(cm[idx], cm[idx - 1]);
+            f(row[x], row[x - 1]);
         }
-    }
-    for (int y = 0; y < yres - 1; y++) {
-        for (int x = 0; x < xres; x++) {
-            int idx = y * xres + x;
-            f(cm[idx], cm[idx + xres]);
+    });
+
+    int const strips = (xres + COLUMN_STRIP - 1) / COLUMN_STRIP;
+    Util::parallel_for(strips, threads, [&] (std::size_t strip) {
+        int const x1 = strip * COLUMN_STRIP;
+        int const x2 = std::min(xres, x1 + COLUMN_STRIP);
+        for (int y = 0; y < yres - 1; y++) {
+            for (int x = x1; x < x2; x++) {
+                int idx = y * xres + x;
+                f(cm[idx], cm[idx + xres]);
+            }
         }
-    }
-    for (int y = yres - 1; y >= 1; y--) {
-        for (int x = 0; x < xres; x++) {
-            int idx = y * xres + x;
-            f(cm[idx], cm[idx - xres]);
+        for (int y = yres - 1; y >= 1; y--) {
+            for (int x = x1; x < x2; x++) {
+                int idx = y * xres + x;
+                f(cm[idx], cm[idx - xres]);
+            }
         }
-    }
+    });
 }
 
 /**
@@ -157,9 +193,9 @@ void apply_adjacent(float *cm, int xres, int yres, F f)
  *
  * Can be used to close small holes in the given confidence matrix.
  */
-void dilate(float *cm, int xres, int yres)
+void dilate(float *cm, int xres, int yres, int nthreads)
 {
-    apply_adjacent(cm, xres, yres, [] (float &a, float b) {
+    apply_adjacent(cm, xres, yres, nthreads, [] (float &a, float b) {
         if (b > a) {
             a = b;
         }
@@ -169,9 +205,9 @@ void dilate(float *cm, int xres, int yres)
 /**
  * Applies the morphological erode operator.
  */
-void erode(float *cm, int xres, int yres)
+void erode(float *cm, int xres, int yres, int nthreads)
 {
-    apply_adjacent(cm, xres, yres, [] (float &a, float b) {
+    apply_adjacent(cm, xres, yres, nthreads, [] (float &a, float b) {
         if (b < a) {
             a = b;
         }
@@ -214,32 +250,38 @@ void normalizeMatrix(float *cm, int cmSize)
  * In the standard case confidence matrix entries are between 0...1 and
  * the weight factors sum up to 1.
  */
-void smooth(float *cm, int xres, int yres, float f1, float f2, float f3)
+void smooth(float *cm, int xres, int yres, int nthreads, float f1, float f2, float f3)
 {
-    for (int y = 0; y < yres; y++) {
+    // As in apply_adjacent(), rows then column strips are processed independently.
+    int const threads = xres * yres > PARALLEL_THRESHOLD ? nthreads : 1;
+
+    Util::parallel_for(yres, threads, [&] (std::size_t y) {
+        float *row = cm + y * xres;
         for (int x = 0; x < xres - 2; x++) {
-            int idx = y * xres + x;
-            cm[idx] = f1 * cm[idx] + f2 * cm[idx + 1] + f3 * cm[idx + 2];
+            row[x] = f1 * row[x] + f2 * row[x + 1] + f3 * row[x + 2];
         }
-    }
-    for (int y = 0; y < yres; y++) {
         for (int x = xres - 1; x >= 2; x--) {
-            int idx = y * xres + x;
-            cm[idx] = f3 * cm[idx - 2] + f2 * cm[idx - 1] + f1 * cm[idx];
+            row[x] = f3 * row[x - 2] + f2 * row[x - 1] + f1 * row[x];
         }
-    }
-    for (int y = 0; y < yres - 2; y++) {
-        for (int x = 0; x < xres; x++) {
-            int idx = y * xres + x;
-            cm[idx] = f1 * cm[idx] + f2 * cm[((y + 1) * xres) + x] + f3 * cm[((y + 2) * xres) + x];
+    });
+
+    int const strips = (xres + COLUMN_STRIP - 1) / COLUMN_STRIP;
+    Util::parallel_for(strips, threads, [&] (std::size_t strip) {
+        int const x1 = strip * COLUMN_STRIP;
+        int const x2 = std::min(xres, x1 + COLUMN_STRIP);
+        for (int y = 0; y < yres - 2; y++) {
+            for (int x = x1; x < x2; x++) {
+                int idx = y * xres + x;
+                cm[idx] = f1 * cm[idx] + f2 * cm[idx + xres] + f3 * cm[idx + 2 * xres];
+            }
         }
-    }
-    for (int y = yres - 1; y >= 2; y--) {
-        for (int x = 0; x < xres; x++) {
-            int idx = y * xres + x;
-            cm[idx] = f3 * cm[((y - 2) * xres) + x] + f2 * cm[((y - 1) * xres) + x] + f1 * cm[idx];
+        for (int y = yres - 1; y >= 2; y--) {
+            for (int x = x1; x < x2; x++) {
+                int idx = y * xres + x;
+                cm[idx] = f3 * cm[idx - 2 * xres] + f2 * cm[idx - xres] + f1 * cm[idx];
+            }
         }
-    }
+    });
 }
 
 /**
@@ -255,15 +297,93 @@ float sqrEuclideanDist(float *p, int pSize, float *q)
     return sum;
 }
 
+/**
+ * A k-d tree over the points of a color signature, answering nearest-neighbour queries.
+ */
+class SignatureTree
+{
+public:
+    SignatureTree(std::vector<CieLab> points)
+    {
+        nodes.reserve(points.size());
+        root = build(points, 0, points.size(), 0);
+    }
+
+    bool empty() const { return root == -1; }
+
+    /**
+     * Return the squared distance from \a lab to the closest point of the signature.
+     */
+    float nearestSq(CieLab const &lab) const
+    {
+        float best = std::numeric_limits<float>::max();
+        search(root, lab, best);
+        return best;
+    }
+
+private:
+    struct Node
+    {
+        CieLab point;
+        unsigned axis;
+        int left;
+        int right;
+    };
+
+    std::vector<Node> nodes;
+    int root;
+
+    int build(std::vector<CieLab> &points, int begin, int end, unsigned depth)
+    {
+        if (begin >= end) {
+            return -1;
+        }
+
+        unsigned const axis = depth % 3;
+        int const mid = begin + (end - begin) / 2;
+        std::nth_element(points.begin() + begin, points.begin() + mid, points.begin() + end,
+                         [axis] (CieLab const &a, CieLab const &b) { return a(axis) < b(axis); });
+
+        int const index = nodes.size();
+        nodes.push_back({points[mid], axis, -1, -1});
+        int const left = build(points, begin, mid, depth + 1);
+        int const right = build(points, mid + 1, end, depth + 1);
+        nodes[index].left = left;
+        nodes[index].right = right;
+        return index;
+    }
+
+    void search(int index, CieLab const &lab, float &best) const
+    {
+        if (index == -1) {
+            return;
+        }
+
+        auto const &node = nodes[index];
+        best = std::min(best, CieLab::diffSq(lab, node.point));
+
+        float const delta = lab(node.axis) - node.point(node.axis);
+        int const near = delta < 0 ? node.left : node.right;
+        int const far  = delta < 0 ? node.right : node.left;
+
+        search(near, lab, best);
+        if (delta * delta < best) {
+            search(far, lab, best);
+        }
+    }
+};
+
 } // namespace
 
-Siox::Siox(Async::Progress<double> &progress)
+Siox::Siox(Async::Progress<double> &progress, int nthreads)
     : progress(&progress)
+    , nthreads(nthreads)
     , width(0)
     , height(0)
     , pixelCount(0)
     , image(nullptr)
-    , cm(nullptr) {}
+    , cm(nullptr)
+    , imageLab(nullptr) {}
 
 void Siox::error(std::string const &msg)
 {
@@ -275,7 +395,32 @@ void Siox::trace(std::string const &msg)
     g_message("Siox: %s\n", msg.c_str());
 }
 
+std::vector<CieLab> Siox::convertToLab(SioxImage const &image, int nthreads)
+{
+    int const pixelCount = image.getWidth() * image.getHeight();
+    auto const pixels = image.getImageData();
+
+    std::vector<CieLab> result(pixelCount);
+
+    int const chunks = (pixelCount + LAB_CHUNK - 1) / LAB_CHUNK;
+    Util::parallel_for(chunks, pixelCount > PARALLEL_THRESHOLD ? nthreads : 1, [&] (std::size_t chunk) {
+        int const begin = chunk * LAB_CHUNK;
+        int const end = std::min(pixelCount, begin + LAB_CHUNK);
+        for (int i = begin; i < end; i++) {
+            result[i] = pixels[i];
+        }
+    });
+
+    return result;
+}
+
 SioxImage Siox::extractForeground(SioxImage const &originalImage, uint32_t backgroundFillColor)
+{
+    return extractForeground(originalImage, backgroundFillColor, convertToLab(originalImage, nthreads));
+}
+
+SioxImage Siox::extractForeground(SioxImage const &originalImage, uint32_t backgroundFillColor,
+                                  std::vector<CieLab> const &labData)
 {
     trace("### Start");
 
@@ -289,6 +434,9 @@ SioxImage Siox::extractForeground(SioxImage const &originalImage, uint32_t backg
     pixelCount = width * height;
     image      = workImage.getImageData();
     cm         = workImage.getConfidenceData();
+    imageLab   = labData.data();
+
+    assert(labData.size() == static_cast<std::size_t>(pixelCount));
 
     // Create labelField.
     auto labelField_storage = std::make_unique<int[]>(pixelCount);
@@ -298,16 +446,12 @@ SioxImage Siox::extractForeground(SioxImage const &originalImage, uint32_t backg
 
     // Create color signatures.
     std::vector<CieLab> knownBg, knownFg;
-    auto imageClab = std::make_unique<CieLab[]>(pixelCount);
     for (int i = 0; i < pixelCount; i++) {
         float conf = cm[i];
-        uint32_t pix = image[i];
-        CieLab lab = pix;
-        imageClab[i] = lab;
         if (conf <= BACKGROUND_CONFIDENCE) {
-            knownBg.emplace_back(lab);
+            knownBg.emplace_back(imageLab[i]);
         } else if (conf >= FOREGROUND_CONFIDENCE) {
-            knownFg.emplace_back(lab);
+            knownFg.emplace_back(imageLab[i]);
         }
     }
 
@@ -334,63 +478,69 @@ SioxImage Siox::extractForeground(SioxImage const &originalImage, uint32_t backg
     progress->report_or_throw(0.3);
 
     // classify using color signatures,
-    // classification cached in hashmap for drb and speedup purposes
+    // classification done once per distinct color for drb and speedup purposes
     trace("### Analyzing image");
 
-    std::unordered_map<uint32_t, bool> hs;
+    auto const bgTree = SignatureTree(std::move(bgSignature));
+    auto const fgTree = SignatureTree(std::move(fgSignature));
 
-    int progressResolution = pixelCount / 10;
+    std::unordered_map<uint32_t, int> colorSlots;
+    std::vector<int> pixelSlots(pixelCount, -1);
+    std::vector<CieLab const *> slotColors;
 
     for (int i = 0; i < pixelCount; i++) {
-        if (i % progressResolution == 0) {
-            progress->report_or_throw(0.3 + 0.6 * i / pixelCount);
-        }
-
         if (cm[i] >= FOREGROUND_CONFIDENCE) {
             cm[i] = CERTAIN_FOREGROUND_CONFIDENCE;
         } else if (cm[i] <= BACKGROUND_CONFIDENCE) {
             cm[i] = CERTAIN_BACKGROUND_CONFIDENCE;
         } else { // somewhere in between
-            auto [it, inserted] = hs.emplace(image[i], false);
+            auto [it, inserted] = colorSlots.emplace(image[i], slotColors.size());
             if (inserted) {
-                auto const &lab = imageClab[i];
+                slotColors.emplace_back(&imageLab[i]);
+            }
+            pixelSlots[i] = it->second;
+        }
+    }
 
-                float minBg = std::numeric_limits<float>::max();
-                for (auto const &s : bgSignature) {
-                    minBg = std::min(minBg, CieLab::diffSq(lab, s));
-                }
+    colorSlots.clear();
 
-                float minFg;
-                if (fgSignature.empty()) {
-                    minFg = clusterSize;
-                } else {
-                    minFg = std::numeric_limits<float>::max();
-                    for (auto const &s : fgSignature) {
-                        minFg = std::min(minFg, CieLab::diffSq(lab, s));
-                    }
-                }
+    int const slotCount = slotColors.size();
+    std::vector<unsigned char> slotIsBackground(slotCount);
+    int constexpr chunk = 4096;
 
-                it->second = minBg < minFg;
-            }
+    for (int begin = 0; begin < slotCount; begin += chunk) {
+        progress->report_or_throw(0.3 + 0.6 * begin / slotCount);
+
+        int const end = std::min(slotCount, begin + chunk);
+        Util::parallel_for(end - begin, nthreads, [&] (std::size_t i) {
+            int const slot = begin + i;
+            auto const &lab = *slotColors[slot];
+            float minBg = bgTree.nearestSq(lab);
+            float minFg = fgTree.empty() ? clusterSize : fgTree.nearestSq(lab);
+            slotIsBackground[slot] = minBg < minFg;
+        });
+    }
 
-            bool isBackground = it->second;
+    for (int i = 0; i < pixelCount; i++) {
+        if (pixelSlots[i] != -1) {
+            bool isBackground = slotIsBackground[pixelSlots[i]];
             cm[i] = isBackground ? CERTAIN_BACKGROUND_CONFIDENCE : CERTAIN_FOREGROUND_CONFIDENCE;
         }
     }
 
-    hs.clear();
-    imageClab.reset();
+    pixelSlots.clear();
+    slotColors.clear();
 
     trace("### postProcessing");
 
     // Postprocessing
-    smooth(cm, width, height, 0.333f, 0.333f, 0.333f); // average
+    smooth(cm, width, height, nthreads, 0.333f, 0.333f, 0.333f); // average
     normalizeMatrix(cm, pixelCount);
-    erode(cm, width, height);
+    erode(cm, width, height, nthreads);
     keepOnlyLargeComponents(UNKNOWN_REGION_CONFIDENCE, 1.0/*sizeFactorToKeep*/);
 
     // for (int i = 0; i < 2/*smoothness*/; i++)
-    //     smooth(cm, width, height, 0.333f, 0.333f, 0.333f); // average
+    //     smooth(cm, width, height, nthreads, 0.333f, 0.333f, 0.333f); // average
 
     normalizeMatrix(cm, pixelCount);
 
@@ -402,7 +552,7 @@ SioxImage Siox::extractForeground(SioxImage const &originalImage, uint32_t backg
 
     keepOnlyLargeComponents(UNKNOWN_REGION_CONFIDENCE, 1.5/*sizeFactorToKeep*/);
     fillColorRegions();
-    dilate(cm, width, height);
+    dilate(cm, width, height, nthreads);
 
     progress->report_or_throw(1.0);
 
@@ -413,6 +563,8 @@ SioxImage Siox::extractForeground(SioxImage const &originalImage, uint32_t backg
         }
     }
 
+    imageLab = nullptr;
+
     trace("### Done");
     return workImage;
 }
@@ -720,7 +872,7 @@ void Siox::fillColorRegions()
             continue; // already visited or bg
         }
 
-        uint32_t origColor = image[i];
+        auto const &origColor = imageLab[i];
         int curLabel       = i+1;
         labelField[i]      = curLabel;
         cm[i]              = CERTAIN_FOREGROUND_CONFIDENCE;
@@ -735,28 +887,28 @@ void Siox::fillColorRegions()
             int y = pos / width;
             // check all four neighbours
             int left = pos - 1;
-            if (x - 1 >= 0 && labelField[left] == -1 && CieLab::diff(image[left], origColor) < 1.0) {
+            if (x - 1 >= 0 && labelField[left] == -1 && CieLab::diffSq(imageLab[left], origColor) < 1.0) {
                 labelField[left] = curLabel;
                 cm[left] = CERTAIN_FOREGROUND_CONFIDENCE;
                 // ++componentSize;
                 pixelsToVisit.emplace_back(left);
             }
             int right = pos + 1;
-            if (x + 1 < width && labelField[right] == -1 && CieLab::diff(image[right], origColor) < 1.0) {
+            if (x + 1 < width && labelField[right] == -1 && CieLab::diffSq(imageLab[right], origColor) < 1.0) {
                 labelField[right] = curLabel;
                 cm[right] = CERTAIN_FOREGROUND_CONFIDENCE;
                 // ++componentSize;
                 pixelsToVisit.emplace_back(right);
             }
             int top = pos - width;
-            if (y - 1 >= 0 && labelField[top] == -1 && CieLab::diff(image[top], origColor) < 1.0) {
+            if (y - 1 >= 0 && labelField[top] == -1 && CieLab::diffSq(imageLab[top], origColor) < 1.0) {
                 labelField[top] = curLabel;
                 cm[top] = CERTAIN_FOREGROUND_CONFIDENCE;
                 // ++componentSize;
                 pixelsToVisit.emplace_back(top);
             }
             int bottom = pos + width;
-            if (y + 1 < height && labelField[bottom] == -1 && CieLab::diff(image[bottom], origColor) < 1.0) {
+            if (y + 1 < height && labelField[bottom] == -1 && CieLab::diffSq(imageLab[bottom], origColor) < 1.0) {
                 labelField[bottom] = curLabel;
                 cm[bottom] = CERTAIN_FOREGROUND_CONFIDENCE;
                 // ++componentSize;
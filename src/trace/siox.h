@@ -85,6 +85,11 @@ public:
      */
     unsigned hash() const;
 
+    /**
+     * Return a hash of the image contents only, ignoring the confidence map.
+     */
+    unsigned hashPixels() const;
+
 private:
     int width;                     ///< Width of the image
     int height;                    ///< Height of the image
@@ -125,7 +130,10 @@ public:
      */
     static constexpr float CERTAIN_BACKGROUND_CONFIDENCE = 0.0f;
 
-    Siox(Async::Progress<double> &progress);
+    /**
+     * \param nthreads The number of threads to spread the work over; see Util::get_num_threads().
+     */
+    Siox(Async::Progress<double> &progress, int nthreads = 1);
 
     /**
      * Extract the foreground of the original image, according to the values in the confidence matrix.
@@ -136,16 +144,30 @@ public:
      */
     SioxImage extractForeground(SioxImage const &originalImage, uint32_t backgroundFillColor);
 
+    /**
+     * As above, but using a CIELAB conversion of the image previously obtained from convertToLab().
+     * This allows refining the confidence matrix of the same image repeatedly without reconverting it.
+     */
+    SioxImage extractForeground(SioxImage const &originalImage, uint32_t backgroundFillColor,
+                                std::vector<CieLab> const &labData);
+
+    /**
+     * Convert all pixels of an image to CIELAB, on up to \a nthreads threads.
+     */
+    static std::vector<CieLab> convertToLab(SioxImage const &image, int nthreads = 1);
+
     class Exception {};
 
 private:
     Async::Progress<double> *progress;
+    int nthreads;    ///< Number of threads to use
 
     int width;       ///< Width of the image
     int height;      ///< Height of the image
     int pixelCount;  ///< Number of pixels in the image
     uint32_t *image; ///< Working image data
     float *cm;       ///< Working image confidence matrix
+    CieLab const *imageLab; ///< Working image data in CIELAB
 
     /**
      * Markup for image editing
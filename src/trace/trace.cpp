@@ -45,6 +45,7 @@
 #include "object/weakptr.h"
 #include "ui/icon-names.h"
 #include "ui/dialog-run.h"
+#include "util/parallel.h"
 
 namespace Inkscape::Trace {
 namespace {
@@ -196,17 +197,21 @@ public:
         return instance;
     }
 
-    Glib::RefPtr<Gdk::Pixbuf> process(SioxImage const &sioximage, Async::Progress<double> &progress) const;
+    Glib::RefPtr<Gdk::Pixbuf> process(SioxImage const &sioximage, int nthreads, Async::Progress<double> &progress) const;
 
 private:
     mutable std::mutex mutables;
     mutable unsigned last_hash = 0;
     mutable Glib::RefPtr<Gdk::Pixbuf> last_result;
 
+    // The CIELAB conversion only depends on the image, so survives refinements of the selection.
+    mutable unsigned last_pixel_hash = 0;
+    mutable std::vector<CieLab> last_lab;
+
     SioxImageCache() = default;
 };
 
-Glib::RefPtr<Gdk::Pixbuf> SioxImageCache::process(SioxImage const &sioximage, Async::Progress<double> &progress) const
+Glib::RefPtr<Gdk::Pixbuf> SioxImageCache::process(SioxImage const &sioximage, int nthreads, Async::Progress<double> &progress) const
 {
     auto hash = sioximage.hash();
 
@@ -216,7 +221,13 @@ Glib::RefPtr<Gdk::Pixbuf> SioxImageCache::process(SioxImage const &sioximage, As
         return last_result;
     }
 
-    auto result = Siox(progress).extractForeground(sioximage, 0xffffff);
+    auto pixel_hash = sioximage.hashPixels();
+    if (pixel_hash != last_pixel_hash || last_lab.size() != static_cast<std::size_t>(sioximage.getWidth() * sioximage.getHeight())) {
+        last_lab = Siox::convertToLab(sioximage, nthreads);
+        last_pixel_hash = pixel_hash;
+    }
+
+    auto result = Siox(progress, nthreads).extractForeground(sioximage, 0xffffff, last_lab);
 
     // result.writePPM("siox2.ppm");
 
@@ -226,7 +237,7 @@ Glib::RefPtr<Gdk::Pixbuf> SioxImageCache::process(SioxImage const &sioximage, As
     return last_result;
 }
 
-Glib::RefPtr<Gdk::Pixbuf> sioxProcessImage(Glib::RefPtr<Gdk::Pixbuf> pixbuf, Cairo::RefPtr<Cairo::ImageSurface> siox_mask, Async::Progress<double> &progress)
+Glib::RefPtr<Gdk::Pixbuf> sioxProcessImage(Glib::RefPtr<Gdk::Pixbuf> pixbuf, Cairo::RefPtr<Cairo::ImageSurface> siox_mask, int nthreads, Async::Progress<double> &progress)
 {
     // Copy the pixbuf into the siox image.
     auto sioximage = SioxImage(pixbuf);
@@ -252,7 +263,7 @@ Glib::RefPtr<Gdk::Pixbuf> sioxProcessImage(Glib::RefPtr<Gdk::Pixbuf> pixbuf, Cai
     tmp.writePPM("/tmp/x1.ppm");*/
 
     // Process or retrieve from cache.
-    return SioxImageCache::get().process(sioximage, progress);
+    return SioxImageCache::get().process(sioximage, nthreads, progress);
 }
 
 } // namespace
@@ -320,6 +331,7 @@ private:
     std::shared_ptr<Inkscape::Pixbuf const> image_pixbuf;
     Geom::Affine image_transform;
     Cairo::RefPtr<Cairo::ImageSurface> siox_mask;
+    int nthreads = 1; // Read on the main thread, since the preferences are not thread-safe.
     Async::Channel::Source channel;
 
     TraceResult traceresult;
@@ -377,6 +389,7 @@ TraceFuture TraceTask::launch(std::unique_ptr<TraceTask> self)
 
     if (sioxEnabled) {
         siox_mask = rasterizeItems(imageanditems->second, image_transform, dimensions(*image_pixbuf));
+        nthreads = Util::get_num_threads();
     }
 
     if (type == Type::Trace) log(Inkscape::NORMAL_MESSAGE, _("Trace: Starting trace..."));
@@ -420,7 +433,7 @@ void TraceTask::do_async_work(std::unique_ptr<TraceTask> self)
 
         // If SIOX has been enabled, run SIOX processing.
         if (sioxEnabled) {
-            gdkpixbuf = sioxProcessImage(gdkpixbuf, siox_mask, *sub_siox);
+            gdkpixbuf = sioxProcessImage(gdkpixbuf, siox_mask, nthreads, *sub_siox);
             siox_mask.reset();
             sub_siox->report_or_throw(1.0);
         }
@@ -2639,6 +2639,10 @@ void InkscapePreferences::initPageBehavior()
                                _("If possible, apply transformation to objects without adding a transform= attribute"));
     _page_transforms.add_line( true, "", _trans_preserved, "",
                                _("Always store transformation as a transform= attribute on objects"));
+    _page_transforms.add_group_header( _("Dragging"));
+    _trans_proxy_threshold.init("/options/transform/proxythreshold", 0, 1000000, 100, 1000, 5000, true, false);
+    _page_transforms.add_line( true, _("Drag a snapshot above complexity:"), _trans_proxy_threshold, "",
+                               _("When the selection contains at least this many drawing elements, drag a bitmap snapshot of it and only transform the objects on release (0 to always transform live)"), false);
     
     this->AddPage(_page_transforms, _("Transforms"), iter_behavior, PREFS_PAGE_BEHAVIOR_TRANSFORMS);
 
@@ -2978,6 +2982,9 @@ void InkscapePreferences::initPageRendering()
     _page_rendering.add_line(false, "", _cairo_dithering, "",  _("Makes gradients smoother. This can significantly impact the size of generated PNG files."));
 #endif
 
+    _precise_linear_rgb.init(_("Round linearRGB filter conversions"), "/options/rendering/preciselinearrgb", false);
+    _page_rendering.add_line(false, "", _precise_linear_rgb, "", _("Round rather than truncate colors converted to and from linearRGB in filters. Reduces banding and darkening, but changes the output of existing filters slightly."));
+
     auto const grid = Gtk::make_managed<Gtk::Grid>();
     grid->set_margin(12);
     grid->set_orientation(Gtk::Orientation::VERTICAL);
@@ -356,6 +356,7 @@ protected:
     UI::Widget::PrefRadioButton _filter_quality_normal;
     UI::Widget::PrefRadioButton _filter_quality_worse;
     UI::Widget::PrefRadioButton _filter_quality_worst;
+    UI::Widget::PrefCheckButton _precise_linear_rgb;
 #if CAIRO_VERSION >= CAIRO_VERSION_ENCODE(1, 18, 0)
     UI::Widget::PrefCheckButton _cairo_dithering;
 #endif
@@ -390,6 +391,7 @@ protected:
     UI::Widget::PrefCheckButton _trans_dash_scale;
     UI::Widget::PrefRadioButton _trans_optimized;
     UI::Widget::PrefRadioButton _trans_preserved;
+    UI::Widget::PrefSpinButton _trans_proxy_threshold;
 
     UI::Widget::PrefRadioButton _sel_all;
     UI::Widget::PrefRadioButton _sel_current;
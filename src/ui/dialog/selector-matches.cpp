@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * @brief Cache of the objects matched by CSS selectors, shared by the Style and Selectors dialogs.
+ *
+ * Authors: see git history
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "selector-matches.h"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "document.h"
+#include "object/sp-object.h"
+#include "xml/href-attribute-helper.h"
+#include "xml/node.h"
+
+namespace Inkscape::UI::Dialog {
+
+static bool is_name_char(char c)
+{
+    return g_ascii_isalnum(c) || c == '-' || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+/**
+ * Whether the selector has an id or class simple selector for the name, e.g. "#name" or ".name".
+ */
+static bool selector_names(std::string const &selector, char prefix, std::string const &name)
+{
+    auto const token = prefix + name;
+    for (auto pos = selector.find(token); pos != std::string::npos; pos = selector.find(token, pos + 1)) {
+        auto const end = pos + token.size();
+        if (end == selector.size() || !is_name_char(selector[end])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::set<std::string> class_names(char const *value)
+{
+    std::set<std::string> result;
+    std::istringstream stream(value ? value : "");
+    for (std::string name; stream >> name;) {
+        result.insert(std::move(name));
+    }
+    return result;
+}
+
+/**
+ * The comma separated parts of a selector list, without surrounding whitespace.
+ */
+static std::vector<std::string> selector_parts(std::string const &selector)
+{
+    std::vector<std::string> parts;
+    std::istringstream stream(selector);
+    for (std::string part; std::getline(stream, part, ',');) {
+        auto const begin = part.find_first_not_of(" \t\r\n");
+        auto const end = part.find_last_not_of(" \t\r\n");
+        if (begin != std::string::npos) {
+            parts.push_back(part.substr(begin, end - begin + 1));
+        }
+    }
+    return parts;
+}
+
+/**
+ * Whether the selector may match an element because of the elements around it rather than just
+ * the element itself: it has a combinator, a pseudo-class or a universal selector.
+ */
+static bool is_structural(std::string const &selector)
+{
+    auto const parts = selector_parts(selector);
+    return std::any_of(parts.begin(), parts.end(), [] (auto const &part) {
+        return part.find_first_of(" \t\r\n>+~:*") != std::string::npos;
+    });
+}
+
+/**
+ * Whether one of the compound selectors in the list starts with the element name, e.g. "rect.name".
+ */
+static bool selector_names_element(std::string const &selector, std::string const &element)
+{
+    auto const parts = selector_parts(selector);
+    return std::any_of(parts.begin(), parts.end(), [&] (auto const &part) {
+        return part.compare(0, element.size(), element) == 0 &&
+               (part.size() == element.size() || !is_name_char(part[element.size()]));
+    });
+}
+
+std::vector<SPObject *> SelectorMatches::get(SPDocument const &document, Glib::ustring const &selector)
+{
+    if (selector.find_first_of("[\\") != Glib::ustring::npos) {
+        return document.getObjectsBySelector(selector);
+    }
+    auto it = _matches.find(selector);
+    if (it == _matches.end()) {
+        it = _matches.emplace(selector, document.getObjectsBySelector(selector)).first;
+        for (auto object : it->second) {
+            auto &connection = _release_connections[object];
+            if (!connection) {
+                connection = object->connectRelease([this] (SPObject *released) { _objectReleased(released); });
+            }
+        }
+    }
+    return it->second;
+}
+
+/**
+ * Whether a clone in the document refers to one of the ids.
+ */
+static bool is_referenced_by_clone(SPDocument const &document, std::vector<std::string> const &ids)
+{
+    auto const clones = document.getObjectsByElement("use");
+    return std::any_of(clones.begin(), clones.end(), [&] (SPObject const *clone) {
+        auto const href = Inkscape::getHrefAttribute(*clone->getRepr()).second;
+        return href && href[0] == '#' && std::find(ids.begin(), ids.end(), href + 1) != ids.end();
+    });
+}
+
+void SelectorMatches::nodeAdded(XML::Node const &node)
+{
+    std::set<std::string> elements, ids, classes;
+    bool clones = false;
+    auto collect = [&] (auto &self, XML::Node const &n) -> void {
+        if (n.type() != XML::NodeType::ELEMENT_NODE) {
+            return;
+        }
+        // Selectors name elements without their namespace prefix.
+        std::string name = n.name();
+        elements.insert(name.substr(name.find(':') + 1));
+        clones = clones || name == "svg:use";
+        if (auto id = n.attribute("id")) {
+            ids.insert(id);
+        }
+        classes.merge(class_names(n.attribute("class")));
+        for (auto child = n.firstChild(); child; child = child->next()) {
+            self(self, *child);
+        }
+    };
+    collect(collect, node);
+
+    // A new clone adds copies of its original, which any selector may match.
+    if (clones) {
+        clear();
+        return;
+    }
+
+    std::erase_if(_matches, [&] (auto const &entry) {
+        auto const &selector = entry.first.raw();
+        return is_structural(selector) ||
+               std::any_of(elements.begin(), elements.end(), [&] (auto const &element) {
+                   return selector_names_element(selector, element);
+               }) ||
+               std::any_of(ids.begin(), ids.end(), [&] (auto const &id) {
+                   return selector_names(selector, '#', id);
+               }) ||
+               std::any_of(classes.begin(), classes.end(), [&] (auto const &name) {
+                   return selector_names(selector, '.', name);
+               });
+    });
+}
+
+void SelectorMatches::clear()
+{
+    _matches.clear();
+    _release_connections.clear();
+}
+
+void SelectorMatches::_forgetStructural()
+{
+    std::erase_if(_matches, [] (auto const &entry) { return is_structural(entry.first.raw()); });
+}
+
+void SelectorMatches::_objectReleased(SPObject *object)
+{
+    if (object->cloned) {
+        // The clone is being rebuilt, and its new children may match any selector.
+        clear();
+        _signal_released.emit();
+        return;
+    }
+
+    auto const erased = std::erase_if(_matches, [object] (auto const &entry) {
+        return std::find(entry.second.begin(), entry.second.end(), object) != entry.second.end();
+    });
+    _release_connections.erase(object);
+    if (erased) {
+        _signal_released.emit();
+    }
+}
+
+void SelectorMatches::attributeChanged(SPDocument const &document, GQuark name, char const *old_value,
+                                       char const *new_value)
+{
+    static GQuark const CODE_id = g_quark_from_static_string("id");
+    static GQuark const CODE_class = g_quark_from_static_string("class");
+    static GQuark const CODE_href = g_quark_from_static_string("href");
+    static GQuark const CODE_xlink_href = g_quark_from_static_string("xlink:href");
+
+    if (name == CODE_href || name == CODE_xlink_href) {
+        // A clone whose original changes gets new children, which any selector may match.
+        clear();
+        return;
+    }
+
+    char prefix;
+    std::vector<std::string> changed;
+    if (name == CODE_id) {
+        prefix = '#';
+        for (auto value : {old_value, new_value}) {
+            if (value) {
+                changed.emplace_back(value);
+            }
+        }
+        // A clone referring to the id gains or loses its children, which any selector may match.
+        if (is_referenced_by_clone(document, changed)) {
+            clear();
+            return;
+        }
+    } else if (name == CODE_class) {
+        // Only the classes added or removed matter, not the ones the element keeps.
+        prefix = '.';
+        auto const before = class_names(old_value);
+        auto const after = class_names(new_value);
+        std::set_symmetric_difference(before.begin(), before.end(), after.begin(), after.end(),
+                                      std::back_inserter(changed));
+    } else {
+        return;
+    }
+
+    std::erase_if(_matches, [&] (auto const &entry) {
+        return std::any_of(changed.begin(), changed.end(), [&] (auto const &changed_name) {
+            return selector_names(entry.first.raw(), prefix, changed_name);
+        });
+    });
+}
+
+} // namespace Inkscape::UI::Dialog
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
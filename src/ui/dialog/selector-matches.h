@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * @brief Cache of the objects matched by CSS selectors, shared by the Style and Selectors dialogs.
+ *
+ * Authors: see git history
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_UI_DIALOG_SELECTOR_MATCHES_H
+#define SEEN_UI_DIALOG_SELECTOR_MATCHES_H
+
+#include <map>
+#include <vector>
+
+#include <glib.h>
+#include <glibmm/ustring.h>
+#include <sigc++/signal.h>
+
+#include "helper/auto-connection.h"
+
+class SPDocument;
+class SPObject;
+
+namespace Inkscape::XML {
+class Node;
+} // namespace Inkscape::XML
+
+namespace Inkscape::UI::Dialog {
+
+/**
+ * The objects matched by CSS selectors, kept until a change to the document may alter them.
+ *
+ * Besides the document structure, selectors only depend on the id and class attributes, which
+ * the dialogs watch. Selectors with attribute conditions or escapes are never kept.
+ *
+ * Objects can also be released without any XML node being removed, e.g. the children of a clone
+ * when its original changes. The selectors matching a released object are forgotten as well, and
+ * signal_released() is emitted so that the dialog can drop any other reference to it. Everything
+ * is forgotten when a clone is added, rebuilt or pointed elsewhere, as its new children may match
+ * any selector, and when an id that a clone refers to changes, as the clone may start or stop
+ * resolving its reference.
+ */
+class SelectorMatches
+{
+public:
+    std::vector<SPObject *> get(SPDocument const &document, Glib::ustring const &selector);
+    bool contains(Glib::ustring const &selector) const { return _matches.count(selector); }
+
+    /// Forget the selectors naming an id or class that was added or removed, or everything if
+    /// the reference of a clone or an id it refers to changed.
+    void attributeChanged(SPDocument const &document, GQuark name, char const *old_value,
+                          char const *new_value);
+    /// Forget the selectors that may match the node or one of its descendants.
+    void nodeAdded(XML::Node const &node);
+    /// Forget the selectors depending on the position of nodes. The matches of the removed
+    /// objects themselves go when they are released.
+    void nodeRemoved() { _forgetStructural(); }
+    /// Forget the selectors depending on the position of nodes.
+    void nodeReordered() { _forgetStructural(); }
+    /// Forget everything.
+    void clear();
+
+    /// Emitted after forgetting the selectors matching an object that is being released.
+    sigc::signal<void ()> &signal_released() { return _signal_released; }
+
+private:
+    void _forgetStructural();
+    void _objectReleased(SPObject *object);
+
+    std::map<Glib::ustring, std::vector<SPObject *>> _matches;
+    std::map<SPObject *, auto_connection> _release_connections;
+    sigc::signal<void ()> _signal_released;
+};
+
+} // namespace Inkscape::UI::Dialog
+
+#endif // SEEN_UI_DIALOG_SELECTOR_MATCHES_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
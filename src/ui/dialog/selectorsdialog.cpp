@@ -16,10 +16,12 @@
 #include "selectorsdialog.h"
 
 #include <algorithm>
+#include <cstring>
 #include <map>
 #include <string>
 #include <utility>
 #include <glibmm/i18n.h>
+#include <glibmm/main.h>
 #include <glibmm/regex.h>
 #include <gtkmm/adjustment.h>
 #include <gtkmm/dialog.h>
@@ -79,10 +81,7 @@ void SelectorsDialog::NodeObserver::notifyContentChanged(Inkscape::XML::Node &,
                                                          Inkscape::Util::ptr_shared)
 {
     g_debug("SelectorsDialog::NodeObserver::notifyContentChanged");
-    _selectorsdialog->_scrollock = true;
-    _selectorsdialog->_updating = false;
-    _selectorsdialog->_readStyleElement();
-    _selectorsdialog->_selectRow();
+    _selectorsdialog->_queueRefresh();
 }
 
 // Keeps a watch for new/removed/changed nodes
@@ -110,16 +109,28 @@ public:
         _selectorsdialog->_nodeRemoved(child);
     }
 
+    void notifyChildOrderChanged(Inkscape::XML::Node &,
+                                 Inkscape::XML::Node &child,
+                                 Inkscape::XML::Node *,
+                                 Inkscape::XML::Node *) override
+    {
+        _selectorsdialog->_nodeReordered(child);
+    }
+
     void notifyAttributeChanged(Inkscape::XML::Node &node,
                                 GQuark qname,
-                                Util::ptr_shared,
-                                Util::ptr_shared) override
+                                Util::ptr_shared old_value,
+                                Util::ptr_shared new_value) override
     {
         static GQuark const CODE_id = g_quark_from_static_string("id");
         static GQuark const CODE_class = g_quark_from_static_string("class");
+        static GQuark const CODE_href = g_quark_from_static_string("href");
+        static GQuark const CODE_xlink_href = g_quark_from_static_string("xlink:href");
 
-        if (qname == CODE_id || qname == CODE_class) {
-            _selectorsdialog->_nodeChanged(node);
+        // A clone pointed elsewhere gets new children, which selectors may match.
+        bool const clone_href = (qname == CODE_href || qname == CODE_xlink_href) && !std::strcmp(node.name(), "svg:use");
+        if (qname == CODE_id || qname == CODE_class || clone_href) {
+            _selectorsdialog->_nodeChanged(node, qname, old_value, new_value);
         }
     }
 
@@ -128,8 +139,8 @@ public:
 
 void SelectorsDialog::_nodeAdded(Inkscape::XML::Node &node)
 {
-    _readStyleElement();
-    _selectRow();
+    _matches.nodeAdded(node);
+    _queueRefresh();
 }
 
 void SelectorsDialog::_nodeRemoved(Inkscape::XML::Node &repr)
@@ -138,17 +149,100 @@ void SelectorsDialog::_nodeRemoved(Inkscape::XML::Node &repr)
         _textNode = nullptr;
     }
 
-    _readStyleElement();
-    _selectRow();
+    _matches.nodeRemoved();
+    _queueRefresh();
 }
 
-void SelectorsDialog::_nodeChanged(Inkscape::XML::Node &object)
+void SelectorsDialog::_nodeReordered(Inkscape::XML::Node &)
 {
+    _matches.nodeReordered();
+    _queueRefresh();
+}
+
+void SelectorsDialog::_nodeChanged(Inkscape::XML::Node &object, GQuark name, char const *old_value,
+                                   char const *new_value)
+{
+    static GQuark const CODE_id = g_quark_from_static_string("id");
+
     g_debug("SelectorsDialog::NodeChanged");
 
+    if (auto document = getDocument()) {
+        _matches.attributeChanged(*document, name, old_value, new_value);
+    } else {
+        _matches.clear();
+    }
+    if (name == CODE_id) {
+        // The rows of the objects are labelled with their id.
+        if (auto document = getDocument()) {
+            if (auto obj = document->getObjectByRepr(&object)) {
+                _renamed.push_back(obj);
+            }
+        }
+    }
+    _queueRefresh();
+}
+
+/**
+ * Refresh once the current batch of changes is over, rather than after each of them.
+ */
+void SelectorsDialog::_queueRefresh()
+{
+    if (_idle_refresh) {
+        return;
+    }
+    _idle_refresh = Glib::signal_idle().connect([this] {
+        _refresh();
+        return false;
+    });
+}
+
+/**
+ * Bring the tree up to date with the document. Unless the style element changed, only the objects
+ * of the selectors whose matches may have changed are listed again, i.e. those no longer in the
+ * cache and those matching a renamed object.
+ */
+void SelectorsDialog::_refresh()
+{
+    g_debug("SelectorsDialog::_refresh");
+
+    _idle_refresh.disconnect();
+    if (!getDesktop()) return;
     _scrollock = true;
 
-    _readStyleElement();
+    auto const textNode = _getStyleTextNode();
+    if (_content != ((textNode && textNode->content()) ? textNode->content() : "")) {
+        _readStyleElement();
+        _selectRow();
+        return;
+    }
+
+    if (_updating) return;
+    _updating = true;
+
+    std::sort(_renamed.begin(), _renamed.end());
+    for (auto &&row : _store->children()) {
+        if (row[_mColumns._colType] != SELECTOR) {
+            continue;
+        }
+        Glib::ustring const selector = row[_mColumns._colSelector];
+        bool stale = !_matches.contains(selector);
+        auto const objects = _getObjVec(selector);
+        stale = stale || std::any_of(objects.begin(), objects.end(), [this] (auto obj) {
+            return std::binary_search(_renamed.begin(), _renamed.end(), obj);
+        });
+        if (!stale) {
+            continue;
+        }
+
+        auto children = row.children();
+        while (!children.empty()) {
+            _store->erase(children.begin());
+        }
+        _addObjectRows(row, objects);
+    }
+    _renamed.clear();
+
+    _updating = false;
     _selectRow();
 }
 
@@ -218,6 +312,7 @@ SelectorsDialog::SelectorsDialog()
 
     m_nodewatcher = std::make_unique<NodeWatcher>(this);
     m_styletextwatcher = std::make_unique<NodeObserver>(this);
+    _matches.signal_released().connect([this] { _queueRefresh(); });
 
     // Tree
     auto const addRenderer = Gtk::make_managed<UI::Widget::IconRenderer>();
@@ -383,10 +478,13 @@ void SelectorsDialog::_readStyleElement()
     if (_updating) return; // Don't read if we wrote style element.
     _updating = true;
     _scrollock = true;
+    _idle_refresh.disconnect();
+    _renamed.clear();
     Inkscape::XML::Node * textNode = _getStyleTextNode();
 
     // Get content from style text node.
     std::string content = (textNode && textNode->content()) ? textNode->content() : "";
+    _content = content;
 
     // Remove end-of-lines (check it works on Windoze).
     content.erase(std::remove(content.begin(), content.end(), '\n'), content.end());
@@ -486,20 +584,7 @@ void SelectorsDialog::_readStyleElement()
         row[_mColumns._colSelected] = 400;
 
         // Add as children, objects that match selector.
-        for (auto const &obj : _getObjVec(selector)) {
-            auto const id = obj->getId();
-            if (!id)
-                continue;
-
-            auto childrow = *_store->append(row.children());
-            childrow[_mColumns._colSelector] = "#" + Glib::ustring(id);
-            childrow[_mColumns._colExpand] = false;
-            childrow[_mColumns._colType] = colType == OBJECT;
-            childrow[_mColumns._colObj] = obj;
-            childrow[_mColumns._colProperties] = ""; // Unused
-            childrow[_mColumns._colVisible] = true;  // Unused
-            childrow[_mColumns._colSelected] = 400;
-        }
+        _addObjectRows(row, _getObjVec(selector));
     }
 
     _updating = false;
@@ -841,7 +926,7 @@ std::vector<SPObject *> SelectorsDialog::_getObjVec(Glib::ustring selector)
 
     g_assert(selector.find(";") == Glib::ustring::npos);
 
-    return getDesktop()->getDocument()->getObjectsBySelector(selector);
+    return _matches.get(*getDesktop()->getDocument(), selector);
 }
 
 /**
@@ -1230,6 +1315,27 @@ private:
     Glib::ustring _attrValue;
 };
 
+/**
+ * Add the rows of the objects a selector matches under the row of the selector.
+ */
+void SelectorsDialog::_addObjectRows(Gtk::TreeModel::Row row, std::vector<SPObject *> const &objects)
+{
+    for (auto const &obj : objects) {
+        auto const id = obj->getId();
+        if (!id)
+            continue;
+
+        auto childrow = *_store->append(row.children());
+        childrow[_mColumns._colSelector] = "#" + Glib::ustring(id);
+        childrow[_mColumns._colExpand] = false;
+        childrow[_mColumns._colType] = OBJECT;
+        childrow[_mColumns._colObj] = obj;
+        childrow[_mColumns._colProperties] = ""; // Unused
+        childrow[_mColumns._colVisible] = true;  // Unused
+        childrow[_mColumns._colSelected] = 400;
+    }
+}
+
 // -------------------------------------------------------------------
 
 SelectorsDialog::~SelectorsDialog()
@@ -1263,6 +1369,7 @@ void SelectorsDialog::removeObservers()
 void SelectorsDialog::documentReplaced()
 {
     removeObservers();
+    _matches.clear();
     if (auto document = getDocument()) {
         m_root = document->getReprRoot();
         m_root->addSubtreeObserver(*m_nodewatcher);
@@ -1323,7 +1430,7 @@ void SelectorsDialog::_selectRow()
     std::sort(selected_objs.begin(), selected_objs.end());
 
     for (auto &&row : children) {
-        // Recalculate the selector, in real time.
+        // Objects the selector matches, kept until a change to the document may alter them.
         auto row_children = _getObjVec(row[_mColumns._colSelector]);
         std::sort(row_children.begin(), row_children.end());
 
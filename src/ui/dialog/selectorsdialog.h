@@ -17,6 +17,7 @@
 #define SELECTORSDIALOG_H
 
 #include <memory>
+#include <string>
 #include <vector>
 #include <glibmm/refptr.h>
 #include <gtkmm/box.h>
@@ -28,7 +29,9 @@
 #include <gtkmm/treestore.h>
 #include <gtkmm/treeview.h>
 
+#include "helper/auto-connection.h"
 #include "ui/dialog/dialog-base.h"
+#include "ui/dialog/selector-matches.h"
 #include "xml/helper-observer.h"
 
 namespace Gtk {
@@ -79,7 +82,10 @@ public:
     enum SelectorType { CLASS, ID, TAG };
     void _nodeAdded(   Inkscape::XML::Node &repr );
     void _nodeRemoved( Inkscape::XML::Node &repr );
-    void _nodeChanged( Inkscape::XML::Node &repr );
+    void _nodeReordered( Inkscape::XML::Node &repr );
+    void _nodeChanged( Inkscape::XML::Node &repr, GQuark name, char const *old_value, char const *new_value );
+    void _queueRefresh();
+    void _refresh();
     // Data structure
     enum coltype { OBJECT, SELECTOR, OTHER };
     class ModelColumns : public Gtk::TreeModel::ColumnRecord {
@@ -143,6 +149,7 @@ public:
     Inkscape::XML::Node *_getStyleTextNode(bool create_if_missing = false);
     void _readStyleElement();
     void _writeStyleElement();
+    void _addObjectRows(Gtk::TreeModel::Row row, std::vector<SPObject *> const &objects);
 
     // Update watchers
     std::unique_ptr<Inkscape::XML::NodeObserver> m_nodewatcher;
@@ -154,6 +161,7 @@ public:
     void _removeFromSelector(Gtk::TreeModel::Row row);
     Glib::ustring _getIdList(std::vector<SPObject *>);
     std::vector<SPObject *> _getObjVec(Glib::ustring selector);
+    SelectorMatches _matches;
     void _insertClass(const std::vector<SPObject *>& objVec, const Glib::ustring& className);
     void _insertClass(SPObject *obj, const Glib::ustring &className);
     void _removeClass(const std::vector<SPObject *> &objVec, const Glib::ustring &className, bool all = false);
@@ -168,6 +176,9 @@ public:
     bool _updating{false};          // Prevent cyclic actions: read <-> write, select via dialog <-> via desktop
     Inkscape::XML::Node *m_root{nullptr};
     Inkscape::XML::Node *_textNode{nullptr}; // Track so we know when to add a NodeObserver.
+    std::string _content;                    // Style element content the tree was read from.
+    std::vector<SPObject *> _renamed;        // Objects whose id changed since the tree was updated.
+    auto_connection _idle_refresh;
 
     void _rowExpand(const Gtk::TreeModel::iterator &iter, const Gtk::TreeModel::Path &path);
     void _rowCollapse(const Gtk::TreeModel::iterator &iter, const Gtk::TreeModel::Path &path);
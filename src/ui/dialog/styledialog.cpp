@@ -17,12 +17,15 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <regex>
 #include <string>
 #include <utility>
 
 #include <glibmm/i18n.h>
+#include <glibmm/main.h>
 #include <glibmm/regex.h>
 #include <gdk/gdkkeysyms.h>
 #include <gtkmm/adjustment.h>
@@ -135,6 +138,18 @@ XML::Node *get_first_style_text_node(XML::Node *root, bool create_if_missing)
     return textNode;
 }
 
+/**
+ * Whether a child added to or removed from this node can change which text node
+ * get_first_style_text_node() finds.
+ */
+static bool holds_style_element(XML::Node const &node, XML::Node const *root)
+{
+    static GQuark const CODE_svg_style = g_quark_from_static_string("svg:style");
+    static GQuark const CODE_svg_defs = g_quark_from_static_string("svg:defs");
+
+    return &node == root || node.code() == CODE_svg_defs || node.code() == CODE_svg_style;
+}
+
 // Keeps a watch on style element
 class StyleDialog::NodeObserver : public Inkscape::XML::NodeObserver {
   public:
@@ -157,8 +172,7 @@ void StyleDialog::NodeObserver::notifyContentChanged(Inkscape::XML::Node & /*nod
 {
 
     g_debug("StyleDialog::NodeObserver::notifyContentChanged");
-    _styledialog->_updating = false;
-    _styledialog->readStyleElement();
+    _styledialog->_queueRefresh();
 }
 
 // Keeps a watch for new/removed/changed nodes
@@ -173,41 +187,61 @@ public:
         g_debug("StyleDialog::NodeWatcher: Constructor");
     };
 
-    void notifyChildAdded(Inkscape::XML::Node & /*node*/, Inkscape::XML::Node &child,
+    void notifyChildAdded(Inkscape::XML::Node &node, Inkscape::XML::Node &child,
                           Inkscape::XML::Node * /*prev*/) override
     {
-        _styledialog->_nodeAdded(child);
+        _styledialog->_nodeAdded(node, child);
     }
 
-    void notifyChildRemoved(Inkscape::XML::Node & /*node*/, Inkscape::XML::Node &child,
+    void notifyChildRemoved(Inkscape::XML::Node &node, Inkscape::XML::Node &child,
                             Inkscape::XML::Node * /*prev*/) override
     {
-        _styledialog->_nodeRemoved(child);
+        _styledialog->_nodeRemoved(node, child);
+    }
+
+    void notifyChildOrderChanged(Inkscape::XML::Node &node, Inkscape::XML::Node &child,
+                                 Inkscape::XML::Node * /*old_prev*/, Inkscape::XML::Node * /*new_prev*/) override
+    {
+        _styledialog->_nodeReordered(node, child);
     }
 
-    void notifyAttributeChanged(Inkscape::XML::Node &node, GQuark qname, Util::ptr_shared /*old_value*/,
-                                Util::ptr_shared /*new_value*/) override
+    void notifyAttributeChanged(Inkscape::XML::Node &node, GQuark qname, Util::ptr_shared old_value,
+                                Util::ptr_shared new_value) override
     {
         static GQuark const CODE_id = g_quark_from_static_string("id");
         static GQuark const CODE_class = g_quark_from_static_string("class");
         static GQuark const CODE_style = g_quark_from_static_string("style");
+        static GQuark const CODE_href = g_quark_from_static_string("href");
+        static GQuark const CODE_xlink_href = g_quark_from_static_string("xlink:href");
 
-        if (qname == CODE_id || qname == CODE_class || qname == CODE_style) {
-            _styledialog->_nodeChanged(node);
+        // A clone pointed elsewhere gets new children, which selectors may match.
+        bool const clone_href = (qname == CODE_href || qname == CODE_xlink_href) && !std::strcmp(node.name(), "svg:use");
+        if (qname == CODE_id || qname == CODE_class || qname == CODE_style || clone_href) {
+            _styledialog->_nodeChanged(node, qname, old_value, new_value);
         }
     }
 };
 
-void StyleDialog::_nodeAdded(Inkscape::XML::Node &node)
+/*
+ * The dialog only shows the rules applying to the selected objects. Whether a rule applies to an
+ * object depends on the object, its ancestors and their siblings, so only changes under or next
+ * to these nodes, or to the style element, need a refresh.
+ */
+
+void StyleDialog::_nodeAdded(Inkscape::XML::Node &parent, Inkscape::XML::Node &node)
 {
+    _matches.nodeAdded(node);
     if (!getShowing()) {
         return;
     }
-    readStyleElement();
+    if (_watched.count(&parent) || holds_style_element(parent, m_root)) {
+        _queueRefresh();
+    }
 }
 
-void StyleDialog::_nodeRemoved(Inkscape::XML::Node &repr)
+void StyleDialog::_nodeRemoved(Inkscape::XML::Node &parent, Inkscape::XML::Node &repr)
 {
+    _matches.nodeRemoved();
     if (!getShowing()) {
         return;
     }
@@ -215,16 +249,58 @@ void StyleDialog::_nodeRemoved(Inkscape::XML::Node &repr)
         _textNode = nullptr;
     }
 
-    readStyleElement();
+    if (_watched.count(&parent) || holds_style_element(parent, m_root)) {
+        _queueRefresh();
+    }
 }
 
-void StyleDialog::_nodeChanged(Inkscape::XML::Node &object)
+void StyleDialog::_nodeReordered(Inkscape::XML::Node &parent, Inkscape::XML::Node &)
 {
+    // Selectors like :first-child or "a + b" depend on the order.
+    _matches.nodeReordered();
+    if (!getShowing()) {
+        return;
+    }
+    if (_watched.count(&parent) || holds_style_element(parent, m_root)) {
+        _queueRefresh();
+    }
+}
+
+void StyleDialog::_nodeChanged(Inkscape::XML::Node &object, GQuark name, char const *old_value,
+                               char const *new_value)
+{
+    static GQuark const CODE_id = g_quark_from_static_string("id");
+    static GQuark const CODE_style = g_quark_from_static_string("style");
+
+    if (auto document = getDocument()) {
+        _matches.attributeChanged(*document, name, old_value, new_value);
+    } else {
+        _matches.clear();
+    }
     if (!getShowing()) {
         return;
     }
     g_debug("StyleDialog::_nodeChanged");
-    readStyleElement();
+    // Ids are also looked up for the links in the style properties.
+    bool const relevant = name == CODE_id || _watched.count(&object) ||
+                          (name != CODE_style && object.parent() && _watched.count(object.parent()));
+    if (relevant) {
+        _queueRefresh();
+    }
+}
+
+/**
+ * Refresh once the current batch of changes is over, rather than after each of them.
+ */
+void StyleDialog::_queueRefresh()
+{
+    if (_idle_refresh) {
+        return;
+    }
+    _idle_refresh = Glib::signal_idle().connect([this] {
+        readStyleElement();
+        return false;
+    });
 }
 
 /**
@@ -240,6 +316,12 @@ StyleDialog::StyleDialog()
 {
     g_debug("StyleDialog::StyleDialog");
 
+    _matches.signal_released().connect([this] {
+        if (getShowing()) {
+            _queueRefresh();
+        }
+    });
+
     UI::pack_start(_mainBox, _scrolledWindow, UI::PackOptions::expand_widget);
     _scrolledWindow.set_policy(Gtk::PolicyType::AUTOMATIC, Gtk::PolicyType::AUTOMATIC);
 
@@ -368,6 +450,7 @@ void StyleDialog::readStyleElement()
     auto document = getDocument();
     if (_updating || !document || _deletion)
         return; // Don't read if we wrote style element.
+    _idle_refresh.disconnect();
     _updating = true;
     _scrollock = true;
     Inkscape::XML::Node *textNode = _getStyleTextNode();
@@ -441,6 +524,22 @@ void StyleDialog::readStyleElement()
         }
     }
 
+    _watched.clear();
+    auto const watch = [this] (SPObject const *object) {
+        for (auto node = object->getRepr(); node; node = node->parent()) {
+            if (!_watched.insert(node).second) {
+                break; // Its ancestors are in already.
+            }
+        }
+    };
+    if (obj) {
+        watch(obj);
+    } else {
+        for (auto object : selection->objects()) {
+            watch(object);
+        }
+    }
+
     // Currently selected object's properties set via style element.
     auto builder = create_builder("dialog-css.glade");
     auto css_selector_container = &get_widget<Gtk::Box>     (builder, "CSSSelectorContainer");
@@ -1461,7 +1560,7 @@ std::vector<SPObject *> StyleDialog::_getObjVec(Glib::ustring selector)
 
     g_assert(selector.find(";") == Glib::ustring::npos);
 
-    return getDocument()->getObjectsBySelector(selector);
+    return _matches.get(*getDocument(), selector);
 }
 
 void StyleDialog::_closeDialog(Gtk::Dialog *textDialogPtr) { textDialogPtr->response(Gtk::ResponseType::OK); }
@@ -1486,6 +1585,7 @@ void StyleDialog::removeObservers()
 void StyleDialog::documentReplaced()
 {
     removeObservers();
+    _matches.clear();
     if (auto document = getDocument()) {
         m_root = document->getReprRoot();
         m_root->addSubtreeObserver(*m_nodewatcher);
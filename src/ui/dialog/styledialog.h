@@ -18,6 +18,7 @@
 
 #include <map>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include <glibmm/refptr.h>
@@ -28,7 +29,9 @@
 #include <gtkmm/treemodel.h>
 #include <gtkmm/treepath.h>
 
+#include "helper/auto-connection.h"
 #include "ui/dialog/dialog-base.h"
+#include "ui/dialog/selector-matches.h"
 
 namespace Gtk {
 class Adjustment;
@@ -42,6 +45,7 @@ class TreeViewColumn;
 
 struct SPStyleEnum;
 
+class SPDocument;
 class SPObject;
 
 namespace Inkscape {
@@ -93,9 +97,11 @@ public:
     class NodeObserver;
     // Monitor all objects for addition/removal/attribute change
     class NodeWatcher;
-    void _nodeAdded(Inkscape::XML::Node &repr);
-    void _nodeRemoved(Inkscape::XML::Node &repr);
-    void _nodeChanged(Inkscape::XML::Node &repr);
+    void _nodeAdded(Inkscape::XML::Node &parent, Inkscape::XML::Node &repr);
+    void _nodeRemoved(Inkscape::XML::Node &parent, Inkscape::XML::Node &repr);
+    void _nodeReordered(Inkscape::XML::Node &parent, Inkscape::XML::Node &repr);
+    void _nodeChanged(Inkscape::XML::Node &repr, GQuark name, char const *old_value, char const *new_value);
+    void _queueRefresh();
     void removeObservers();
 
     // Data structure
@@ -189,11 +195,14 @@ public:
     AttrProp parseStyle(Glib::ustring style_string);
     AttrProp _owner_style;
     void _addOwnerStyle(Glib::ustring name, Glib::ustring selector);
+    SelectorMatches _matches;
 
     // Variables
     Inkscape::XML::Node *m_root{nullptr};
     Inkscape::XML::Node *_textNode{nullptr}; // Track so we know when to add a NodeObserver.
     bool _updating{false};                   // Prevent cyclic actions: read <-> write, select via dialog <-> via desktop
+    std::unordered_set<Inkscape::XML::Node const *> _watched; // Shown objects and their ancestors.
+    auto_connection _idle_refresh;
 
     void _closeDialog(Gtk::Dialog *textDialogPtr);
 };
@@ -10,6 +10,8 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <boost/none.hpp>
 #include <gdk/gdkkeysyms.h>
 #include <2geom/transforms.h>
@@ -84,7 +86,7 @@ std::pair<ControlPointSelection::iterator, bool> ControlPointSelection::insert(c
     }
 
     found = _points.insert(x).first;
-    _points_list.push_back(x);
+    _points_list_pos[x] = _points_list.insert(_points_list.end(), x);
 
     x->updateState();
 
@@ -102,7 +104,11 @@ std::pair<ControlPointSelection::iterator, bool> ControlPointSelection::insert(c
 void ControlPointSelection::erase(iterator pos, bool to_update)
 {
     SelectableControlPoint *erased = *pos;
-    _points_list.remove(*pos);
+    auto list_pos = _points_list_pos.find(erased);
+    if (list_pos != _points_list_pos.end()) {
+        _points_list.erase(list_pos->second);
+        _points_list_pos.erase(list_pos);
+    }
     _points.erase(pos);
     erased->updateState();
     if (to_update) {
@@ -140,6 +146,7 @@ void ControlPointSelection::clear()
     std::vector<SelectableControlPoint *> out(begin(), end()); // begin() takes from _points
     _points.clear();
     _points_list.clear();
+    _points_list_pos.clear();
     for (auto erased : out) {
         erased->updateState();
     }
@@ -163,20 +170,34 @@ void ControlPointSelection::selectAll()
 /** Select all points inside the given rectangle (in desktop coordinates). */
 void ControlPointSelection::selectArea(Geom::Path const &path, bool invert)
 {
+    Geom::OptRect area = path.boundsFast();
+    if (!area) {
+        return;
+    }
+
+    // Only the points whose grid cells overlap the bounding box of the area are tested
+    // against the path, so a small rubberband over a huge path stays cheap.
+    _updateIndex();
     std::vector<SelectableControlPoint *> out;
-    for (auto _all_point : _all_points) {
-        if (path.winding(_all_point->position()) % 2 != 0) {
-            if (invert) {
-                erase(_all_point);
-            } else {
-                insert(_all_point, false, false);
+    _visitIndex(*area, [&] (SelectableControlPoint *point) {
+        if (!area->contains(point->position()) || path.winding(point->position()) % 2 == 0) {
+            return;
+        }
+        if (invert) {
+            auto found = _points.find(point);
+            if (found == _points.end()) {
+                return;
             }
-            out.push_back(_all_point);
+            erase(found, false);
+        } else {
+            insert(point, false, false);
         }
-    }
+        out.push_back(point);
+    });
     if (!out.empty()) {
         _update();
-        signal_selection_changed.emit(out, true);
+        // With invert, out holds the points just deselected.
+        signal_selection_changed.emit(out, !invert);
     }
 }
 /** Unselect all selected points and select all unselected points. */
@@ -186,7 +207,7 @@ void ControlPointSelection::invertSelection()
     for (auto _all_point : _all_points) {
         if (_all_point->selected()) {
             in.push_back(_all_point);
-            erase(_all_point); 
+            erase(_points.find(_all_point), false);
         }
         else {
             out.push_back(_all_point);
@@ -203,23 +224,18 @@ void ControlPointSelection::spatialGrow(SelectableControlPoint *origin, int dir)
 {
     bool grow = (dir > 0);
     Geom::Point p = origin->position();
-    double best_dist = grow ? HUGE_VAL : 0;
     SelectableControlPoint *match = nullptr;
-    for (auto _all_point : _all_points) {
-        bool selected = _all_point->selected();
-        if (grow && !selected) {
-            double dist = Geom::distance(_all_point->position(), p);
-            if (dist < best_dist) {
-                best_dist = dist;
-                match = _all_point;
-            }
-        }
-        if (!grow && selected) {
-            double dist = Geom::distance(_all_point->position(), p);
+    if (grow) {
+        match = _nearestUnselected(p);
+    } else {
+        // the farthest selected point can only be among the selected ones
+        double best_dist = 0;
+        for (auto point : _points) {
+            double dist = Geom::distance(point->position(), p);
             // use >= to also deselect the origin node when it's the last one selected
             if (dist >= best_dist) {
                 best_dist = dist;
-                match = _all_point;
+                match = point;
             }
         }
     }
@@ -230,6 +246,20 @@ void ControlPointSelection::spatialGrow(SelectableControlPoint *origin, int dir)
     }
 }
 
+/** Materialize the points inside the area and dematerialize the others. This visits every point,
+ * so it should only be called when the area changes, not on every redraw. */
+void ControlPointSelection::setMaterializeArea(Geom::OptRect const &area)
+{
+    _materialize_area = area;
+    for (auto point : _all_points) {
+        if (_inMaterializeArea(point->position())) {
+            point->materialize();
+        } else {
+            point->dematerialize();
+        }
+    }
+}
+
 /** Transform all selected control points by the given affine transformation. */
 void ControlPointSelection::transform(Geom::Affine const &m)
 {
@@ -481,6 +511,132 @@ void ControlPointSelection::_update()
     }
 }
 
+/** Rebuild the spatial index of all points if any of them was added, removed or moved. */
+void ControlPointSelection::_updateIndex()
+{
+    if (_index_valid) {
+        return;
+    }
+    _index_valid = true;
+    _index_cells.clear();
+    _index_cols = _index_rows = 0;
+
+    Geom::OptRect bounds;
+    for (auto point : _all_points) {
+        Geom::Point p = point->position();
+        if (!bounds) {
+            bounds = Geom::Rect(p, p);
+        } else {
+            bounds->expandTo(p);
+        }
+    }
+    if (!bounds) {
+        return;
+    }
+
+    // Aim for a handful of points per cell, but keep the grid size bounded
+    // so that degenerate layouts (all points on a line) do not explode.
+    constexpr double POINTS_PER_CELL = 4.0;
+    constexpr int MAX_CELLS_PER_SIDE = 1024;
+    double const cells = std::max(1.0, _all_points.size() / POINTS_PER_CELL);
+    double const w = bounds->width(), h = bounds->height();
+    double cell_size = std::sqrt(std::max(w * h, 1e-12) / cells);
+    cell_size = std::max({cell_size, w / MAX_CELLS_PER_SIDE, h / MAX_CELLS_PER_SIDE, 1e-6});
+
+    _index_area = *bounds;
+    _index_cell_size = cell_size;
+    _index_cols = std::clamp(static_cast<int>(w / cell_size) + 1, 1, MAX_CELLS_PER_SIDE);
+    _index_rows = std::clamp(static_cast<int>(h / cell_size) + 1, 1, MAX_CELLS_PER_SIDE);
+    _index_cells.resize(static_cast<std::size_t>(_index_cols) * _index_rows);
+
+    for (auto point : _all_points) {
+        Geom::Point rel = (point->position() - _index_area.min()) / _index_cell_size;
+        int col = std::clamp(static_cast<int>(rel[Geom::X]), 0, _index_cols - 1);
+        int row = std::clamp(static_cast<int>(rel[Geom::Y]), 0, _index_rows - 1);
+        _index_cells[row * _index_cols + col].push_back(point);
+    }
+}
+
+/** Call f for every point whose grid cell overlaps the given area.
+ * The caller has to make sure the index is up to date. */
+template <typename F>
+void ControlPointSelection::_visitIndex(Geom::Rect const &area, F &&f) const
+{
+    if (_index_cells.empty()) {
+        return;
+    }
+    Geom::Point lo = (area.min() - _index_area.min()) / _index_cell_size;
+    Geom::Point hi = (area.max() - _index_area.min()) / _index_cell_size;
+    if (hi[Geom::X] < 0 || hi[Geom::Y] < 0 || lo[Geom::X] >= _index_cols || lo[Geom::Y] >= _index_rows) {
+        return;
+    }
+    int col0 = std::clamp(static_cast<int>(std::floor(lo[Geom::X])), 0, _index_cols - 1);
+    int row0 = std::clamp(static_cast<int>(std::floor(lo[Geom::Y])), 0, _index_rows - 1);
+    int col1 = std::clamp(static_cast<int>(std::floor(hi[Geom::X])), 0, _index_cols - 1);
+    int row1 = std::clamp(static_cast<int>(std::floor(hi[Geom::Y])), 0, _index_rows - 1);
+
+    for (int row = row0; row <= row1; ++row) {
+        for (int col = col0; col <= col1; ++col) {
+            // f may change the selection, but never the set of all points
+            for (auto point : _index_cells[row * _index_cols + col]) {
+                f(point);
+            }
+        }
+    }
+}
+
+/** Find the unselected point closest to p, searching the grid in rings of growing radius. */
+SelectableControlPoint *ControlPointSelection::_nearestUnselected(Geom::Point const &p)
+{
+    _updateIndex();
+    if (_index_cells.empty()) {
+        return nullptr;
+    }
+
+    Geom::Point rel = (p - _index_area.min()) / _index_cell_size;
+    int const pcol = std::clamp(static_cast<int>(std::floor(rel[Geom::X])), 0, _index_cols - 1);
+    int const prow = std::clamp(static_cast<int>(std::floor(rel[Geom::Y])), 0, _index_rows - 1);
+    int const max_ring = std::max(_index_cols, _index_rows);
+
+    double best_dist = HUGE_VAL;
+    SelectableControlPoint *match = nullptr;
+    auto visit_cell = [&] (int col, int row) {
+        if (col < 0 || row < 0 || col >= _index_cols || row >= _index_rows) {
+            return;
+        }
+        for (auto point : _index_cells[row * _index_cols + col]) {
+            if (point->selected()) {
+                continue;
+            }
+            double dist = Geom::distance(point->position(), p);
+            if (dist < best_dist) {
+                best_dist = dist;
+                match = point;
+            }
+        }
+    };
+
+    for (int ring = 0; ring <= max_ring; ++ring) {
+        if (ring == 0) {
+            visit_cell(pcol, prow);
+        } else {
+            for (int i = -ring; i <= ring; ++i) {
+                visit_cell(pcol + i, prow - ring);
+                visit_cell(pcol + i, prow + ring);
+            }
+            for (int i = -ring + 1; i < ring; ++i) {
+                visit_cell(pcol - ring, prow + i);
+                visit_cell(pcol + ring, prow + i);
+            }
+        }
+        // every cell of the next ring is at least this far away
+        if (match && best_dist <= ring * _index_cell_size) {
+            break;
+        }
+    }
+    return match;
+}
+
 void ControlPointSelection::_updateBounds()
 {
     _rot_radius = std::nullopt;
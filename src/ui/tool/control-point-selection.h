@@ -19,6 +19,7 @@
 #include <unordered_set>
 #include <optional>
 #include <cstddef>
+#include <vector>
 #include <sigc++/sigc++.h>
 #include <2geom/forward.h>
 #include <2geom/point.h>
@@ -96,6 +97,12 @@ public:
     void invertSelection();
     void spatialGrow(SelectableControlPoint *origin, int dir);
 
+    /**
+     * Give deferred points a canvas item only inside the given area (in desktop coordinates),
+     * and drop the canvas items of those outside. Without an area, every point has one.
+     */
+    void setMaterializeArea(Geom::OptRect const &area);
+
     bool event(Inkscape::UI::Tools::ToolBase *tool, CanvasEvent const &event) override;
 
     void transform(Geom::Affine const &m);
@@ -116,6 +123,7 @@ public:
     sigc::signal<void ()> signal_update;
     // It turns out that emitting a signal after every point is selected or deselected is not too efficient,
     // so this can be done in a massive group once the selection is finally changed.
+    // The flag tells whether the points were added to the selection (true) or removed from it (false).
     sigc::signal<void (std::vector<SelectableControlPoint *>, bool)> signal_selection_changed;
     sigc::signal<void (CommitEvent)> signal_commit;
 
@@ -138,6 +146,12 @@ private:
     void _update();
     void _updateTransformHandles(bool preserve_center);
     void _updateBounds();
+    void _invalidateIndex() { _index_valid = false; }
+    void _updateIndex();
+    template <typename F>
+    void _visitIndex(Geom::Rect const &area, F &&f) const;
+    SelectableControlPoint *_nearestUnselected(Geom::Point const &p);
+    bool _inMaterializeArea(Geom::Point const &p) const { return !_materialize_area || _materialize_area->contains(p); }
     bool _keyboardMove(KeyPressEvent const &, Geom::Point const &);
     bool _keyboardRotate(KeyPressEvent const &, int);
     bool _keyboardScale(KeyPressEvent const &, int);
@@ -149,6 +163,19 @@ private:
     set_type _points;
 
     set_type _all_points;
+    std::unordered_map<SelectableControlPoint *, std::list<SelectableControlPoint *>::iterator> _points_list_pos;
+
+    // Uniform grid over the positions of _all_points, used by area selection and spatialGrow().
+    // It is rebuilt lazily after points are added, removed or moved.
+    std::vector<std::vector<SelectableControlPoint *>> _index_cells;
+    Geom::Rect _index_area;
+    double _index_cell_size = 1.0;
+    int _index_cols = 0;
+    int _index_rows = 0;
+    bool _index_valid = false;
+
+    Geom::OptRect _materialize_area;
+
     std::unordered_map<SelectableControlPoint *, Geom::Point> _original_positions;
     std::unordered_map<SelectableControlPoint *, Geom::Affine> _last_trans;
     std::optional<double> _rot_radius;
@@ -45,15 +45,18 @@ bool ControlPoint::_event_grab = false;
 
 ControlPoint::ControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
                            Inkscape::CanvasItemCtrlType type,
-                           Inkscape::CanvasItemGroup *group)
+                           Inkscape::CanvasItemGroup *group,
+                           bool deferred)
     : _desktop(d)
     , _position(initial_pos)
+    , _canvas_group(group ? group : d->getCanvasControls())
+    , _ctrl_type(type)
+    , _anchor(anchor)
+    , _deferred(deferred)
 {
-    _canvas_item_ctrl = make_canvasitem<Inkscape::CanvasItemCtrl>(group ? group : _desktop->getCanvasControls(), type);
-    _canvas_item_ctrl->set_name("CanvasItemCtrl:ControlPoint");
-    _canvas_item_ctrl->set_anchor(anchor);
-
-    _commonInit();
+    if (!_deferred) {
+        _createCanvasItem();
+    }
 }
 
 ControlPoint::~ControlPoint()
@@ -63,12 +66,38 @@ ControlPoint::~ControlPoint()
         _clearMouseover();
     }
 
-    _canvas_item_ctrl->set_visible(false);
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_visible(false);
+    }
 }
 
-void ControlPoint::_commonInit()
+/** Create the canvas item, applying everything that was set on the point so far. */
+void ControlPoint::_createCanvasItem()
 {
+    _canvas_item_ctrl = make_canvasitem<Inkscape::CanvasItemCtrl>(_canvas_group, _ctrl_type);
+    _canvas_item_ctrl->set_name(_name);
+    _canvas_item_ctrl->set_anchor(_anchor);
     _canvas_item_ctrl->set_position(_position);
+    _canvas_item_ctrl->set_visible(_visible);
+    if (_relative_size) {
+        _canvas_item_ctrl->set_size(*_relative_size);
+    }
+    if (_size) {
+        _canvas_item_ctrl->_set_size(*_size);
+    }
+    if (_selected_appearance) {
+        _canvas_item_ctrl->set_selected(true);
+    }
+    if (_selected_appearance || _state != STATE_NORMAL) {
+        // Not through _setState(), which subclasses override with side effects on other points.
+        _canvas_item_ctrl->set_normal(_selected_appearance);
+        if (_state == STATE_MOUSEOVER) {
+            _canvas_item_ctrl->set_hover();
+        } else if (_state == STATE_CLICKED) {
+            _canvas_item_ctrl->set_click();
+        }
+    }
+
     _event_handler_connection = _canvas_item_ctrl->connect_event([this] (CanvasEvent const &event) {
         // re-routes events into the virtual function   TODO: Refactor this nonsense.
         if (!_desktop) {
@@ -78,10 +107,28 @@ void ControlPoint::_commonInit()
     });
 }
 
+void ControlPoint::materialize()
+{
+    if (!_canvas_item_ctrl) {
+        _createCanvasItem();
+    }
+}
+
+void ControlPoint::dematerialize()
+{
+    if (!_deferred || !_canvas_item_ctrl || _event_grab || _state != STATE_NORMAL || this == mouseovered_point) {
+        return;
+    }
+    _event_handler_connection.disconnect();
+    _canvas_item_ctrl.reset();
+}
+
 void ControlPoint::setPosition(Geom::Point const &pos)
 {
     _position = pos;
-    _canvas_item_ctrl->set_position(_position);
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_position(_position);
+    }
 }
 
 void ControlPoint::move(Geom::Point const &pos)
@@ -95,15 +142,14 @@ void ControlPoint::transform(Geom::Affine const &m) {
 
 bool ControlPoint::visible() const
 {
-    return _canvas_item_ctrl->is_visible();
+    return _visible;
 }
 
 void ControlPoint::setVisible(bool v)
 {
-    if (v) {
-        _canvas_item_ctrl->set_visible(true);
-    } else {
-        _canvas_item_ctrl->set_visible(false);
+    _visible = v;
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_visible(v);
     }
 }
 
@@ -123,12 +169,35 @@ Glib::ustring ControlPoint::format_tip(char const *format, ...)
 
 void ControlPoint::_setSize(unsigned int size)
 {
-    _canvas_item_ctrl->_set_size(size);
+    _size = size;
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->_set_size(size);
+    }
+}
+
+void ControlPoint::_setRelativeSize(Inkscape::HandleSize size)
+{
+    _relative_size = size;
+    _size.reset();
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_size(size);
+    }
 }
 
 void ControlPoint::_setControlType(Inkscape::CanvasItemCtrlType type)
 {
-    _canvas_item_ctrl->set_type(type);
+    _ctrl_type = type;
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_type(type);
+    }
+}
+
+void ControlPoint::_setName(char const *name)
+{
+    _name = name;
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_name(name);
+    }
 }
 
 // main event callback, which emits all other callbacks.
@@ -401,6 +470,7 @@ void ControlPoint::transferGrab(ControlPoint *prev_point, MotionEvent const &eve
     if (!_event_grab) return;
 
     grabbed(event);
+    materialize();
     prev_point->_canvas_item_ctrl->ungrab();
     _canvas_item_ctrl->grab(grab_event_mask); // cursor is null
 
@@ -412,6 +482,11 @@ void ControlPoint::transferGrab(ControlPoint *prev_point, MotionEvent const &eve
 
 void ControlPoint::_setState(State state)
 {
+    _state = state;
+    if (!_canvas_item_ctrl) {
+        return;
+    }
+
     _canvas_item_ctrl->set_normal(_selected_appearance);
 
     switch(state) {
@@ -424,20 +499,24 @@ void ControlPoint::_setState(State state)
             _canvas_item_ctrl->set_click();
             break;
     };
-    _state = state;
 }
 
 void ControlPoint::set_selected_appearance(bool selected) {
     if (_selected_appearance == selected) return;
 
     _selected_appearance = selected;
-    _canvas_item_ctrl->set_selected(selected);
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_selected(selected);
+    }
 }
 
 // TODO: RENAME
 void ControlPoint::_handleControlStyling()
 {
-    _canvas_item_ctrl->set_size_default();
+    _size.reset();
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->set_size_default();
+    }
 }
 
 bool ControlPoint::_is_drag_cancelled(MotionEvent const &event)
@@ -12,6 +12,7 @@
 #define INKSCAPE_UI_TOOL_CONTROL_POINT_H
 
 #include <cstddef>
+#include <optional>
 #include <boost/noncopyable.hpp>
 #include <gdkmm/pixbuf.h>
 #include <sigc++/signal.h>
@@ -145,6 +146,26 @@ public:
      */
     virtual void setVisible(bool v);
     /// @}
+
+    /// @name Create the canvas item of a deferred point
+    /// @{
+    /** Whether the point currently has a canvas item. Points that are not deferred always have one. */
+    bool materialized() const { return (bool)_canvas_item_ctrl; }
+
+    /**
+     * Create the canvas item of a deferred point, with the position and appearance it was given
+     * so far. Deferred points are used where there can be so many of them that most are off screen,
+     * like path nodes; they only get a canvas item while they are near the visible area.
+     */
+    virtual void materialize();
+
+    /**
+     * Destroy the canvas item of a deferred point, keeping its position and appearance. Does nothing
+     * for points that are not deferred, while the point is hovered or clicked, or while any point
+     * holds the grab.
+     */
+    virtual void dematerialize();
+    /// @}
     
     /// @name Transfer grab from another event handler
     /// @{
@@ -200,10 +221,12 @@ protected:
      * @param anchor Where is the control point rendered relative to its desktop coordinates
      * @param type Logical type of the control point.
      * @param group The canvas group the point's canvas item should be created in
+     * @param deferred Don't create the canvas item until materialize() is called
      */
     ControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
                  Inkscape::CanvasItemCtrlType type,
-                 Inkscape::CanvasItemGroup *group = nullptr);
+                 Inkscape::CanvasItemGroup *group = nullptr,
+                 bool deferred = false);
 
     /// @name Handle control point events in subclasses
     /// @{
@@ -264,14 +287,17 @@ protected:
     void _handleControlStyling();
 
     void _setSize(unsigned int size);
+    void _setRelativeSize(Inkscape::HandleSize size);
     void _setControlType(Inkscape::CanvasItemCtrlType type);
+    void _setName(char const *name);
     void _setAnchor(SPAnchorType anchor);
 
     virtual Glib::ustring _getTip(unsigned /*state*/) const { return ""; }
     virtual Glib::ustring _getDragTip(MotionEvent const &event) const { return ""; }
     virtual bool _hasDragTips() const { return false; }
 
-    CanvasItemPtr<Inkscape::CanvasItemCtrl> _canvas_item_ctrl; ///< Visual representation of the control point.
+    /// Visual representation of the control point. Null while a deferred point is not materialized.
+    CanvasItemPtr<Inkscape::CanvasItemCtrl> _canvas_item_ctrl;
 
     State _state = STATE_NORMAL;
 
@@ -291,10 +317,20 @@ private:
 
     void _setDefaultColors();
 
-    void _commonInit();
+    void _createCanvasItem();
 
     Geom::Point _position; ///< Current position in desktop coordinates
 
+    // What the canvas item is created with, also when it is created later.
+    Inkscape::CanvasItemGroup *_canvas_group;
+    Inkscape::CanvasItemCtrlType _ctrl_type;
+    SPAnchorType _anchor;
+    char const *_name = "CanvasItemCtrl:ControlPoint";
+    std::optional<Inkscape::HandleSize> _relative_size;
+    std::optional<unsigned> _size;
+    bool _visible = true;
+    bool const _deferred;
+
     auto_connection _event_handler_connection;
 
     /** Stores the window point over which the cursor was during the last mouse button press. */
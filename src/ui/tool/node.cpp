@@ -162,9 +162,9 @@ bool Handle::_drag_out = false;
 Handle::Handle(NodeSharedData const &data, Geom::Point const &initial_pos, Node *parent)
     : ControlPoint(data.desktop, initial_pos, SP_ANCHOR_CENTER,
                    Inkscape::CANVAS_ITEM_CTRL_TYPE_ROTATE,
-                   data.handle_group)
-    , _handle_line(make_canvasitem<CanvasItemCurve>(data.handle_line_group))
+                   data.handle_group, true)
     , _parent(parent)
+    , _handle_line_group(data.handle_line_group)
     , _degenerate(true)
 {
     setVisible(false);
@@ -175,10 +175,34 @@ Handle::~Handle() = default;
 void Handle::setVisible(bool v)
 {
     ControlPoint::setVisible(v);
-    _handle_line->set_visible(v);
+    // A handle is only drawn next to its node, so it is materialized along with it.
+    if (v && _parent->materialized()) {
+        materialize();
+    }
+    if (_handle_line) {
+        _handle_line->set_visible(v);
+    }
     set_selected_appearance(_parent->selected());
 }
 
+void Handle::materialize()
+{
+    ControlPoint::materialize();
+    if (!_handle_line) {
+        _handle_line = make_canvasitem<CanvasItemCurve>(_handle_line_group);
+        _handle_line->set_coords(_parent->position(), position());
+        _handle_line->set_visible(visible());
+    }
+}
+
+void Handle::dematerialize()
+{
+    ControlPoint::dematerialize();
+    if (!materialized()) {
+        _handle_line.reset();
+    }
+}
+
 void Handle::_update_bspline_handles() {
     // move the handle and its opposite the same proportion
     if (_pm()._isBSpline()) {
@@ -277,7 +301,10 @@ void Handle::move(Geom::Point const &new_pos)
 void Handle::setPosition(Geom::Point const &p)
 {
     ControlPoint::setPosition(p);
-    _handle_line->set_coords(_parent->position(), position());
+    _parent->_invalidateGeometry();
+    if (_handle_line) {
+        _handle_line->set_coords(_parent->position(), position());
+    }
 
     // update degeneration info and visibility
     if (Geom::are_near(position(), _parent->position()))
@@ -739,16 +766,47 @@ Node::Node(NodeSharedData const &data, Geom::Point const &initial_pos) :
     SelectableControlPoint(data.desktop, initial_pos, SP_ANCHOR_CENTER,
                            Inkscape::CANVAS_ITEM_CTRL_TYPE_NODE_CUSP,
                            *data.selection,
-                           data.node_group),
+                           data.node_group, true),
     _front(data, initial_pos, this),
     _back(data, initial_pos, this),
     _type(NODE_CUSP),
     _handles_shown(false)
 {
-    _canvas_item_ctrl->set_name("CanvasItemCtrl:Node");
+    _setName("CanvasItemCtrl:Node");
     // NOTE we do not set type here, because the handles are still degenerate
 }
 
+void Node::materialize()
+{
+    SelectableControlPoint::materialize();
+    for (auto handle : {&_front, &_back}) {
+        if (handle->visible()) {
+            handle->materialize();
+        }
+    }
+}
+
+void Node::dematerialize()
+{
+    _front.dematerialize();
+    _back.dematerialize();
+    SelectableControlPoint::dematerialize();
+}
+
+void Node::setPosition(Geom::Point const &p)
+{
+    SelectableControlPoint::setPosition(p);
+    _invalidateGeometry();
+}
+
+/** Mark the geometry of the subpath containing this node as out of date. */
+void Node::_invalidateGeometry()
+{
+    if (ln_list) {
+        ln_list->_invalidateGeometry();
+    }
+}
+
 Node const *Node::_next() const
 {
     return const_cast<Node*>(this)->_next();
@@ -1119,7 +1177,9 @@ bool Node::isEndNode() const
 
 void Node::sink()
 {
-    _canvas_item_ctrl->lower_to_bottom();
+    if (_canvas_item_ctrl) {
+        _canvas_item_ctrl->lower_to_bottom();
+    }
 }
 
 NodeType Node::parse_nodetype(char x)
@@ -1287,7 +1347,7 @@ void Node::_linearGrow(int dir)
 void Node::_setState(State state)
 {
     // change node size to match type and selection state
-    _canvas_item_ctrl->set_size(selected() ? HandleSize::LARGE : HandleSize::NORMAL);
+    _setRelativeSize(selected() ? HandleSize::LARGE : HandleSize::NORMAL);
     switch (state) {
         // These were used to set "active" and "prelight" flags but the flags weren't being used.
         case STATE_NORMAL:
@@ -1741,6 +1801,7 @@ NodeList::iterator NodeList::insert(iterator pos, Node *x)
     ins->ln_prev->ln_next = x;
     ins->ln_prev = x;
     x->ln_list = this;
+    _invalidateGeometry();
     return iterator(x);
 }
 
@@ -1759,6 +1820,11 @@ void NodeList::splice(iterator pos, NodeList &list, iterator i)
 void NodeList::splice(iterator pos, NodeList &/*list*/, iterator first, iterator last)
 {
     ListNode *ins_beg = first._node, *ins_end = last._node, *at = pos._node;
+    if (ins_beg == ins_end) {
+        return;
+    }
+    ins_beg->ln_list->_invalidateGeometry();
+    _invalidateGeometry();
     for (ListNode *ln = ins_beg; ln != ins_end; ln = ln->ln_next) {
         ln->ln_list = this;
     }
@@ -1789,6 +1855,7 @@ void NodeList::shift(int n)
     ln_prev = new_begin->ln_prev;
     new_begin->ln_prev->ln_next = this;
     new_begin->ln_prev = this;
+    _invalidateGeometry();
 }
 
 void NodeList::reverse()
@@ -1801,6 +1868,7 @@ void NodeList::reverse()
         node->back()->setPosition(save_pos);
     }
     std::swap(ln_next, ln_prev);
+    _invalidateGeometry();
 }
 
 void NodeList::clear()
@@ -1848,6 +1916,7 @@ NodeList::iterator NodeList::erase(iterator i)
     delete rm;
     rmprev->ln_next = rmnext;
     rmnext->ln_prev = rmprev;
+    _invalidateGeometry();
     return i;
 }
 
@@ -19,6 +19,7 @@
 #include <memory>
 #include <optional>
 #include <2geom/point.h>
+#include <2geom/pathvector.h>
 #include <boost/noncopyable.hpp>
 
 #include "snap-candidate.h"
@@ -44,9 +45,9 @@ std::ostream &operator<<(std::ostream &, NodeType);
 
 struct ListNode
 {
-    ListNode *ln_next;
-    ListNode *ln_prev;
-    NodeList *ln_list;
+    ListNode *ln_next = nullptr;
+    ListNode *ln_prev = nullptr;
+    NodeList *ln_list = nullptr;
 };
 
 struct NodeSharedData
@@ -68,6 +69,8 @@ public:
     bool isDegenerate() const { return _degenerate; } // True if the handle is retracted, i.e. has zero length.
 
     void setVisible(bool) override;
+    void materialize() override;
+    void dematerialize() override;
     void move(Geom::Point const &p) override;
 
     void setPosition(Geom::Point const &p) override;
@@ -102,7 +105,8 @@ private:
     void _update_bspline_handles();
     Node *_parent; // the handle's lifetime does not extend beyond that of the parent node,
     // so a naked pointer is OK and allows setting it during Node's construction
-    CanvasItemPtr<CanvasItemCurve> _handle_line;
+    Inkscape::CanvasItemGroup *_handle_line_group;
+    CanvasItemPtr<CanvasItemCurve> _handle_line; ///< Created and destroyed along with the handle's canvas item.
     bool _degenerate; // True if the handle is retracted, i.e. has zero length. This is used often internally so it makes sense to cache this
 
     /**
@@ -133,8 +137,11 @@ public:
     Node(Node const &) = delete;
 
     void move(Geom::Point const &p) override;
+    void setPosition(Geom::Point const &p) override;
     void transform(Geom::Affine const &m) override;
     void fixNeighbors() override;
+    void materialize() override;
+    void dematerialize() override;
     Geom::Rect bounds() const override;
 
     NodeType type() const { return _type; }
@@ -233,6 +240,7 @@ private:
     Inkscape::SnapTargetType _snapTargetType() const;
     inline PathManipulator &_pm();
     inline PathManipulator &_pm() const;
+    void _invalidateGeometry();
 
     /** Determine whether two nodes are joined by a linear segment. */
     static bool _is_line_segment(Node *first, Node *second);
@@ -373,7 +381,7 @@ public:
      */
     bool degenerate() const;
 
-    void setClosed(bool c) { _closed = c; }
+    void setClosed(bool c) { _closed = c; _invalidateGeometry(); }
     iterator before(double t, double *fracpart = nullptr);
     iterator before(Geom::PathTime const &pvp);
     const_iterator before(double t, double *fracpart = nullptr) const {
@@ -425,10 +433,22 @@ public:
     static NodeList &get(iterator const &i);
 
 private:
+    void _invalidateGeometry() { _geometry_dirty = true; }
+
     SubpathList &_list;
     bool _closed = false;
+    /// Geometry built from this subpath by PathManipulator, in desktop coordinates.
+    /// Marked dirty whenever a node or handle of the subpath moves or the list changes,
+    /// so that only the edited subpaths are rebuilt and compared with what they were.
+    std::optional<Geom::PathVector> _geometry;
+    bool _geometry_dirty = true;
+    /// The same geometry in item coordinates without empty paths, as spliced into the
+    /// edited curve. Retransformed only when _geometry changes or the item transform does.
+    Geom::PathVector _item_geometry;
+    bool _item_geometry_dirty = true;
 
     friend class Node;
+    friend class PathManipulator;
     friend class Handle; // required to access handle and handle line groups
     friend class NodeIterator<Node>;
     friend class NodeIterator<Node const>;
@@ -15,6 +15,7 @@
 #include <2geom/path-sink.h>
 #include <2geom/point.h>
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -1258,6 +1259,8 @@ void PathManipulator::_createControlPointsFromGeometry()
         return;
     }
     _spcurve = SPCurve(pathv);
+    // the subpaths are created anew, so nothing can be spliced into this curve
+    _geometry_valid = false;
 
     pathv *= _getTransform();
 
@@ -1429,49 +1432,111 @@ Geom::Point PathManipulator::_bsplineHandleReposition(Handle *h,double pos){
  */
 void PathManipulator::_createGeometryFromControlPoints(bool alert_LPE)
 {
-    Geom::PathBuilder builder;
     //Refresh if is bspline some times -think on path change selection, this value get lost
     _recalculateIsBSpline();
+
+    // Each subpath caches its own geometry, which is marked dirty when one of its nodes or
+    // handles moves. When dragging a few nodes of a path with many subpaths, only those are
+    // rebuilt, compared with the previous geometry, transformed to item coordinates and
+    // spliced into the curve.
+    bool changed = false;
+    std::vector<NodeList const *> subpaths;
+    subpaths.reserve(_subpaths.size());
     for (std::list<SubpathPtr>::iterator spi = _subpaths.begin(); spi != _subpaths.end(); ) {
         SubpathPtr subpath = *spi;
         if (subpath->empty()) {
             _subpaths.erase(spi++);
             continue;
         }
-        NodeList::iterator prev = subpath->begin();
-        builder.moveTo(prev->position());
-        for (NodeList::iterator i = ++subpath->begin(); i != subpath->end(); ++i) {
-            build_segment(builder, prev.ptr(), i.ptr());
-            prev = i;
-        }
-        if (subpath->closed()) {
-            // Here we link the last and first node if the path is closed.
-            // If the last segment is Bezier, we add it.
-            if (!prev->front()->isDegenerate() || !subpath->begin()->back()->isDegenerate()) {
-                build_segment(builder, prev.ptr(), subpath->begin().ptr());
+        if (subpath->_geometry_dirty) {
+            Geom::PathBuilder builder;
+            NodeList::iterator prev = subpath->begin();
+            builder.moveTo(prev->position());
+            for (NodeList::iterator i = ++subpath->begin(); i != subpath->end(); ++i) {
+                build_segment(builder, prev.ptr(), i.ptr());
+                prev = i;
             }
-            // if that segment is linear, we just call closePath().
-            builder.closePath();
+            if (subpath->closed()) {
+                // Here we link the last and first node if the path is closed.
+                // If the last segment is Bezier, we add it.
+                if (!prev->front()->isDegenerate() || !subpath->begin()->back()->isDegenerate()) {
+                    build_segment(builder, prev.ptr(), subpath->begin().ptr());
+                }
+                // if that segment is linear, we just call closePath().
+                builder.closePath();
+            }
+            builder.flush();
+            if (!subpath->_geometry || !(*subpath->_geometry == builder.peek())) {
+                subpath->_geometry = builder.peek();
+                subpath->_item_geometry_dirty = true;
+                changed = true;
+            }
+            subpath->_geometry_dirty = false;
         }
+        subpaths.push_back(subpath.get());
         ++spi;
     }
-    builder.flush();
-    Geom::PathVector pathv = builder.peek() * _getTransform().inverse();
-    for (Geom::PathVector::iterator i = pathv.begin(); i != pathv.end(); ) {
-        // NOTE: this utilizes the fact that Geom::PathVector is an std::vector.
-        // When we erase an element, the next one slides into position,
-        // so we do not increment the iterator even though it is theoretically invalidated.
-        if (i->empty()) {
-            i = pathv.erase(i);
-        } else {
-            ++i;
+
+    // If no subpath changed and the list of subpaths is the same, neither has the geometry.
+    Geom::Affine const transform = _getTransform();
+    bool const same_subpaths = subpaths == _geometry_subpaths;
+    bool const same_transform = transform == _geometry_transform;
+    if (_geometry_valid && !changed && same_subpaths && same_transform) {
+        return;
+    }
+
+    // Transforms the desktop geometry of a subpath to item coordinates, dropping empty paths.
+    Geom::Affine const d2i = transform.inverse();
+    auto update_item_geometry = [&] (NodeList &subpath) {
+        Geom::PathVector item;
+        for (auto const &path : *subpath._geometry) {
+            if (!path.empty()) {
+                item.push_back(path * d2i);
+            }
+        }
+        subpath._item_geometry = std::move(item);
+        subpath._item_geometry_dirty = false;
+    };
+
+    Geom::PathVector pathv;
+    if (_geometry_valid && same_subpaths && same_transform) {
+        // Only the geometry of some subpaths changed: splice them into the current curve.
+        // Copying the path vector only copies references to the path data of each subpath.
+        pathv = _spcurve.get_pathvector();
+        std::size_t offset = 0;
+        for (auto &subpath : _subpaths) {
+            std::size_t const old_size = subpath->_item_geometry.size();
+            if (subpath->_item_geometry_dirty) {
+                update_item_geometry(*subpath);
+                auto const &item = subpath->_item_geometry;
+                auto const pos = pathv.begin() + offset;
+                if (item.size() == old_size) {
+                    std::copy(item.begin(), item.end(), pos);
+                } else {
+                    pathv.insert(pathv.erase(pos, pos + old_size), item.begin(), item.end());
+                }
+            }
+            offset += subpath->_item_geometry.size();
+        }
+    } else {
+        for (auto &subpath : _subpaths) {
+            if (subpath->_item_geometry_dirty || !same_transform) {
+                update_item_geometry(*subpath);
+            }
+            pathv.insert(pathv.end(), subpath->_item_geometry.begin(), subpath->_item_geometry.end());
         }
     }
+
+    // Compare the whole path with the object's only if it was reloaded from the object since.
+    bool const compare = !_geometry_valid;
+    _geometry_subpaths = std::move(subpaths);
+    _geometry_transform = transform;
+    _geometry_valid = !pathv.empty();
     if (pathv.empty()) {
         return;
     }
 
-    if (_spcurve.get_pathvector() == pathv) {
+    if (compare && _spcurve.get_pathvector() == pathv) {
         return;
     }
     _spcurve = SPCurve(pathv);
@@ -1536,7 +1601,18 @@ void PathManipulator::_updateOutline()
         return;
     }
 
-    auto pv = _spcurve.get_pathvector() * _getTransform();
+    Geom::PathVector pv;
+    if (_geometry_valid && _geometry_transform == _getTransform()) {
+        // The subpaths keep the geometry last built from the nodes in desktop coordinates,
+        // so there is no need to transform the whole curve back.
+        for (auto const &subpath : _subpaths) {
+            if (subpath->_geometry) {
+                pv.insert(pv.end(), subpath->_geometry->begin(), subpath->_geometry->end());
+            }
+        }
+    } else {
+        pv = _spcurve.get_pathvector() * _getTransform();
+    }
     // This SPCurve thing has to be killed with extreme prejudice
     if (_show_path_direction) {
         // To show the direction, we append additional subpaths which consist of a single
@@ -1567,6 +1643,8 @@ void PathManipulator::_updateOutline()
 void PathManipulator::_getGeometry()
 {
     using namespace Inkscape::LivePathEffect;
+    // _spcurve no longer matches what was last built from the nodes
+    _geometry_valid = false;
     auto lpeobj = cast<LivePathEffectObject>(_path);
     auto path = cast<SPPath>(_path);
     if (lpeobj) {
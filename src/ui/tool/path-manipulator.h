@@ -14,6 +14,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <2geom/pathvector.h>
 #include <2geom/path-sink.h>
 #include <2geom/affine.h>
@@ -162,6 +163,9 @@ private:
     MultiPathManipulator &_multi_path_manipulator;
     SPObject *_path; ///< can be an SPPath or an Inkscape::LivePathEffect::Effect  !!!
     SPCurve _spcurve; // in item coordinates
+    std::vector<NodeList const *> _geometry_subpaths; ///< subpaths _spcurve was last built from
+    Geom::Affine _geometry_transform; ///< transform _spcurve was last built with
+    bool _geometry_valid = false;
     CanvasItemPtr<Inkscape::CanvasItemBpath> _outline;
     CurveDragPoint *_dragpoint; // an invisible control point hovering over curve
     PathManipulatorObserver *_observer;
@@ -17,18 +17,35 @@ namespace UI {
 SelectableControlPoint::SelectableControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
                                                Inkscape::CanvasItemCtrlType type,
                                                ControlPointSelection &sel,
-                                               Inkscape::CanvasItemGroup *group)
-    : ControlPoint(d, initial_pos, anchor, type, group)
+                                               Inkscape::CanvasItemGroup *group,
+                                               bool deferred)
+    : ControlPoint(d, initial_pos, anchor, type, group, deferred)
     , _selection(sel)
 {
-    _canvas_item_ctrl->set_name("CanvasItemCtrl:SelectableControlPoint");
+    _setName("CanvasItemCtrl:SelectableControlPoint");
     _selection.allPoints().insert(this);
+    _selection._invalidateIndex();
+    if (_selection._inMaterializeArea(position())) {
+        materialize();
+    }
 }
 
 SelectableControlPoint::~SelectableControlPoint()
 {
     _selection.erase(this);
     _selection.allPoints().erase(this);
+    _selection._invalidateIndex();
+}
+
+void SelectableControlPoint::setPosition(Geom::Point const &pos)
+{
+    ControlPoint::setPosition(pos);
+    _selection._invalidateIndex();
+    // Points moved into view need a canvas item. Those moved out keep theirs until the
+    // area changes.
+    if (!materialized() && _selection._inMaterializeArea(pos)) {
+        materialize();
+    }
 }
 
 bool SelectableControlPoint::grabbed(MotionEvent const &)
@@ -96,6 +113,10 @@ void SelectableControlPoint::_setState(State state)
     if (!selected()) {
         ControlPoint::_setState(state);
     } else {
+        _state = state;
+        if (!_canvas_item_ctrl) {
+            return;
+        }
         _canvas_item_ctrl->set_normal(true);
         switch (state) {
             case STATE_NORMAL:
@@ -107,7 +128,6 @@ void SelectableControlPoint::_setState(State state)
                 _canvas_item_ctrl->set_click();
                 break;
         }
-        _state = state;
     }
 }
 
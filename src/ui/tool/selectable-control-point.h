@@ -30,13 +30,15 @@ public:
         return Geom::Rect(position(), position());
     }
     virtual void select(bool toselect);
+    void setPosition(Geom::Point const &pos) override;
     friend class NodeList;
 
 protected:
     SelectableControlPoint(SPDesktop *d, Geom::Point const &initial_pos, SPAnchorType anchor,
                            Inkscape::CanvasItemCtrlType type,
                            ControlPointSelection &sel,
-                           Inkscape::CanvasItemGroup *group = nullptr);
+                           Inkscape::CanvasItemGroup *group = nullptr,
+                           bool deferred = false);
 
     void _setState(State state) override;
 
@@ -753,8 +753,8 @@ void ConnectorTool::_setSubsequentPoint(Geom::Point const p)
     Avoid::Point src(o[Geom::X], o[Geom::Y]);
     Avoid::Point dst(d[Geom::X], d[Geom::Y]);
 
+    Avoid::Router *router = _desktop->getDocument()->getRouter();
     if (!this->newConnRef) {
-        Avoid::Router *router = _desktop->getDocument()->getRouter();
         this->newConnRef = new Avoid::ConnRef(router);
         this->newConnRef->setEndpoint(Avoid::VertID::src, src);
         if (this->isOrthogonal) {
@@ -767,7 +767,7 @@ void ConnectorTool::_setSubsequentPoint(Geom::Point const p)
     this->newConnRef->setEndpoint(Avoid::VertID::tar, dst);
     // Immediately generate new routes for connector.
     this->newConnRef->makePathInvalid();
-    this->newConnRef->router()->processTransaction();
+    router->processTransaction();
     // Recreate curve from libavoid route.
     red_curve = SPConnEndPair::createCurve(newConnRef, curvature);
     red_curve->transform(_desktop->doc2dt());
@@ -893,7 +893,7 @@ void ConnectorTool::_finish()
     this->npoints = 0;
 
     if (this->newConnRef) {
-        this->newConnRef->router()->deleteConnector(this->newConnRef);
+        _desktop->getDocument()->getRouter()->deleteConnector(this->newConnRef);
         this->newConnRef = nullptr;
     }
 }
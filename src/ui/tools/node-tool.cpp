@@ -42,6 +42,7 @@
 #include "ui/tool/multi-path-manipulator.h"
 #include "ui/tool/path-manipulator.h"
 #include "ui/tools/node-tool.h"
+#include "ui/widget/canvas.h"
 #include "ui/widget/events/canvas-event.h"
 #include "util-string/ustring-format.h"
 
@@ -166,6 +167,10 @@ NodeTool::NodeTool(SPDesktop *desktop)
     sp_event_context_read(this, "edit_clipping_paths");
     sp_event_context_read(this, "edit_masks");
 
+    // only nodes near the visible area get canvas items, so that huge paths stay editable
+    update_materialize_area();
+    _pre_draw_connection = desktop->getCanvas()->connectPreDraw([this] { update_materialize_area(); });
+
     selection_changed(selection);
     update_tip();
 
@@ -199,6 +204,7 @@ NodeTool::~NodeTool()
     this->_selection_changed_connection.disconnect();
     // this->_selection_modified_connection.disconnect();
     this->_mouseover_changed_connection.disconnect();
+    _pre_draw_connection.disconnect();
 
     delete this->_multipath;
     delete this->_selected_nodes;
@@ -353,6 +359,24 @@ void gather_items(NodeTool *nt, SPItem *base, SPObject *obj, Inkscape::UI::Shape
     }
 }
 
+/**
+ * Keep the control points around the visible area materialized. The area is padded by half the
+ * view on each side and only recomputed once the view leaves it or becomes much smaller than it,
+ * so that scrolling does not create and destroy canvas items on every frame.
+ */
+void NodeTool::update_materialize_area()
+{
+    auto const visible = _desktop->get_display_area().bounds();
+    if (_materialize_area && _materialize_area->contains(visible) &&
+        _materialize_area->area() <= 16 * visible.area())
+    {
+        return;
+    }
+    _materialize_area = visible;
+    _materialize_area->expandBy(visible.width() / 2, visible.height() / 2);
+    _selected_nodes->setMaterializeArea(_materialize_area);
+}
+
 void NodeTool::selection_changed(Inkscape::Selection *sel) {
     using namespace Inkscape::UI;
 
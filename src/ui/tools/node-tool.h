@@ -15,6 +15,7 @@
 #include <map>
 #include <memory>
 #include <vector>
+#include <2geom/rect.h>
 #include <sigc++/connection.h>
 
 #include "ui/tools/tool-base.h"
@@ -65,6 +66,8 @@ private:
 
     sigc::connection _selection_changed_connection;
     sigc::connection _mouseover_changed_connection;
+    sigc::connection _pre_draw_connection;
+    Geom::OptRect _materialize_area;
 
     SPItem *flashed_item = nullptr;
 
@@ -94,6 +97,7 @@ private:
     void update_tip(CanvasEvent const &event);
     void update_tip();
     void handleControlUiStyleChange();
+    void update_materialize_area();
 };
 
 void sp_update_helperpath(SPDesktop *desktop);
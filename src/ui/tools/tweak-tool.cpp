@@ -14,6 +14,11 @@
 
 #include "tweak-tool.h"
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
 #include <gdk/gdkkeysyms.h>
 #include <glibmm/i18n.h>
 
@@ -41,10 +46,12 @@
 #include "object/sp-flowtext.h"
 #include "object/sp-linear-gradient.h"
 #include "object/sp-mesh-gradient.h"
+#include "object/sp-offset.h"
 #include "object/sp-path.h"
 #include "object/sp-radial-gradient.h"
 #include "object/sp-stop.h"
 #include "object/sp-text.h"
+#include "object/sp-use.h"
 
 #include "path/path-util.h"
 
@@ -61,6 +68,350 @@ using Inkscape::DocumentUndo;
 
 namespace Inkscape::UI::Tools {
 
+/**
+ * The items that the selection is tweaked as, each one on its own, in the order they are
+ * tweaked in. They are found through a grid of their bounding boxes, so that every event
+ * only visits the items within reach of the brush.
+ *
+ * Clones are indexed like the other items. Their bounding boxes follow their originals, so
+ * they are re-indexed when an original, or an object inside it, was tweaked.
+ *
+ * Items deleted or duplicated by the tool are removed from the grid or added to it as they go.
+ *
+ * The livarot shapes of the paths that the brush reached are kept too: as they were for the
+ * paths left unchanged, and built from the result for the paths that were changed.
+ */
+struct TweakTool::Stroke
+{
+    struct Entry
+    {
+        SPItem *item;
+        Geom::OptRect bbox;
+        /// Whether to visit the item on every event, because its bounding box may follow other
+        /// objects in ways not tracked here, or because it is replaced by paths the first time
+        /// it is tweaked.
+        bool always;
+        /// Whether the item is a clone whose original was tweaked since the bounding box was taken.
+        bool stale = false;
+    };
+
+    explicit Stroke(Selection *selection);
+
+    /// Indices of the entries whose bounding boxes touch the area, in increasing order.
+    std::vector<int> query(Geom::Rect const &area);
+
+    /// Take a new bounding box for an entry whose item was tweaked, and mark the clones of the
+    /// item and of its ancestors for the same.
+    void update(int index);
+
+    /// Forget the entry of an item about to be deleted, and mark the clones of its ancestors.
+    /// If the item has clones, which may go away with it, the stroke is started anew instead.
+    void remove(SPItem *item);
+    /// Add entries for an item added next to the tweaked ones, e.g. a copy of one of them.
+    void add(SPItem *item);
+    /// The index of the entry of an item, or -1 if it has none.
+    int indexOf(SPItem *item) const;
+
+    /// Return the shape kept for a path, if it was kept for the same transform and fidelity.
+    std::unique_ptr<Shape> takeShape(SPItem *item, Geom::Affine const &i2doc, double fidelity);
+    void keepShape(SPItem *item, Geom::Affine const &i2doc, double fidelity, std::unique_ptr<Shape> shape);
+
+    std::vector<Entry> entries;
+
+    /// Set when items were replaced, added or removed, so the stroke must be started anew.
+    bool stale = false;
+    /// Set while the tool changes the selection along with entries it updates itself, so that
+    /// the change does not make the stroke stale.
+    bool tracked_change = false;
+
+private:
+    /// Maximal number of columns and rows of the grid.
+    static constexpr int MAX_GRID_SIZE = 1024;
+    /// Entries spanning more cells than this are visited on every query instead.
+    static constexpr int MAX_ENTRY_CELLS = 64;
+
+    struct CellRange
+    {
+        int x0, x1, y0, y1;
+        int size() const { return (x1 - x0 + 1) * (y1 - y0 + 1); }
+    };
+
+    struct KeptShape
+    {
+        Geom::Affine i2doc;
+        double fidelity;
+        std::unique_ptr<Shape> shape;
+    };
+
+    void _collect(SPItem *item);
+    void _index(int index);
+    CellRange _cellRange(Geom::Rect const &rect) const;
+    bool _inGrid(Entry const &entry) const;
+    void _insert(int index);
+    void _remove(int index);
+    void _reindex(int index);
+    void _markClones(SPObject *changed);
+
+    Geom::Point _origin;
+    Geom::Point _cell_size;
+    int _cols = 0;
+    int _rows = 0;
+    std::vector<std::vector<int>> _cells;
+    std::vector<int> _others;
+
+    /// Entries by their item.
+    std::unordered_map<SPItem *, int> _indices;
+    /// Clone entries by the object they refer to.
+    std::unordered_map<SPObject *, std::vector<int>> _clones;
+    /// Clone entries to re-index before the next query.
+    std::vector<int> _stale;
+
+    std::vector<unsigned> _visited;
+    unsigned _query = 0;
+
+    std::unordered_map<SPItem *, KeptShape> _shapes;
+    auto_connection _selection_changed;
+};
+
+TweakTool::Stroke::Stroke(Selection *selection)
+{
+    std::vector<SPItem *> items(selection->items().begin(), selection->items().end());
+    for (auto item : items) {
+        _collect(item);
+    }
+
+    Geom::OptRect bounds;
+    for (auto const &entry : entries) {
+        if (!entry.always) {
+            bounds.unionWith(entry.bbox);
+        }
+    }
+    if (bounds) {
+        double const n = entries.size();
+        double const w = std::max(bounds->width(), 1e-6);
+        double const h = std::max(bounds->height(), 1e-6);
+        _cols = std::clamp(static_cast<int>(std::sqrt(n * w / h)), 1, MAX_GRID_SIZE);
+        _rows = std::clamp(static_cast<int>(n / _cols), 1, MAX_GRID_SIZE);
+        _origin = bounds->min();
+        _cell_size = Geom::Point(w / _cols, h / _rows);
+        _cells.resize(_cols * _rows);
+    }
+
+    for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+        _index(i);
+    }
+
+    _selection_changed = selection->connectChanged([this] (Selection *) {
+        if (!tracked_change) {
+            stale = true;
+        }
+    });
+}
+
+void TweakTool::Stroke::_index(int index)
+{
+    auto const item = entries[index].item;
+    _visited.resize(entries.size());
+    _indices[item] = index;
+    _insert(index);
+    if (auto use = cast<SPUse>(item)) {
+        if (auto original = use->get_original()) {
+            _clones[original].push_back(index);
+        }
+    }
+}
+
+void TweakTool::Stroke::_collect(SPItem *item)
+{
+    if (is<SPGroup>(item) && !is<SPBox3D>(item)) {
+        std::vector<SPItem *> children;
+        for (auto &child : item->children) {
+            if (auto child_item = cast<SPItem>(&child)) {
+                children.push_back(child_item);
+            }
+        }
+        for (auto i = children.rbegin(); i != children.rend(); ++i) {
+            _collect(*i);
+        }
+        return;
+    }
+
+    auto lpeitem = cast<SPLPEItem>(item);
+    bool const always = is<SPOffset>(item) || is<SPText>(item) || is<SPFlowtext>(item)
+                     || is<SPBox3D>(item) || (lpeitem && lpeitem->hasPathEffectRecursive());
+    entries.push_back({item, item->documentVisualBounds(), always});
+}
+
+TweakTool::Stroke::CellRange TweakTool::Stroke::_cellRange(Geom::Rect const &rect) const
+{
+    // Rectangles outside of the grid are clamped onto its border cells.
+    auto cell = [] (double coord, double origin, double size, int count) {
+        return static_cast<int>(std::clamp(std::floor((coord - origin) / size), 0.0, count - 1.0));
+    };
+    return {cell(rect.left(), _origin.x(), _cell_size.x(), _cols),
+            cell(rect.right(), _origin.x(), _cell_size.x(), _cols),
+            cell(rect.top(), _origin.y(), _cell_size.y(), _rows),
+            cell(rect.bottom(), _origin.y(), _cell_size.y(), _rows)};
+}
+
+bool TweakTool::Stroke::_inGrid(Entry const &entry) const
+{
+    return !entry.always && entry.bbox && !_cells.empty() && _cellRange(*entry.bbox).size() <= MAX_ENTRY_CELLS;
+}
+
+void TweakTool::Stroke::_insert(int index)
+{
+    auto const &entry = entries[index];
+    if (!_inGrid(entry)) {
+        _others.push_back(index);
+        return;
+    }
+    auto const range = _cellRange(*entry.bbox);
+    for (int y = range.y0; y <= range.y1; y++) {
+        for (int x = range.x0; x <= range.x1; x++) {
+            _cells[y * _cols + x].push_back(index);
+        }
+    }
+}
+
+void TweakTool::Stroke::_remove(int index)
+{
+    auto const &entry = entries[index];
+    if (!_inGrid(entry)) {
+        std::erase(_others, index);
+        return;
+    }
+    auto const range = _cellRange(*entry.bbox);
+    for (int y = range.y0; y <= range.y1; y++) {
+        for (int x = range.x0; x <= range.x1; x++) {
+            std::erase(_cells[y * _cols + x], index);
+        }
+    }
+}
+
+std::vector<int> TweakTool::Stroke::query(Geom::Rect const &area)
+{
+    for (auto index : _stale) {
+        if (entries[index].item) {
+            _reindex(index);
+        }
+        entries[index].stale = false;
+    }
+    _stale.clear();
+
+    std::vector<int> result;
+    _query++;
+
+    auto visit = [&] (int index) {
+        auto const &entry = entries[index];
+        if (_visited[index] != _query && (entry.always || !entry.bbox || entry.bbox->intersects(area))) {
+            _visited[index] = _query;
+            result.push_back(index);
+        }
+    };
+
+    for (auto index : _others) {
+        visit(index);
+    }
+    if (!_cells.empty()) {
+        auto const range = _cellRange(area);
+        for (int y = range.y0; y <= range.y1; y++) {
+            for (int x = range.x0; x <= range.x1; x++) {
+                for (auto index : _cells[y * _cols + x]) {
+                    visit(index);
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void TweakTool::Stroke::update(int index)
+{
+    _reindex(index);
+    _markClones(entries[index].item);
+}
+
+void TweakTool::Stroke::remove(SPItem *item)
+{
+    auto it = _indices.find(item);
+    if (it == _indices.end() || _clones.count(item)) {
+        stale = true;
+        return;
+    }
+    int const index = it->second;
+    _indices.erase(it);
+    _remove(index);
+    _shapes.erase(item);
+    _markClones(item->parent);
+    entries[index].item = nullptr;
+    entries[index].bbox = {};
+}
+
+void TweakTool::Stroke::add(SPItem *item)
+{
+    int const first = entries.size();
+    _collect(item);
+    for (int i = first; i < static_cast<int>(entries.size()); i++) {
+        _index(i);
+    }
+    _markClones(item->parent);
+}
+
+int TweakTool::Stroke::indexOf(SPItem *item) const
+{
+    auto it = _indices.find(item);
+    return it != _indices.end() ? it->second : -1;
+}
+
+void TweakTool::Stroke::_reindex(int index)
+{
+    _remove(index);
+    entries[index].bbox = entries[index].item->documentVisualBounds();
+    _insert(index);
+}
+
+void TweakTool::Stroke::_markClones(SPObject *changed)
+{
+    // A clone changes with everything inside its original, and the clones of a clone change with it.
+    for (auto object = changed; object; object = object->parent) {
+        auto it = _clones.find(object);
+        if (it == _clones.end()) {
+            continue;
+        }
+        for (auto index : it->second) {
+            auto &entry = entries[index];
+            if (entry.item && !entry.stale) {
+                entry.stale = true;
+                _stale.push_back(index);
+                _markClones(entry.item);
+            }
+        }
+    }
+}
+
+std::unique_ptr<Shape> TweakTool::Stroke::takeShape(SPItem *item, Geom::Affine const &i2doc, double fidelity)
+{
+    auto it = _shapes.find(item);
+    if (it == _shapes.end()) {
+        return nullptr;
+    }
+    auto kept = std::move(it->second);
+    _shapes.erase(it);
+    if (kept.i2doc != i2doc || kept.fidelity != fidelity) {
+        return nullptr;
+    }
+    return std::move(kept.shape);
+}
+
+void TweakTool::Stroke::keepShape(SPItem *item, Geom::Affine const &i2doc, double fidelity,
+                                  std::unique_ptr<Shape> shape)
+{
+    _shapes[item] = {i2doc, fidelity, std::move(shape)};
+}
+
 TweakTool::TweakTool(SPDesktop *desktop)
     : ToolBase(desktop, "/tools/tweak", "tweak-push.svg")
     , pressure(TC_DEFAULT_PRESSURE)
@@ -290,8 +641,30 @@ get_move_force (TweakTool *tc)
     return force * tc->force;
 }
 
+/**
+ * Build the livarot shape that a path in item coordinates is tweaked from, with the fill rule of
+ * the item. The path is converted in place.
+ */
+static std::unique_ptr<Shape> tweak_shape(Path &path, SPItem *item, Geom::Affine const &i2doc, double fidelity)
+{
+    path.ConvertWithBackData((0.08 - (0.07 * fidelity)) / i2doc.descrim()); // default 0.059
+    Shape filled;
+    path.Fill(&filled, 0);
+
+    auto shape = std::make_unique<Shape>();
+    SPCSSAttr *css = sp_repr_css_attr(item->getRepr(), "style");
+    gchar const *val = sp_repr_css_property(css, "fill-rule", nullptr);
+    if (val && strcmp(val, "evenodd") == 0) {
+        shape->ConvertToShape(&filled, fill_oddEven);
+    } else {
+        shape->ConvertToShape(&filled, fill_nonZero);
+    }
+    sp_repr_css_attr_unref(css);
+    return shape;
+}
+
 static bool
-sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::Point p, Geom::Point vector, gint mode, double radius, double force, double fidelity, bool reverse)
+sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::Point p, Geom::Point vector, gint mode, double radius, double force, double fidelity, bool reverse, TweakTool::Stroke &stroke)
 {
     bool did = false;
 
@@ -328,7 +701,7 @@ sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::P
         for (auto i = children.rbegin(); i!= children.rend(); ++i) {
             SPItem *child = *i; 
             g_assert(child != nullptr);
-            if (sp_tweak_dilate_recursive (selection, child, p, vector, mode, radius, force, fidelity, reverse)) {
+            if (sp_tweak_dilate_recursive (selection, child, p, vector, mode, radius, force, fidelity, reverse, stroke)) {
                 did = true;
             }
         }
@@ -412,7 +785,10 @@ sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::P
                     double prob = force * 0.5 * (cos(M_PI * x) + 1);
                     double chance = g_random_double_range(0, 1);
                     if (chance <= prob) {
+                        // the stroke updates its entries for the items deleted and copied
+                        stroke.tracked_change = true;
                         if (reverse) { // delete
+                            stroke.remove(item);
                             item->deleteObject(true, true);
                         } else { // duplicate
                             SPDocument *doc = item->document;
@@ -427,7 +803,11 @@ sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::P
                                 selection->add(new_obj);
                             }
                             Inkscape::GC::release(copy);
+                            if (auto new_item = cast<SPItem>(new_obj)) {
+                                stroke.add(new_item);
+                            }
                         }
+                        stroke.tracked_change = false;
                         did = true;
                     }
                 }
@@ -435,6 +815,15 @@ sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::P
 
         } else if (is<SPPath>(item) || is<SPShape>(item)) {
 
+            // skip those paths whose bboxes are entirely out of reach with our radius
+            Geom::OptRect bbox = item->documentVisualBounds();
+            if (bbox) {
+                bbox->expandBy(radius);
+                if (!bbox->contains(p)) {
+                    return false;
+                }
+            }
+
             Inkscape::XML::Node *newrepr = nullptr;
             gint pos = 0;
             Inkscape::XML::Node *parent = nullptr;
@@ -453,38 +842,28 @@ sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::P
                 id = item->getRepr()->attribute("id");
             }
 
-            // skip those paths whose bboxes are entirely out of reach with our radius
-            Geom::OptRect bbox = item->documentVisualBounds();
-            if (bbox) {
-                bbox->expandBy(radius);
-                if (!bbox->contains(p)) {
+            Geom::Affine i2doc(item->i2doc_affine());
+
+            // the shape left by the previous event is still valid if that did not change the path
+            auto theRes = stroke.takeShape(item, i2doc, fidelity);
+            std::unique_ptr<Path> orig;
+            if (!theRes) {
+                orig = Path_for_item(item, false);
+                if (!orig) {
+                    if (newrepr) {
+                        Inkscape::GC::release(newrepr);
+                    }
                     return false;
                 }
             }
 
-            auto orig = Path_for_item(item, false);
-            if (!orig) {
-                return false;
-            }
-
             Path *res = new Path;
             res->SetBackData(false);
 
             Shape *theShape = new Shape;
-            Shape *theRes = new Shape;
-            Geom::Affine i2doc(item->i2doc_affine());
-
-            orig->ConvertWithBackData((0.08 - (0.07 * fidelity)) / i2doc.descrim()); // default 0.059
-            orig->Fill(theShape, 0);
 
-            SPCSSAttr *css = sp_repr_css_attr(item->getRepr(), "style");
-            gchar const *val = sp_repr_css_property(css, "fill-rule", nullptr);
-            if (val && strcmp(val, "nonzero") == 0) {
-                theRes->ConvertToShape(theShape, fill_nonZero);
-            } else if (val && strcmp(val, "evenodd") == 0) {
-                theRes->ConvertToShape(theShape, fill_oddEven);
-            } else {
-                theRes->ConvertToShape(theShape, fill_nonZero);
+            if (!theRes) {
+                theRes = tweak_shape(*orig, item, i2doc, fidelity);
             }
 
             if (Geom::L2(vector) != 0) {
@@ -493,25 +872,25 @@ sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::P
 
             bool did_this = false;
             if (mode == TWEAK_MODE_SHRINK_GROW) {
-                if (theShape->MakeTweak(tweak_mode_grow, theRes,
+                if (theShape->MakeTweak(tweak_mode_grow, theRes.get(),
                         reverse? force : -force,
                         join_straight, 4.0,
                         true, p, Geom::Point(0,0), radius, &i2doc) == 0) // 0 means the shape was actually changed
                     did_this = true;
             } else if (mode == TWEAK_MODE_ATTRACT_REPEL) {
-                if (theShape->MakeTweak(tweak_mode_repel, theRes,
+                if (theShape->MakeTweak(tweak_mode_repel, theRes.get(),
                         reverse? force : -force,
                         join_straight, 4.0,
                         true, p, Geom::Point(0,0), radius, &i2doc) == 0)
                     did_this = true;
             } else if (mode == TWEAK_MODE_PUSH) {
-                if (theShape->MakeTweak(tweak_mode_push, theRes,
+                if (theShape->MakeTweak(tweak_mode_push, theRes.get(),
                         1.0,
                         join_straight, 4.0,
                         true, p, force*2*vector, radius, &i2doc) == 0)
                     did_this = true;
             } else if (mode == TWEAK_MODE_ROUGHEN) {
-                if (theShape->MakeTweak(tweak_mode_roughen, theRes,
+                if (theShape->MakeTweak(tweak_mode_roughen, theRes.get(),
                         force,
                         join_straight, 4.0,
                         true, p, Geom::Point(0,0), radius, &i2doc) == 0)
@@ -559,20 +938,24 @@ sp_tweak_dilate_recursive (Inkscape::Selection *selection, SPItem *item, Geom::P
                             item->setAttribute("inkscape:original-d", str.c_str());
                         } else {
                             item->setAttribute("d", str.c_str());
+                            // the next event would read back the path just written, so build
+                            // its shape from the result right away
+                            stroke.keepShape(item, i2doc, fidelity, tweak_shape(*res, item, i2doc, fidelity));
                         }
                     }
                 } else {
                     // TODO: if there's 0 or 1 node left, delete this path altogether
                 }
+            } else {
+                stroke.keepShape(item, i2doc, fidelity, std::move(theRes));
+            }
 
-                if (newrepr) {
-                    Inkscape::GC::release(newrepr);
-                    newrepr = nullptr;
-                }
+            if (newrepr) {
+                Inkscape::GC::release(newrepr);
+                newrepr = nullptr;
             }
 
             delete theShape;
-            delete theRes;
             delete res;
 
             if (did_this) {
@@ -1021,28 +1404,65 @@ sp_tweak_dilate (TweakTool *tc, Geom::Point event_p, Geom::Point p, Geom::Point
     double move_force = get_move_force(tc);
     double color_force = MIN(sqrt(path_force)/20.0, 1);
 
-    //    auto items= selection->items();
-    std::vector<SPItem*> items(selection->items().begin(), selection->items().end());
-    for(auto item : items){
-        if (is_color_mode (tc->mode)) {
-            if (do_fill || do_stroke || do_opacity) {
-                if (sp_tweak_color_recursive (tc->mode, item, item_at_point,
-                        fill_goal, do_fill,
-                        stroke_goal, do_stroke,
-                        opacity_goal, do_opacity,
-                        tc->mode == TWEAK_MODE_BLUR, reverse,
-                        p, radius, color_force, tc->do_h, tc->do_s, tc->do_l, tc->do_o)) {
-                    did = true;
-                }
+    if (is_color_mode(tc->mode) && !(do_fill || do_stroke || do_opacity)) {
+        return false;
+    }
+
+    if (!tc->stroke || tc->stroke->stale) {
+        tc->stroke = std::make_unique<TweakTool::Stroke>(selection);
+    }
+    auto &stroke = *tc->stroke;
+    Geom::Rect const reach(p - Geom::Point(radius, radius), p + Geom::Point(radius, radius));
+
+    if (is_color_mode(tc->mode)) {
+        // Colors are tweaked for the items whose geometric bounding boxes touch the brush, which
+        // lie within their visual ones, and for the item under the pointer.
+        auto indices = stroke.query(reach);
+        if (auto index = stroke.indexOf(item_at_point); index >= 0) {
+            auto it = std::lower_bound(indices.begin(), indices.end(), index);
+            if (it == indices.end() || *it != index) {
+                indices.insert(it, index);
             }
-        } else if (is_transform_mode(tc->mode)) {
-            if (sp_tweak_dilate_recursive (selection, item, p, vector, tc->mode, radius, move_force, tc->fidelity, reverse)) {
+        }
+        for (auto index : indices) {
+            if (sp_tweak_color_recursive (tc->mode, stroke.entries[index].item, item_at_point,
+                    fill_goal, do_fill,
+                    stroke_goal, do_stroke,
+                    opacity_goal, do_opacity,
+                    tc->mode == TWEAK_MODE_BLUR, reverse,
+                    p, radius, color_force, tc->do_h, tc->do_s, tc->do_l, tc->do_o)) {
                 did = true;
             }
-        } else {
-            if (sp_tweak_dilate_recursive (selection, item, p, vector, tc->mode, radius, path_force, tc->fidelity, reverse)) {
-                did = true;
+        }
+        return did;
+    }
+
+    double const force = is_transform_mode(tc->mode) ? move_force : path_force;
+
+    for (auto index : stroke.query(reach)) {
+        SPItem *item = stroke.entries[index].item;
+
+        // Text and 3D boxes become paths and groups when tweaked, and so do other shapes, or
+        // their copies appear, once they are actually changed.
+        bool const converted = is<SPText>(item) || is<SPFlowtext>(item)
+                            || (is<SPBox3D>(item) && !is_transform_mode(tc->mode));
+        bool const replaced = !is_transform_mode(tc->mode) && !is<SPPath>(item);
+
+        if (sp_tweak_dilate_recursive (selection, item, p, vector, tc->mode, radius, force, tc->fidelity, reverse, stroke)) {
+            did = true;
+            if (tc->mode == TWEAK_MODE_MORELESS) {
+                // The entries were updated for the deleted or copied item, unless other items
+                // may have gone with a deleted one. Then the remaining entries cannot be trusted.
+                if (stroke.stale) {
+                    break;
+                }
+            } else if (replaced || converted) {
+                stroke.stale = true;
+            } else {
+                stroke.update(index);
             }
+        } else if (converted) {
+            stroke.stale = true;
         }
     }
 
@@ -1124,6 +1544,7 @@ bool TweakTool::root_handler(CanvasEvent const &event)
                     is_drawing = true;
                     is_dilating = true;
                     has_dilated = false;
+                    stroke.reset();
 
                     ret = true;
                 }
@@ -1143,11 +1564,7 @@ bool TweakTool::root_handler(CanvasEvent const &event)
             dilate_area->set_bpath(path);
             dilate_area->set_visible(true);
 
-            unsigned num = 0;
-            if (!_desktop->getSelection()->isEmpty()) {
-                num = (unsigned)boost::distance(_desktop->getSelection()->items());
-            }
-            if (num == 0) {
+            if (_desktop->getSelection()->isEmpty()) {
                 message_context->flash(Inkscape::ERROR_MESSAGE, _("<b>Nothing selected!</b> Select objects to tweak."));
             }
 
@@ -1175,6 +1592,7 @@ bool TweakTool::root_handler(CanvasEvent const &event)
                 }
                 is_dilating = false;
                 has_dilated = false;
+                stroke.reset();
                 Glib::ustring text;
                 switch (mode) {
                     case TWEAK_MODE_MOVE:
@@ -13,6 +13,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <memory>
 #include <2geom/point.h>
 #include "ui/tools/tool-base.h"
 #include "display/control/canvas-item-ptr.h"
@@ -68,6 +69,10 @@ public:
     Geom::Point last_push;
     CanvasItemPtr<CanvasItemBpath> dilate_area;
 
+    /// The items under tweaking and their livarot shapes, kept during one stroke.
+    struct Stroke;
+    std::unique_ptr<Stroke> stroke;
+
     bool do_h;
     bool do_s;
     bool do_l;
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "preferences.h"
+
+namespace Inkscape::Util {
+
+namespace {
+
+/// The number of threads to start for count jobs, when asked for nthreads.
+std::size_t clamp_threads(std::size_t count, int nthreads)
+{
+    return std::min<std::size_t>(count, std::max(nthreads, 1));
+}
+
+} // namespace
+
+int get_num_threads()
+{
+    // hardware_concurrency() may be 0 if unknown.
+    return std::max(1, Preferences::get()->getIntLimited("/options/threading/numthreads", std::thread::hardware_concurrency(), 1, 256));
+}
+
+void parallel_for(std::size_t count, int nthreads, std::function<void(std::size_t)> const &job)
+{
+    std::atomic<std::size_t> next = 0;
+    auto work = [&] {
+        for (std::size_t i; (i = next++) < count; ) {
+            job(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < clamp_threads(count, nthreads); t++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+void parallel_for(std::size_t count, int nthreads, std::function<void(std::size_t)> const &job,
+                  std::function<void()> const &poll, std::chrono::milliseconds interval)
+{
+    auto const nworkers = clamp_threads(count, nthreads);
+
+    std::atomic<std::size_t> next = 0;
+    std::mutex mutex;
+    std::condition_variable cond;
+    auto running = nworkers;
+
+    auto work = [&] {
+        for (std::size_t i; (i = next++) < count; ) {
+            job(i);
+        }
+        auto lock = std::lock_guard(mutex);
+        running--;
+        cond.notify_one();
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < nworkers; t++) {
+        threads.emplace_back(work);
+    }
+
+    {
+        auto lock = std::unique_lock(mutex);
+        while (!cond.wait_for(lock, interval, [&] { return running == 0; })) {
+            lock.unlock();
+            poll();
+            lock.lock();
+        }
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+    poll();
+}
+
+} // namespace Inkscape::Util
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim:filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99:
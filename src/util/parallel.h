@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** \file
+ * Run independent jobs on a number of threads.
+ */
+
+#ifndef INKSCAPE_UTIL_PARALLEL_H
+#define INKSCAPE_UTIL_PARALLEL_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace Inkscape::Util {
+
+/**
+ * Return the number of threads to use for parallel work: the value of /options/threading/numthreads,
+ * or the hardware concurrency if unset, and at least 1.
+ *
+ * This reads the preferences, so only call it on the main thread. Work that runs on another thread
+ * must be handed the thread count by the code that starts it.
+ */
+int get_num_threads();
+
+/**
+ * Run \a job(i) for every i in [0, count), on the calling thread and up to \a nthreads - 1 other
+ * threads. Jobs are taken in increasing order of i. Returns once all jobs have finished.
+ *
+ * Jobs must not throw. To stop early, make the remaining jobs return immediately.
+ */
+void parallel_for(std::size_t count, int nthreads, std::function<void(std::size_t)> const &job);
+
+/**
+ * Like parallel_for(), but run all jobs on up to \a nthreads worker threads, while the calling
+ * thread calls \a poll() every \a interval until they have finished, and once more after that.
+ * Use this to report progress or check for cancellation from the calling thread.
+ */
+void parallel_for(std::size_t count, int nthreads, std::function<void(std::size_t)> const &job,
+                  std::function<void()> const &poll, std::chrono::milliseconds interval);
+
+} // namespace Inkscape::Util
+
+#endif // INKSCAPE_UTIL_PARALLEL_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -50,13 +50,113 @@ using Inkscape::XML::rebase_href_attrs;
 Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns);
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
-static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
+namespace {
+
+/**
+ * Collects serialized XML in a large buffer, which is passed on to the Writer in one block
+ * whenever it fills up instead of character by character.
+ */
+class XmlBuffer
+{
+public:
+    explicit XmlBuffer(Writer &out)
+        : _out(out)
+    {
+        _buf.reserve(CAPACITY);
+    }
+
+    XmlBuffer(XmlBuffer const &) = delete;
+    XmlBuffer &operator=(XmlBuffer const &) = delete;
+
+    void append(char c)
+    {
+        _buf.push_back(c);
+        _check();
+    }
+
+    void append(char const *str, size_t len)
+    {
+        _buf.append(str, len);
+        _check();
+    }
+
+    /// Append a string; null is written as "(null)", like printf() did.
+    void append(char const *str)
+    {
+        if (!str) {
+            str = "(null)";
+        }
+        append(str, std::strlen(str));
+    }
+
+    void appendIndent(int indent_level, int indent)
+    {
+        if (indent_level > 0 && indent > 0) {
+            _buf.append(static_cast<size_t>(indent_level) * indent, ' ');
+            _check();
+        }
+    }
+
+    /// Append a string with the characters special to XML replaced by entities.
+    void appendQuoted(char const *val, bool attr)
+    {
+        if (!val) {
+            return;
+        }
+        char const *special = attr ? "\"&<>\n" : "\"&<>";
+        while (true) {
+            size_t len = std::strcspn(val, special);
+            _buf.append(val, len);
+            val += len;
+            switch (*val) {
+                case '"': _buf.append("&quot;"); break;
+                case '&': _buf.append("&amp;"); break;
+                case '<': _buf.append("&lt;"); break;
+                case '>': _buf.append("&gt;"); break;
+                case '\n': _buf.append("&#10;"); break;
+                default: _check(); return;
+            }
+            val++;
+        }
+    }
+
+    void flush()
+    {
+        if (!_buf.empty()) {
+            _out.write(_buf.data(), _buf.size());
+            _buf.clear();
+        }
+    }
+
+private:
+    static constexpr size_t CAPACITY = 64 * 1024;
+
+    void _check()
+    {
+        if (_buf.size() >= CAPACITY) {
+            flush();
+        }
+    }
+
+    Writer &_out;
+    std::string _buf;
+};
+
+} // namespace
+
+static void sp_repr_write_stream_root_element(Node *repr, XmlBuffer &out,
                                               bool add_whitespace, gchar const *default_ns,
                                               int inlineattrs, int indent,
                                               gchar const *old_href_abs_base,
                                               gchar const *new_href_abs_base);
 
-static void sp_repr_write_stream_element(Node *repr, Writer &out,
+static void sp_repr_write_stream_node(Node *repr, XmlBuffer &out, gint indent_level,
+                                      bool add_whitespace, Glib::QueryQuark elide_prefix,
+                                      int inlineattrs, int indent,
+                                      gchar const *old_href_base,
+                                      gchar const *new_href_base);
+
+static void sp_repr_write_stream_element(Node *repr, XmlBuffer &out,
                                          gint indent_level, bool add_whitespace,
                                          Glib::QueryQuark elide_prefix,
                                          const AttributeVector & attributes,
@@ -602,12 +702,14 @@ static void sp_repr_save_writer(Document *doc, Inkscape::IO::Writer *out,
     bool inlineattrs = prefs->getBool("/options/svgoutput/inlineattrs");
     int indent = prefs->getInt("/options/svgoutput/indent", 2);
 
+    XmlBuffer buf(*out);
+
     /* fixme: do this The Right Way */
-    out->writeString( "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n" );
+    buf.append( "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n" );
 
     const gchar *str = static_cast<Node *>(doc)->attribute("doctype");
     if (str) {
-        out->writeString( str );
+        buf.append( str );
     }
 
     for (Node *repr = sp_repr_document_first_child(doc);
@@ -615,16 +717,18 @@ static void sp_repr_save_writer(Document *doc, Inkscape::IO::Writer *out,
     {
         Inkscape::XML::NodeType const node_type = repr->type();
         if ( node_type == Inkscape::XML::NodeType::ELEMENT_NODE ) {
-            sp_repr_write_stream_root_element(repr, *out, TRUE, default_ns, inlineattrs, indent,
+            sp_repr_write_stream_root_element(repr, buf, TRUE, default_ns, inlineattrs, indent,
                                               old_href_abs_base, new_href_abs_base);
         } else {
-            sp_repr_write_stream(repr, *out, 0, TRUE, GQuark(0), inlineattrs, indent,
-                                 old_href_abs_base, new_href_abs_base);
+            sp_repr_write_stream_node(repr, buf, 0, TRUE, GQuark(0), inlineattrs, indent,
+                                      old_href_abs_base, new_href_abs_base);
             if ( node_type == Inkscape::XML::NodeType::COMMENT_NODE ) {
-                out->writeChar('\n');
+                buf.append('\n');
             }
         }
     }
+
+    buf.flush();
 }
 
 
@@ -647,7 +751,13 @@ void sp_repr_save_stream(Document *doc, FILE *fp, gchar const *default_ns, bool
                     gchar const *const new_href_abs_base)
 {
     Inkscape::IO::FileOutputStream bout(fp);
-    Inkscape::IO::GzipOutputStream *gout = compress ? new Inkscape::IO::GzipOutputStream(bout) : nullptr;
+    Inkscape::IO::GzipOutputStream *gout = nullptr;
+    if (compress) {
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        int level = prefs->getIntLimited("/options/svgoutput/compression_level", Z_DEFAULT_COMPRESSION, Z_DEFAULT_COMPRESSION, Z_BEST_COMPRESSION);
+        // Compress on a worker thread while the document is being serialized.
+        gout = new Inkscape::IO::GzipOutputStream(bout, level, true);
+    }
     Inkscape::IO::OutputStreamWriter *out  = compress ? new Inkscape::IO::OutputStreamWriter( *gout ) : new Inkscape::IO::OutputStreamWriter( bout );
 
     sp_repr_save_writer(doc, out, default_ns, old_href_abs_base, new_href_abs_base);
@@ -727,40 +837,21 @@ bool sp_repr_save_file(Document *doc, gchar const *const filename, gchar const *
 }
 
 
-/* (No doubt this function already exists elsewhere.) */
-static void repr_quote_write (Writer &out, const gchar * val, bool attr)
-{
-    if (val) {
-        for (; *val != '\0'; val++) {
-            switch (*val) {
-                case '"': out.writeString( "&quot;" ); break;
-                case '&': out.writeString( "&amp;" ); break;
-                case '<': out.writeString( "&lt;" ); break;
-                case '>': out.writeString( "&gt;" ); break;
-                case '\n': out.writeString( attr ? "&#10;" : "\n" ); break;
-                default: out.writeChar( *val ); break;
-            }
-        }
-    }
-}
-
-static void repr_write_comment( Writer &out, const gchar * val, bool addWhitespace, gint indentLevel, int indent )
+static void repr_write_comment( XmlBuffer &out, const gchar * val, bool addWhitespace, gint indentLevel, int indent )
 {
     if ( indentLevel > 16 ) {
         indentLevel = 16;
     }
     if (addWhitespace && indent) {
-        for (gint i = 0; i < indentLevel; i++) {
-            for (gint j = 0; j < indent; j++) {
-                out.writeChar(' ');
-            }
-        }
+        out.appendIndent(indentLevel, indent);
     }
 
-    out.printf("<!--%s-->", val);
+    out.append("<!--");
+    out.append(val);
+    out.append("-->");
 
     if (addWhitespace) {
-        out.writeChar('\n');
+        out.append('\n');
     }
 }
 
@@ -826,7 +917,7 @@ void populate_ns_map(NSMap &ns_map, Node &repr) {
 
 }
 
-static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
+static void sp_repr_write_stream_root_element(Node *repr, XmlBuffer &out,
                                   bool add_whitespace, gchar const *default_ns,
                                   int inlineattrs, int indent,
                                   gchar const *const old_href_base,
@@ -892,6 +983,18 @@ void sp_repr_write_stream( Node *repr, Writer &out, gint indent_level,
                            int inlineattrs, int indent,
                            gchar const *const old_href_base,
                            gchar const *const new_href_base)
+{
+    XmlBuffer buf(out);
+    sp_repr_write_stream_node(repr, buf, indent_level, add_whitespace, elide_prefix,
+                              inlineattrs, indent, old_href_base, new_href_base);
+    buf.flush();
+}
+
+static void sp_repr_write_stream_node( Node *repr, XmlBuffer &out, gint indent_level,
+                                       bool add_whitespace, Glib::QueryQuark elide_prefix,
+                                       int inlineattrs, int indent,
+                                       gchar const *const old_href_base,
+                                       gchar const *const new_href_base)
 {
     switch (repr->type()) {
         case Inkscape::XML::NodeType::TEXT_NODE: {
@@ -899,9 +1002,11 @@ void sp_repr_write_stream( Node *repr, Writer &out, gint indent_level,
             assert(textnode);
             if (textnode->is_CData()) {
                 // Preserve CDATA sections, not converting '&' to &amp;, etc.
-                out.printf( "<![CDATA[%s]]>", repr->content() );
+                out.append( "<![CDATA[" );
+                out.append( repr->content() );
+                out.append( "]]>" );
             } else {
-                repr_quote_write( out, repr->content(), false );
+                out.appendQuoted( repr->content(), false );
             }
             break;
         }
@@ -910,7 +1015,11 @@ void sp_repr_write_stream( Node *repr, Writer &out, gint indent_level,
             break;
         }
         case Inkscape::XML::NodeType::PI_NODE: {
-            out.printf( "<?%s %s?>", repr->name(), repr->content() );
+            out.append( "<?" );
+            out.append( repr->name() );
+            out.append( ' ' );
+            out.append( repr->content() );
+            out.append( "?>" );
             break;
         }
         case Inkscape::XML::NodeType::ELEMENT_NODE: {
@@ -932,7 +1041,7 @@ void sp_repr_write_stream( Node *repr, Writer &out, gint indent_level,
 }
 
 
-void sp_repr_write_stream_element( Node * repr, Writer & out,
+void sp_repr_write_stream_element( Node * repr, XmlBuffer & out,
                                    gint indent_level, bool add_whitespace,
                                    Glib::QueryQuark elide_prefix,
                                    const AttributeVector & attributes, 
@@ -951,11 +1060,7 @@ void sp_repr_write_stream_element( Node * repr, Writer & out,
     }
 
     if (add_whitespace && indent) {
-        for (gint i = 0; i < indent_level; i++) {
-            for (gint j = 0; j < indent; j++) {
-                out.writeChar(' ');
-            }
-        }
+        out.appendIndent(indent_level, indent);
     }
 
     GQuark code = repr->code();
@@ -965,7 +1070,8 @@ void sp_repr_write_stream_element( Node * repr, Writer & out,
     } else {
         element_name = g_quark_to_string(code);
     }
-    out.printf( "<%s", element_name );
+    out.append( '<' );
+    out.append( element_name );
 
     // If this is a <text> element, suppress formatting whitespace
     // for its content and children:
@@ -985,18 +1091,16 @@ void sp_repr_write_stream_element( Node * repr, Writer & out,
     const auto rbd = rebase_href_attrs(old_href_base, new_href_base, attributes);
     for (const auto &iter : rbd) {
         if (!inlineattrs) {
-            out.writeChar('\n');
+            out.append('\n');
             if (indent) {
-                for ( gint i = 0 ; i < indent_level + 1 ; i++ ) {
-                    for ( gint j = 0 ; j < indent ; j++ ) {
-                        out.writeChar(' ');
-                    }
-                }
+                out.appendIndent(indent_level + 1, indent);
             }
         }
-        out.printf(" %s=\"", g_quark_to_string(iter.key));
-        repr_quote_write(out, iter.value, true);
-        out.writeChar('"');
+        out.append(' ');
+        out.append(g_quark_to_string(iter.key));
+        out.append("=\"");
+        out.appendQuoted(iter.value, true);
+        out.append('"');
     }
 
     loose = TRUE;
@@ -1008,30 +1112,28 @@ void sp_repr_write_stream_element( Node * repr, Writer & out,
     }
 
     if (repr->firstChild()) {
-        out.writeChar('>');
+        out.append('>');
         if (loose && add_whitespace) {
-            out.writeChar('\n');
+            out.append('\n');
         }
         for (child = repr->firstChild(); child != nullptr; child = child->next()) {
-            sp_repr_write_stream(child, out, ( loose ? indent_level + 1 : 0 ),
+            sp_repr_write_stream_node(child, out, ( loose ? indent_level + 1 : 0 ),
                                  add_whitespace, elide_prefix, inlineattrs, indent,
                                  old_href_base, new_href_base);
         }
 
         if (loose && add_whitespace && indent) {
-            for (gint i = 0; i < indent_level; i++) {
-                for ( gint j = 0 ; j < indent ; j++ ) {
-                    out.writeChar(' ');
-                }
-            }
+            out.appendIndent(indent_level, indent);
         }
-        out.printf( "</%s>", element_name );
+        out.append( "</" );
+        out.append( element_name );
+        out.append( '>' );
     } else {
-        out.writeString( " />" );
+        out.append( " />" );
     }
 
     if (add_whitespace_parent) {
-        out.writeChar('\n');
+        out.append('\n');
     }
 }
 
@@ -9,6 +9,10 @@
  * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
  */
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <src/display/cairo-utils.h>
 #include <src/inkscape.h>
@@ -48,4 +52,61 @@ TEST_F(PixbufTest, creatingFromSvgUriWithoutViewboxOrWidthAndHeightReturnsNull)
     double default_dpi = 96.0;
 
     ASSERT_EQ(Inkscape::Pixbuf::create_from_data_uri(uri_data.c_str(), default_dpi), nullptr);
-}
\ No newline at end of file
+}
+/// Sends an opaque grey ramp through linearRGB and back; returns the resulting level of each input level.
+static std::vector<int> linear_rgb_round_trip(bool precise)
+{
+    set_precise_linear_rgb(precise);
+
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 256, 1);
+    auto px = reinterpret_cast<guint32 *>(cairo_image_surface_get_data(surface));
+    for (guint32 c = 0; c < 256; c++) {
+        px[c] = 0xff000000 | (c << 16) | (c << 8) | c;
+    }
+    cairo_surface_mark_dirty(surface);
+
+    ink_cairo_surface_srgb_to_linear(surface);
+    ink_cairo_surface_linear_to_srgb(surface);
+
+    std::vector<int> result;
+    for (int c = 0; c < 256; c++) {
+        EXPECT_EQ(px[c] >> 24, 0xffu);
+        result.push_back((px[c] >> 8) & 0xff);
+    }
+    cairo_surface_destroy(surface);
+
+    set_precise_linear_rgb(false);
+    return result;
+}
+
+TEST(LinearRGBTest, preciseConversionReducesRoundTripError)
+{
+    auto const truncated = linear_rgb_round_trip(false);
+    auto const rounded = linear_rgb_round_trip(true);
+
+    // Truncation loses a level on nearly every round trip, even white.
+    EXPECT_EQ(truncated[255], 254);
+
+    int truncated_exact = 0, rounded_exact = 0, truncated_error = 0, rounded_error = 0, rounded_max_error = 0;
+    for (int c = 0; c < 256; c++) {
+        truncated_exact += truncated[c] == c;
+        rounded_exact += rounded[c] == c;
+        truncated_error += std::abs(truncated[c] - c);
+        rounded_error += std::abs(rounded[c] - c);
+        rounded_max_error = std::max(rounded_max_error, std::abs(rounded[c] - c));
+        if (c > 0) {
+            EXPECT_GE(rounded[c], rounded[c - 1]);
+        }
+    }
+
+    // Linear light has too few dark levels in 8 bits, so dark shades still merge, but every level
+    // from 124 up survives and no level moves by more than the spacing of the dark linear levels.
+    EXPECT_EQ(rounded[0], 0);
+    EXPECT_EQ(rounded[255], 255);
+    for (int c = 124; c < 256; c++) {
+        EXPECT_EQ(rounded[c], c);
+    }
+    EXPECT_GT(rounded_exact, truncated_exact);
+    EXPECT_LT(rounded_error, truncated_error);
+    EXPECT_LE(rounded_max_error, 6);
+}
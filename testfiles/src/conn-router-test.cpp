@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Test connector routing on document updates and on the router's worker thread.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "conn-router.h"
+#include "document.h"
+#include "inkscape.h"
+#include "object/sp-path.h"
+
+using namespace std::literals;
+
+namespace {
+
+// Two shapes at different heights joined by an orthogonal connector, drawn straight across.
+constexpr auto docString = R"A(
+<svg xmlns='http://www.w3.org/2000/svg' xmlns:inkscape='http://www.inkscape.org/namespaces/inkscape'
+     width='220' height='100'>
+<rect id='a' x='0' y='0' width='20' height='20'/>
+<rect id='b' x='200' y='60' width='20' height='20'/>
+<path id='conn' d='M 20,10 H 200' inkscape:connector-type='orthogonal'
+      inkscape:connection-start='#a' inkscape:connection-end='#b'/>
+</svg>)A"sv;
+
+void wait_for_worker(Inkscape::ConnRouter const &router)
+{
+    auto const deadline = std::chrono::steady_clock::now() + 10s;
+    while (router.busy() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    ASSERT_FALSE(router.busy());
+}
+
+double route_height(SPPath const *path)
+{
+    auto const bounds = path->curve()->get_pathvector().boundsFast();
+    return bounds ? bounds->height() : 0.0;
+}
+
+} // namespace
+
+class ConnRouterTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (!Inkscape::Application::exists()) {
+            Inkscape::Application::create(false);
+        }
+        doc = SPDocument::createNewDocFromMem(docString, false);
+        ASSERT_TRUE(doc);
+        path = cast<SPPath>(doc->getObjectById("conn"));
+        ASSERT_TRUE(path);
+    }
+
+    std::unique_ptr<SPDocument> doc;
+    SPPath *path = nullptr;
+};
+
+// Updating the document routes the connectors, so that whatever reads them next sees the final
+// routes.
+TEST_F(ConnRouterTest, UpdateRoutes)
+{
+    doc->ensureUpToDate();
+    EXPECT_GT(route_height(path), 50.0);
+
+    doc->getObjectById("b")->setAttribute("y", "0");
+    doc->ensureUpToDate();
+    EXPECT_LT(route_height(path), 1.0);
+}
+
+// Routing in the background, as while dragging, leaves connectors alone until the worker has
+// finished and its routes are collected.
+TEST_F(ConnRouterTest, RouteInBackground)
+{
+    auto &router = doc->getConnRouter();
+    doc->ensureUpToDate();
+    ASSERT_GT(route_height(path), 50.0);
+
+    doc->getObjectById("b")->setAttribute("y", "0");
+    doc->_updateDocument(0);
+    router.routeInBackground();
+    wait_for_worker(router);
+    EXPECT_GT(route_height(path), 50.0);
+
+    router.collect();
+    EXPECT_LT(route_height(path), 1.0);
+
+    // Nothing has changed since, so there is nothing left to route.
+    router.routeInBackground();
+    EXPECT_FALSE(router.busy());
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
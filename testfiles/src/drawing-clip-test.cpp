@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Compare the ways clips are applied when rendering.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cairomm/surface.h>
+#include <2geom/int-rect.h>
+
+#include "inkscape.h"
+#include "document.h"
+#include "object/sp-root.h"
+#include "display/drawing.h"
+#include "display/drawing-surface.h"
+#include "display/drawing-context.h"
+
+// A clip made of a single path is filled straight into the intermediate surface, others are
+// composited in. Both must give the same pixels, also where the edges of the clip lie between pixels.
+TEST(DrawingClipTest, SinglePathMatchesComposited)
+{
+    if (!Inkscape::Application::exists()) {
+        Inkscape::Application::create(false);
+    }
+
+    // The same rotated clip, whose edges lie between pixels: on the left a single path, on the right
+    // with a second shape outside the object, so that it is composited in.
+    auto doc = SPDocument::createNewDocFromMem(R"(<svg xmlns="http://www.w3.org/2000/svg" width="100" height="50">
+  <defs>
+    <clipPath id="rotated">
+      <rect x="10.3" y="5.7" width="30.4" height="30.2" transform="rotate(17 25.5 20.8)" />
+    </clipPath>
+    <clipPath id="rotated-multiple">
+      <rect x="60.3" y="5.7" width="30.4" height="30.2" transform="rotate(17 75.5 20.8)" />
+      <rect x="0" y="0" width="1" height="1" />
+    </clipPath>
+  </defs>
+  <rect x="0" y="0" width="50" height="50" style="fill:#ff8000" clip-path="url(#rotated)" />
+  <rect x="50" y="0" width="50" height="50" style="fill:#ff8000" clip-path="url(#rotated-multiple)" />
+</svg>)", false);
+    ASSERT_TRUE((bool)doc);
+    ASSERT_TRUE((bool)doc->getRoot());
+    doc->ensureUpToDate();
+
+    Inkscape::Drawing drawing;
+    auto const root = doc->getRoot();
+    auto const dkey = SPItem::display_key_new(1);
+    drawing.setRoot(root->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+    drawing.update();
+
+    auto const area = Geom::IntRect::from_xywh(0, 0, 100, 50);
+    auto cs = Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32, area.width(), area.height());
+    {
+        auto ds = Inkscape::DrawingSurface(cs->cobj(), area.min());
+        auto dc = Inkscape::DrawingContext(ds);
+        drawing.render(dc, area);
+    }
+    cs->flush();
+
+    int partial = 0;
+    int differing = 0;
+    for (int y = 0; y < area.height(); y++) {
+        auto const row = cs->get_data() + y * cs->get_stride();
+        for (int x = 0; x < area.width() / 2; x++) {
+            auto const left = row + x * 4;
+            auto const right = row + (x + area.width() / 2) * 4;
+            if (left[3] != 0 && left[3] != 255) {
+                partial++;
+            }
+            if (!std::equal(left, left + 4, right)) {
+                differing++;
+            }
+        }
+    }
+
+    EXPECT_GT(partial, 0);
+    EXPECT_EQ(differing, 0);
+
+    root->invoke_hide(dkey);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Render filters that work in linearRGB.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <cairomm/surface.h>
+#include <2geom/int-rect.h>
+
+#include "inkscape.h"
+#include "document.h"
+#include "object/sp-root.h"
+#include "display/cairo-utils.h"
+#include "display/drawing.h"
+#include "display/drawing-surface.h"
+#include "display/drawing-context.h"
+
+namespace {
+
+// A ramp of every opaque grey level, one pixel column each, through an identity colour matrix
+// computed in linearRGB. The filter itself changes nothing, so every difference between input
+// and output comes from converting to linearRGB and back.
+std::vector<int> render_grey_ramp(bool precise)
+{
+    std::string svg = R"(<svg xmlns="http://www.w3.org/2000/svg" width="256" height="4"><defs>)"
+                      R"(<filter id="identity" filterUnits="userSpaceOnUse" x="0" y="0" width="256" height="4" )"
+                      R"(color-interpolation-filters="linearRGB">)"
+                      R"(<feColorMatrix type="matrix" values="1 0 0 0 0  0 1 0 0 0  0 0 1 0 0  0 0 0 1 0"/>)"
+                      R"(</filter></defs><g filter="url(#identity)">)";
+    for (int c = 0; c < 256; c++) {
+        char fill[8];
+        std::snprintf(fill, sizeof(fill), "#%02x%02x%02x", c, c, c);
+        svg += "<rect x=\"" + std::to_string(c) + "\" y=\"0\" width=\"1\" height=\"4\" fill=\"" + fill + "\"/>";
+    }
+    svg += "</g></svg>";
+
+    auto doc = SPDocument::createNewDocFromMem(svg, false);
+    EXPECT_TRUE((bool)doc);
+    if (!doc) {
+        return {};
+    }
+    doc->ensureUpToDate();
+
+    set_precise_linear_rgb(precise);
+
+    Inkscape::Drawing drawing;
+    auto const root = doc->getRoot();
+    auto const dkey = SPItem::display_key_new(1);
+    drawing.setRoot(root->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+    drawing.update();
+
+    auto const area = Geom::IntRect::from_xywh(0, 0, 256, 4);
+    auto cs = Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32, area.width(), area.height());
+    {
+        auto ds = Inkscape::DrawingSurface(cs->cobj(), area.min());
+        auto dc = Inkscape::DrawingContext(ds);
+        drawing.render(dc, area);
+    }
+    cs->flush();
+
+    std::vector<int> result;
+    auto const row = reinterpret_cast<guint32 const *>(cs->get_data() + 2 * cs->get_stride());
+    for (int c = 0; c < 256; c++) {
+        EXPECT_EQ(row[c] >> 24, 0xffu);
+        result.push_back((row[c] >> 8) & 0xff);
+    }
+
+    root->invoke_hide(dkey);
+    set_precise_linear_rgb(false);
+    return result;
+}
+
+} // namespace
+
+TEST(DrawingFilterTest, RoundedLinearRGBReducesDarkeningAndBanding)
+{
+    if (!Inkscape::Application::exists()) {
+        Inkscape::Application::create(false);
+    }
+
+    auto const truncated = render_grey_ramp(false);
+    auto const rounded = render_grey_ramp(true);
+    ASSERT_EQ(truncated.size(), 256);
+    ASSERT_EQ(rounded.size(), 256);
+
+    // Darkening: the sum of how far each level moved down, and the levels that came back unchanged.
+    // Banding: the number of distinct levels left in the ramp.
+    auto measure = [] (std::vector<int> const &ramp, int &darkening, int &exact, int &distinct) {
+        darkening = exact = distinct = 0;
+        for (int c = 0; c < 256; c++) {
+            darkening += std::max(c - ramp[c], 0);
+            exact += ramp[c] == c;
+            distinct += c == 0 || ramp[c] != ramp[c - 1];
+        }
+    };
+
+    int truncated_darkening, truncated_exact, truncated_distinct;
+    int rounded_darkening, rounded_exact, rounded_distinct;
+    measure(truncated, truncated_darkening, truncated_exact, truncated_distinct);
+    measure(rounded, rounded_darkening, rounded_exact, rounded_distinct);
+
+    // Truncating darkens even white; rounding keeps the light half of the ramp exact.
+    EXPECT_EQ(truncated[255], 254);
+    EXPECT_EQ(rounded[255], 255);
+    for (int c = 124; c < 256; c++) {
+        EXPECT_EQ(rounded[c], c);
+    }
+
+    EXPECT_LT(rounded_darkening, truncated_darkening / 2);
+    EXPECT_GT(rounded_exact, truncated_exact);
+    EXPECT_GT(rounded_distinct, truncated_distinct);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
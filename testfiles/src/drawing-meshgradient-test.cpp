@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Compare the mesh gradient rasterizer with cairo's.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <cairo.h>
+#include <2geom/affine.h>
+#include <2geom/transforms.h>
+
+#include "display/drawing-paintserver.h"
+
+using Inkscape::DrawingMeshGradient;
+
+namespace {
+
+/// A 2 × 2 mesh over (0, 0) - (200, 200), with a mix of curved and straight sides and one tensor point.
+DrawingMeshGradient make_mesh()
+{
+    Geom::Point const nodes[3][3] = {
+        {{0, 0}, {100, 0}, {200, 0}},
+        {{0, 100}, {110, 90}, {200, 100}},
+        {{0, 200}, {100, 200}, {200, 200}},
+    };
+    float const colors[3][3][3] = {
+        {{1.0, 0.0, 0.0}, {1.0, 1.0, 0.0}, {0.0, 1.0, 0.0}},
+        {{1.0, 0.0, 1.0}, {1.0, 1.0, 1.0}, {0.0, 1.0, 1.0}},
+        {{0.0, 0.0, 1.0}, {0.0, 0.0, 0.0}, {0.5, 0.5, 0.5}},
+    };
+    double const opacities[3][3] = {
+        {1.0, 0.8, 1.0},
+        {0.6, 1.0, 0.9},
+        {1.0, 0.7, 1.0},
+    };
+
+    std::vector<std::vector<DrawingMeshGradient::PatchData>> patchdata(2);
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 2; c++) {
+            int const corner_row[4] = {r, r, r + 1, r + 1};
+            int const corner_col[4] = {c, c + 1, c + 1, c};
+
+            DrawingMeshGradient::PatchData data{};
+            for (int k = 0; k < 4; k++) {
+                int const row = corner_row[k], col = corner_col[k];
+                int const next_row = corner_row[(k + 1) % 4], next_col = corner_col[(k + 1) % 4];
+                auto const a = nodes[row][col];
+                auto const b = nodes[next_row][next_col];
+                auto const bulge = (b - a).cw() * 0.1;
+
+                data.points[k][0] = a;
+                data.points[k][1] = Geom::lerp(1.0 / 3.0, a, b) + bulge;
+                data.points[k][2] = Geom::lerp(2.0 / 3.0, a, b) - bulge;
+                data.points[k][3] = b;
+                data.pathtype[k] = (r + c + k) % 2 ? 'L' : 'C';
+                data.tensorIsSet[k] = false;
+                for (int ch = 0; ch < 3; ch++) {
+                    data.color[k][ch] = colors[row][col][ch];
+                }
+                data.opacity[k] = opacities[row][col];
+            }
+            if (r == 1 && c == 1) {
+                data.tensorIsSet[0] = true;
+                data.tensorpoints[0] = nodes[1][1] + Geom::Point(45, 20);
+            }
+            patchdata[r].push_back(data);
+        }
+    }
+
+    return DrawingMeshGradient(SP_GRADIENT_SPREAD_PAD, SP_GRADIENT_UNITS_USERSPACEONUSE, Geom::Translate(10, 10),
+                               2, 2, std::move(patchdata));
+}
+
+cairo_surface_t *render(DrawingMeshGradient const &mesh, bool direct, Geom::Affine const &ctm, double device_scale,
+                        Geom::OptRect const &clip)
+{
+    int const size = 240 * device_scale;
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+    cairo_surface_set_device_scale(surface, device_scale, device_scale);
+    auto ct = cairo_create(surface);
+
+    if (clip) {
+        cairo_rectangle(ct, clip->left(), clip->top(), clip->width(), clip->height());
+        cairo_clip(ct);
+    }
+
+    cairo_matrix_t matrix;
+    cairo_matrix_init(&matrix, ctm[0], ctm[1], ctm[2], ctm[3], ctm[4], ctm[5]);
+    cairo_set_matrix(ct, &matrix);
+
+    auto pat = direct ? mesh.create_pattern(ct, {}, 0.9) : mesh.create_cairo_mesh_pattern({}, 0.9);
+    cairo_set_source(ct, pat);
+    cairo_paint(ct);
+
+    cairo_pattern_destroy(pat);
+    cairo_destroy(ct);
+    cairo_surface_flush(surface);
+    return surface;
+}
+
+/**
+ * Both rasterizers sample each patch differently, so they can disagree on the outermost pixels.
+ * Inside the mesh, their colors must agree up to the sub-pixel offset between their samples.
+ */
+void expect_close(cairo_surface_t *reference, cairo_surface_t *result)
+{
+    int const width = cairo_image_surface_get_width(reference);
+    int const height = cairo_image_surface_get_height(reference);
+    ASSERT_EQ(width, cairo_image_surface_get_width(result));
+    ASSERT_EQ(height, cairo_image_surface_get_height(result));
+
+    auto pixel = [] (cairo_surface_t *surface, int x, int y) {
+        auto data = cairo_image_surface_get_data(surface) + y * cairo_image_surface_get_stride(surface);
+        return reinterpret_cast<uint32_t const *>(data)[x];
+    };
+    auto covered = [&] (cairo_surface_t *surface, int x, int y) {
+        return x >= 0 && y >= 0 && x < width && y < height && pixel(surface, x, y) >> 24 != 0;
+    };
+
+    int covered_count = 0;
+    int mismatched = 0;
+    int maxdiff = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            bool const in_reference = covered(reference, x, y);
+            covered_count += in_reference;
+            if (in_reference != covered(result, x, y)) {
+                mismatched++;
+                continue;
+            }
+
+            bool interior = true;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    interior = interior && covered(reference, x + dx, y + dy);
+                }
+            }
+            if (!interior) {
+                continue;
+            }
+
+            auto const p = pixel(reference, x, y);
+            auto const q = pixel(result, x, y);
+            for (int c = 0; c < 32; c += 8) {
+                int const diff = std::abs(static_cast<int>((p >> c) & 0xff) - static_cast<int>((q >> c) & 0xff));
+                maxdiff = std::max(maxdiff, diff);
+            }
+        }
+    }
+
+    EXPECT_GT(covered_count, 0);
+    EXPECT_LE(mismatched, covered_count / 50);
+    EXPECT_LE(maxdiff, 6);
+}
+
+void compare(Geom::Affine const &ctm, double device_scale = 1.0, Geom::OptRect const &clip = {})
+{
+    auto const mesh = make_mesh();
+    auto reference = render(mesh, false, ctm, device_scale, clip);
+    auto result = render(mesh, true, ctm, device_scale, clip);
+    expect_close(reference, result);
+    cairo_surface_destroy(reference);
+    cairo_surface_destroy(result);
+}
+
+} // namespace
+
+TEST(DrawingMeshGradientTest, Identity)
+{
+    compare(Geom::identity());
+}
+
+TEST(DrawingMeshGradientTest, Transformed)
+{
+    compare(Geom::Translate(-100, -100) * Geom::Rotate(0.4) * Geom::Scale(0.9, 1.1) * Geom::Translate(120, 120));
+}
+
+TEST(DrawingMeshGradientTest, ZoomedIn)
+{
+    // Only a corner of the mesh is visible, at a zoom level of its own.
+    compare(Geom::Scale(3.7));
+}
+
+TEST(DrawingMeshGradientTest, Clipped)
+{
+    compare(Geom::identity(), 1.0, Geom::Rect(35, 50, 170, 120));
+}
+
+TEST(DrawingMeshGradientTest, DeviceScale)
+{
+    compare(Geom::Scale(0.8), 2.0);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
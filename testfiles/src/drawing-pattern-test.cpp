@@ -16,13 +16,17 @@
 #include <cairomm/surface.h>
 #include <2geom/int-rect.h>
 #include <2geom/int-point.h>
+#include <2geom/transforms.h>
 
 #include "inkscape.h"
 #include "document.h"
+#include "object/sp-pattern.h"
 #include "object/sp-root.h"
 #include "display/drawing.h"
+#include "display/drawing-pattern.h"
 #include "display/drawing-surface.h"
 #include "display/drawing-context.h"
+#include "display/nr-style.h"
 
 TEST(DrawingPatternTest, fragments)
 {
@@ -115,3 +119,76 @@ TEST(DrawingPatternTest, fragments)
 
     ASSERT_LE(maxdiff, 10);
 }
+
+TEST(DrawingPatternTest, TilesSurviveZoom)
+{
+    if (!Inkscape::Application::exists()) {
+        Inkscape::Application::create(false);
+    }
+
+    // Enough items for a change of transform to totally invalidate the pattern.
+    std::string svg = R"(<svg xmlns="http://www.w3.org/2000/svg" width="100" height="100"><defs>)"
+                      R"(<pattern id="pattern" width="20" height="20" patternUnits="userSpaceOnUse">)";
+    for (int i = 0; i < 25; i++) {
+        svg += "<rect id=\"rect" + std::to_string(i) + "\" x=\"" + std::to_string(i % 5 * 4) + "\" y=\""
+             + std::to_string(i / 5 * 4) + "\" width=\"3\" height=\"3\" fill=\"#ff0000\"/>";
+    }
+    svg += R"(</pattern></defs><rect width="100" height="100" fill="url(#pattern)"/></svg>)";
+
+    auto doc = SPDocument::createNewDocFromMem(svg, false);
+    ASSERT_TRUE((bool)doc);
+    doc->ensureUpToDate();
+
+    auto pattern = cast<SPPattern>(doc->getObjectById("pattern"));
+    ASSERT_TRUE(pattern);
+
+    Inkscape::Drawing drawing;
+    auto const dkey = SPItem::display_key_new(1);
+    auto item = pattern->show(drawing, dkey, Geom::Rect(0, 0, 100, 100));
+
+    Inkscape::RenderContext rc{.outline_color = 0};
+    auto const area = Geom::IntRect::from_xywh(0, 0, 10, 10);
+
+    // Update the pattern for a zoom level, as the item painted with it would.
+    auto zoom = [&] (double scale) {
+        item->update(Geom::IntRect::infinite(), {.ctm = Geom::Scale(scale)});
+        EXPECT_GT(item->getUpdateComplexity(), 20);
+    };
+
+    // The surface of the tile block painted from. Holding the pattern keeps the surface alive,
+    // so a newly rendered tile cannot end up at the same address.
+    std::vector<CairoPatternUniqPtr> held;
+    auto tile = [&] {
+        held.emplace_back(item->renderPattern(rc, area, 1.0, 1));
+        cairo_surface_t *surface = nullptr;
+        cairo_pattern_get_surface(held.back().get(), &surface);
+        return surface;
+    };
+
+    zoom(1.0);
+    auto const before = tile();
+    ASSERT_TRUE(before);
+
+    zoom(2.0);
+    auto const zoomed = tile();
+    EXPECT_NE(zoomed, before);
+
+    zoom(1.0);
+    EXPECT_EQ(tile(), before);
+
+    // Zoomed in very far, the resolution is limited and only the block under the area is rendered.
+    zoom(1e6);
+    auto const deep = tile();
+    ASSERT_TRUE(deep);
+    EXPECT_LE(cairo_image_surface_get_width(deep), 256);
+    EXPECT_LE(cairo_image_surface_get_height(deep), 256);
+
+    // Changing the content drops them.
+    doc->getObjectById("rect0")->setAttribute("fill", "#0000ff");
+    doc->ensureUpToDate();
+    zoom(1.0);
+    EXPECT_NE(tile(), before);
+
+    held.clear();
+    pattern->hide(dkey);
+}
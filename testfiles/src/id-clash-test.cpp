@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for resolving ID clashes
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "document.h"
+#include "id-clash.h"
+#include "inkscape.h"
+#include "object/sp-object.h"
+
+using namespace Inkscape;
+
+class IdClashTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // setup hidden dependency
+        Application::create(false);
+    }
+};
+
+static std::string attribute(SPObject *object, char const *name)
+{
+    auto value = object ? object->getAttribute(name) : nullptr;
+    return value ? value : "";
+}
+
+TEST_F(IdClashTest, RenamesAndFixesReferences)
+{
+    auto current = SPDocument::createNewDocFromMem(R"(
+<svg xmlns="http://www.w3.org/2000/svg">
+  <defs>
+    <linearGradient id="g1"><stop offset="0" style="stop-color:#ff0000"/></linearGradient>
+  </defs>
+  <rect id="r1" width="10" height="10"/>
+  <rect id="r1-1" width="10" height="10"/>
+</svg>)", true);
+    auto imported = SPDocument::createNewDocFromMem(R"(
+<svg xmlns="http://www.w3.org/2000/svg" xmlns:xlink="http://www.w3.org/1999/xlink">
+  <defs>
+    <linearGradient id="g1"><stop offset="0" style="stop-color:#0000ff"/></linearGradient>
+  </defs>
+  <rect id="r1" width="10" height="10" style="fill:url(#g1)"/>
+  <use id="u1" xlink:href="#r1"/>
+  <rect id="r2" width="10" height="10" clip-path="url(#r1)"/>
+</svg>)", true);
+    ASSERT_TRUE(current);
+    ASSERT_TRUE(imported);
+
+    prevent_id_clashes(imported.get(), current.get());
+
+    // New IDs are numbered from 1, skipping the ones in use in either document.
+    EXPECT_TRUE(imported->getObjectById("g1-1"));
+    EXPECT_TRUE(imported->getObjectById("r1-2"));
+    EXPECT_FALSE(imported->getObjectById("g1"));
+    EXPECT_FALSE(imported->getObjectById("r1"));
+
+    auto rect = imported->getObjectById("r1-2");
+    EXPECT_NE(attribute(rect, "style").find("url(#g1-1)"), std::string::npos);
+    EXPECT_EQ(attribute(imported->getObjectById("u1"), "xlink:href"), "#r1-2");
+    EXPECT_EQ(attribute(imported->getObjectById("r2"), "clip-path"), "url(#r1-2)");
+}
+
+TEST_F(IdClashTest, RepeatedImportContinuesNumbering)
+{
+    auto current = SPDocument::createNewDocFromMem(R"(
+<svg xmlns="http://www.w3.org/2000/svg">
+  <rect id="r1" width="10" height="10"/>
+</svg>)", true);
+    ASSERT_TRUE(current);
+
+    for (auto expected : {"r1-1", "r1-2", "r1-3"}) {
+        auto imported = SPDocument::createNewDocFromMem(R"(
+<svg xmlns="http://www.w3.org/2000/svg">
+  <rect id="r1" width="10" height="10"/>
+</svg>)", true);
+        ASSERT_TRUE(imported);
+
+        prevent_id_clashes(imported.get(), current.get());
+        EXPECT_TRUE(imported->getObjectById(expected));
+    }
+}
+
+TEST_F(IdClashTest, RenameToTakenId)
+{
+    auto doc = SPDocument::createNewDocFromMem(R"(
+<svg xmlns="http://www.w3.org/2000/svg" xmlns:xlink="http://www.w3.org/1999/xlink">
+  <rect id="a" width="10" height="10"/>
+  <rect id="b-1" width="10" height="10"/>
+  <rect id="c" width="10" height="10"/>
+  <use id="u" xlink:href="#c"/>
+</svg>)", true);
+    ASSERT_TRUE(doc);
+
+    auto c = doc->getObjectById("c");
+    rename_id(c, "a");
+    EXPECT_STREQ(c->getId(), "a-1");
+    EXPECT_EQ(attribute(doc->getObjectById("u"), "xlink:href"), "#a-1");
+
+    rename_id(c, "b");
+    EXPECT_STREQ(c->getId(), "b");
+    EXPECT_EQ(attribute(doc->getObjectById("u"), "xlink:href"), "#b");
+}
+
+TEST_F(IdClashTest, ImportDefsMergesDuplicates)
+{
+    auto current = SPDocument::createNewDocFromMem(R"(
+<svg xmlns="http://www.w3.org/2000/svg">
+  <defs>
+    <linearGradient id="red"><stop offset="0" style="stop-color:#ff0000"/></linearGradient>
+  </defs>
+</svg>)", true);
+    auto source = SPDocument::createNewDocFromMem(R"(
+<svg xmlns="http://www.w3.org/2000/svg">
+  <defs>
+    <linearGradient id="x"><stop offset="0" style="stop-color:#ff0000"/></linearGradient>
+    <linearGradient id="y"><stop offset="0" style="stop-color:#ff0000"/></linearGradient>
+    <linearGradient id="b"><stop offset="0" style="stop-color:#0000ff"/></linearGradient>
+    <linearGradient id="c"><stop offset="0" style="stop-color:#0000ff"/></linearGradient>
+  </defs>
+  <rect id="r1" width="10" height="10" style="fill:url(#x)"/>
+  <rect id="r2" width="10" height="10" style="fill:url(#y)"/>
+  <rect id="r3" width="10" height="10" style="fill:url(#b);stroke:url(#c)"/>
+  <rect id="r4" width="10" height="10" style="fill:url(#c)"/>
+</svg>)", true);
+    ASSERT_TRUE(current);
+    ASSERT_TRUE(source);
+
+    current->importDefs(source.get());
+
+    // Duplicates of a definition in the document refer to that one, later duplicates in the
+    // source to the first one there, however many references to them were changed before.
+    for (auto id : {"r1", "r2"}) {
+        EXPECT_NE(attribute(source->getObjectById(id), "style").find("fill:url(#red)"), std::string::npos) << id;
+    }
+    auto const r3 = attribute(source->getObjectById("r3"), "style");
+    EXPECT_NE(r3.find("fill:url(#b)"), std::string::npos);
+    EXPECT_NE(r3.find("stroke:url(#b)"), std::string::npos);
+    EXPECT_NE(attribute(source->getObjectById("r4"), "style").find("fill:url(#b)"), std::string::npos);
+
+    EXPECT_TRUE(current->getObjectById("b"));
+    EXPECT_FALSE(current->getObjectById("c"));
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
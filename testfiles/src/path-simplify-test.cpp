@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for path simplification
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "async/progress.h"
+#include "document.h"
+#include "inkscape.h"
+#include "livarot/Path.h"
+#include "object/sp-item-group.h"
+#include "object/sp-path.h"
+#include "path/path-simplify.h"
+#include "path/path-util.h"
+
+using namespace Inkscape;
+
+namespace {
+
+/// Wavy paths with many nodes, some of them transformed or in a group.
+std::string make_svg(int count)
+{
+    std::string svg = R"(<svg xmlns="http://www.w3.org/2000/svg" width="400" height="400"><g id="group">)";
+    for (int i = 0; i < count; i++) {
+        std::string d = "M 0," + std::to_string(i * 3);
+        for (int j = 1; j <= 60; j++) {
+            d += " L " + std::to_string(j * 5) + "," + std::to_string(i * 3 + 2 * std::sin(j * 0.3 + i));
+        }
+        svg += "<path id=\"p" + std::to_string(i) + "\" d=\"" + d + "\"";
+        if (i % 3 == 0) {
+            svg += " transform=\"rotate(" + std::to_string(i) + ") scale(1.5)\"";
+        }
+        svg += " style=\"fill:none;stroke:black;stroke-width:1\"/>";
+        if (i == count / 2) {
+            svg += "</g>";
+        }
+    }
+    svg += "</svg>";
+    return svg;
+}
+
+/// Simplify paths one by one the way it was done before paths were simplified in batches: the
+/// transform is reset before the path is read.
+int simplify_reference(SPItem *item, float threshold, double size)
+{
+    if (auto group = cast<SPGroup>(item)) {
+        int count = 0;
+        for (auto child : group->item_list()) {
+            count += simplify_reference(child, threshold, size);
+        }
+        return count;
+    }
+    if (!is<SPPath>(item)) {
+        return 0;
+    }
+
+    size /= item->i2doc_affine().descrim();
+    Geom::Affine const transform(item->transform);
+    item->doWriteTransform(Geom::identity());
+
+    auto orig = Path_for_item_before_LPE(item, false);
+    if (!orig) {
+        return 0;
+    }
+    orig->ConvertEvenLines(threshold * size);
+    orig->Simplify(threshold * size);
+    item->setAttribute("d", orig->svg_dump_path());
+    item->doWriteTransform(transform);
+    item->removeAttribute("sodipodi:nodetypes");
+    return 1;
+}
+
+class CancelAtFirstReport final : public Async::Progress<double>
+{
+    bool cancelled = false;
+    bool _keepgoing() const override { return !cancelled; }
+    bool _report(double const &) override
+    {
+        cancelled = true;
+        return false;
+    }
+};
+
+/// Records whether the document had been changed by the time of any report.
+class CheckUnchangedOnReport final : public Async::Progress<double>
+{
+public:
+    CheckUnchangedOnReport(SPObject *path) : path{path}, before{path->getAttribute("d")} {}
+    bool changed = false;
+    int reports = 0;
+
+private:
+    SPObject *path;
+    std::string before;
+    bool _keepgoing() const override { return true; }
+    bool _report(double const &) override
+    {
+        reports++;
+        changed = changed || before != path->getAttribute("d");
+        return true;
+    }
+};
+
+} // namespace
+
+class PathSimplifyTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // setup hidden dependency
+        Application::create(false);
+    }
+};
+
+// Simplifying many paths at once writes the same paths as simplifying them one by one, reading
+// every path after its transform was reset.
+TEST_F(PathSimplifyTest, BatchMatchesSerial)
+{
+    int const count = 40;
+    auto const svg = make_svg(count);
+    auto serial = SPDocument::createNewDocFromMem(svg, true);
+    auto batch = SPDocument::createNewDocFromMem(svg, true);
+    ASSERT_TRUE(serial);
+    ASSERT_TRUE(batch);
+
+    auto top_items = [] (SPDocument *doc) {
+        std::vector<SPItem *> items{cast<SPItem>(doc->getObjectById("group"))};
+        for (int i = count / 2 + 1; i < count; i++) {
+            items.push_back(cast<SPItem>(doc->getObjectById("p" + std::to_string(i))));
+        }
+        return items;
+    };
+
+    int serial_count = 0;
+    for (auto item : top_items(serial.get())) {
+        serial_count += simplify_reference(item, 0.003, 400);
+    }
+    auto progress = Async::ProgressAlways<double>();
+    int batch_count = path_simplify(top_items(batch.get()), 0.003, false, 400, progress);
+
+    EXPECT_EQ(serial_count, count);
+    EXPECT_EQ(batch_count, count);
+    for (int i = 0; i < count; i++) {
+        auto id = "p" + std::to_string(i);
+        auto expected = serial->getObjectById(id);
+        auto result = batch->getObjectById(id);
+        ASSERT_TRUE(expected);
+        ASSERT_TRUE(result);
+        EXPECT_STREQ(expected->getAttribute("d"), result->getAttribute("d")) << id;
+        EXPECT_STREQ(expected->getAttribute("transform"), result->getAttribute("transform")) << id;
+        EXPECT_STREQ(expected->getAttribute("style"), result->getAttribute("style")) << id;
+    }
+}
+
+// Once cancelled, the paths are left as they were.
+TEST_F(PathSimplifyTest, Cancel)
+{
+    auto doc = SPDocument::createNewDocFromMem(make_svg(10), true);
+    ASSERT_TRUE(doc);
+    auto item = cast<SPItem>(doc->getObjectById("group"));
+    ASSERT_TRUE(item);
+    std::string const before = doc->getObjectById("p1")->getAttribute("d");
+
+    auto progress = CancelAtFirstReport();
+    EXPECT_EQ(path_simplify(std::vector<SPItem *>{item}, 0.003, false, 400, progress), 0);
+    EXPECT_EQ(before, doc->getObjectById("p1")->getAttribute("d"));
+}
+
+// Progress is only reported before any path is written, as reports may handle events.
+TEST_F(PathSimplifyTest, ReportsBeforeWriting)
+{
+    auto doc = SPDocument::createNewDocFromMem(make_svg(10), true);
+    ASSERT_TRUE(doc);
+    auto item = cast<SPItem>(doc->getObjectById("group"));
+    ASSERT_TRUE(item);
+
+    auto progress = CheckUnchangedOnReport(doc->getObjectById("p1"));
+    EXPECT_GT(path_simplify(std::vector<SPItem *>{item}, 0.003, false, 400, progress), 0);
+    EXPECT_GT(progress.reports, 0);
+    EXPECT_FALSE(progress.changed);
+}
+
+// A batch simplified in the background leaves alone the paths changed or deleted after it read
+// them, and can still be written after the simplification finished without the batch.
+TEST_F(PathSimplifyTest, BatchSkipsChangedPaths)
+{
+    auto doc = SPDocument::createNewDocFromMem(make_svg(10), true);
+    ASSERT_TRUE(doc);
+    auto item = cast<SPItem>(doc->getObjectById("group"));
+    ASSERT_TRUE(item);
+
+    auto batch = PathSimplifyBatch({item}, 0.003, false, 400);
+    auto work = batch.work();
+    doc->getObjectById("p1")->setAttribute("d", "M 0,0 L 10,10");
+    doc->getObjectById("p2")->deleteObject();
+
+    auto progress = Async::ProgressAlways<double>();
+    EXPECT_TRUE(work->run(progress, 2));
+    EXPECT_EQ(batch.write(), 4); // p0 to p5 are in the group, p1 and p2 are left alone
+    EXPECT_STREQ(doc->getObjectById("p1")->getAttribute("d"), "M 0,0 L 10,10");
+    EXPECT_FALSE(doc->getObjectById("p2"));
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test the cache of selector matches used by the Style and Selectors dialogs.
+ *//*
+ * Authors: see git history
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <gtest/gtest.h>
+#include <doc-per-case-test.h>
+
+#include <src/document.h>
+#include <src/object/sp-object.h>
+#include <src/object/sp-root.h>
+#include <src/ui/dialog/selector-matches.h>
+#include <src/xml/document.h>
+#include <src/xml/node.h>
+
+using namespace Inkscape;
+using Inkscape::UI::Dialog::SelectorMatches;
+using namespace std::literals;
+
+class SelectorMatchesTest : public DocPerCaseTest
+{
+public:
+    SelectorMatchesTest()
+    {
+        constexpr auto docString = R"A(
+<svg xmlns='http://www.w3.org/2000/svg' xmlns:xlink='http://www.w3.org/1999/xlink'>
+<g id='g1'>
+  <rect id='a' class='c d' width='10' height='10'/>
+  <rect id='ab' width='10' height='10'/>
+</g>
+<circle id='b' class='c' r='5'/>
+<use id='clone' xlink:href='#a'/>
+</svg>)A"sv;
+        doc = SPDocument::createNewDocFromMem(docString, false);
+    }
+
+    std::unique_ptr<SPDocument> doc;
+    SelectorMatches matches;
+
+    void fill(std::initializer_list<char const *> selectors)
+    {
+        for (auto selector : selectors) {
+            matches.get(*doc, selector);
+            ASSERT_TRUE(matches.contains(selector)) << selector;
+        }
+    }
+};
+
+// Only selectors naming the changed id are forgotten, not those with the name as a prefix.
+TEST_F(SelectorMatchesTest, IdChanged)
+{
+    ASSERT_TRUE(doc);
+    fill({"#b", "#ba", "circle#b", "#a, #b", "#b-a"});
+
+    matches.attributeChanged(*doc, g_quark_from_static_string("id"), "b", "x");
+
+    EXPECT_FALSE(matches.contains("#b"));
+    EXPECT_FALSE(matches.contains("circle#b"));
+    EXPECT_FALSE(matches.contains("#a, #b"));
+    EXPECT_TRUE(matches.contains("#ba"));
+    EXPECT_TRUE(matches.contains("#b-a"));
+}
+
+// A clone whose reference starts resolving because an id changed gets children, which any
+// selector may match.
+TEST_F(SelectorMatchesTest, IdOfCloneReferenceChanged)
+{
+    ASSERT_TRUE(doc);
+    auto use = doc->getReprDoc()->createElement("svg:use");
+    use->setAttribute("xlink:href", "#z");
+    doc->getRoot()->getRepr()->appendChild(use);
+    Inkscape::GC::release(use);
+    fill({"circle", "#a"});
+    ASSERT_EQ(matches.get(*doc, "circle").size(), 1u);
+
+    doc->getObjectById("b")->setAttribute("id", "z");
+    matches.attributeChanged(*doc, g_quark_from_static_string("id"), "b", "z");
+
+    EXPECT_FALSE(matches.contains("circle"));
+    EXPECT_FALSE(matches.contains("#a"));
+    EXPECT_EQ(matches.get(*doc, "circle").size(), 2u); // the circle and the copy in the clone
+}
+
+// Only the classes added or removed matter.
+TEST_F(SelectorMatchesTest, ClassChanged)
+{
+    ASSERT_TRUE(doc);
+    fill({".c", ".d", ".e", ".cd", "rect.d"});
+
+    matches.attributeChanged(*doc, g_quark_from_static_string("class"), "c d", "c e");
+
+    EXPECT_TRUE(matches.contains(".c"));
+    EXPECT_FALSE(matches.contains(".d"));
+    EXPECT_FALSE(matches.contains(".e"));
+    EXPECT_TRUE(matches.contains(".cd"));
+    EXPECT_FALSE(matches.contains("rect.d"));
+
+    // Other attributes never matter.
+    matches.attributeChanged(*doc, g_quark_from_static_string("style"), "fill:red", nullptr);
+    EXPECT_TRUE(matches.contains(".c"));
+}
+
+// Selectors with attribute conditions or escapes are never kept.
+TEST_F(SelectorMatchesTest, Uncached)
+{
+    ASSERT_TRUE(doc);
+    matches.get(*doc, "[id=a]");
+    EXPECT_FALSE(matches.contains("[id=a]"));
+}
+
+// An added node only drops the selectors that may match it or its children.
+TEST_F(SelectorMatchesTest, NodeAdded)
+{
+    ASSERT_TRUE(doc);
+    fill({"circle", "rect", "ellipse", "#new", "#a", ".f", ".c", "g > circle", "circle:first-child", "*"});
+
+    auto group = doc->getReprDoc()->createElement("svg:g");
+    auto ellipse = doc->getReprDoc()->createElement("svg:ellipse");
+    ellipse->setAttribute("id", "new");
+    ellipse->setAttribute("class", "f");
+    group->appendChild(ellipse);
+    doc->getRoot()->getRepr()->appendChild(group);
+    matches.nodeAdded(*group);
+    Inkscape::GC::release(ellipse);
+    Inkscape::GC::release(group);
+
+    EXPECT_FALSE(matches.contains("ellipse"));
+    EXPECT_FALSE(matches.contains("#new"));
+    EXPECT_FALSE(matches.contains(".f"));
+    EXPECT_FALSE(matches.contains("g > circle"));
+    EXPECT_FALSE(matches.contains("circle:first-child"));
+    EXPECT_FALSE(matches.contains("*"));
+    EXPECT_TRUE(matches.contains("circle"));
+    EXPECT_TRUE(matches.contains("rect"));
+    EXPECT_TRUE(matches.contains("#a"));
+    EXPECT_TRUE(matches.contains(".c"));
+}
+
+// Removing or moving a node only drops the selectors depending on the structure.
+TEST_F(SelectorMatchesTest, NodeRemovedOrReordered)
+{
+    ASSERT_TRUE(doc);
+    fill({"circle", "g rect", "rect + rect", ":first-child"});
+
+    matches.nodeReordered();
+    EXPECT_TRUE(matches.contains("circle"));
+    EXPECT_FALSE(matches.contains("g rect"));
+    EXPECT_FALSE(matches.contains("rect + rect"));
+    EXPECT_FALSE(matches.contains(":first-child"));
+
+    fill({"g rect"});
+    matches.nodeRemoved();
+    EXPECT_TRUE(matches.contains("circle"));
+    EXPECT_FALSE(matches.contains("g rect"));
+}
+
+// A new clone copies its original, which may match any selector.
+TEST_F(SelectorMatchesTest, CloneAdded)
+{
+    ASSERT_TRUE(doc);
+    fill({"circle", "#b"});
+
+    auto use = doc->getReprDoc()->createElement("svg:use");
+    use->setAttribute("xlink:href", "#b");
+    doc->getRoot()->getRepr()->appendChild(use);
+    matches.nodeAdded(*use);
+    Inkscape::GC::release(use);
+
+    EXPECT_FALSE(matches.contains("circle"));
+    EXPECT_FALSE(matches.contains("#b"));
+    EXPECT_EQ(matches.get(*doc, "circle").size(), 2u);
+}
+
+// The children of a clone are released when its original changes, with no node being removed.
+// Its new children may match any selector.
+TEST_F(SelectorMatchesTest, CloneChildrenReleased)
+{
+    ASSERT_TRUE(doc);
+    fill({"#a", "circle"});
+    ASSERT_EQ(matches.get(*doc, "#a").size(), 2u); // the rect and its clone
+
+    int released = 0;
+    matches.signal_released().connect([&] { released++; });
+
+    doc->getObjectById("clone")->setAttribute("xlink:href", "#b");
+
+    EXPECT_FALSE(matches.contains("#a"));
+    EXPECT_FALSE(matches.contains("circle"));
+    EXPECT_GE(released, 1);
+    EXPECT_EQ(matches.get(*doc, "#a").size(), 1u);
+    EXPECT_EQ(matches.get(*doc, "circle").size(), 2u);
+}
+
+// A deleted object is forgotten even before the dialog hears about the removed node.
+TEST_F(SelectorMatchesTest, ObjectDeleted)
+{
+    ASSERT_TRUE(doc);
+    fill({".c", "#ab"});
+
+    doc->getObjectById("b")->deleteObject();
+
+    EXPECT_FALSE(matches.contains(".c"));
+    EXPECT_TRUE(matches.contains("#ab"));
+    EXPECT_EQ(matches.get(*doc, ".c").size(), 2u); // the rect and its clone
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
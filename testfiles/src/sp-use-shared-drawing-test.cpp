@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Test the sharing of drawings between clones of the same original.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cairomm/surface.h>
+#include <2geom/int-rect.h>
+
+#include "inkscape.h"
+#include "document.h"
+#include "object/sp-root.h"
+#include "object/sp-use.h"
+#include "display/drawing.h"
+#include "display/drawing-surface.h"
+#include "display/drawing-context.h"
+
+using namespace std::literals;
+
+class SPUseSharedDrawingTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (!Inkscape::Application::exists()) {
+            Inkscape::Application::create(false);
+        }
+
+        // Each clone covers 10x10 pixels at its x, the original itself is not displayed.
+        constexpr auto docString = R"A(
+<svg xmlns='http://www.w3.org/2000/svg' xmlns:xlink='http://www.w3.org/1999/xlink' width='100' height='10'>
+<defs>
+  <rect id='r' width='10' height='10'/>
+  <rect id='c' width='10' height='10' fill='context-fill'/>
+</defs>
+<use id='u1' xlink:href='#r' x='0' fill='lime'/>
+<use id='u2' xlink:href='#r' x='20' fill='lime'/>
+<use id='u3' xlink:href='#r' x='40' fill='blue'/>
+<use id='u4' xlink:href='#c' x='60' fill='red'/>
+<use id='u5' xlink:href='#c' x='80' fill='lime'/>
+</svg>)A"sv;
+        doc = SPDocument::createNewDocFromMem(docString, false);
+        ASSERT_TRUE(doc);
+        doc->ensureUpToDate();
+
+        dkey = SPItem::display_key_new(1);
+        drawing.setRoot(doc->getRoot()->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+        drawing.update();
+
+        for (auto id : {"u1", "u2", "u3", "u4", "u5"}) {
+            auto use = cast<SPUse>(doc->getObjectById(id));
+            ASSERT_TRUE(use && use->child) << id;
+        }
+    }
+
+    void TearDown() override
+    {
+        if (doc) {
+            doc->getRoot()->invoke_hide(dkey);
+        }
+    }
+
+    SPUse *use(char const *id) const { return cast<SPUse>(doc->getObjectById(id)); }
+
+    /// Whether the child of the use is shown by the use itself, rather than through another clone.
+    bool showsOwnChild(char const *id) const
+    {
+        auto child = use(id)->child;
+        return child && child->get_arenaitem(dkey);
+    }
+
+    /// Render the document and return the pixel in the middle of the clone at x.
+    std::uint32_t pixelAt(int x)
+    {
+        drawing.update();
+        auto const area = Geom::IntRect::from_xywh(0, 0, 100, 10);
+        auto cs = Cairo::ImageSurface::create(Cairo::Surface::Format::ARGB32, area.width(), area.height());
+        {
+            auto ds = Inkscape::DrawingSurface(cs->cobj(), area.min());
+            auto dc = Inkscape::DrawingContext(ds);
+            drawing.render(dc, area);
+        }
+        cs->flush();
+        return *reinterpret_cast<std::uint32_t const *>(cs->get_data() + 5 * cs->get_stride() + (x + 5) * 4);
+    }
+
+    std::unique_ptr<SPDocument> doc;
+    Inkscape::Drawing drawing;
+    unsigned dkey = 0;
+};
+
+static constexpr std::uint32_t LIME = 0xff00ff00;
+static constexpr std::uint32_t BLUE = 0xff0000ff;
+static constexpr std::uint32_t RED = 0xffff0000;
+
+// Clones inheriting the same style share one drawing of the original, shown by the first of them.
+TEST_F(SPUseSharedDrawingTest, Share)
+{
+    EXPECT_TRUE(use("u1")->sharesDrawing(dkey));
+    EXPECT_TRUE(use("u2")->sharesDrawing(dkey));
+    EXPECT_TRUE(showsOwnChild("u1"));
+    EXPECT_FALSE(showsOwnChild("u2"));
+
+    // A different inherited fill needs a drawing of its own.
+    EXPECT_TRUE(use("u3")->sharesDrawing(dkey));
+    EXPECT_TRUE(showsOwnChild("u3"));
+
+    EXPECT_EQ(pixelAt(0), LIME);
+    EXPECT_EQ(pixelAt(20), LIME);
+    EXPECT_EQ(pixelAt(40), BLUE);
+}
+
+// Sharing only concerns the drawing: a clone displaying the drawing of another clone keeps its
+// own copy of the original, in its own place in the document.
+TEST_F(SPUseSharedDrawingTest, KeepChild)
+{
+    ASSERT_TRUE(use("u2")->child);
+    EXPECT_NE(use("u2")->child, use("u1")->child);
+    EXPECT_EQ(use("u2")->child->parent, use("u2"));
+    EXPECT_EQ(use("u2")->firstChild(), use("u2")->child);
+    EXPECT_EQ(*use("u2")->documentVisualBounds(), Geom::Rect(20, 0, 30, 10));
+    EXPECT_EQ(*use("u2")->child->documentVisualBounds(), Geom::Rect(20, 0, 30, 10));
+}
+
+// Once the original cannot be shared any more, every clone shows its own copy again.
+TEST_F(SPUseSharedDrawingTest, OriginalNotShareable)
+{
+    doc->getObjectById("r")->setAttribute("opacity", "0.5");
+    doc->ensureUpToDate();
+
+    for (auto id : {"u1", "u2", "u3"}) {
+        EXPECT_FALSE(use(id)->sharesDrawing(dkey)) << id;
+        EXPECT_TRUE(showsOwnChild(id)) << id;
+    }
+    EXPECT_NE(pixelAt(20), 0);
+    EXPECT_EQ(pixelAt(20), pixelAt(0));
+}
+
+// With a cache budget, the clones render the shared drawing from rasters of it.
+TEST_F(SPUseSharedDrawingTest, Rasters)
+{
+    drawing.setCacheBudget(std::size_t{64} << 20);
+
+    EXPECT_EQ(pixelAt(0), LIME);
+    EXPECT_EQ(pixelAt(20), LIME);
+    EXPECT_EQ(pixelAt(40), BLUE);
+    EXPECT_EQ(pixelAt(10), 0);
+    EXPECT_EQ(pixelAt(22), LIME);
+
+    // Changes to the original drop the rasters.
+    doc->getObjectById("r")->setAttribute("width", "5");
+    doc->ensureUpToDate();
+    EXPECT_EQ(pixelAt(17), LIME);
+    EXPECT_EQ(pixelAt(22), 0);
+}
+
+// Context paint depends on each clone, so such originals are never shared.
+TEST_F(SPUseSharedDrawingTest, ContextPaint)
+{
+    EXPECT_FALSE(use("u4")->sharesDrawing(dkey));
+    EXPECT_FALSE(use("u5")->sharesDrawing(dkey));
+    EXPECT_TRUE(showsOwnChild("u4"));
+    EXPECT_TRUE(showsOwnChild("u5"));
+
+    EXPECT_EQ(pixelAt(60), RED);
+    EXPECT_EQ(pixelAt(80), LIME);
+}
+
+// A clone whose inherited style changes leaves the shared drawing, and joins it again once
+// the style is the same as that of the others.
+TEST_F(SPUseSharedDrawingTest, Unshare)
+{
+    use("u2")->setAttribute("fill", "blue");
+    doc->ensureUpToDate();
+
+    EXPECT_TRUE(showsOwnChild("u1"));
+    EXPECT_TRUE(showsOwnChild("u3"));
+    EXPECT_FALSE(showsOwnChild("u2")); // now shares the drawing of u3
+    EXPECT_EQ(pixelAt(0), LIME);
+    EXPECT_EQ(pixelAt(20), BLUE);
+
+    use("u2")->setAttribute("fill", "lime");
+    doc->ensureUpToDate();
+
+    EXPECT_TRUE(showsOwnChild("u1"));
+    EXPECT_FALSE(showsOwnChild("u2"));
+    EXPECT_EQ(pixelAt(20), LIME);
+    EXPECT_EQ(pixelAt(40), BLUE);
+}
+
+// When the clone showing the shared drawing is hidden, the next clone shows it instead.
+TEST_F(SPUseSharedDrawingTest, HideOwner)
+{
+    use("u1")->invoke_hide(dkey);
+
+    EXPECT_FALSE(use("u1")->sharesDrawing(dkey));
+    EXPECT_TRUE(use("u2")->sharesDrawing(dkey));
+    EXPECT_TRUE(showsOwnChild("u2"));
+    EXPECT_EQ(pixelAt(20), LIME);
+
+    // Hiding the last user removes the shared drawing, so the next view starts a new one.
+    use("u2")->invoke_hide(dkey);
+    EXPECT_FALSE(use("u2")->sharesDrawing(dkey));
+
+    Inkscape::Drawing other;
+    auto const okey = SPItem::display_key_new(1);
+    other.setRoot(use("u2")->invoke_show(other, okey, SP_ITEM_SHOW_DISPLAY));
+    EXPECT_TRUE(use("u2")->sharesDrawing(okey));
+    EXPECT_TRUE(use("u2")->child->get_arenaitem(okey));
+    use("u2")->invoke_hide(okey);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -160,3 +160,49 @@ TEST(StreamTest, GzipFExtraFComment)
     pipeStream(inStreamGzip, outStreamString);
     ASSERT_EQ(outStreamString.getString(), "the content");
 }
+
+TEST(StreamTest, GzipThreadedChunks)
+{
+    // Several compression chunks of 256 KiB, with flushes in the middle of chunks and right at
+    // their ends, written both in blocks and byte by byte.
+    std::string source;
+    for (int i = 0; source.size() < 5 * 256 * 1024 + 1000; i++) {
+        source += "<path id=\"path" + std::to_string(i) + "\" d=\"M " + std::to_string(i * 7 % 1013) + ",0 L 1,"
+                + std::to_string(i * 13 % 997) + "\"/>\n";
+    }
+
+    auto gzFile = MyOutFile("threaded.gz");
+    auto destFile = MyOutFile("threaded.xml");
+
+    {
+        auto gzOuts = Inkscape::IO::FileOutputStream(gzFile);
+        auto gzipOuts = Inkscape::IO::GzipOutputStream(gzOuts, Z_DEFAULT_COMPRESSION, true);
+        std::size_t pos = 0;
+        for (std::size_t end : {std::size_t{1000}, std::size_t{256 * 1024}, std::size_t{700 * 1024}, std::size_t{768 * 1024}}) {
+            gzipOuts.write(source.data() + pos, end - pos);
+            pos = end;
+            gzipOuts.flush();
+            gzipOuts.flush();
+        }
+        for (; pos < 800 * 1024; pos++) {
+            gzipOuts.put(source[pos]);
+        }
+        gzipOuts.write(source.data() + pos, source.size() - pos);
+        gzipOuts.close();
+    }
+
+    {
+        auto gzIns = Inkscape::IO::FileInputStream(gzFile.open("rb"));
+        auto destOuts = Inkscape::IO::FileOutputStream(destFile);
+        auto gzipIns = Inkscape::IO::GzipInputStream(gzIns);
+        pipeStream(gzipIns, destOuts);
+    }
+
+    ASSERT_EQ(source, destFile.getContents());
+}
+
+TEST(StreamTest, GzipBadLevel)
+{
+    auto outs = Inkscape::IO::StringOutputStream();
+    EXPECT_THROW(Inkscape::IO::GzipOutputStream(outs, 42), Inkscape::IO::StreamException);
+}
@@ -0,0 +1,402 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Compare the colour quantizer used by tracing with the octree it replaced.
+ */
+/*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "trace/imagemap.h"
+#include "trace/quantize.h"
+
+using namespace Inkscape::Trace;
+
+namespace {
+
+/*
+ * The octree quantizer as it was before the colour histogram: every pixel is inserted as an exact
+ * leaf, and the tree is pruned to the requested number of leaves, whose mean colours form the
+ * palette. Kept here, without its memory pool, as the reference for the palette.
+ */
+struct Ocnode
+{
+    Ocnode *parent = nullptr;
+    Ocnode **ref = nullptr;
+    Ocnode *child[8] = {};
+    int nchild = 0;
+    int width = 0;
+    RGB rgb{};
+    unsigned long weight = 0;
+    unsigned long rs = 0, gs = 0, bs = 0;
+    int nleaf = 0;
+    unsigned long mi = 0;
+};
+
+RGB shift(RGB rgb, int s) { return {(unsigned char)(rgb.r >> s), (unsigned char)(rgb.g >> s), (unsigned char)(rgb.b >> s)}; }
+bool same(RGB a, RGB b) { return a.r == b.r && a.g == b.g && a.b == b.b; }
+int childIndex(RGB rgb) { return ((rgb.r & 1) << 2) | ((rgb.g & 1) << 1) | (rgb.b & 1); }
+
+void octreeDelete(Ocnode *node)
+{
+    if (!node) return;
+    for (auto c : node->child) {
+        octreeDelete(c);
+    }
+    delete node;
+}
+
+int octreeMerge(Ocnode *parent, Ocnode **ref, Ocnode *node1, Ocnode *node2)
+{
+    if (!node1 && !node2) return 0;
+    if (parent && !*ref) parent->nchild++;
+    if (!node1) {
+        *ref = node2; node2->ref = ref; node2->parent = parent;
+        return node2->nleaf;
+    }
+    if (!node2) {
+        *ref = node1; node1->ref = ref; node1->parent = parent;
+        return node1->nleaf;
+    }
+    int dwidth = node1->width - node2->width;
+    if (dwidth < 0) {
+        std::swap(node1, node2);
+        dwidth = -dwidth;
+    }
+    if (dwidth > 0 && same(node1->rgb, shift(node2->rgb, dwidth))) {
+        // place node2 below node1
+        *ref = node1; node1->ref = ref; node1->parent = parent;
+        int i = childIndex(shift(node2->rgb, dwidth - 1));
+        node1->rs += node2->rs; node1->gs += node2->gs; node1->bs += node2->bs;
+        node1->weight += node2->weight;
+        node1->mi = 0;
+        if (node1->child[i]) node1->nleaf -= node1->child[i]->nleaf;
+        node1->nleaf += octreeMerge(node1, &node1->child[i], node1->child[i], node2);
+        return node1->nleaf;
+    }
+    auto newnode = new Ocnode;
+    newnode->rs = node1->rs + node2->rs;
+    newnode->gs = node1->gs + node2->gs;
+    newnode->bs = node1->bs + node2->bs;
+    newnode->weight = node1->weight + node2->weight;
+    *ref = newnode; newnode->ref = ref; newnode->parent = parent;
+    if (dwidth == 0 && same(node1->rgb, node2->rgb)) {
+        // merge the nodes in newnode
+        newnode->width = node1->width;
+        newnode->rgb = node1->rgb;
+        if (node1->nchild == 0 && node2->nchild == 0) {
+            newnode->nleaf = 1;
+        } else {
+            for (int i = 0; i < 8; i++) {
+                if (node1->child[i] || node2->child[i]) {
+                    newnode->nleaf += octreeMerge(newnode, &newnode->child[i], node1->child[i], node2->child[i]);
+                }
+            }
+        }
+        delete node1;
+        delete node2;
+        return newnode->nleaf;
+    }
+    // use newnode as a fork node with children node1 and node2
+    int newwidth = std::max(node1->width, node2->width);
+    RGB rgb1 = shift(node1->rgb, newwidth - node1->width);
+    RGB rgb2 = shift(node2->rgb, newwidth - node2->width);
+    while (!same(rgb1, rgb2)) {
+        rgb1 = shift(rgb1, 1);
+        rgb2 = shift(rgb2, 1);
+        newwidth++;
+    }
+    newnode->width = newwidth;
+    newnode->rgb = rgb1;
+    newnode->nchild = 2;
+    newnode->nleaf = node1->nleaf + node2->nleaf;
+    for (auto node : {node1, node2}) {
+        int i = childIndex(shift(node->rgb, newwidth - node->width - 1));
+        node->parent = newnode;
+        node->ref = &newnode->child[i];
+        newnode->child[i] = node;
+    }
+    return newnode->nleaf;
+}
+
+void ocnodeMi(Ocnode *node)
+{
+    node->mi = node->parent ? node->weight << (2 * node->parent->width) : 0;
+}
+
+void ocnodeStrip(Ocnode **ref, int &count, unsigned long lvl)
+{
+    Ocnode *node = *ref;
+    if (!node) return;
+    if (node->nchild == 0) {
+        if (!node->mi) ocnodeMi(node);
+        if (node->mi > lvl) return;
+        delete node;
+        *ref = nullptr;
+        count--;
+        return;
+    }
+    if (node->mi && node->mi > lvl) return;
+    node->nchild = 0;
+    node->nleaf = 0;
+    node->mi = 0;
+    Ocnode **lonelychild = nullptr;
+    for (auto &c : node->child) {
+        if (c) {
+            ocnodeStrip(&c, count, lvl);
+            if (c) {
+                lonelychild = &c;
+                node->nchild++;
+                node->nleaf += c->nleaf;
+                if (!node->mi || node->mi > c->mi) {
+                    node->mi = c->mi;
+                }
+            }
+        }
+    }
+    if (node->nchild == 0) {
+        count++;
+        node->nleaf = 1;
+        ocnodeMi(node);
+    } else if (node->nchild == 1) {
+        if ((*lonelychild)->nchild == 0) {
+            node->nchild = 0;
+            node->nleaf = 1;
+            ocnodeMi(node);
+            delete *lonelychild;
+            *lonelychild = nullptr;
+        } else {
+            auto const child = *lonelychild;
+            child->parent = node->parent;
+            child->ref = ref;
+            delete node;
+            *ref = child;
+        }
+    }
+}
+
+void octreeBuildArea(RgbMap const &rgbmap, Ocnode **ref, int x1, int y1, int x2, int y2)
+{
+    int dx = x2 - x1, dy = y2 - y1;
+    Ocnode *ref1 = nullptr;
+    Ocnode *ref2 = nullptr;
+    if (dx == 1 && dy == 1) {
+        auto node = new Ocnode;
+        node->rgb = rgbmap.getPixel(x1, y1);
+        node->rs = node->rgb.r; node->gs = node->rgb.g; node->bs = node->rgb.b;
+        node->weight = 1;
+        node->nleaf = 1;
+        node->ref = ref;
+        *ref = node;
+        return;
+    } else if (dx > dy) {
+        octreeBuildArea(rgbmap, &ref1, x1, y1, x1 + dx / 2, y2);
+        octreeBuildArea(rgbmap, &ref2, x1 + dx / 2, y1, x2, y2);
+    } else {
+        octreeBuildArea(rgbmap, &ref1, x1, y1, x2, y1 + dy / 2);
+        octreeBuildArea(rgbmap, &ref2, x1, y1 + dy / 2, x2, y2);
+    }
+    octreeMerge(nullptr, ref, ref1, ref2);
+}
+
+void octreeIndex(Ocnode *node, std::vector<RGB> &palette)
+{
+    if (!node) return;
+    if (node->nchild == 0) {
+        palette.push_back({(unsigned char)(node->rs / node->weight), (unsigned char)(node->gs / node->weight), (unsigned char)(node->bs / node->weight)});
+    } else {
+        for (auto c : node->child) {
+            octreeIndex(c, palette);
+        }
+    }
+}
+
+std::vector<RGB> octreePalette(RgbMap const &rgbmap, int ncolor)
+{
+    Ocnode *tree = nullptr;
+    octreeBuildArea(rgbmap, &tree, 0, 0, rgbmap.width, rgbmap.height);
+    for (int n = tree->nleaf - ncolor; n > 0; ) {
+        ocnodeStrip(&tree, n, tree->mi);
+    }
+    std::vector<RGB> palette;
+    octreeIndex(tree, palette);
+    octreeDelete(tree);
+    return palette;
+}
+
+double distance(RGB a, RGB b)
+{
+    return std::hypot(a.r - b.r, a.g - b.g, a.b - b.b);
+}
+
+/// The squared distance, exact to tell apart colours at the same distance.
+int distance2(RGB a, RGB b)
+{
+    return (a.r - b.r) * (a.r - b.r) + (a.g - b.g) * (a.g - b.g) + (a.b - b.b) * (a.b - b.b);
+}
+
+/// The largest distance from a colour of one palette to the closest colour of the other.
+double paletteDistance(std::vector<RGB> const &a, std::vector<RGB> const &b)
+{
+    double result = 0;
+    for (auto [from, to] : {std::pair{&a, &b}, std::pair{&b, &a}}) {
+        for (auto c : *from) {
+            double closest = INFINITY;
+            for (auto d : *to) {
+                closest = std::min(closest, distance(c, d));
+            }
+            result = std::max(result, closest);
+        }
+    }
+    return result;
+}
+
+/// The mean distance of the pixels of an image to the palette colour they were mapped to.
+double meanError(RgbMap const &rgbmap, IndexedMap const &imap)
+{
+    double sum = 0;
+    for (std::size_t i = 0; i < rgbmap.pixels.size(); i++) {
+        sum += distance(rgbmap.pixels[i], imap.clut[imap.pixels[i]]);
+    }
+    return sum / rgbmap.pixels.size();
+}
+
+/// The error of mapping each pixel to its closest colour in a palette.
+double meanError(RgbMap const &rgbmap, std::vector<RGB> const &palette)
+{
+    double sum = 0;
+    for (auto c : rgbmap.pixels) {
+        double closest = INFINITY;
+        for (auto d : palette) {
+            closest = std::min(closest, distance(c, d));
+        }
+        sum += closest;
+    }
+    return sum / rgbmap.pixels.size();
+}
+
+enum class Image { Gradient, Noise, Blobs, Flat, CloseColors };
+
+RgbMap makeImage(Image kind)
+{
+    int const width = 160, height = 120;
+    auto rgbmap = RgbMap(width, height);
+    std::mt19937 rng(1);
+    auto byte = [&] { return (unsigned char)(rng() % 256); };
+
+    std::vector<RGB> colors;
+    std::vector<int> xs, ys;
+    for (int i = 0; i < 12; i++) {
+        colors.push_back({byte(), byte(), byte()});
+        xs.push_back(rng() % width);
+        ys.push_back(rng() % height);
+    }
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            RGB c{};
+            switch (kind) {
+                case Image::Gradient:
+                    c = {(unsigned char)(x * 255 / (width - 1)), (unsigned char)(y * 255 / (height - 1)), (unsigned char)((x + y) * 255 / (width + height - 2))};
+                    break;
+                case Image::Noise:
+                    c = {byte(), byte(), byte()};
+                    break;
+                case Image::Blobs: {
+                    // smooth mixes of a few colours with a little noise, like a photograph
+                    double wsum = 0, r = 0, g = 0, b = 0;
+                    for (int i = 0; i < 12; i++) {
+                        double const w = 1.0 / (1.0 + ((x - xs[i]) * (x - xs[i]) + (y - ys[i]) * (y - ys[i])) / 400.0);
+                        wsum += w; r += w * colors[i].r; g += w * colors[i].g; b += w * colors[i].b;
+                    }
+                    auto noisy = [&] (double v) { return (unsigned char)std::clamp(v / wsum + (int)(rng() % 9) - 4, 0.0, 255.0); };
+                    c = {noisy(r), noisy(g), noisy(b)};
+                    break;
+                }
+                case Image::Flat:
+                    c = colors[(x / 40 + y / 40 * 4) % 6];
+                    break;
+                case Image::CloseColors:
+                    // two greys sharing a histogram bin, and two far apart reds
+                    c = (x + y) % 3 == 0 ? RGB{100, 100, 100} : (x + y) % 3 == 1 ? RGB{103, 101, 102} : RGB{(unsigned char)(x % 2 ? 250 : 5), 20, 20};
+                    break;
+            }
+            rgbmap.setPixel(x, y, c);
+        }
+    }
+    return rgbmap;
+}
+
+// The histogram only merges colours that share a bin of 8 levels per channel, so no palette colour
+// may move further than the diagonal of a bin.
+double constexpr PALETTE_TOLERANCE = 12.2;
+
+// Pixels are mapped exactly, so only the small differences in palette show in the error.
+double constexpr ERROR_TOLERANCE = 1.5;
+
+} // namespace
+
+class TraceQuantizeTest : public ::testing::TestWithParam<Image> {};
+
+TEST_P(TraceQuantizeTest, PaletteMatchesOctree)
+{
+    auto const rgbmap = makeImage(GetParam());
+
+    for (int ncolor : {2, 4, 8, 16, 32, 64}) {
+        auto const expected = octreePalette(rgbmap, ncolor);
+
+        for (int nthreads : {1, 4}) {
+            auto const imap = rgbMapQuantize(rgbmap, ncolor, nthreads);
+            ASSERT_GT(imap.nrColors, 0);
+            ASSERT_LE(imap.nrColors, ncolor);
+            auto const palette = std::vector<RGB>(imap.clut.begin(), imap.clut.begin() + imap.nrColors);
+
+            EXPECT_LE(paletteDistance(palette, expected), PALETTE_TOLERANCE) << "colors: " << ncolor;
+            EXPECT_LE(meanError(rgbmap, imap), meanError(rgbmap, expected) + ERROR_TOLERANCE) << "colors: " << ncolor;
+            for (auto index : imap.pixels) {
+                ASSERT_LT(index, (unsigned)imap.nrColors);
+            }
+        }
+    }
+}
+
+// Every pixel gets the palette colour closest to it, the first one of those at the same distance,
+// exactly as if each pixel was looked up in the palette on its own.
+TEST_P(TraceQuantizeTest, PixelsMapToClosestColor)
+{
+    auto const rgbmap = makeImage(GetParam());
+
+    for (int ncolor : {2, 3, 8, 13, 64}) {
+        auto const imap = rgbMapQuantize(rgbmap, ncolor, 4);
+        for (std::size_t i = 0; i < rgbmap.pixels.size(); i++) {
+            auto const rgb = rgbmap.pixels[i];
+            unsigned closest = 0;
+            for (unsigned k = 1; k < (unsigned)imap.nrColors; k++) {
+                if (distance2(rgb, imap.clut[k]) < distance2(rgb, imap.clut[closest])) {
+                    closest = k;
+                }
+            }
+            ASSERT_EQ(imap.pixels[i], closest) << "colors: " << ncolor << ", pixel: " << i;
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Images, TraceQuantizeTest,
+                         ::testing::Values(Image::Gradient, Image::Noise, Image::Blobs, Image::Flat, Image::CloseColors));
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Unclump test
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <string>
+#include <vector>
+#include <2geom/point.h>
+
+#include "document.h"
+#include "inkscape.h"
+#include "object/algorithms/unclump.h"
+#include "object/sp-item.h"
+
+using namespace Inkscape;
+
+namespace {
+
+/**
+ * The original unclumping algorithm, comparing every item with every other one, on the centers
+ * and sizes of the items.
+ */
+class ReferenceUnclump
+{
+public:
+    std::vector<Geom::Point> c, wh;
+
+    double dist(int i1, int i2) const
+    {
+        Geom::Point c1 = c[i1], c2 = c[i2], wh1 = wh[i1], wh2 = wh[i2];
+
+        double a1 = std::abs(std::atan2((c2 - c1)[Geom::Y], (c2 - c1)[Geom::X] * wh1[Geom::Y] / wh1[Geom::X]));
+        if (a1 > M_PI / 2) a1 = M_PI - a1;
+        double a2 = std::abs(std::atan2((c1 - c2)[Geom::Y], (c1 - c2)[Geom::X] * wh2[Geom::Y] / wh2[Geom::X]));
+        if (a2 > M_PI / 2) a2 = M_PI - a2;
+
+        double r1 = 0.5 * (wh1[Geom::X] + (wh1[Geom::Y] - wh1[Geom::X]) * (a1 / (M_PI / 2)));
+        double r2 = 0.5 * (wh2[Geom::X] + (wh2[Geom::Y] - wh2[Geom::X]) * (a2 / (M_PI / 2)));
+        double dist_r = Geom::L2(c2 - c1) - r1 - r2;
+
+        double stretch1 = wh1[Geom::Y] / wh1[Geom::X];
+        double stretch2 = wh2[Geom::Y] / wh2[Geom::X];
+        if (!((stretch1 > 1.5 || stretch1 < 0.66) && (stretch2 > 1.5 || stretch2 < 0.66))) {
+            return dist_r;
+        }
+
+        auto closest_points = [] (Geom::Point const &c, Geom::Point const &wh, Geom::Point const &to) {
+            Geom::Point p[2];
+            for (int d = 0; d < 2; d++) {
+                double closest = std::clamp(to[d], c[d] - wh[d] / 2, c[d] + wh[d] / 2);
+                p[d] = c;
+                p[d][d] = closest;
+            }
+            return std::vector<Geom::Point>{p[Geom::Y], p[Geom::X]};
+        };
+        double result = dist_r;
+        for (auto const &p1 : closest_points(c1, wh1, c2)) {
+            for (auto const &p2 : closest_points(c2, wh2, c1)) {
+                result = std::min(result, Geom::L2(p1 - p2));
+            }
+        }
+        return result;
+    }
+
+    void run()
+    {
+        int const n = c.size();
+        for (int item = 0; item < n; item++) {
+            std::list<int> nei, rest;
+            for (int i = 0; i < n; i++) {
+                if (i != item) rest.push_back(i);
+            }
+            while (!rest.empty()) {
+                int closest = pick(item, rest, [] (double d, double best) { return d < best; }, HUGE_VAL);
+                if (closest < 0) break;
+                nei.push_front(closest);
+                rest.remove(closest);
+                Geom::Point it = c[item], p1 = c[closest];
+                Geom::Point p2 = p1 + Geom::rot90(it - p1);
+                double A = p1[Geom::Y] - p2[Geom::Y];
+                double B = p2[Geom::X] - p1[Geom::X];
+                double C = p2[Geom::Y] * p1[Geom::X] - p1[Geom::Y] * p2[Geom::X];
+                double val_item = A * it[Geom::X] + B * it[Geom::Y] + C;
+                rest.remove_if([&] (int o) { return val_item * (A * c[o][Geom::X] + B * c[o][Geom::Y] + C) <= 1e-6; });
+            }
+            if (nei.size() < 2) continue;
+
+            double ave = 0;
+            for (int o : nei) ave += dist(item, o);
+            ave /= nei.size();
+            int closest = pick(item, nei, [] (double d, double best) { return d < best; }, HUGE_VAL);
+            int farthest = pick(item, nei, [] (double d, double best) { return d > best; }, -HUGE_VAL);
+            double dist_closest = dist(closest, item);
+            double dist_farthest = dist(farthest, item);
+            if (std::abs(ave) < 1e6 && std::abs(dist_closest) < 1e6 && std::abs(dist_farthest) < 1e6) {
+                c[item] += 0.3 * (ave - dist_closest) * Geom::unit_vector(-(c[closest] - c[item]));
+                c[item] += 0.35 * (dist_farthest - ave) * Geom::unit_vector(c[farthest] - c[item]);
+            }
+        }
+    }
+
+private:
+    template <typename F>
+    int pick(int item, std::list<int> const &others, F better, double best) const
+    {
+        int result = -1;
+        for (int o : others) {
+            double d = dist(item, o);
+            if (better(d, best) && std::abs(d) < 1e6) {
+                best = d;
+                result = o;
+            }
+        }
+        return result;
+    }
+};
+
+} // namespace
+
+class UnclumpTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // setup hidden dependency
+        Application::create(false);
+    }
+};
+
+// Unclumping through the spatial index moves the items exactly like the original algorithm did.
+TEST_F(UnclumpTest, MatchesOriginalAlgorithm)
+{
+    int const count = 40;
+    std::string svg = R"(<svg xmlns="http://www.w3.org/2000/svg" width="300" height="300">)";
+    unsigned seed = 12345;
+    auto random = [&] (int max) {
+        seed = seed * 1103515245 + 12345;
+        return static_cast<int>((seed >> 16) % max);
+    };
+    for (int i = 0; i < count; i++) {
+        // A mix of scattered and aligned items, some of them elongated.
+        int x = random(280), y = random(280);
+        if (i % 4 == 0) {
+            x = x / 40 * 40;
+            y = y / 40 * 40;
+        }
+        int w = 2 + random(12), h = 2 + random(12);
+        if (i % 5 == 0) {
+            w *= 4;
+        }
+        svg += "<rect id=\"r" + std::to_string(i) + "\" x=\"" + std::to_string(x) + "\" y=\"" + std::to_string(y)
+             + "\" width=\"" + std::to_string(w) + "\" height=\"" + std::to_string(h) + "\" style=\"fill:black\"/>";
+    }
+    svg += "</svg>";
+
+    auto doc = SPDocument::createNewDocFromMem(svg, true);
+    ASSERT_TRUE(doc);
+    doc->ensureUpToDate();
+
+    std::vector<SPItem *> items;
+    ReferenceUnclump reference;
+    for (int i = 0; i < count; i++) {
+        auto item = cast<SPItem>(doc->getObjectById("r" + std::to_string(i)));
+        ASSERT_TRUE(item);
+        auto bbox = item->desktopVisualBounds();
+        ASSERT_TRUE(bbox);
+        items.push_back(item);
+        reference.c.push_back(bbox->midpoint());
+        reference.wh.push_back(bbox->dimensions());
+    }
+
+    for (int pass = 0; pass < 3; pass++) {
+        reference.run();
+        unclump(items);
+        doc->ensureUpToDate();
+
+        for (int i = 0; i < count; i++) {
+            auto bbox = items[i]->desktopVisualBounds();
+            ASSERT_TRUE(bbox);
+            // Allow for the rounding of the written transforms.
+            EXPECT_NEAR(bbox->midpoint()[Geom::X], reference.c[i][Geom::X], 1e-3) << "item " << i << ", pass " << pass;
+            EXPECT_NEAR(bbox->midpoint()[Geom::Y], reference.c[i][Geom::Y], 1e-3) << "item " << i << ", pass " << pass;
+            // Continue from the written positions, like repeated unclumping does.
+            reference.c[i] = bbox->midpoint();
+        }
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
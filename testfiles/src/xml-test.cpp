@@ -12,10 +12,16 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <list>
 #include <memory>
 #include <string>
 #include "gtest/gtest.h"
+#include "io/stream/inkscapestream.h"
+#include "io/stream/stringstream.h"
 #include "xml/repr.h"
 
 #include <list>
@@ -100,6 +106,130 @@ NODE
 )""");
 }
 
+TEST(XmlWriteTest, indentation)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(
+        "<svg><g id='a' title='x&quot;y&#10;z&lt;'><!--c--><text>a &amp; b<tspan>&gt;</tspan></text></g><rect/></svg>",
+        SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+
+    Inkscape::IO::StringOutputStream souts;
+    Inkscape::IO::OutputStreamWriter outs(souts);
+    sp_repr_write_stream(testdoc->root(), outs, 0, true, g_quark_from_static_string("svg"), 0, 2);
+    ASSERT_STREQ(souts.getString().c_str(), R"""(<svg>
+  <g
+     id="a"
+     title="x&quot;y&#10;z&lt;">
+    <!--c-->
+    <text>a &amp; b<tspan>&gt;</tspan></text>
+  </g>
+  <rect />
+</svg>
+)""");
+}
+
+namespace {
+
+/// Only implements put(), so it receives the output one byte at a time.
+class BytewiseOutputStream : public Inkscape::IO::OutputStream
+{
+public:
+    void close() override {}
+    void flush() override {}
+    int put(char ch) override
+    {
+        str.push_back(ch);
+        return 1;
+    }
+
+    std::string str;
+};
+
+/// Filters the output in put() only, like XsltOutputStream.
+class UppercaseOutputStream : public Inkscape::IO::BasicOutputStream
+{
+public:
+    using BasicOutputStream::BasicOutputStream;
+    int put(char ch) override { return BasicOutputStream::put(std::toupper(ch)); }
+};
+
+} // namespace
+
+// Blocks written to a filtering stream go through its put().
+TEST(XmlWriteTest, filterStreamSeesBlocks)
+{
+    BytewiseOutputStream bytes;
+    UppercaseOutputStream upper(bytes);
+    upper.write("<svg/>", 6);
+    EXPECT_EQ(bytes.str, "<SVG/>");
+}
+
+// Writing every document of the test corpus, reading it back and writing it again gives the same
+// output, whether it is passed on in blocks or byte by byte.
+TEST(XmlWriteTest, roundTripCorpus)
+{
+    int count = 0;
+    for (auto dir : {"/rendering_tests", "/data"}) {
+        for (auto const &entry : std::filesystem::directory_iterator(INKSCAPE_TESTS_DIR + std::string(dir))) {
+            if (entry.path().extension() != ".svg") {
+                continue;
+            }
+            SCOPED_TRACE(entry.path().string());
+
+            auto doc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_file(entry.path().string().c_str(), SP_SVG_NS_URI));
+            ASSERT_TRUE(doc);
+            auto const saved = sp_repr_save_buf(doc.get());
+
+            auto reread = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(saved, SP_SVG_NS_URI));
+            ASSERT_TRUE(reread);
+            EXPECT_EQ(sp_repr_save_buf(reread.get()).raw(), saved.raw());
+
+            Inkscape::IO::StringOutputStream souts;
+            Inkscape::IO::OutputStreamWriter outs(souts);
+            sp_repr_write_stream(doc->root(), outs, 0, true, GQuark(0), 0, 2);
+            BytewiseOutputStream bytes;
+            Inkscape::IO::OutputStreamWriter bytes_outs(bytes);
+            sp_repr_write_stream(doc->root(), bytes_outs, 0, true, GQuark(0), 0, 2);
+            EXPECT_EQ(bytes.str, souts.getString().raw());
+
+            count++;
+        }
+    }
+    EXPECT_GT(count, 10);
+}
+
+// Saving a document gives exactly the output of the old character-by-character writer. The expected
+// files were written by it; only documents in the SVG namespace alone are used, since the order of
+// several xmlns declarations on the root depends on the order the prefixes were interned in.
+TEST(XmlWriteTest, matchesExpectedOutput)
+{
+    auto const tests_dir = std::filesystem::path(INKSCAPE_TESTS_DIR);
+    for (auto name : {"data/livarot-pathoutline.svg", "rendering_tests/style-parsing.svg", "rendering_tests/test-clip-path.svg",
+                      "rendering_tests/text-glyphs-vertical.svg", "rendering_tests/text-shaping.svg"}) {
+        SCOPED_TRACE(name);
+        auto const input = tests_dir / name;
+        auto const expected_path = tests_dir / "data" / "expected_xml" / input.filename();
+
+        auto doc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_file(input.string().c_str(), SP_SVG_NS_URI));
+        ASSERT_TRUE(doc);
+
+        auto file = std::unique_ptr<FILE, decltype(&std::fclose)>(std::tmpfile(), &std::fclose);
+        ASSERT_TRUE(file);
+        sp_repr_save_stream(doc.get(), file.get(), SP_SVG_NS_URI);
+        std::rewind(file.get());
+        std::string saved;
+        char buf[4096];
+        while (auto n = std::fread(buf, 1, sizeof(buf), file.get())) {
+            saved.append(buf, n);
+        }
+
+        std::ifstream expected_file(expected_path, std::ios::binary);
+        ASSERT_TRUE(expected_file);
+        std::string const expected{std::istreambuf_iterator<char>(expected_file), std::istreambuf_iterator<char>()};
+        EXPECT_EQ(saved, expected);
+    }
+}
+
 /*
   Local Variables:
   mode:c++